@@ -35,6 +35,10 @@ AnalParams::AnalParams(string apXmlFile)
   xml.LoadFile(apXml.c_str());
 
   this->simParams = nullptr;
+  obsReader = NULL;
+  obsIndex = NULL;
+  distributor = NULL;
+  journal = NULL;
   //pack up the analysis parameters and steps first
   tinyxml2::XMLElement* xAnalysis;
   tinyxml2::XMLElement* xParameters;
@@ -184,6 +188,34 @@ AnalParams::AnalParams(string apXmlFile)
   if(!xtmp) throwXmlError("cutStd not found.");
   cutStd = atof(xtmp->GetText());
 
+  //only compute the leading PCA modes instead of the full decomposition
+  pcaTruncated=false;
+  xtmp = xParameters->FirstChildElement("pcaTruncated");
+  if(xtmp){
+    if (atoi(xtmp->GetText())!=0)
+        pcaTruncated=true;
+  }
+
+  //write the per-scan PCA modes to the observation files
+  writePcaModes=false;
+  xtmp = xParameters->FirstChildElement("writePcaModes");
+  if(xtmp){
+    if (atoi(xtmp->GetText())!=0)
+        writePcaModes=true;
+  }
+
+  //optional chain of cleaners, by registered name, replacing the
+  //single cleaner chosen from the parameters above
+  cleanChain.clear();
+  xtmp = xParameters->FirstChildElement("cleanChain");
+  if(xtmp && xtmp->GetText()){
+    string chain = xtmp->GetText();
+    for(size_t c=0;c<chain.size();c++) if(chain[c] == ',') chain[c] = ' ';
+    istringstream chainStream(chain);
+    string stage;
+    while(chainStream >> stage) cleanChain.push_back(stage);
+  }
+
   xtmp = xParameters->FirstChildElement("noiseMapsPerObs");
   if(!xtmp){
     nNoiseMapsPerObs = 5;
@@ -228,6 +260,26 @@ AnalParams::AnalParams(string apXmlFile)
   } else nThreads = atoi(xtmp->GetText());
   if (nThreads < 1) nThreads = 1;
 
+  //threads for each BLAS/LAPACK call, 0 splits the cores between files
+  xtmp = xParameters->FirstChildElement("blasThreads");
+  if(!xtmp){
+    blasThreads = 0;
+  } else blasThreads = atoi(xtmp->GetText());
+  if (blasThreads < 0) blasThreads = 0;
+
+  //estimated memory of the observations reduced at once, in GB
+  xtmp = xParameters->FirstChildElement("jobMemoryBudget");
+  if(!xtmp){
+    jobMemoryBudget = 0.;
+  } else jobMemoryBudget = atof(xtmp->GetText());
+  if (jobMemoryBudget < 0.) jobMemoryBudget = 0.;
+
+  //pick up an interrupted run from its journal
+  xtmp = xParameters->FirstChildElement("resume");
+  if(!xtmp){
+    resume = 0;
+  } else resume = atoi(xtmp->GetText());
+
   saveTimeStreams=false;
   xtmp = xParameters->FirstChildElement("saveTimeStreams");
   if(xtmp){
@@ -235,6 +287,43 @@ AnalParams::AnalParams(string apXmlFile)
         saveTimeStreams=true;
   }
 
+  xtmp = xParameters->FirstChildElement("mapTileSize");
+  if(!xtmp){
+    mapTileSize = 0;
+  } else mapTileSize = atoi(xtmp->GetText());
+  if (mapTileSize < 0) mapTileSize = 0;
+
+  //absolute coordinate grids in the output files, 0 keeps only the
+  //projection parameters
+  writeAbsCoords=true;
+  xtmp = xParameters->FirstChildElement("writeAbsCoords");
+  if(xtmp){
+    if (atoi(xtmp->GetText())==0)
+        writeAbsCoords=false;
+  }
+
+  //netcdf-4 compressed output, 0 keeps the uncompressed classic files
+  xtmp = xParameters->FirstChildElement("ncDeflateLevel");
+  if(!xtmp){
+    ncDeflateLevel = 0;
+  } else ncDeflateLevel = atoi(xtmp->GetText());
+  if (ncDeflateLevel < 0) ncDeflateLevel = 0;
+  if (ncDeflateLevel > 9) ncDeflateLevel = 9;
+
+  ncShuffle=true;
+  xtmp = xParameters->FirstChildElement("ncShuffle");
+  if(xtmp){
+    if (atoi(xtmp->GetText())==0)
+        ncShuffle=false;
+  }
+
+  noiseFloat32=false;
+  xtmp = xParameters->FirstChildElement("noiseFloat32");
+  if(xtmp){
+    if (atoi(xtmp->GetText())!=0)
+        noiseFloat32=true;
+  }
+
 
   xtmp = xParameters->FirstChildElement("pixelSize");
   if(!xtmp) throwXmlError("pixelSize not found.");
@@ -278,6 +367,11 @@ AnalParams::AnalParams(string apXmlFile)
   cerr << "timeChunk: " << timeChunk << endl;
   cerr << "neigToCut: " << neigToCut << endl;
   cerr << "cutStd: " << cutStd << endl;
+  cerr << "pcaTruncated: " << pcaTruncated << endl;
+  cerr << "writePcaModes: " << writePcaModes << endl;
+  cerr << "cleanChain:";
+  for(size_t c=0;c<cleanChain.size();c++) cerr << " " << cleanChain[c];
+  cerr << endl;
   cerr << "pixelSize: " << pixelSize << endl;
   cerr << "azelMap: " << azelMap << endl;
   cerr << "approximateWeights: " << approximateWeights << endl;
@@ -287,6 +381,14 @@ AnalParams::AnalParams(string apXmlFile)
   cerr << "cleanStripe: " <<cleanStripe<<endl;
   cerr << "resample: "<< resample <<endl;
   cerr << "ThreadNumber: " <<nThreads<<endl;
+  cerr << "blasThreads: " << blasThreads << endl;
+  cerr << "jobMemoryBudget: " << jobMemoryBudget << endl;
+  cerr << "resume: " << resume << endl;
+  cerr << "mapTileSize: " << mapTileSize << endl;
+  cerr << "writeAbsCoords: " << writeAbsCoords << endl;
+  cerr << "ncDeflateLevel: " << ncDeflateLevel << endl;
+  cerr << "ncShuffle: " << ncShuffle << endl;
+  cerr << "noiseFloat32: " << noiseFloat32 << endl;
   cerr << "initial Mastergrid: [" << masterGridJ2000[0];
   cerr << "," << masterGridJ2000[1] << "]" << endl;
 
@@ -691,6 +793,9 @@ AnalParams::AnalParams(AnalParams *ap){
   this->cutSamplesAtEndOfScans = ap->cutSamplesAtEndOfScans;
   this->cutStd = ap->cutStd;
   this->neigToCut=ap->neigToCut;
+  this->pcaTruncated = ap->pcaTruncated;
+  this->writePcaModes = ap->writePcaModes;
+  this->cleanChain = ap->cleanChain;
   this->cleanPixelSize = ap->cleanPixelSize;
   this->order = ap->order;
   this->cleanStripe = ap->cleanStripe;
@@ -703,12 +808,25 @@ AnalParams::AnalParams(AnalParams *ap){
   this->observatory = ap->observatory;
   this->timeVarName = ap->timeVarName;
   this->nThreads = ap-> nThreads;
+  this->blasThreads = ap->blasThreads;
+  this->jobMemoryBudget = ap->jobMemoryBudget;
+  this->resume = ap->resume;
   this->saveTimeStreams = ap->saveTimeStreams;
+  this->mapTileSize = ap->mapTileSize;
+  this->writeAbsCoords = ap->writeAbsCoords;
+  this->ncDeflateLevel = ap->ncDeflateLevel;
+  this->ncShuffle = ap->ncShuffle;
+  this->noiseFloat32 = ap->noiseFloat32;
   this->tOrder = ap->tOrder;
   if (ap->simParams != NULL)
 	  this->simParams = new SimParams(ap->simParams);
   else
 	  this->simParams = NULL;
+  //each copy opens its own file when it needs it
+  this->obsReader = NULL;
+  this->obsIndex = NULL;
+  this->distributor = ap->distributor;
+  this->journal = ap->journal;
   this->doSubtract = ap->doSubtract;
   this->subtractFile = ap->subtractFile;
   this->subtractPath = ap->subtractPath;
@@ -787,6 +905,10 @@ AnalParams::AnalParams(AnalParams *ap){
 bool AnalParams::setDataFile(int index)
 {
   dataFile = fileList[index].c_str();
+  delete obsReader;
+  obsReader = NULL;
+  delete obsIndex;
+  obsIndex = NULL;
   bolostatsFile = bstatList[index].c_str();
   mapFile = mapFileList[index].c_str();
   if(beammapping == 1){
@@ -817,33 +939,19 @@ bool AnalParams::setDataFile(int index)
 //----------------------------- o ---------------------------------------
 
 
+///LMT, ASTE or JCMT, as recorded in the data file's index
+/** The index tells them apart by the variables in the file, see
+    ObsIndex::indexDataFile().
+**/
 bool AnalParams::determineObservatory()
 {
-  //is it the LMT?
-#pragma omp critical (dataio)
-{
-  NcError ncerror(NcError::silent_nonfatal);
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcVar* timeVar = ncfid.get_var("Data.AztecBackend.time");
-  if(timeVar){
+  ObsIndex* index = getObsIndex();
+  observatory = index->getString("observatory");
+  timeVarName = index->getString("timeVarName");
+  if(observatory.compare("LMT") == 0){
     cerr << "AnalParams::determinObservatory(): ";
     cerr << "This is an LMT data file." << endl;
-    observatory.assign("LMT");
-    timeVarName.assign("Data.AztecBackend.time");
-  }
-  else{
-  //must check to see if it's ASTE or JCMT
-	  NcVar* randomAsteSig = ncfid.get_var("aste_windtime");
-	  if(randomAsteSig){
-		observatory.assign("ASTE");
-		timeVarName.assign("time");
-	  }else{
-		observatory.assign("JCMT");
-		timeVarName.assign("time");
-	  }
   }
-  ncfid.close();
-}
   return 1;
 }
 
@@ -939,6 +1047,47 @@ const char* AnalParams::getDataFile()
   return dataFile;
 }
 
+///the reader of the current data file, opened on first use
+ObsReader* AnalParams::getObsReader()
+{
+  if(!obsReader) obsReader = new ObsReader(dataFile);
+  return obsReader;
+}
+
+///the index of the current data file, from its sidecar when current
+ObsIndex* AnalParams::getObsIndex()
+{
+  if(!obsIndex) obsIndex = ObsIndex::forDataFile(dataFile);
+  return obsIndex;
+}
+
+///the processes sharing this run, NULL when there is just this one
+Distributor* AnalParams::getDistributor()
+{
+  return distributor;
+}
+
+void AnalParams::setDistributor(Distributor* dist)
+{
+  distributor = dist;
+}
+
+///the record of finished work of this run, NULL if none is kept
+Journal* AnalParams::getJournal()
+{
+  return journal;
+}
+
+void AnalParams::setJournal(Journal* j)
+{
+  journal = j;
+}
+
+string AnalParams::getApXml()
+{
+  return apXml;
+}
+
 
 //----------------------------- o ---------------------------------------
 
@@ -1085,6 +1234,21 @@ int AnalParams::getNeigToCut()
   return neigToCut;
 }
 
+bool AnalParams::getPcaTruncated()
+{
+  return pcaTruncated;
+}
+
+bool AnalParams::getWritePcaModes()
+{
+  return writePcaModes;
+}
+
+vector<string> AnalParams::getCleanChain()
+{
+  return cleanChain;
+}
+
 //----------------------------- o ---------------------------------------
 
 double AnalParams::getCleanPixelSize()
@@ -1119,6 +1283,21 @@ int AnalParams::getNThreads()
   return nThreads;
 }
 
+int AnalParams::getBlasThreads()
+{
+  return blasThreads;
+}
+
+double AnalParams::getJobMemoryBudget()
+{
+  return jobMemoryBudget;
+}
+
+bool AnalParams::getResume()
+{
+  return resume;
+}
+
 //----------------------------- o ---------------------------------------
 
 bool AnalParams::getSaveTimestreams()
@@ -1127,6 +1306,36 @@ bool AnalParams::getSaveTimestreams()
 }
 
 
+//----------------------------- o ---------------------------------------
+
+int AnalParams::getMapTileSize()
+{
+ return mapTileSize;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+bool AnalParams::getWriteAbsCoords()
+{
+ return writeAbsCoords;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+///storage settings for all netcdf map output
+NcCompression AnalParams::getNcCompression()
+{
+ return NcCompression(ncDeflateLevel, ncShuffle);
+}
+
+bool AnalParams::getNoiseFloat32()
+{
+ return noiseFloat32;
+}
+
+
 //----------------------------- o ---------------------------------------
 
 double* AnalParams::getBsOffset()
@@ -1184,6 +1393,11 @@ string AnalParams::getMapFile()
   return tmp;
 }
 
+string AnalParams::getMapPath()
+{
+  return mapPath;
+}
+
 
 //----------------------------- o ---------------------------------------
 
@@ -1192,6 +1406,16 @@ string AnalParams::getMapFileList(int i)
   return mapFileList[i];
 }
 
+string AnalParams::getFileList(int i)
+{
+  return fileList[i];
+}
+
+string AnalParams::getBstatList(int i)
+{
+  return bstatList[i];
+}
+
 
 //----------------------------- o ---------------------------------------
 
@@ -1527,4 +1751,6 @@ AnalParams::~AnalParams()
   delete macanaRandom;
   if (simParams !=NULL)
 	  delete simParams;
+  delete obsReader;
+  delete obsIndex;
 }
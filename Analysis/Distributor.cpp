@@ -0,0 +1,413 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include <ctime>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dirent.h>
+using namespace std;
+
+#include "nr3.h"
+#include "Distributor.h"
+
+//how long a rank waits before looking for a message again [us]
+#define DIST_WAIT 20000
+
+//how long a rank waits for a message unless told otherwise [s]
+#define DIST_TIMEOUT 86400.
+
+//the distributed run of this process, told at exit if it didn't finish
+static Distributor* unfinished = NULL;
+
+static void abortUnfinished()
+{
+  if(unfinished) unfinished->abort();
+}
+
+
+///Distributor constructor, rank and run from the environment
+/** The rank and number of ranks come from the first of MACANA_RANK/
+    MACANA_NRANKS, OMPI_COMM_WORLD_RANK/OMPI_COMM_WORLD_SIZE,
+    PMI_RANK/PMI_SIZE and SLURM_PROCID/SLURM_NTASKS that is set, the
+    run id from MACANA_RUN, SLURM_JOB_ID, PMIX_NAMESPACE or
+    OMPI_MCA_ess_base_jobid.  A slurm job id gets the step and the
+    restart count appended, as a requeued job keeps its id.
+**/
+Distributor::Distributor(const char* sharedDir)
+{
+  const char* rankVars[4][2] = {{"MACANA_RANK", "MACANA_NRANKS"},
+				{"OMPI_COMM_WORLD_RANK", "OMPI_COMM_WORLD_SIZE"},
+				{"PMI_RANK", "PMI_SIZE"},
+				{"SLURM_PROCID", "SLURM_NTASKS"}};
+  int r = 0;
+  int n = 1;
+  for(int i=0;i<4;i++){
+    const char* rv = getenv(rankVars[i][0]);
+    const char* nv = getenv(rankVars[i][1]);
+    if(rv && nv){
+      r = atoi(rv);
+      n = atoi(nv);
+      break;
+    }
+  }
+
+  const char* idVars[4] = {"MACANA_RUN", "SLURM_JOB_ID", "PMIX_NAMESPACE",
+			   "OMPI_MCA_ess_base_jobid"};
+  string runId;
+  for(int i=0;i<4;i++){
+    const char* v = getenv(idVars[i]);
+    if(!v) continue;
+    runId.assign(v);
+    //every step and every restart of a slurm job is a run of its own
+    if(i == 1 && getenv("SLURM_STEP_ID"))
+      runId.append(".").append(getenv("SLURM_STEP_ID"));
+    if(i == 1 && getenv("SLURM_RESTART_COUNT"))
+      runId.append(".r").append(getenv("SLURM_RESTART_COUNT"));
+    break;
+  }
+
+  init(sharedDir, r, n, runId.c_str());
+}
+
+///Distributor constructor with everything given
+Distributor::Distributor(const char* sharedDir, int rank, int nRanks,
+			 const char* runId)
+{
+  init(sharedDir, rank, nRanks, runId);
+}
+
+///Distributor destructor, a run that goes out of scope is not aborted
+Distributor::~Distributor()
+{
+  if(unfinished == this) unfinished = NULL;
+}
+
+///sets up rank of nRanks, making the run directory if there are several
+/** The run directory must be new.  The root refuses to start if it
+    holds anything, and then posts "started"; the other ranks wait for
+    that before they send anything, so the root never mistakes their
+    messages for an earlier run's.  A rank that finds messages of its
+    own from before refuses as well.  From here on an exit() before
+    finish() posts "aborted" for the other ranks.
+**/
+void Distributor::init(const char* sharedDir, int rank, int nRanks,
+		       const char* runId)
+{
+  this->rank = rank;
+  this->nRanks = nRanks;
+  waitTimeout = DIST_TIMEOUT;
+  const char* tv = getenv("MACANA_WAIT_TIMEOUT");
+  if(tv) waitTimeout = atof(tv);
+  if(nRanks < 1 || rank < 0 || rank >= nRanks){
+    cerr << "Distributor(): rank " << rank << " of " << nRanks;
+    cerr << " makes no sense." << endl;
+    exit(1);
+  }
+  if(nRanks == 1) return;
+
+  string id(runId);
+  if(id.empty()){
+    cerr << "Distributor(): " << nRanks << " ranks but no run id, ";
+    cerr << "set MACANA_RUN to a name unique to this run." << endl;
+    exit(1);
+  }
+  for(size_t i=0;i<id.size();i++)
+    if(!isalnum(id[i]) && id[i] != '.' && id[i] != '-') id[i] = '_';
+
+  runDir.assign(sharedDir);
+  if(runDir.empty()) runDir.assign(".");
+  if(runDir[runDir.size()-1] != '/') runDir.append("/");
+  runDir.append(".macanaRun.").append(id);
+  if(mkdir(runDir.c_str(), 0775) != 0 && errno != EEXIST){
+    cerr << "Distributor(): cannot make " << runDir << endl;
+    exit(1);
+  }
+  static bool atExit = 0;
+  if(!atExit) atExit = (atexit(abortUnfinished) == 0);
+  unfinished = this;
+
+  ostringstream mine;
+  mine << "." << rank;
+  DIR* dir = opendir(runDir.c_str());
+  if(dir){
+    struct dirent* e;
+    bool stale = 0;
+    while(!stale && (e = readdir(dir)) != NULL){
+      string f(e->d_name);
+      if(f == "." || f == "..") continue;
+      stale = isRoot() || (f.size() > mine.str().size() &&
+			   f.compare(f.size()-mine.str().size(),
+				     mine.str().size(), mine.str()) == 0);
+    }
+    closedir(dir);
+    if(stale){
+      cerr << "Distributor(): " << runDir << " holds messages of an ";
+      cerr << "earlier run, remove it or give this run a new id." << endl;
+      exit(1);
+    }
+  }
+  if(isRoot()) send("started", NULL, 0);
+  else waitFor(messageFile("started", 0));
+
+  cerr << "Distributor(): rank " << rank << " of " << nRanks;
+  cerr << ", messages in " << runDir << endl;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+int Distributor::getRank()
+{
+  return rank;
+}
+
+int Distributor::getNRanks()
+{
+  return nRanks;
+}
+
+bool Distributor::isRoot()
+{
+  return rank == 0;
+}
+
+bool Distributor::isDistributed()
+{
+  return nRanks > 1;
+}
+
+///how long to wait for a message before giving up [s], 0 for ever
+void Distributor::setWaitTimeout(double seconds)
+{
+  waitTimeout = seconds;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///splits the observations over the ranks by their work
+/** Largest first, each to the rank with the least work so far.  All
+    ranks size the same files the same way so they all come to the
+    same split without talking.
+**/
+void Distributor::assignJobs(VecDoub &work)
+{
+  int nJobs = work.size();
+  owner.assign(nJobs, 0);
+  if(nRanks == 1) return;
+
+  VecInt order(nJobs);
+  for(int i=0;i<nJobs;i++){
+    int j = i;
+    for(;j>0 && work[order[j-1]] < work[i];j--) order[j] = order[j-1];
+    order[j] = i;
+  }
+
+  VecDoub load(nRanks, 0.);
+  for(int k=0;k<nJobs;k++){
+    int i = order[k];
+    int r = 0;
+    for(int q=1;q<nRanks;q++) if(load[q] < load[r]) r = q;
+    owner[i] = r;
+    load[r] += work[i];
+  }
+
+  int mine = 0;
+  double total = 0.;
+  for(int i=0;i<nJobs;i++){
+    if(owner[i] == rank) mine++;
+    total += work[i];
+  }
+  cerr << "Distributor(): rank " << rank << " takes " << mine << " of ";
+  cerr << nJobs << " observations, " << load[rank] << " of " << total;
+  cerr << " detector samples." << endl;
+}
+
+///whether this rank reduces observation job
+/** Round robin when the observations were not sized in this run,
+    as when only the coaddition is asked for.
+**/
+bool Distributor::owns(int job)
+{
+  if(nRanks == 1) return 1;
+  if(job < (int) owner.size()) return owner[job] == rank;
+  return job%nRanks == rank;
+}
+
+///the rank doing task, for work that costs the same every time
+int Distributor::taskOwner(int task)
+{
+  return task%nRanks;
+}
+
+bool Distributor::ownsTask(int task)
+{
+  return taskOwner(task) == rank;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+std::string Distributor::messageFile(const std::string &name, int from)
+{
+  ostringstream f;
+  f << runDir << "/" << name << "." << from;
+  return f.str();
+}
+
+///waits for file to appear, gives up if a rank aborted or on the timeout
+/** The other ranks' "aborted" markers are looked for about once a
+    second rather than at every poll, there may be many of them.
+**/
+void Distributor::waitFor(const std::string &file)
+{
+  time_t start = time(NULL);
+  int check = 1000000/DIST_WAIT;
+  for(int polls=1;access(file.c_str(), F_OK) != 0;polls++){
+    usleep(DIST_WAIT);
+    if(polls%check) continue;
+    for(int r=0;r<nRanks;r++){
+      if(r == rank || access(messageFile("aborted", r).c_str(), F_OK) != 0)
+	continue;
+      cerr << "Distributor::waitFor(): rank " << r << " aborted the run, ";
+      cerr << "giving up on " << file << endl;
+      exit(1);
+    }
+    if(waitTimeout > 0 && difftime(time(NULL), start) > waitTimeout){
+      cerr << "Distributor::waitFor(): no " << file << " after ";
+      cerr << waitTimeout << " s, giving up." << endl;
+      exit(1);
+    }
+  }
+}
+
+///posts n doubles as message name of this rank
+void Distributor::send(const std::string &name, const double* data, long n)
+{
+  string file = messageFile(name, rank);
+  string tmp = file + ".tmp";
+  FILE* fp = fopen(tmp.c_str(), "wb");
+  bool ok = fp && fwrite(&n, sizeof(long), 1, fp) == 1;
+  if(ok && n > 0) ok = fwrite(data, sizeof(double), n, fp) == (size_t) n;
+  if(fp && fclose(fp) != 0) ok = 0;
+  if(!ok || rename(tmp.c_str(), file.c_str()) != 0){
+    cerr << "Distributor::send(): cannot write " << file << endl;
+    exit(1);
+  }
+}
+
+///waits for message name of rank from and reads it into data
+void Distributor::receive(const std::string &name, int from, VecDoub &data)
+{
+  string file = messageFile(name, from);
+  waitFor(file);
+  FILE* fp = fopen(file.c_str(), "rb");
+  long n = 0;
+  bool ok = fp && fread(&n, sizeof(long), 1, fp) == 1 && n >= 0;
+  if(ok){
+    data.resize(n);
+    if(n > 0) ok = fread(&data[0], sizeof(double), n, fp) == (size_t) n;
+  }
+  if(fp) fclose(fp);
+  if(!ok){
+    cerr << "Distributor::receive(): cannot read " << file << endl;
+    exit(1);
+  }
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///sums data over all of the ranks, every rank ends with the sum
+/** A binary tree: at each level the odd ranks of the level post their
+    partial sum and drop out, the even ones add their partner's.  The
+    root then posts the total for everyone.  The sums are done in the
+    same order whatever the timing so the result is reproducible for
+    a given number of ranks.
+**/
+void Distributor::allReduce(const std::string &name, double* data, long n)
+{
+  if(nRanks == 1) return;
+  VecDoub part;
+  for(int step=1;step<nRanks;step*=2){
+    ostringstream level;
+    level << name << ".l" << step;
+    if(rank%(2*step)){
+      send(level.str(), data, n);
+      break;
+    }
+    if(rank+step < nRanks){
+      receive(level.str(), rank+step, part);
+      if((long) part.size() != n){
+	cerr << "Distributor::allReduce(): " << name << " has " << part.size();
+	cerr << " values from rank " << rank+step << ", not " << n << endl;
+	exit(1);
+      }
+      for(long i=0;i<n;i++) data[i] += part[i];
+    }
+  }
+
+  if(isRoot()) send(name + ".sum", data, n);
+  else {
+    receive(name + ".sum", 0, part);
+    for(long i=0;i<n;i++) data[i] = part[i];
+  }
+}
+
+///waits here until every rank has got to barrier name
+void Distributor::barrier(const std::string &name)
+{
+  if(nRanks == 1) return;
+  send(name, NULL, 0);
+  for(int r=0;r<nRanks;r++)
+    if(r != rank) waitFor(messageFile(name, r));
+}
+
+///the end of the run, the root clears the run directory
+/** The other ranks only say they are done; the root waits for all of
+    them since they may still be reading its messages.
+**/
+void Distributor::finish()
+{
+  if(nRanks == 1) return;
+  if(!isRoot()){
+    send("finished", NULL, 0);
+    if(unfinished == this) unfinished = NULL;
+    return;
+  }
+  for(int r=1;r<nRanks;r++) waitFor(messageFile("finished", r));
+
+  DIR* dir = opendir(runDir.c_str());
+  if(dir){
+    struct dirent* e;
+    while((e = readdir(dir)) != NULL){
+      string f(e->d_name);
+      if(f == "." || f == "..") continue;
+      remove((runDir + "/" + f).c_str());
+    }
+    closedir(dir);
+  }
+  rmdir(runDir.c_str());
+  if(unfinished == this) unfinished = NULL;
+}
+
+///tells the other ranks this one is leaving the run
+/** Called at exit for a run that didn't get to finish(), so it only
+    tries: it can't exit itself, and has nobody to complain to.  The
+    marker is empty, the other ranks only look for it.
+**/
+void Distributor::abort()
+{
+  if(unfinished == this) unfinished = NULL;
+  if(nRanks == 1) return;
+  FILE* fp = fopen(messageFile("aborted", rank).c_str(), "wb");
+  if(fp) fclose(fp);
+}
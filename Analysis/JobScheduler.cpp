@@ -0,0 +1,226 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <omp.h>
+using namespace std;
+
+#include "nr3.h"
+#include "JobScheduler.h"
+#include "ObsIndex.h"
+#include "Distributor.h"
+#include "Journal.h"
+#include "Detector.h"
+#include "tinyxml2.h"
+
+//bytes held per detector sample: the signal and kernel of a Detector,
+//its six double pointing and template signals, its flags, the
+//cleaning's working copies and the sample and pixel the binning
+//buckets it under
+#define JOB_SAMPLE_BYTES (92. + 2*sizeof(Sample))
+
+//signal, weight, kernel and inttime, plus the noise maps, per pixel
+#define JOB_MAP_PLANES 4
+
+//how long a thread waits before looking for room again [us]
+#define JOB_WAIT 20000
+
+
+///JobScheduler constructor, sizes every observation
+/** This reads the indexes of all the data files, which are built on
+    the way if they don't exist yet, and each bolostats file once,
+    several files at a time.
+**/
+JobScheduler::JobScheduler(AnalParams* ap, int nThreads)
+{
+  nJobs = ap->getNFiles();
+  this->nThreads = max(nThreads, 1);
+  budget = ap->getJobMemoryBudget()*1.e9;
+  work.resize(nJobs);
+  memory.resize(nJobs);
+  order.resize(nJobs);
+  started.resize(nJobs);
+  nStarted = 0;
+  nRunning = 0;
+  inFlight = 0.;
+
+  int nPlanes = JOB_MAP_PLANES + ap->getNNoiseMapsPerObs();
+  Journal* journal = ap->getJournal();
+  VecBool done(nJobs);
+#pragma omp parallel for schedule(dynamic)
+  for(int i=0;i<nJobs;i++){
+    order[i] = i;
+    started[i] = 0;
+
+    //observations the journal has as reduced are not redone
+    done[i] = journal && ap->getResume() &&
+      journal->isDone(journal->reduceStamp(i), ap->getMapFileList(i));
+    if(done[i]){
+      work[i] = 0.;
+      memory[i] = 0.;
+      continue;
+    }
+
+    ObsIndex* index = ObsIndex::forDataFile(ap->getFileList(i).c_str());
+    double nSamples = index->getInt("nSamples");
+    delete index;
+    double nDetectors = countDetectors(ap->getBstatList(i).c_str());
+    work[i] = nSamples*nDetectors;
+    memory[i] = work[i]*JOB_SAMPLE_BYTES;
+
+    //the map, if an earlier run says how big it was
+    ObsIndex mapIndex(ap->getMapFileList(i).c_str());
+    if(mapIndex.isCurrent() && mapIndex.has("nrows") && mapIndex.has("ncols"))
+      memory[i] += 8.*nPlanes*mapIndex.getInt("nrows")*mapIndex.getInt("ncols");
+  }
+  int nDone = 0;
+  for(int i=0;i<nJobs;i++)
+    if(done[i]){
+      started[i] = 1;
+      nStarted++;
+      nDone++;
+    }
+  if(nDone > 0)
+    cerr << "JobScheduler(): " << nDone << " observations already reduced." << endl;
+
+  //in a distributed run the other ranks' observations count as
+  //started here
+  Distributor* dist = ap->getDistributor();
+  if(dist){
+    dist->assignJobs(work);
+    for(int i=0;i<nJobs;i++)
+      if(!dist->owns(i) && !done[i]){
+	started[i] = 1;
+	nStarted++;
+      }
+  }
+
+  //largest first, ties in input order
+  for(int i=1;i<nJobs;i++){
+    int o = order[i];
+    int j = i;
+    for(;j>0 && work[order[j-1]] < work[o];j--) order[j] = order[j-1];
+    order[j] = o;
+  }
+
+  double total = 0.;
+  for(int i=0;i<nJobs;i++) if(!started[i]) total += memory[i];
+  cerr << "JobScheduler(): " << nJobs-nStarted << " observations, ";
+  cerr << total/1.e9 << " GB estimated in all";
+  if(budget > 0.) cerr << ", at most " << budget/1.e9 << " GB at once";
+  cerr << "." << endl;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///number of detectors with goodflag=1 in a bolostats file
+/** Counted the same way Array::Array() does.
+**/
+int JobScheduler::countDetectors(const char* bolostatsFile)
+{
+  tinyxml2::XMLDocument bolostats;
+  if(bolostats.LoadFile(bolostatsFile) != tinyxml2::XML_SUCCESS){
+    cerr << "JobScheduler(): can't read " << bolostatsFile << endl;
+    exit(1);
+  }
+  tinyxml2::XMLElement* x = bolostats.FirstChildElement("nBolos");
+  if(!x || !x->FirstChildElement("value")){
+    cerr << "JobScheduler(): no nBolos in " << bolostatsFile << endl;
+    exit(1);
+  }
+  int nBolos = atoi(x->FirstChildElement("value")->GetText());
+  int count = 0;
+  char dId[50];
+  for(int i=0;i<nBolos;i++){
+    sprintf(dId, "d%d", i);
+    x = bolostats.FirstChildElement(dId);
+    if(!x) continue;
+    x = x->FirstChildElement("goodflag");
+    if(!x || !x->FirstChildElement("value")) continue;
+    const char* flag = x->FirstChildElement("value")->GetText();
+    if(flag && strcmp(flag, "1") == 0) count++;
+  }
+  return count;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///the next observation to reduce, -1 when there are none left
+/** Takes the largest queued job that fits next to the ones running,
+    or the largest of all if nothing is running.  If nothing fits the
+    caller waits here until a running job finishes.
+**/
+int JobScheduler::nextJob()
+{
+  while(1){
+    int job = -1;
+    bool done = 0;
+#pragma omp critical (scheduler)
+{
+    if(nStarted == nJobs) done = 1;
+    else {
+      for(int k=0;k<nJobs;k++){
+	int i = order[k];
+	if(started[i]) continue;
+	if(nRunning == 0 || budget <= 0. || inFlight+memory[i] <= budget){
+	  job = i;
+	  break;
+	}
+      }
+      if(job >= 0){
+	started[job] = 1;
+	nStarted++;
+	nRunning++;
+	inFlight += memory[job];
+      }
+    }
+}
+    if(done) return -1;
+    if(job >= 0) return job;
+    usleep(JOB_WAIT);
+  }
+}
+
+///returns the memory of a finished job to the budget
+void JobScheduler::finishJob(int job)
+{
+#pragma omp critical (scheduler)
+{
+  nRunning--;
+  inFlight -= memory[job];
+}
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///threads a running job may use for its own parallel stages
+/** One while observations are still queued, since every thread has a
+    file of its own; after that the threads of the whole team split
+    evenly over the jobs that are left.
+**/
+int JobScheduler::threadsPerJob()
+{
+  int n = 1;
+#pragma omp critical (scheduler)
+{
+  if(nStarted == nJobs && nRunning > 0) n = max(nThreads/nRunning, 1);
+}
+  return n;
+}
+
+double JobScheduler::getWork(int job)
+{
+  return work[job];
+}
+
+double JobScheduler::getMemory(int job)
+{
+  return memory[job];
+}
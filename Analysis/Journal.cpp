@@ -0,0 +1,269 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <omp.h>
+using namespace std;
+
+#include "nr3.h"
+#include "AnalParams.h"
+#include "Distributor.h"
+#include "Journal.h"
+#include "tinyxml2.h"
+
+//the journals in the map path all start with this
+#define JOURNAL_NAME "macana.journal"
+
+
+///Journal constructor, reads or starts the journals of the run
+Journal::Journal(AnalParams* analParams)
+{
+  ap = analParams;
+  hashParameters();
+
+  string dir = ap->getMapPath();
+  if(dir.empty()) dir.assign("./");
+  if(dir[dir.size()-1] != '/') dir.append("/");
+  ostringstream f;
+  f << dir << JOURNAL_NAME;
+  Distributor* dist = ap->getDistributor();
+  if(dist && dist->isDistributed()) f << "." << dist->getRank();
+  journalFile = f.str();
+
+  if(ap->getResume()){
+    DIR* d = opendir(dir.c_str());
+    if(d){
+      struct dirent* e;
+      while((e = readdir(d)) != NULL){
+	string name(e->d_name);
+	if(name.compare(0, strlen(JOURNAL_NAME), JOURNAL_NAME) == 0)
+	  load(dir + name);
+      }
+      closedir(d);
+    }
+    cerr << "Journal(): resuming, " << stamps.size();
+    cerr << " pieces of work done before." << endl;
+  } else {
+    FILE* fp = fopen(journalFile.c_str(), "w");
+    if(!fp){
+      cerr << "Journal(): cannot write " << journalFile << endl;
+      exit(1);
+    }
+    fclose(fp);
+  }
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///an element of the analysis xml as compact text
+static string printXml(const tinyxml2::XMLElement* x)
+{
+  tinyxml2::XMLPrinter printer;
+  x->Accept(&printer);
+  return string(printer.CStr());
+}
+
+///hashes the parts of the analysis xml each kind of work depends on
+/** The reductions depend on every section but the analysis steps,
+    the file lists and the coaddition, noise and Wiener sections, and
+    not on the parameters that only say how the run is executed.  Each
+    observation also depends on its own entry in the file list.
+**/
+void Journal::hashParameters()
+{
+  tinyxml2::XMLDocument xml;
+  if(xml.LoadFile(ap->getApXml().c_str()) != tinyxml2::XML_SUCCESS){
+    cerr << "Journal(): cannot read " << ap->getApXml() << endl;
+    exit(1);
+  }
+  tinyxml2::XMLElement* xAnalysis = xml.FirstChildElement("analysis");
+  if(!xAnalysis){
+    cerr << "Journal(): no <analysis> in " << ap->getApXml() << endl;
+    exit(1);
+  }
+
+  const char* runOnly[] = {"threadNumber", "blasThreads", "jobMemoryBudget",
+			   "resume"};
+  string params;
+  for(tinyxml2::XMLElement* x = xAnalysis->FirstChildElement(); x;
+      x = x->NextSiblingElement()){
+    string name(x->Name());
+    if(name == "analysisSteps" || name == "observations" ||
+       name == "coaddition") continue;
+    if(name == "noiseRealization"){
+      noiseHash = hash(printXml(x));
+      continue;
+    }
+    if(name == "wienerFilter"){
+      wienerHash = hash(printXml(x));
+      continue;
+    }
+    if(name != "parameters"){
+      params.append(printXml(x));
+      continue;
+    }
+    for(tinyxml2::XMLElement* p = x->FirstChildElement(); p;
+	p = p->NextSiblingElement()){
+      bool skip = 0;
+      for(int i=0;i<4;i++) if(!strcmp(p->Name(), runOnly[i])) skip = 1;
+      if(!skip) params.append(printXml(p));
+    }
+  }
+  paramHash = hash(params);
+
+  tinyxml2::XMLElement* xObs = xAnalysis->FirstChildElement("observations");
+  char fId[50];
+  for(int i=0;i<ap->getNFiles();i++){
+    sprintf(fId, "f%d", i);
+    tinyxml2::XMLElement* x = (xObs) ? xObs->FirstChildElement(fId) : NULL;
+    obsHash.push_back((x) ? hash(printXml(x)) : string());
+  }
+}
+
+///reads the entries of one journal
+void Journal::load(const std::string &file)
+{
+  ifstream in(file.c_str());
+  string line;
+  while(getline(in, line)){
+    istringstream ls(line);
+    string stamp, output;
+    if(!(ls >> stamp >> output)) continue;
+    stamps.push_back(stamp);
+    outputs.push_back(output);
+  }
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///64 bit FNV-1a hash of s, in hex
+std::string Journal::hash(const std::string &s)
+{
+  unsigned long long h = 14695981039346656037ULL;
+  for(size_t i=0;i<s.size();i++){
+    h ^= (unsigned char) s[i];
+    h *= 1099511628211ULL;
+  }
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016llx", h);
+  return string(buf);
+}
+
+///size and modification time of file, "-" if there is no such file
+std::string Journal::fileStamp(const std::string &file)
+{
+  struct stat st;
+  if(stat(file.c_str(), &st) != 0) return string("-");
+  ostringstream s;
+  s << st.st_size << "." << st.st_mtime;
+  return s.str();
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///the stamp of reducing observation i
+std::string Journal::reduceStamp(int i)
+{
+  string s("reduce ");
+  s.append(paramHash).append(" ").append(obsHash[i]);
+  s.append(" ").append(ap->getFileList(i));
+  s.append(" ").append(fileStamp(ap->getFileList(i)));
+  s.append(" ").append(ap->getBstatList(i));
+  s.append(" ").append(fileStamp(ap->getBstatList(i)));
+  s.append(" ").append(ap->getMapFileList(i));
+  return hash(s);
+}
+
+///the stamp of noise realization k of store storeId
+/** Depends on every observation map as it is now, which is only
+    looked at the first time it is needed.
+**/
+std::string Journal::noiseStamp(double storeId, int k)
+{
+  string c;
+#pragma omp critical (journal)
+  {
+    if(coaddHash.empty()){
+      string s("coadd ");
+      s.append(paramHash);
+      for(int i=0;i<ap->getNFiles();i++){
+	s.append(" ").append(reduceStamp(i));
+	s.append(" ").append(fileStamp(ap->getMapFileList(i)));
+      }
+      coaddHash = hash(s);
+    }
+    c = coaddHash;
+  }
+  ostringstream s;
+  s << "noise " << c << " " << noiseHash << " ";
+  s << setprecision(17) << storeId << " " << k;
+  return hash(s.str());
+}
+
+///the stamp of Wiener filtering noise realization k of store storeId
+std::string Journal::filteredNoiseStamp(double storeId, int k)
+{
+  return hash("filteredNoise " + noiseStamp(storeId, k) + " " + wienerHash);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///whether stamp was done and output is as that work left it
+bool Journal::isDone(const std::string &stamp, const std::string &output)
+{
+  string now = fileStamp(output);
+  if(now == "-") return 0;
+  for(size_t i=0;i<stamps.size();i++)
+    if(stamps[i] == stamp && outputs[i] == now) return 1;
+  return 0;
+}
+
+///whether stamp was done, for work whose output is checked otherwise
+bool Journal::isDone(const std::string &stamp)
+{
+  for(size_t i=0;i<stamps.size();i++)
+    if(stamps[i] == stamp) return 1;
+  return 0;
+}
+
+///appends an entry for finished work, output as it is now
+/** The line is synced to disk before returning.  A journal that
+    can't be written is not fatal, the work is just done again on
+    resume.
+**/
+void Journal::markDone(const std::string &stamp, const std::string &what,
+		       const std::string &output)
+{
+  string line = stamp + " " + ((output.empty()) ? string("-") :
+			       fileStamp(output)) + " " + what + "\n";
+  bool ok;
+#pragma omp critical (journal)
+  {
+    FILE* fp = fopen(journalFile.c_str(), "a");
+    ok = fp && fputs(line.c_str(), fp) >= 0 && fflush(fp) == 0 &&
+      fsync(fileno(fp)) == 0;
+    if(fp) ok = (fclose(fp) == 0) && ok;
+  }
+  if(!ok) cerr << "Journal::markDone(): cannot write " << journalFile << endl;
+}
+
+void Journal::markDone(const std::string &stamp, const std::string &what)
+{
+  markDone(stamp, what, string());
+}
@@ -1,6 +1,9 @@
-#include <gsl/gsl_multifit.h>
 #include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_machine.h>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #include "AzElTemplateCalculator.h"
 
 using namespace std;
@@ -46,63 +49,154 @@ AzElTemplateCalculator::AzElTemplateCalculator(gsl_matrix* data,
 	gsl_matrix_set_all(azelTemplate,0.0);
 }
 
-void AzElTemplateCalculator::calculateTemplate(gsl_vector *corrCoeffs) {
-	gsl_matrix_set_all(azelTemplate,0.0);
+///Samples fitted together in one batch
+#define AZEL_BLOCK_SAMPLES 256
 
-	size_t npars = (size_t) mode;
+///Fills the design matrix of sample i, one row per detector
+void AzElTemplateCalculator::designMatrix(size_t i, gsl_matrix *coordMatrix) {
+	double jaz, jel;
 	size_t ipar = 0;
+	for (size_t j=0; j<nDetectors; j++){
+		ipar = 0;
+		if (!matrixCoords){
+			jaz = gsl_vector_get(azOffsets,j);
+			jel = gsl_vector_get(elOffsets,j);
+		}else{
+			jaz = gsl_matrix_get(azOffMatrix,j,i);
+			jel = gsl_matrix_get (elOffMatrix,j,i);
+		}
 
-	gsl_multifit_linear_workspace *work = gsl_multifit_linear_alloc(nDetectors, npars);
-	gsl_matrix *coordMatrix = gsl_matrix_alloc(nDetectors, npars);
-	gsl_matrix *cov =gsl_matrix_alloc(npars,npars);
-	gsl_vector *tmp = gsl_vector_alloc (nDetectors);;
-	gsl_vector *iData = gsl_vector_alloc(nDetectors);
-	gsl_vector *coeff = gsl_vector_alloc(npars);
-	gsl_vector *fcoeff = gsl_vector_alloc(nDetectors);
-
+		gsl_matrix_set(coordMatrix, j,ipar++, 1.0);
+		if (mode == LINEAR || mode == QUADRATIC){
+			gsl_matrix_set(coordMatrix,j, ipar++, jaz);
+			gsl_matrix_set(coordMatrix,j, ipar++, jel);
+		}
+		if (mode == QUADRATIC){
+			gsl_matrix_set(coordMatrix,j, ipar++, jaz*jaz);
+			gsl_matrix_set(coordMatrix,j, ipar++, jel*jel);
+			gsl_matrix_set(coordMatrix,j, ipar++, jaz*jel);
+		}
+	}
+}
 
+///Weighted pseudo-inverse of the design matrix
+/** pinv = (A^T W A)^-1 A^T W, so the weighted least squares
+    coefficients of any data column d are pinv*d.  As in
+    gsl_multifit_wlinear() negative weights count as zero and the
+    SVD of the column balanced sqrt(W) A is truncated at
+    GSL_DBL_EPSILON relative to its largest singular value.  aw, v,
+    s, d and work are npars sized scratch space.
+**/
+void AzElTemplateCalculator::weightedPinv(const gsl_matrix *coordMatrix, const gsl_vector *weights, gsl_matrix *pinv,
+		gsl_matrix *aw, gsl_matrix *v, gsl_vector *s, gsl_vector *d, gsl_vector *work) {
+	size_t npars = coordMatrix->size2;
+
+	gsl_matrix_memcpy(aw, coordMatrix);
+	for (size_t j=0; j<nDetectors; j++){
+		double wj = gsl_vector_get(weights,j);
+		gsl_vector_view row = gsl_matrix_row(aw,j);
+		gsl_vector_scale(&row.vector, (wj > 0) ? sqrt(wj) : 0.0);
+	}
+	gsl_linalg_balance_columns(aw, d);
+	gsl_linalg_SV_decomp(aw, v, s, work);
+
+	//aw now holds U, scale V by the inverse singular values and balance
+	double sMax = gsl_vector_get(s,0);
+	for (size_t k=0; k<npars; k++){
+		double sk = gsl_vector_get(s,k);
+		gsl_vector_view col = gsl_matrix_column(v,k);
+		gsl_vector_scale(&col.vector, (sk > GSL_DBL_EPSILON*sMax) ? 1.0/sk : 0.0);
+	}
+	for (size_t k=0; k<npars; k++){
+		gsl_vector_view row = gsl_matrix_row(v,k);
+		gsl_vector_scale(&row.vector, 1.0/gsl_vector_get(d,k));
+	}
+	gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, v, aw, 0.0, pinv);
+	for (size_t j=0; j<nDetectors; j++){
+		double wj = gsl_vector_get(weights,j);
+		gsl_vector_view col = gsl_matrix_column(pinv,j);
+		gsl_vector_scale(&col.vector, (wj > 0) ? sqrt(wj) : 0.0);
+	}
+}
 
-	double chisq= 0.0;
-	double jaz, jel;
-	for (size_t i=0; i<nSamples; i++){
-		gsl_vector_set_all(tmp,0.0);
-		gsl_vector_memcpy(fcoeff, corrCoeffs);
-		for (size_t j=0; j<nDetectors; j++){
-			ipar = 0;
-			gsl_vector_set(iData, j, gsl_matrix_get(data,j,i));
-			if (gsl_matrix_get (flags,j,i)==0)
-				gsl_vector_set(fcoeff, j, gsl_vector_get(fcoeff,j)*1e-1);
-			if (!matrixCoords){
-				jaz = gsl_vector_get(azOffsets,j);
-				jel = gsl_vector_get(elOffsets,j);
-			}else{
-				jaz = gsl_matrix_get(azOffMatrix,j,i);
-				jel = gsl_matrix_get (elOffMatrix,j,i);
-			}
+///Fits the az/el template of every sample
+/** Each sample is a weighted least squares fit of the detector values
+    to a polynomial in the detector offsets, weighted by corrCoeffs
+    and by a tenth for flagged samples.  Samples are taken in blocks
+    of AZEL_BLOCK_SAMPLES, in parallel.  With constant offsets the
+    weighted pseudo-inverse is only rebuilt when the flags change, so
+    every run of samples with the same flags is fitted with a single
+    matrix-matrix product.  With per-sample offsets the design matrix,
+    and with it the pseudo-inverse, changes every sample.
+**/
+void AzElTemplateCalculator::calculateTemplate(gsl_vector *corrCoeffs) {
+	gsl_matrix_set_all(azelTemplate,0.0);
 
-			gsl_matrix_set(coordMatrix, j,ipar++, 1.0);
-			if (mode == LINEAR || mode == QUADRATIC){
-				gsl_matrix_set(coordMatrix,j, ipar++, jaz);
-				gsl_matrix_set(coordMatrix,j, ipar++, jel);
-			}
-			if (mode == QUADRATIC){
-				gsl_matrix_set(coordMatrix,j, ipar++, jaz*jaz);
-				gsl_matrix_set(coordMatrix,j, ipar++, jel*jel);
-				gsl_matrix_set(coordMatrix,j, ipar++, jaz*jel);
+	size_t npars = (size_t) mode;
+	size_t nBlocks = (nSamples + AZEL_BLOCK_SAMPLES - 1)/AZEL_BLOCK_SAMPLES;
+
+	#pragma omp parallel shared (corrCoeffs, npars, nBlocks) default (none)
+	{
+		gsl_matrix *coordMatrix = gsl_matrix_alloc(nDetectors, npars);
+		gsl_matrix *pinv = gsl_matrix_alloc(npars, nDetectors);
+		gsl_matrix *aw = gsl_matrix_alloc(nDetectors, npars);
+		gsl_matrix *v = gsl_matrix_alloc(npars, npars);
+		gsl_vector *s = gsl_vector_alloc(npars);
+		gsl_vector *d = gsl_vector_alloc(npars);
+		gsl_vector *work = gsl_vector_alloc(npars);
+		gsl_vector *fcoeff = gsl_vector_alloc(nDetectors);
+		gsl_matrix *coeff = gsl_matrix_alloc(npars, AZEL_BLOCK_SAMPLES);
+
+		if (!matrixCoords)
+			designMatrix(0, coordMatrix);
+
+		#pragma omp for schedule(dynamic)
+		for (size_t b=0; b<nBlocks; b++){
+			size_t i0 = b*AZEL_BLOCK_SAMPLES;
+			size_t i1 = min(i0 + AZEL_BLOCK_SAMPLES, nSamples);
+			size_t i = i0;
+			while (i<i1){
+				//the run of samples sharing this sample's fit
+				size_t iEnd = i+1;
+				if (!matrixCoords)
+					while (iEnd < i1 && sameFlags(i, iEnd))
+						iEnd++;
+				else
+					designMatrix(i, coordMatrix);
+
+				gsl_vector_memcpy(fcoeff, corrCoeffs);
+				for (size_t j=0; j<nDetectors; j++)
+					if (gsl_matrix_get (flags,j,i)==0)
+						gsl_vector_set(fcoeff, j, gsl_vector_get(fcoeff,j)*1e-1);
+				weightedPinv(coordMatrix, fcoeff, pinv, aw, v, s, d, work);
+
+				gsl_matrix_const_view iData = gsl_matrix_const_submatrix(data, 0, i, nDetectors, iEnd-i);
+				gsl_matrix_view iCoeff = gsl_matrix_submatrix(coeff, 0, 0, npars, iEnd-i);
+				gsl_matrix_view iTemplate = gsl_matrix_submatrix(azelTemplate, 0, i, nDetectors, iEnd-i);
+				gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, pinv, &iData.matrix, 0.0, &iCoeff.matrix);
+				gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, coordMatrix, &iCoeff.matrix, 0.0, &iTemplate.matrix);
+				i = iEnd;
 			}
 		}
-		gsl_multifit_wlinear(coordMatrix,fcoeff,iData,coeff, cov, &chisq, work);
-		gsl_blas_dgemv(CblasNoTrans,1.0,coordMatrix,coeff,0.0,tmp);
-		gsl_matrix_set_col(azelTemplate, i,tmp);
 
+		gsl_matrix_free(coordMatrix);
+		gsl_matrix_free(pinv);
+		gsl_matrix_free(aw);
+		gsl_matrix_free(v);
+		gsl_vector_free(s);
+		gsl_vector_free(d);
+		gsl_vector_free(work);
+		gsl_vector_free(fcoeff);
+		gsl_matrix_free(coeff);
 	}
-	gsl_matrix_free(coordMatrix);
-	gsl_matrix_free(cov);
-	gsl_vector_free(tmp);
-	gsl_vector_free(coeff);
-	gsl_vector_free (iData);
-	gsl_multifit_linear_free(work);
+}
 
+///True if samples i and k have the same detectors flagged
+bool AzElTemplateCalculator::sameFlags(size_t i, size_t k) {
+	for (size_t j=0; j<nDetectors; j++)
+		if ((gsl_matrix_get(flags,j,i)==0) != (gsl_matrix_get(flags,j,k)==0))
+			return false;
+	return true;
 }
 
 void AzElTemplateCalculator::setMode (){
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <cmath>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_bspline.h>
+using namespace std;
+
+#include "BsplineBasisCache.h"
+
+//bases kept for reuse once no scan is using them
+#define BSPLINE_CACHE_SIZE 4
+
+///BsplineBasis constructor
+/** Evaluates the uniform-knot basis of the given order on the sample
+    positions 0..nSamples-1 and repeats it for every detector.
+**/
+BsplineBasis::BsplineBasis(int nSamp, int nBrk, int ord, int nDet)
+{
+  nSamples = nSamp;
+  nBreaks = nBrk;
+  order = ord;
+  nDetectors = nDet;
+  users = 0;
+
+  int nSpline = nBreaks + order - 2;
+  long dataLen = (long) nSamples*nDetectors;
+
+  gsl_bspline_workspace *bsw = gsl_bspline_alloc(order, nBreaks);
+  if (bsw == NULL){
+    cerr << "BsplineBasis(): Cannot allocate B-spline working space. ";
+    cerr << "Imploding" << endl;
+    exit(-1);
+  }
+  gsl_bspline_knots_uniform(0.0, (double)(nSamples-1), bsw);
+  gsl_vector *tmpB = gsl_vector_alloc(nSpline);
+
+  cs *tmpbMatrix = cs_spalloc(nSpline, dataLen, 5*nSpline, 1, 1);
+  cs *tmpbMatrix_t = cs_spalloc(dataLen, nSpline, 5*nSpline, 1, 1);
+  for (long i=0; i<nSamples; i++){
+    gsl_bspline_eval((double) i, tmpB, bsw);
+    for (int k=0; k<nSpline; k++){
+      double c_sample = gsl_vector_get(tmpB, k);
+      if (!isfinite(c_sample)){
+        cerr << "Nan detected on BaseMatrix....Imploding" << endl;
+        exit(-1);
+      }
+      if (c_sample == 0)
+        continue;
+      for (long j=0; j<nDetectors; j++){
+        cs_entry(tmpbMatrix, k, j*nSamples + i, c_sample);
+        cs_entry(tmpbMatrix_t, j*nSamples + i, k, c_sample);
+      }
+    }
+  }
+  gsl_vector_free(tmpB);
+  gsl_bspline_free(bsw);
+
+  b = cs_compress(tmpbMatrix_t);
+  bt = cs_compress(tmpbMatrix);
+  cs_spfree(tmpbMatrix_t);
+  cs_spfree(tmpbMatrix);
+  btb = (b && bt) ? cs_multiply(bt, b) : NULL;
+
+  if (!b || !bt || !btb){
+    cerr << "BsplineBasis(): Cannot allocate Bspline base matrix. ";
+    cerr << "Imploding" << endl;
+    exit(-1);
+  }
+}
+
+BsplineBasis::~BsplineBasis()
+{
+  cs_spfree(b);
+  cs_spfree(bt);
+  cs_spfree(btb);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+BsplineBasisCache::BsplineBasisCache()
+{
+  nBuilt = 0;
+}
+
+///returns the basis for this scan shape, building it if needed
+/** The lookup and the build are done in one critical section so two
+    scans of the same shape never build it twice.
+**/
+const BsplineBasis* BsplineBasisCache::get(int nSamples, int nBreaks,
+                                           int order, int nDetectors)
+{
+  BsplineBasis *basis = NULL;
+#pragma omp critical (bsplineBasisCache)
+  {
+    for (size_t i=0; i<bases.size() && !basis; i++)
+      if (bases[i]->nSamples == nSamples && bases[i]->nBreaks == nBreaks &&
+          bases[i]->order == order && bases[i]->nDetectors == nDetectors){
+        basis = bases[i];
+        bases.erase(bases.begin()+i);
+      }
+    if (!basis){
+      basis = new BsplineBasis(nSamples, nBreaks, order, nDetectors);
+      nBuilt++;
+    }
+    basis->users++;
+    bases.insert(bases.begin(), basis);
+    trim();
+  }
+  return basis;
+}
+
+///hands back a basis from get()
+void BsplineBasisCache::release(const BsplineBasis* basis)
+{
+#pragma omp critical (bsplineBasisCache)
+  {
+    for (size_t i=0; i<bases.size(); i++)
+      if (bases[i] == basis) bases[i]->users--;
+    trim();
+  }
+}
+
+///drops the least recent bases beyond BSPLINE_CACHE_SIZE not in use
+void BsplineBasisCache::trim()
+{
+  for (size_t i=bases.size(); i-- > BSPLINE_CACHE_SIZE;)
+    if (bases[i]->users == 0){
+      delete bases[i];
+      bases.erase(bases.begin()+i);
+    }
+}
+
+///number of distinct bases built
+int BsplineBasisCache::size()
+{
+  return nBuilt;
+}
+
+BsplineBasisCache::~BsplineBasisCache()
+{
+  for (size_t i=0; i<bases.size(); i++)
+    delete bases[i];
+}
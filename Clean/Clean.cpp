@@ -1,3 +1,7 @@
+#include <iostream>
+#include <omp.h>
+using namespace std;
+
 #include "Clean.h"
 
 
@@ -9,4 +13,59 @@ Clean::Clean(Array *dataArray, Telescope *telescope){
   if (this->dataArray != NULL){
     this->ap=dataArray->getAp();
   }
-}
\ No newline at end of file
+}
+
+///true if the cleaner implements cleanScan()
+bool Clean::scanWise(){
+  return false;
+}
+
+///called once before the scans are cleaned with cleanScan()
+void Clean::beginScans(int nScans){
+  (void) nScans;
+}
+
+///cleans one scan in place, only for scanWise() cleaners
+bool Clean::cleanScan(ScanBlock &block){
+  (void) block;
+  cerr << "Clean::cleanScan(): this cleaner only works on the whole array";
+  cerr << endl;
+  exit(1);
+}
+
+///called once after all of the scans are cleaned with cleanScan()
+void Clean::endScans(){
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///runs scan-wise stages over all scans, in parallel
+/** Each scan is gathered into a ScanBlock once, cleaned in place by
+    every stage in order and scattered back once.
+**/
+bool Clean::runScans(Array *dataArray, Telescope *telescope,
+                     Clean **stages, int nStages){
+  int nScans = telescope->scanIndex.ncols();
+  bool ok = true;
+
+  for(int s=0;s<nStages;s++) stages[s]->beginScans(nScans);
+
+#pragma omp parallel for schedule(dynamic)
+  for(int k=0;k<nScans;k++){
+    ScanBlock block;
+    block.gather(dataArray, telescope, k);
+    bool scanOk = true;
+    for(int s=0;s<nStages && scanOk;s++)
+      scanOk = stages[s]->cleanScan(block);
+    block.scatter(dataArray);
+    if(!scanOk){
+#pragma omp critical (runScansError)
+      ok = false;
+    }
+  }
+
+  for(int s=0;s<nStages;s++) stages[s]->endScans();
+  return ok;
+}
@@ -11,6 +11,7 @@
 #include <gsl/gsl_spline.h>
 
 #include <unistd.h>
+#include <algorithm>
 
 #include "Clean2dStripe.h"
 #include "Map.h"
@@ -23,86 +24,17 @@ Clean2dStripe::Clean2dStripe(Map *cmap){
 }
 
 
-bool Clean2dStripe::fastRemoveStripe(int cellSize, double coverage){
-	if (cellSize <= 1){
-			cerr<<"Clean2dStripe::removeStripe(): Error. Cell size is less than 1. Skipping Map cleaning"<<endl;
-			return false;
-		}
+///Columns of the map fitted together in the x direction
+#define STRIPE_STRIP_COLUMNS 64
 
-		if (coverage <= 0.0){
-			coverage = 0.0;
-		}
-
-		if (coverage >= 0.7){
-			cerr<<"Clean2dStripe::removeStripe(): Error. Cell coverage larger than 0.7. Clipping to 0.7"<<endl;
-			coverage = 0.7;
-		}
-		size_t nx = this->map->getNrows();
-		size_t ny = this->map->getNcols();
-		size_t ntot = nx * ny;
-
-		double **map2fit = new double *[nx];
-		double *weights = new double  [ntot];
-		double *xfit = new double [ntot];
-		double *x2fit = new double [nx];
-		double *yfit = new double [ntot];
-		double *fit = new double [ntot];
-
-
-
-		for (size_t ix = 0; ix < nx; ix++){
-			x2fit[ix] = this->map->getRowCoordsPhys(ix);
-			map2fit[ix]= new double [ny];
-			for (size_t iy = 0; iy < ny; iy++){
-				map2fit[ix][iy] = this->map->image[ix][iy];
-				weights[ix*ny+iy] = this->map->weight[ix][iy];
-				xfit [ix*ny+iy] = this->map->getRowCoordsPhys(ix);
-				yfit [ix*ny+iy] = this->map->getColCoordsPhys(iy);
-			}
-		}
-
-		double pcut = 1e100;
-		size_t pixelCut=0;
-		if (coverage > 0.0){
-			pcut = coverage*percentile(weights, nx*ny,0.95);
-			for (size_t ix=0; ix <nx; ix++)
-				for (size_t iy=0; iy<ny; iy++){
-					if (weights[ix*ny+iy]<pcut){
-						map2fit[ix][iy] = 0.0;
-						pixelCut++;
-					}
-				}
-			cerr<<"Cleand2dStripe(): Cut threshold set on "<<pcut<< " number of pixel set to zero: "<<pixelCut<<endl;
-		}
-		size_t tCell= size_t(cellSize);
-		Spline2d *myspline2d  = new Spline2d(x2fit,nx,yfit,ny,map2fit,tCell, tCell,4);
-		//Spline2dInterp *myspline2d  = new Spline2dInterp(x2fit,nx,yfit,ny,map2fit,tCell, tCell);
-		cout<<"Cleand2dStripe(): 2D-spline interpolator created"<<endl;
-
-		myspline2d->interpolate(xfit,yfit,ntot,fit);
-
-		for (size_t ix = 0; ix < nx; ix++)
-			for (size_t iy = 0; iy < ny; iy++)
-				this->map->image[ix][iy]-=fit[ix*ny+iy];
-
-		delete myspline2d;
-
-		for (size_t ix=0; ix <nx; ix++)
-			delete [] map2fit[ix];
-		delete [] map2fit;
-		delete [] fit;
-		delete [] x2fit;
-		delete [] yfit;
-		delete [] xfit;
-		delete [] weights;
-		return true;
+///Same as removeStripe(), kept for the callers of the old point-wise version
+bool Clean2dStripe::fastRemoveStripe(int cellSize, double coverage){
+	return this->removeStripe(cellSize, coverage);
 }
 
 
 bool Clean2dStripe::removeStripe(int cellSize, double coverage){
 
-	bool debug = false;
-
 	if (cellSize <= 1){
 		cerr<<"Clean2dStripe::removeStripe(): Error. Cell size is less than 1. Skipping Map cleaning"<<endl;
 		return false;
@@ -119,148 +51,67 @@ bool Clean2dStripe::removeStripe(int cellSize, double coverage){
 	size_t nx = this->map->getNrows();
 	size_t ny = this->map->getNcols();
 
-	double **map2fit = new double * [nx];
-	//double mapOut [2+nx*ny];
-	double *fit  = new double [2+nx*ny];
-	if (!fit){
-		cerr<<"Fatal. Not enough memory to compute 2D stripe removal"<<endl;
-				exit(-1);
-	}
-	double *weights  = new double [nx*ny];
-	if (!weights){
-		cerr<<"Fatal. Not enough memory to compute 2D stripe removal"<<endl;
-						exit(-1);
-	}
-	double *x2fit = new double [nx];
-	if (x2fit ==NULL){
-		cerr<<"Fatal. Not enough memory to compute 2D stripe removal"<<endl;
-		exit(-1);
-	}
-	double *y2fit = new double [ny];
-	if (y2fit == NULL){
-		cerr<<"Fatal. Not enough memory to compute 2D stripe removal"<<endl;
-		exit(-1);
-	}
+	MatDoub map2fit(nx, ny);
+	VecDoub x2fit(nx);
+	VecDoub y2fit(ny);
 
 	//Copy values
 	for (size_t ix=0; ix <nx; ix++)
 		x2fit[ix] = this->map->getRowCoordsPhys(ix);
 	for (size_t iy=0; iy<ny; iy++)
 		y2fit[iy] = this->map->getColCoordsPhys(iy);
-	for (size_t ix=0; ix <nx; ix++){
-		map2fit[ix]= new double [ny];
-		for (size_t iy=0; iy<ny; iy++){
-			map2fit[ix][iy] = this->map->image[ix][iy];
-			weights[ix*ny+iy] = this->map->weight[ix][iy];
-		}
-	}
 
-	double pcut = 1e100;
+	double pcut = -1e100;
 	size_t pixelCut=0;
-	if (coverage > 0.0){
-		pcut = coverage*percentile(weights, nx*ny,0.95);
-		for (size_t ix=0; ix <nx; ix++)
-				for (size_t iy=0; iy<ny; iy++){
-					if (weights[ix*ny+iy]<pcut){
-						map2fit[ix][iy] = 0.0;
-						pixelCut++;
-
-					}
-					//mapOut[2+ix*ny+iy]= map2fit[ix][iy];
-				}
-	}
-//	fit[0]=mapOut[0]= nx;
-//	fit[1]=mapOut[1]=ny;
-//
-//	writeVecOut("Map2fit_fs.txt", mapOut, 2+nx*ny);
+	if (coverage > 0.0)
+		pcut = coverage*percentile(&this->map->weight[0][0], nx*ny,0.95);
+	for (size_t ix=0; ix <nx; ix++)
+		for (size_t iy=0; iy<ny; iy++){
+			if (this->map->weight[ix][iy]<pcut){
+				map2fit[ix][iy] = 0.0;
+				pixelCut++;
+			}else
+				map2fit[ix][iy] = this->map->image[ix][iy];
+		}
 	cerr<<"Cleand2dStripe(): Cut threshold set on "<<pcut<< " number of pixel set to zero: "<<pixelCut<<endl;
 
 	size_t tCell= size_t(cellSize);
-	//Spline2dInterp *myspline2d  = new Spline2dInterp(x2fit,nx,y2fit,ny,map2fit,tCell, tCell);
-	Spline2d *myspline2d  = new Spline2d(x2fit,nx,y2fit,ny,map2fit,tCell, tCell,4);
+	Spline2d myspline2d (&x2fit[0],nx,&y2fit[0],ny,map2fit,tCell, tCell,4);
 	cout<<"Cleand2dStripe(): 2D-spline interpolator created"<<endl;
-	for (size_t ix=0; ix <nx; ix++){
-		for (size_t iy=0; iy<ny; iy++){
-			fit[2+ix*ny+iy]= myspline2d->interpolate_single(this->map->getRowCoordsPhys(ix),this->map->getColCoordsPhys(iy));
-			this->map->image[ix][iy]-=fit[2+ix*ny+iy];
-		}
-	}
-
-
-
-	if (debug)
-		writeVecOut("Fit_fs.txt", fit, 2+nx*ny);
-	delete myspline2d;
 
+	//map2fit is no longer needed, reuse it for the fit
+	myspline2d.interpolateGrid(&x2fit[0], nx, &y2fit[0], ny, map2fit);
 	for (size_t ix=0; ix <nx; ix++)
-		delete [] map2fit[ix];
-	delete [] map2fit;
-	delete [] fit;
-	delete [] x2fit;
-	delete [] y2fit;
-	delete [] weights;
+		for (size_t iy=0; iy<ny; iy++)
+			this->map->image[ix][iy]-=map2fit[ix][iy];
+
 	return true;
 }
 
 
-Spline2d::Spline2d(double *x, size_t nx, double *y, size_t ny, double **map, size_t px, size_t py){
-	this->x = x;
-	this->y = y;
-	this->map = map;
-	this->nx = nx;
-	this->ny = ny;
-
-	this->order = 4;
-	this->px = px;
-	this->py = py;
-
-	this->downsample = 1;
-	this->dx = 1;
-	this->dy = 1;
-
-	this->nSplinex = this->px +order -2;
-	this->nSpliney = this->py + order -2;
-
-	this->bswx = gsl_bspline_alloc(order, this->px);
-	gsl_bspline_knots_uniform(this->x[0], this->x[this->nx-1] , this->bswx);
-	this->bswy = gsl_bspline_alloc(order, this->py);
-	gsl_bspline_knots_uniform(this->y[0], this->y[this->ny-1] , this->bswy);
-
-	this->coeff = NULL;
-	this->baseMatrix_x = NULL;
-	this->baseMatrix_t_x = NULL;
-	this->baseMatrix_y = NULL;
-	this->baseMatrix_t_y = NULL;
-
-	this->createBaseMatrix(bswx,this->x, &(this->baseMatrix_x), &(this->baseMatrix_t_x), this->nSplinex, this->nx);
-	this->createBaseMatrix(bswy, this->y, &(this->baseMatrix_y), &(this->baseMatrix_t_y), this->nSpliney, this->ny);
-
-	this->createCoeffs();
+Spline2d::Spline2d(double *x, size_t nx, double *y, size_t ny, const MatDoub &map, size_t px, size_t py) :
+	Spline2d(x, nx, y, ny, map, px, py, 1){
 }
 
-Spline2d::Spline2d(double *x, size_t nx, double *y, size_t ny, double **map, size_t px, size_t py, size_t downsample){
+Spline2d::Spline2d(double *x, size_t nx, double *y, size_t ny, const MatDoub &map, size_t px, size_t py, size_t downsample){
 	this->nx = ceil(nx/downsample);
 	this->ny = ceil (ny/downsample);
-	this->dx = double(nx-1)/double(this->nx-1);
-	this->dy = double(ny-1)/double(this->ny-1);
+	this->dx = (this->nx > 1) ? double(nx-1)/double(this->nx-1) : 1.0;
+	this->dy = (this->ny > 1) ? double(ny-1)/double(this->ny-1) : 1.0;
 
-	//this->x = x;
-	this->x =  new double [this->nx];
-	this->y = new double[this->ny];
-	this->map = new double *[this->nx];
+	this->x.resize(this->nx);
+	this->y.resize(this->ny);
+	this->surface.resize(this->nx, this->ny);
 
-	for (size_t i=0; i<this->nx; i++){
+	for (size_t i=0; i<this->nx; i++)
 		this->x[i]= x[size_t(round(i*dx))];
-		this->map[i] = new double [ny];
-	}
 	for (size_t i=0; i<this->ny; i++)
 		this->y[i] = y[size_t(round(i*dy))];
 
 	for (size_t i=0; i<this->nx; i++)
 		for (size_t j=0; j<this->ny; j++)
-			this->map[i][j]= map[size_t(round(i*dx))][size_t(round(j*dy))];
+			this->surface[i][j]= map[size_t(round(i*dx))][size_t(round(j*dy))];
 
-	//this->map = map;
 	this->order = 4;
 	this->px = px;
 	this->py = py;
@@ -268,178 +119,161 @@ Spline2d::Spline2d(double *x, size_t nx, double *y, size_t ny, double **map, siz
 	this->nSplinex = this->px +order -2;
 	this->nSpliney = this->py + order -2;
 
-	this->bswx = gsl_bspline_alloc(order, this->px);
-	gsl_bspline_knots_uniform(this->x[0], this->x[this->nx-1] , this->bswx);
-	this->bswy = gsl_bspline_alloc(order, this->py);
-	gsl_bspline_knots_uniform(this->y[0], this->y[this->ny-1] , this->bswy);
+	this->createBasis(this->x, this->px, this->nSplinex, this->firstx, this->basisx, this->gramx);
+	this->createBasis(this->y, this->py, this->nSpliney, this->firsty, this->basisy, this->gramy);
 
-	this->coeff = NULL;
-	this->baseMatrix_x = NULL;
-	this->baseMatrix_t_x = NULL;
-	this->baseMatrix_y = NULL;
-	this->baseMatrix_t_y = NULL;
+	this->fitRows();
+	this->fitColumns();
+}
 
-	this->createBaseMatrix(bswx,this->x, &(this->baseMatrix_x), &(this->baseMatrix_t_x), this->nSplinex, this->nx);
-	this->createBaseMatrix(bswy, this->y, &(this->baseMatrix_y), &(this->baseMatrix_t_y), this->nSpliney, this->ny);
+///Evaluates the basis on the grid and factors its normal matrix
+/** For every grid point only the order splines starting at first[i]
+    are stored, the rest are zero.  gram is B B^T, banded with order-1
+    subdiagonals.
+**/
+void Spline2d::createBasis(const VecDoub &time, size_t nBreaks, size_t nSpline, VecInt &first, VecDoub &basis, BandedCholesky &gram){
+
+	size_t nData = time.size();
+	gsl_bspline_workspace *bsw = gsl_bspline_alloc(order, nBreaks);
+	gsl_bspline_knots_uniform(time[0], time[nData-1], bsw);
+	gsl_vector  *btdata = gsl_vector_alloc(nSpline);
+
+	first.resize(nData);
+	basis.assign(nData*order, 0.0);
+	gram.resize(nSpline, order-1);
+	for (size_t i=0; i<nData; i++){
+		gsl_bspline_eval(time[i], btdata, bsw);
+		size_t kstart = 0;
+		while (kstart < nSpline-1 && gsl_vector_get(btdata, kstart) <= 0.0)
+			kstart++;
+		kstart = min(kstart, nSpline-order);
+		first[i] = kstart;
+		for (int k=0; k<order; k++)
+			basis[i*order+k] = gsl_vector_get(btdata, kstart+k);
+		for (int k=0; k<order; k++)
+			for (int l=0; l<=k; l++)
+				gram.add(kstart+k, kstart+l, basis[i*order+k]*basis[i*order+l]);
+	}
+	gsl_vector_free(btdata);
+	gsl_bspline_free(bsw);
 
-	this->createCoeffs();
+	if (!gram.factor()){
+		cerr<<"Cleand2dStripe():: Unable to find coefficients, singular spline system"<<endl;
+		exit(-1);
+	}
 }
 
-void Spline2d::createBaseMatrix(gsl_bspline_workspace *bsw,double *time,cs **bMatrix, cs **bMatrix_t, size_t nSpline, size_t nData){
-
-	  gsl_vector  *btdata = gsl_vector_alloc(nSpline);
-	  long kstart =0;
-	  long kend = 0;
-	  double c_sample = 0;
-	  double tol = 0.0;
-	  cs *tmpbMatrix = cs_spalloc(nSpline, nData, 5*nSpline,1,1);
-	  cs *tmpbMatrix_t = cs_spalloc(nData, nSpline,5*nSpline,1,1);
-
-
-	  for (size_t i=0; i<nData; i++){
-	    gsl_bspline_eval(time[i], btdata, bsw);
-	    kstart = -1;
-	    kend = -1;
-	    for (size_t k=0; k<nSpline; k++){
-	      c_sample = gsl_vector_get(btdata, k);
-	      if (kstart == -1 && c_sample > tol){
-	    	  kstart = k;
-	    	  continue;
-	      }
-	      if (kend ==-1 && kstart > -1 &&  c_sample <=tol )
-	    	  kend = k;
-	    }
-	    if (kend == -1 && kstart != -1)
-	       kend = nSpline;
-	    for (long k=kstart; k<kend; k++){
-	      c_sample = gsl_vector_get(btdata, k);
-	      cs_entry(tmpbMatrix, k, i , c_sample);
-	      cs_entry(tmpbMatrix_t, i , k , c_sample);
-	    }
-	  }
-	  (*bMatrix) = cs_compress(tmpbMatrix);
-	  (*bMatrix_t) = cs_compress (tmpbMatrix_t);
-
-	  cs_spfree(tmpbMatrix);
-	  cs_spfree(tmpbMatrix_t);
-	  gsl_vector_free(btdata);
+///Replaces every row of the surface by its spline fit along y
+void Spline2d::fitRows(){
+
+	#pragma omp parallel
+	{
+		VecDoub coeff(nSpliney);
+		#pragma omp for schedule(static)
+		for (size_t i=0; i<nx; i++){
+			double *row = surface[i];
+			for (size_t k=0; k<nSpliney; k++)
+				coeff[k] = 0.0;
+			for (size_t j=0; j<ny; j++)
+				for (int k=0; k<order; k++)
+					coeff[firsty[j]+k] += basisy[j*order+k]*row[j];
+			gramy.solve(&coeff[0]);
+			for (size_t j=0; j<ny; j++){
+				double v = 0.0;
+				for (int k=0; k<order; k++)
+					v += basisy[j*order+k]*coeff[firsty[j]+k];
+				row[j] = v;
+			}
+		}
+	}
 }
 
-
-void Spline2d::create1DCoeffs(double *data, size_t nData, cs *bMatrix, cs *btbMatrix, size_t nSpline, double *coeffOut){
-
-    (void) nData;
-	for (size_t j=0; j<nSpline; j++)
-			coeffOut[j]=0.0;
-
-	cs_gaxpy (bMatrix,data,coeffOut);
-	if (!cs_qrsol(3, btbMatrix, coeffOut)){
-			cerr<<"Cleand2dStripe():: Unable to find coefficient for row"<<endl;
-			exit(-1);
+///Replaces every column of the surface by its spline fit along x
+/** Columns are fitted STRIPE_STRIP_COLUMNS at a time as a multiple
+    right hand side solve, so all the loops run along the rows.
+**/
+void Spline2d::fitColumns(){
+
+	size_t nStrips = (ny + STRIPE_STRIP_COLUMNS - 1)/STRIPE_STRIP_COLUMNS;
+
+	#pragma omp parallel
+	{
+		VecDoub coeff(nSplinex*STRIPE_STRIP_COLUMNS);
+		#pragma omp for schedule(dynamic)
+		for (size_t s=0; s<nStrips; s++){
+			size_t j0 = s*STRIPE_STRIP_COLUMNS;
+			size_t w = min(ny, j0+STRIPE_STRIP_COLUMNS) - j0;
+			for (size_t k=0; k<nSplinex*w; k++)
+				coeff[k] = 0.0;
+			for (size_t i=0; i<nx; i++){
+				const double *row = &surface[i][j0];
+				for (int k=0; k<order; k++){
+					double b = basisx[i*order+k];
+					double *c = &coeff[(firstx[i]+k)*w];
+					for (size_t j=0; j<w; j++)
+						c[j] += b*row[j];
+				}
+			}
+			gramx.solve(&coeff[0], w, w);
+			for (size_t i=0; i<nx; i++){
+				double *row = &surface[i][j0];
+				for (size_t j=0; j<w; j++)
+					row[j] = 0.0;
+				for (int k=0; k<order; k++){
+					double b = basisx[i*order+k];
+					const double *c = &coeff[(firstx[i]+k)*w];
+					for (size_t j=0; j<w; j++)
+						row[j] += b*c[j];
+				}
+			}
+		}
 	}
-
-//	for (size_t j=0; j<nSpline;j++)
-//		cerr<<coeffOut[j]<<",";
-//	cerr<<endl;
+	cerr<<"Spline2d::fitColumns(). 2D spline fit done"<<endl;
 }
 
-void Spline2d::createCoeffs(){
-
-	this->coeff = new double* [this->nx];
-
 
-	cs *btbMatrix = cs_multiply(this->baseMatrix_y, this->baseMatrix_t_y);
+//----------------------------- o ---------------------------------------
 
-	//double *downMap = new double [this->ny];
 
-	for (size_t i=0; i<this->nx; i++){
-		this->coeff[i]= new double [this->nSpliney];
-//		for (size_t j=0; j<this->ny; j++){
-//			downMap[j] = this->map[int(round(i*dx))][int(round(j*dy))];
-//		}
-		this->create1DCoeffs(this->map[i], this->ny, this->baseMatrix_y, btbMatrix, this->nSpliney, this->coeff[i]);
-//		for (size_t j=0; j<this->nSpliney; j++)
-//			cerr<<this->coeff[i][j]<<",";
-//		cerr<<endl;
+///Grid row at or below xi
+size_t Spline2d::gridRow(double xi){
+	double xpos = (xi-this->x[0])*(this->nx-1)/(this->x[this->nx-1]-this->x[0]);
+	return size_t(max(0.0, min(floor(xpos), double(this->nx-1))));
+}
 
-	}
-//	cin >> a;
-	cs_spfree(btbMatrix);
-	//delete []downMap;
-	cerr<<"Spline2d::createCoeffs(). 1D Coefficients created"<<endl;
+///Grid column at or below yi
+size_t Spline2d::gridCol(double yi){
+	double ypos = (yi-this->y[0])*(this->ny-1)/(this->y[this->ny-1]-this->y[0]);
+	return size_t(max(0.0, min(floor(ypos), double(this->ny-1))));
 }
 
 void Spline2d::interpolate(double *xi, double *yi, size_t nData, double *dataOut){
+	for (size_t i =0; i<nData; i++)
+		dataOut[i] = surface[gridRow(xi[i])][gridCol(yi[i])];
+}
 
-	double *iSplinex = new double [this->ny];
-	double *jValuesx = new double [this->nx];
-	double *coeffx = new double [this->nSplinex];
-	double *cEval = new double  [this->nx];
-	cs *btbMatrix = NULL;
-
-	double xpos=0;
-	double ypos=0;
-	size_t fpox=0;
-	size_t cpox=0;
-	size_t fpoy=0;
-	size_t cpoy=0;
-
-	btbMatrix = cs_multiply(this->baseMatrix_x, this->baseMatrix_t_x);
-	for (size_t i =0; i<nData; i++){
-		xpos = (xi[i]-this->x[0])*(this->nx-1)/(this->x[this->nx-1]-this->x[0]);
-		fpox = floor(xpos);
-		cpox = fpox+1;
-		ypos = (yi[i]-this->y[0])*(this->ny-1)/(this->y[this->ny-1]-this->y[0]);
-		fpoy = floor(ypos);
-		cpoy = fpoy +1;
-		for (size_t k=0; k<this->nx; k++){
-			for (size_t j=0; j<this->ny; j++)
-				iSplinex[j]=0.0;
-			cs_gaxpy(this->baseMatrix_t_y, this->coeff[k], iSplinex);
-			jValuesx[k]= iSplinex[fpoy];
-
-		}
-//		cerr<<"i"<<i<<" x:"<<xi[i]<<" y: "<< y[i]<< " px,py:"<< fpox <<","<<fpoy<<endl;
-		this->create1DCoeffs(jValuesx,this->nx,this->baseMatrix_x, btbMatrix, this->nSplinex, coeffx);
-//		for (size_t ixx = 0; ixx< this->nSplinex; ixx++)
-//			cerr<<coeffx[ixx]<<",";
-//		cerr<<endl;
-//		sleep(1);
-
-		for (size_t k=0; k<this->nx; k++)
-			cEval[k]=0.0;
-		cs_gaxpy(this->baseMatrix_t_x, coeffx, cEval);
-		dataOut[i]= cEval[fpox];
+///Evaluates the fit on the nxi x nyi grid of rows xi and columns yi
+void Spline2d::interpolateGrid(double *xi, size_t nxi, double *yi, size_t nyi, MatDoub &dataOut){
+	VecInt cols(nyi);
+	for (size_t j=0; j<nyi; j++)
+		cols[j] = gridCol(yi[j]);
+	dataOut.resize(nxi, nyi);
+
+	#pragma omp parallel for schedule(static)
+	for (size_t i=0; i<nxi; i++){
+		const double *row = surface[gridRow(xi[i])];
+		double *out = dataOut[i];
+		for (size_t j=0; j<nyi; j++)
+			out[j] = row[cols[j]];
 	}
-	cs_spfree(btbMatrix);
 }
 
 double Spline2d::interpolate_single(double xi, double yi){
 	double result;
 	this->interpolate(&xi,&yi,1,&result);
-//	for (size_t i=0; i< this->nx; i++){
-//		for (size_t j=0; j< this->nSpliney; j++)
-//			cerr <<coeff[i][j]<<",";
-//		cerr<<endl;
-//	}
 	return result;
 }
 
-Spline2d::~Spline2d(){
-	cs_spfree(this->baseMatrix_x);
-	cs_spfree(this->baseMatrix_t_x);
-	cs_spfree(this->baseMatrix_y);
-	cs_spfree(this->baseMatrix_t_y);
-
-	for  (size_t i=0; i<this->nx; i++)
-		delete [] this->coeff[i];
-
-	delete [] coeff;
-
-	gsl_bspline_free(this->bswx);
-	gsl_bspline_free(this->bswy);
-}
-
 
 Spline2dInterp::Spline2dInterp(double *x, size_t nx, double *y, size_t ny, double **map, size_t px, size_t py){
 	this->npx = px +1;
@@ -481,20 +315,20 @@ Spline2dInterp::Spline2dInterp(double *x, size_t nx, double *y, size_t ny, doubl
 }
 
 void Spline2dInterp::interpolate(double *xi, double *yi, size_t nData, double *dataOut){
-	gsl_spline *splinex= NULL;
-	gsl_interp_accel *accelx = NULL;
-	double xp [this->npx];
+	//one spline across the rows, re-initialized for every point
+	gsl_spline *splinex= gsl_spline_alloc(gsl_interp_cspline, this->npx);
+	gsl_interp_accel *accelx = gsl_interp_accel_alloc();
+	VecDoub xp (this->npx);
 	for (size_t i=0; i<nData; i++){
 		for (size_t j=0; j<this->npx; j++){
 			xp[j]= gsl_spline_eval(this->splineArray[j], yi[i],this->accArray[j]);
 		}
-		splinex = gsl_spline_alloc(gsl_interp_cspline, this->npx);
-		gsl_spline_init(splinex,this->x, xp, this->npx);
-		accelx = gsl_interp_accel_alloc();
+		gsl_spline_init(splinex,this->x, &xp[0], this->npx);
+		gsl_interp_accel_reset(accelx);
 		dataOut[i]=gsl_spline_eval(splinex, xi[i], accelx);
-		gsl_spline_free(splinex);
-		gsl_interp_accel_free(accelx);
 	}
+	gsl_spline_free(splinex);
+	gsl_interp_accel_free(accelx);
 
 }
 
@@ -32,12 +32,6 @@ using namespace std;
 
 CleanBspline::CleanBspline(Array* dataArray, Telescope* tel) :
   Clean(dataArray,tel){
-  baseMatrix = NULL;
-  baseMatrix_t = NULL;
-  bsw = NULL;
-  time = NULL;
-  baseMatrixSamples=0;
-  baseMatrixDetectors=0;
   calibrated = 0;
   detPerHextant=NULL;
   nDetPerHextant.resize(0);
@@ -65,6 +59,10 @@ CleanBspline::CleanBspline(Array* dataArray, Telescope* tel) :
 
 }
 
+Clean* CleanBspline::create(Array *dataArray, Telescope *telescope){
+  return new CleanBspline(dataArray, telescope);
+}
+
 
 void CleanBspline::removeBadBolos(){
 
@@ -76,8 +74,9 @@ void CleanBspline::removeBadBolos(){
 	VecDoub avg (totSamples,0.0);
 	VecDoub detMean (nDetectors);
 	VecInt count(totSamples, 0.0);
+	VecDoub scratch;
 	for (size_t i=0; i<nDetectors; i++){
-		detMean[i] = mean(&dataArray->detectors[di[i]].hValues[0], &dataArray->detectors[di[i]].hSampleFlags[0], totSamples);
+		detMean[i] = mean(&asDoubles(dataArray->detectors[di[i]].hValues, scratch)[0], &dataArray->detectors[di[i]].hSampleFlags[0], totSamples);
 		for (size_t j=0; j<totSamples; j++){
 			if (dataArray->detectors[di[i]].hSampleFlags[j]){
 				avg[j]+=(dataArray->detectors[di[i]].hValues[j]-detMean[i]);
@@ -181,6 +180,15 @@ bool CleanBspline::cleanScans (){
 
 	cout<<"CleanBspline("<<tid<<")::clean(). Starting cleaning for "<< nDetectors<< "bolometers. This could take some time...."<<endl;
 
+	scanSetupTime.assign(nScans, 0.0);
+	scanSolveTime.assign(nScans, 0.0);
+	scanSystemNnz.assign(nScans, 0);
+	scanFactorNnz.assign(nScans, 0);
+
+	//Scans are independent: each one has its own data, pointing and
+	//spline system and only writes its own range of the template, the
+	//shared bases come from the cache
+#pragma omp parallel for schedule(dynamic)
 	for (size_t k =0; k<nScans; k++){
 		size_t ei = telescope->scanIndex[1][k]+1;
 		size_t si = telescope->scanIndex[0][k];
@@ -242,7 +250,7 @@ bool CleanBspline::cleanScans (){
 		}
 
 		if (fixFlags(dataVector,flags,(int)nDetectors,(int)nSamples)){
-			atmTemplate = cottingham(dataVector, raVector, decVector, flags, nDetectors, nSamples, cleanPixelSize, 0);
+			atmTemplate = cottingham(dataVector, raVector, decVector, flags, nDetectors, nSamples, cleanPixelSize, 0, k);
 
 			if (!atmTemplate){
 				cout<<"CleanBspline("<<tid<<")::cleanScans(). Failed to produce and atmosphere template. Setting scan to 0.0"<<endl;
@@ -285,12 +293,34 @@ bool CleanBspline::cleanScans (){
 		gsl_vector_free(decVector);
 		}
 
-
+	this->reportSolves();
 
 	return true;
 
 }
 
+
+///Reports the time and fill-in of the spline system solve of each scan
+/** Setup is the pointing and projection products, solve the QR
+    factorization and back substitution.  Fill-in is the ratio of the
+    nonzeros of the QR factors to those of the system.
+**/
+void CleanBspline::reportSolves(){
+	double setup = 0.0;
+	double solve = 0.0;
+	for (size_t k=0; k<scanSolveTime.size(); k++){
+		cout<<"CleanBspline("<<tid<<")::cleanScans(). Scan "<<k<<": setup "<<scanSetupTime[k]<<" s, solve "<<scanSolveTime[k]<<" s, ";
+		cout<<"system nnz "<<scanSystemNnz[k]<<", factor nnz "<<scanFactorNnz[k];
+		if (scanSystemNnz[k] > 0)
+			cout<<" (fill-in "<<double(scanFactorNnz[k])/scanSystemNnz[k]<<")";
+		cout<<endl;
+		setup += scanSetupTime[k];
+		solve += scanSolveTime[k];
+	}
+	cout<<"CleanBspline("<<tid<<")::cleanScans(). "<<bases.size()<<" B-spline bases for "<<scanSolveTime.size()<<" scans, ";
+	cout<<"total setup "<<setup<<" s, total solve "<<solve<<" s"<<endl;
+}
+
 CleanBsplineDestriping CleanBspline::translateStripeMethod(){
 
 	if (ap->stripeMethod =="fft")
@@ -307,7 +337,7 @@ CleanBsplineDestriping CleanBspline::translateStripeMethod(){
 	return STRIPE_NONE;
 }
 
-double * CleanBspline::cottingham(double *dataVector, gsl_vector *raVector, gsl_vector *decVector, bool *flags, size_t nDetectors, size_t nSamples, double cleanPixelSize, int refBolo){
+double * CleanBspline::cottingham(double *dataVector, gsl_vector *raVector, gsl_vector *decVector, bool *flags, size_t nDetectors, size_t nSamples, double cleanPixelSize, int refBolo, int scan){
 
 	size_t dataLen = nDetectors*nSamples;
 	cs *ptMatrix = NULL;
@@ -319,7 +349,6 @@ double * CleanBspline::cottingham(double *dataVector, gsl_vector *raVector, gsl_
 	cs *a1 =NULL;
 	cs *a2 = NULL;
 	cs *a3 =NULL;
-	cs *bMatrix = NULL;
 	//Temporary vector for data side
 	double *v1 = NULL;
 	double *v2 = NULL;
@@ -380,8 +409,11 @@ double * CleanBspline::cottingham(double *dataVector, gsl_vector *raVector, gsl_
 
 
 
-	this->createBaseMatrix(nSamples, nDetectors);
-	nSp = this->baseMatrix->n;
+	double tStart = omp_get_wtime();
+	const BsplineBasis *basis = this->getBaseMatrix(nSamples, nDetectors);
+	const cs *baseMatrix = basis->b;
+	const cs *baseMatrix_t = basis->bt;
+	nSp = baseMatrix->n;
 	pMatrix = this->getPMatrix(raVector, decVector, cleanPixelSize);
 	nP = pMatrix->n;
 
@@ -420,17 +452,12 @@ double * CleanBspline::cottingham(double *dataVector, gsl_vector *raVector, gsl_
 	if (!a2){
 		cerr<<"a2 matrix error"<<endl;
 	}
-	bMatrix = cs_multiply(baseMatrix_t, baseMatrix);
-	if (!bMatrix){
-		cerr<<"bMatrix creation matrix error"<<endl;
-		exit(-1);
-	}
 	a3 = cs_multiply(a1,a2);
 	if (!a3){
 		cerr<<"a3 creation matrix error"<<endl;
 		exit(-1);
 	}
-	phi = cs_add(bMatrix, a3, 1.0, -1.0);
+	phi = cs_add(basis->btb, a3, 1.0, -1.0);
 	if (!phi){
 		cerr<<"phi creation matrix error"<<endl;
 		exit(-1);
@@ -439,10 +466,8 @@ double * CleanBspline::cottingham(double *dataVector, gsl_vector *raVector, gsl_
 
 	cs_spfree(a2);
 	cs_spfree(a3);
-	cs_spfree(bMatrix);
 	a2=NULL;
 	a3=NULL;
-	bMatrix = NULL;
 	//Now compute data side matrix
 	v1 = new double [nP];
     for (size_t idata=0; idata < (size_t)nP; idata++)
@@ -484,12 +509,25 @@ double * CleanBspline::cottingham(double *dataVector, gsl_vector *raVector, gsl_
 	v2= NULL;
 	a1= NULL;
 	tta = NULL;
-	//Now solve linear system
+	//Now solve linear system, keeping the factors to measure their fill-in
 	cs_dropnotfinite(phi);
-	if (!cs_qrsol(3,phi,tsi)){
+	double tSolve = omp_get_wtime();
+	css *S = cs_sqr(3, phi, 1);
+	csn *N = (S) ? cs_qr(phi, S) : NULL;
+	double *x = (S) ? (double *) cs_calloc(S->m2, sizeof(double)) : NULL;
+	if (!sparseSolve(S, N, x, tsi, nSp)){
 		cerr<<"CleanBspline(): Cannot solve Spline system for this observation"<<endl;
 		exit(-1);
 	}
+	if (scan >= 0){
+		scanSetupTime[scan] = tSolve - tStart;
+		scanSolveTime[scan] = omp_get_wtime() - tSolve;
+		scanSystemNnz[scan] = phi->p[phi->n];
+		scanFactorNnz[scan] = N->L->p[N->L->n] + N->U->p[N->U->n];
+	}
+	cs_free(x);
+	cs_sfree(S);
+	cs_nfree(N);
 
 
 	v1 = new double [dataLen];
@@ -499,6 +537,7 @@ double * CleanBspline::cottingham(double *dataVector, gsl_vector *raVector, gsl_
 		cerr<<"CleanBspline():Cannot create atm template from Spline solution"<<endl;
 		exit(-1);
 	}
+	bases.release(basis);
 
 
 	delete [] tsi;
@@ -730,22 +769,16 @@ void CleanBspline::removeLargeScaleResiduals (CleanBsplineDestriping method,doub
 
 
 
-void CleanBspline::createBaseMatrix(int nSamples, int nDetectors){
-	double tol = 0.0;
-	if (baseMatrix != NULL){
-		if (nSamples == baseMatrixSamples && nDetectors == baseMatrixDetectors)
-			return;
-		else
-			this->destroyBaseMatrix();
-	}
-
+///Returns the B-Spline Base Matrix of a scan of nSamples samples
+/** The number of breakpoints follows from controlChunk and timeChunk,
+    or one per sample if either is not set.  Scans with the same shape
+    share the same cached basis, which goes back with bases.release().
+**/
+const BsplineBasis* CleanBspline::getBaseMatrix(int nSamples, int nDetectors){
 	int order = dataArray->getAp()->getOrder();
 	double controlChunk = dataArray->getAp()->getControlChunk();
 	double timeChunk = dataArray->getAp()->getTimeChunk();
 	int nbreaks =0;
-	int nSpline = 0;
-	cs *tmpbMatrix=NULL;
-	cs *tmpbMatrix_t=NULL;
 
 	if (controlChunk <= 0.0 || timeChunk <= 0.0){
 		nbreaks = nSamples +order +1;
@@ -755,73 +788,8 @@ void CleanBspline::createBaseMatrix(int nSamples, int nDetectors){
 			nbreaks = nSamples +order + 1;
 		}
 	}
-	nSpline = nbreaks + order -2;
-	//cerr<<"CleanBspline("<<tid<<"): Control Chunk is "<<controlChunk<< " Number of Splines: "<<nSpline<<endl;
-
-	long dataLen = nSamples * nDetectors;
-	gsl_vector* tmpB = NULL;
-	bsw = gsl_bspline_alloc(order, nbreaks);
-	if (bsw == NULL){
-		cerr<<"CleanBspline::createBaseMatrix():Cannot allocate B-spline working space. Imploding"<< endl;
-		exit(-1);
-	}
-	baseMatrixSamples = nSamples;
-	baseMatrixDetectors = nDetectors;
-	gsl_bspline_knots_uniform(0.0, (double)(baseMatrixSamples-1), bsw);
-	time = gsl_vector_alloc(baseMatrixSamples);
-	tmpB = gsl_vector_alloc(nSpline);
-	for (int i=0; i<baseMatrixSamples; i++)
-		gsl_vector_set(time, i, (double) i);
-
-	tmpbMatrix = cs_spalloc(nSpline, dataLen, 5*nSpline,1,1);
-	tmpbMatrix_t = cs_spalloc(dataLen, nSpline,5*nSpline,1,1);
-	//cerr<<"CleanBspline::createBaseMatrix(): Base Matrix Allocated"<<endl;
-	int kstart = 0;
-	int kend = 0;
-	double c_sample=0.0;
-	for (long i=0; i<baseMatrixSamples; i++){
-		gsl_bspline_eval(gsl_vector_get(time,i), tmpB, bsw);
-		//gsl_matrix_set_col(tmpMatrix, i, tmpB);
-		kstart = -1;
-		kend = -1;
-		for (int k=0; k<nSpline; k++){
-			c_sample = gsl_vector_get(tmpB, k);
-            if (!isfinite(c_sample)){
-				cerr<<"Nan detected on BaseMatrix....Imploding"<<endl;
-				exit(-1);
-			}
-			if (kstart == -1 && abs(c_sample) > tol){
-				kstart = k;
-				continue;
-			}
-			if (kend ==-1 && kstart > -1 &&  abs(c_sample) <=tol )
-				kend = k;
-		}
-		if (kend == -1 && kstart != -1)
-			kend = nSpline;
-		for (long k=kstart; k<kend; k++){
-			c_sample = gsl_vector_get(tmpB, k);
-			if (c_sample == 0)
-				continue;
-			for (long j=0; j<nDetectors; j++){
-				cs_entry(tmpbMatrix,  k, j*baseMatrixSamples + i , c_sample);
-				cs_entry(tmpbMatrix_t,j*baseMatrixSamples + i , k , c_sample);
-			}
-		}
-	}
-
-	gsl_vector_free(tmpB);
-	this->baseMatrix = cs_compress(tmpbMatrix_t);
-	this->baseMatrix_t = cs_compress(tmpbMatrix);
-	cs_spfree(tmpbMatrix_t);
-	cs_spfree(tmpbMatrix);
-
-	if (!this->baseMatrix || !this->baseMatrix_t){
-		cerr<<"CleanBspline(): Cannot allocate Bspline base matrix. Imploding"<<endl;
-		exit(-1);
-	}
 
-	return;
+	return bases.get(nSamples, nbreaks, order, nDetectors);
 }
 
 void CleanBspline::calibrate(){
@@ -875,20 +843,6 @@ void CleanBspline::downSample(gsl_vector** out,double *data, bool *flags, long n
 }
 
 
-void CleanBspline::destroyBaseMatrix(){
-	if (baseMatrix != NULL){
-		cs_spfree(baseMatrix);
-		cs_spfree(baseMatrix_t);
-		gsl_bspline_free(bsw);
-		gsl_vector_free(time);
-		baseMatrixDetectors = 0;
-		baseMatrixSamples = 0;
-		baseMatrix = NULL;
-		baseMatrix_t = NULL;
-		bsw=NULL;
-	}
-}
-
 bool CleanBspline::removeCorrelations (double *dataVector, double *flagVector, size_t nDetectors, size_t nSamples, double corrFactor, double *azoffset, double *eloffset, gsl_vector *azVector, gsl_vector *elVector){
 	size_t totalSamples = nDetectors*nSamples;
 	VecDoub outputVector (totalSamples);
@@ -1345,7 +1299,6 @@ bool CleanBspline::fixFlags(double *dataVector, bool *flagsVector, int nDetector
 }
 
 CleanBspline::~CleanBspline(){
-	this->destroyBaseMatrix();
 	if (scanStatus)
 		delete [] scanStatus;
 }
@@ -1862,6 +1815,4 @@ void CleanBspline::azelResidual (double *data, double *flags, size_t nDetectors,
 
 //Getters
 
-cs* CleanBspline::getBaseMatrix(){
-	return baseMatrix;
-}
+
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+using namespace std;
+
+#include "CleanChain.h"
+#include "CleanRegistry.h"
+#include "AzElTemplateCalculator.h"
+#include "vector_utilities.h"
+
+///CleanChain constructor
+/** Unknown stage names are fatal.
+**/
+CleanChain::CleanChain(Array *dataArray, Telescope *telescope,
+                       const vector<string> &stageNames) :
+  Clean(dataArray, telescope){
+  names = stageNames;
+  for(size_t s=0;s<names.size();s++){
+    Clean *stage = CleanRegistry::create(names[s], dataArray, telescope);
+    if(!stage){
+      cerr << "CleanChain(): unknown cleaner " << names[s] << ". Known:";
+      vector<string> known = CleanRegistry::names();
+      for(size_t k=0;k<known.size();k++) cerr << " " << known[k];
+      cerr << endl;
+      exit(1);
+    }
+    stages.push_back(stage);
+  }
+}
+
+bool CleanChain::clean(){
+  size_t s=0;
+  while(s<stages.size()){
+    size_t e=s;
+    if(stages[s]->scanWise()){
+      while(e<stages.size() && stages[e]->scanWise()) e++;
+      cout << "CleanChain(): scan-wise stages";
+      for(size_t k=s;k<e;k++) cout << " " << names[k];
+      cout << endl;
+      if(!runScans(dataArray, telescope, &stages[s], e-s)) return 0;
+    } else {
+      e = s+1;
+      cout << "CleanChain(): stage " << names[s] << endl;
+      if(!stages[s]->clean()) return 0;
+      //whole array stages may change the set of good detectors
+      dataArray->updateDetectorIndices();
+    }
+    s = e;
+  }
+  return 1;
+}
+
+CleanChain::~CleanChain(){
+  for(size_t s=0;s<stages.size();s++) delete stages[s];
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+CleanMedian::CleanMedian(Array *dataArray, Telescope *telescope) :
+  Clean(dataArray, telescope){
+}
+
+Clean* CleanMedian::create(Array *dataArray, Telescope *telescope){
+  return new CleanMedian(dataArray, telescope);
+}
+
+bool CleanMedian::clean(){
+  Clean *self = this;
+  return runScans(dataArray, telescope, &self, 1);
+}
+
+bool CleanMedian::scanWise(){
+  return true;
+}
+
+bool CleanMedian::cleanScan(ScanBlock &block){
+  for(int i=0;i<block.nDetectors;i++){
+    double mn = median(block.data[i], block.nSamples);
+    double mk = median(block.kernel[i], block.nSamples);
+    for(int j=0;j<block.nSamples;j++){
+      block.data[i][j] -= mn;
+      block.kernel[i][j] -= mk;
+    }
+  }
+  return 1;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+CleanAzEl::CleanAzEl(Array *dataArray, Telescope *telescope) :
+  Clean(dataArray, telescope){
+  azOffsets = NULL;
+  elOffsets = NULL;
+  weights = NULL;
+}
+
+Clean* CleanAzEl::create(Array *dataArray, Telescope *telescope){
+  return new CleanAzEl(dataArray, telescope);
+}
+
+bool CleanAzEl::clean(){
+  Clean *self = this;
+  return runScans(dataArray, telescope, &self, 1);
+}
+
+bool CleanAzEl::scanWise(){
+  return true;
+}
+
+///collects the detector offsets and weights shared by all scans
+void CleanAzEl::beginScans(int nScans){
+  (void) nScans;
+  endScans();
+  int nDetectors = dataArray->getNDetectors();
+  int *di = dataArray->getDetectorIndices();
+  azOffsets = gsl_vector_alloc(nDetectors);
+  elOffsets = gsl_vector_alloc(nDetectors);
+  weights = gsl_vector_alloc(nDetectors);
+  for(int i=0;i<nDetectors;i++){
+    gsl_vector_set(azOffsets, i, dataArray->detectors[di[i]].azOffset);
+    gsl_vector_set(elOffsets, i, dataArray->detectors[di[i]].elOffset);
+    gsl_vector_set(weights, i,
+                   1.0/dataArray->detectors[di[i]].getSensitivity());
+  }
+}
+
+bool CleanAzEl::cleanScan(ScanBlock &block){
+  gsl_matrix_view data = block.dataMatrix();
+  gsl_matrix_view flags = block.flagMatrix();
+  AzElTemplateCalculator dataTemp(&data.matrix, &flags.matrix,
+                                  azOffsets, elOffsets);
+  dataTemp.calculateTemplate(weights);
+  dataTemp.removeTemplate();
+
+  if(block.hasKernel){
+    gsl_matrix_view kernel = block.kernelMatrix();
+    AzElTemplateCalculator kernelTemp(&kernel.matrix, &flags.matrix,
+                                      azOffsets, elOffsets);
+    kernelTemp.calculateTemplate(weights);
+    kernelTemp.removeTemplate();
+  }
+  return 1;
+}
+
+void CleanAzEl::endScans(){
+  if(azOffsets) gsl_vector_free(azOffsets);
+  if(elOffsets) gsl_vector_free(elOffsets);
+  if(weights) gsl_vector_free(weights);
+  azOffsets = NULL;
+  elOffsets = NULL;
+  weights = NULL;
+}
+
+CleanAzEl::~CleanAzEl(){
+  endScans();
+}
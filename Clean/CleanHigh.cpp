@@ -20,110 +20,168 @@
 CleanHigh::CleanHigh(Array* dataArray, Telescope* tel) :
     Clean(dataArray,tel){
         order = dataArray->getAp()->getOrder();
+        geometry = NULL;
+        geometryPinv = NULL;
     }
 
+Clean* CleanHigh::create(Array *dataArray, Telescope *telescope){
+    return new CleanHigh(dataArray, telescope);
+}
+
 bool CleanHigh::clean(){
+    // Scans are independent, each one is cleaned in place with BLAS-3
+    // products on its own block
+    Clean *self = this;
+    bool ok = runScans(dataArray, telescope, &self, 1);
+    cout<<"CleanHigh(): done ";
+	return ok;
+}  // end clean
 
-    fullMedianSustraction();
-    //fullLinearCorrection();
-    
-	size_t nDetectors = dataArray->getNDetectors();
-	size_t nScans = telescope->scanIndex.ncols();
-	size_t si, ei;
-	size_t nSamples;
-	int *di = dataArray->getDetectorIndices(); 	//This variable hold the "alive" bolometers
-
-	MatDoub dataVector(0,0);
-
-    for (size_t iScan = 0; iScan < nScans; iScan++){  //Loop through all the data scans
-	//for (size_t iScan = 0; iScan < 1; iScan++){  //Loop through all the data scans
-		si=telescope->scanIndex[0][iScan];
-		ei=telescope->scanIndex[1][iScan]+1;
-		nSamples = ei -si;
-
-		//Copy data from detectors to working variable dataVector
-		dataVector.resize(nDetectors,nSamples);   //  <-------------------- size of matrix
-        
-        for (size_t i=0; i<nDetectors; i++)
-			for (size_t j=0; j<nSamples; j++)
-				dataVector[i][j]=dataArray->detectors[di[i]].hValues[si+j];
-
-		//Do something with the data, like taking out the median of each detector
-
-		cerr<<"CleanHigh(): Processing Data on Scan "<< iScan<<endl;
-//		double meanValue;
-//		for (size_t i=0; i<nDetectors; i++){
-//			meanValue = mean(&(dataVector[i][0]), nSamples);
-//			for (size_t j=0; j<nSamples; j++){
-//                dataVector[i][j]-= meanValue;
-//            }
-//		}
-
-        // MODIFICACION  (
-        // Offsets de AzTEC
-        VecDoub x(nDetectors), y(nDetectors);
-        for(size_t i=0; i<nDetectors; i++){
-                x[i] = dataArray->detectors[di[i]].azOffset ;
-                y[i] = dataArray->detectors[di[i]].elOffset ;
-        }
-        // Covariance Matrix
-        MatDoub Cov(nDetectors,nDetectors);
-        //Cov = CovMat(dataVector);
-        Cov = IdMat(nDetectors);
-        // Construimos el primer Template
-        MatDoub T1(nDetectors,nSamples) ;
-        T1 = Quadratic (dataVector, Cov,x,y) ;
-
-        // Limpieza (
-        // Substraer el template de los datos
-        MatDoub Residuals_1(nDetectors,nSamples);
-//        writeMatOut ("D1.txt", dataVector);
-        for(size_t i=0 ; i<nDetectors ; i++){
-            for(size_t j=0 ; j<nSamples ; j++){
-        //        Residuals_1[i][j] = dataVector[i][j] - T1[i][j] ;
-            	dataVector[i][j]-=T1[i][j];
-            }
+
+bool CleanHigh::scanWise(){
+    return true;
+}
+
+///builds the template geometry shared by all of the scans
+void CleanHigh::beginScans(int nScans){
+    (void) nScans;
+    // The quadratic template basis only depends on the detector offsets,
+    // build it once for all of the scans
+    buildGeometry();
+}
+
+///median subtracts one scan and removes its two atmosphere templates
+/** Only the data are cleaned, the kernel is left untouched.
+**/
+bool CleanHigh::cleanScan(ScanBlock &block){
+    int nDetectors = block.nDetectors;
+    size_t nSamples = block.nSamples;
+
+    cerr<<"CleanHigh(): Processing Data on Scan "<< block.scan<<endl;
+
+    for (int i=0; i<nDetectors; i++){
+        double scanMedian = median(block.data[i], nSamples);
+        for (size_t j=0; j<nSamples; j++)
+            block.data[i][j]-=scanMedian;
+    }
+    gsl_matrix_view dataView = block.dataMatrix();
+    gsl_matrix *dataVector = &dataView.matrix;
+
+    // First template with identity covariance
+    subtractTemplate(dataVector, NULL);
+
+    // Second template weighted by the covariance of the residuals
+    gsl_matrix *Cov = gsl_matrix_alloc(nDetectors,nDetectors);
+    gsl_blas_dsyrk(CblasLower,CblasNoTrans,1./nSamples,dataVector,0.,Cov);
+    for (int i=0; i<nDetectors; i++)
+        for (int j=i+1; j<nDetectors; j++)
+            gsl_matrix_set(Cov,i,j,gsl_matrix_get(Cov,j,i));
+    subtractTemplate(dataVector, Cov);
+    gsl_matrix_free(Cov);
+    return true;
+}
+
+
+///template basis matrix S for nPars = 1 (average), 3 (planar) or 6 (quadratic)
+/** One row per detector: 1, x, y, x*y, x^2, y^2 truncated to nPars
+    columns.
+**/
+gsl_matrix* CleanHigh::templateBasis (const VecDoub &x, const VecDoub &y, size_t nPars){
+    size_t nDetectors = x.size();
+    gsl_matrix * S = gsl_matrix_alloc (nDetectors, nPars);
+    for (size_t nb=0 ; nb<nDetectors ; nb++){
+        double row[6] = {1.0, x[nb], y[nb], x[nb]*y[nb], x[nb]*x[nb], y[nb]*y[nb]};
+        for (size_t p=0 ; p<nPars ; p++)
+            gsl_matrix_set (S, nb, p, row[p]);
+    }
+    return S;
+}
+
+
+///caches the quadratic basis of the array and its pseudo-inverse
+/** geometry is S built from the detector az/el offsets and
+    geometryPinv is (S^T S)^-1 S^T, so the identity covariance template
+    of a scan is just S (geometryPinv d).
+**/
+void CleanHigh::buildGeometry (){
+    size_t nDetectors = dataArray->getNDetectors();
+    int *di = dataArray->getDetectorIndices();
+    size_t nPars = 6;
+
+    VecDoub x(nDetectors), y(nDetectors);
+    for(size_t i=0; i<nDetectors; i++){
+        x[i] = dataArray->detectors[di[i]].azOffset ;
+        y[i] = dataArray->detectors[di[i]].elOffset ;
+    }
+    if (geometry) gsl_matrix_free(geometry);
+    if (geometryPinv) gsl_matrix_free(geometryPinv);
+    geometry = templateBasis(x, y, nPars);
+
+    // (S^T S)^-1
+    int signum;
+    gsl_matrix * SS = gsl_matrix_alloc (nPars, nPars);
+    gsl_matrix * SSinv = gsl_matrix_alloc (nPars, nPars);
+    gsl_permutation * perm = gsl_permutation_alloc (nPars);
+    gsl_blas_dgemm (CblasTrans, CblasNoTrans, 1.0, geometry, geometry, 0.0, SS);
+    gsl_linalg_LU_decomp (SS, perm, &signum);
+    gsl_linalg_LU_invert (SS, perm, SSinv);
+
+    geometryPinv = gsl_matrix_alloc (nPars, nDetectors);
+    gsl_blas_dgemm (CblasNoTrans, CblasTrans, 1.0, SSinv, geometry, 0.0, geometryPinv);
+
+    gsl_matrix_free(SS); gsl_matrix_free(SSinv);
+    gsl_permutation_free(perm);
+}
+
+
+///subtracts the template S (S^T C^-1 S)^-1 S^T C^-1 d from d in place
+/** With C == NULL the cached pseudo-inverse is used (C = identity).
+    Otherwise C^-1 S is solved from an LU decomposition of C, which is
+    destroyed.  Only nPars x nSamples intermediates are formed, never
+    the nDetectors x nDetectors projector.
+**/
+void CleanHigh::subtractTemplate (gsl_matrix *d, gsl_matrix *C){
+    size_t nDetectors = d->size1;
+    size_t nSamples = d->size2;
+    size_t nPars = geometry->size2;
+
+    gsl_matrix * W = geometryPinv;
+    if (C) {
+        // X = C^-1 S, one column at a time
+        int signum;
+        gsl_permutation * permDetect = gsl_permutation_alloc (nDetectors);
+        gsl_matrix * X = gsl_matrix_alloc (nDetectors, nPars);
+        gsl_linalg_LU_decomp (C, permDetect, &signum);
+        for (size_t p=0 ; p<nPars ; p++){
+            gsl_vector_view s = gsl_matrix_column(geometry, p);
+            gsl_vector_view x = gsl_matrix_column(X, p);
+            gsl_linalg_LU_solve (C, permDetect, &s.vector, &x.vector);
         }
+        // W = (S^T X)^-1 X^T
+        gsl_matrix * SX = gsl_matrix_alloc (nPars, nPars);
+        gsl_matrix * SXinv = gsl_matrix_alloc (nPars, nPars);
+        gsl_permutation * permPars = gsl_permutation_alloc (nPars);
+        gsl_blas_dgemm (CblasTrans, CblasNoTrans, 1.0, geometry, X, 0.0, SX);
+        gsl_linalg_LU_decomp (SX, permPars, &signum);
+        gsl_linalg_LU_invert (SX, permPars, SXinv);
+        W = gsl_matrix_alloc (nPars, nDetectors);
+        gsl_blas_dgemm (CblasNoTrans, CblasTrans, 1.0, SXinv, X, 0.0, W);
+
+        gsl_matrix_free(X); gsl_matrix_free(SX); gsl_matrix_free(SXinv);
+        gsl_permutation_free(permDetect); gsl_permutation_free(permPars);
+    }
 
-//        writeMatOut("T1.txt", T1 );
-        Cov = CovMat(dataVector);
-        T1 = Quadratic (dataVector, Cov,x,y) ;
-        for(size_t i=0 ; i<nDetectors ; i++){
-                    for(size_t j=0 ; j<nSamples ; j++){
-                //        Residuals_1[i][j] = dataVector[i][j] - T1[i][j] ;
-                    	dataVector[i][j]-=T1[i][j];
-                    }
-                }
-//        writeMatOut("T2.txt", T1 );
-//        exit (-1);
-
-        // 2do Nivel de limpieza:
-//        double criterion[2] = {5 , 0.6} ;
-//        // at least [0] bolometers correlated more than [1]
-//        bool withCov = 1;
-//        string method = "Quadratic";
-//        MatDoub T2(nDetectors,nSamples);
-//        T2 = subTemplate (Residuals_1, x, y, criterion,withCov,method);
-//        MatDoub Residuals_2(nDetectors,nSamples);
-//        for(size_t i=0 ; i<nDetectors ; i++){
-//            for(size_t j=0 ; j<nSamples ; j++){
-//                Residuals_2[i][j] = Residuals_1[i][j] - T2[i][j] ;
-//            }
-//        }
-        // After the atm template subtraction is done move back the data to the Detector object
-		for (size_t i=0; i<nDetectors; i++)
-					for (size_t j=0; j<nSamples; j++)
-						dataArray->detectors[di[i]].hValues[si+j]=dataVector[i][j];
-        // Limpieza )
-        // MODIFICACION  )
-	}
-    cout<<"CleanHigh(): done ";
-	return true;
-}  // end clean
+    // d -= S (W d)
+    gsl_matrix * coef = gsl_matrix_alloc (nPars, nSamples);
+    gsl_blas_dgemm (CblasNoTrans, CblasNoTrans, 1.0, W, d, 0.0, coef);
+    gsl_blas_dgemm (CblasNoTrans, CblasNoTrans, -1.0, geometry, coef, 1.0, d);
+    gsl_matrix_free(coef);
+    if (W != geometryPinv) gsl_matrix_free(W);
+}
 
 
-MatDoub CleanHigh::subTemplate (MatDoub tods, VecDoub x, VecDoub y, double crit[2],
-                                bool withCov, string method)
+MatDoub CleanHigh::subTemplate (const MatDoub &tods, const VecDoub &x, const VecDoub &y,
+                                double crit[2], bool withCov, string method)
     {
     size_t nDetectors = tods.nrows();
     size_t nSamples = tods.ncols();
@@ -199,23 +257,20 @@ MatDoub CleanHigh::subTemplate (MatDoub tods, VecDoub x, VecDoub y, double crit[
 
 
 void CleanHigh::fullMedianSustraction (){
-    size_t nScans = telescope->scanIndex.ncols();
-    size_t si=0;
-    size_t ei=0;
-    size_t nSamples=0;
+    int nScans = telescope->scanIndex.ncols();
     
     int *di = dataArray->getDetectorIndices();
     size_t nDetectors = dataArray->getNDetectors();
     
-    double scanMedian=0;
-    
-    for(size_t k=0;k<nScans;k++){
-        si=telescope->scanIndex[0][k];
-        ei=telescope->scanIndex[1][k]+1;
-        nSamples = ei -si;
+#pragma omp parallel for schedule(dynamic)
+    for(int k=0;k<nScans;k++){
+        size_t si=telescope->scanIndex[0][k];
+        size_t ei=telescope->scanIndex[1][k]+1;
+        size_t nSamples = ei -si;
+        VecDoub scratch;
         
         for (size_t i=0; i<nDetectors; i++){
-            scanMedian = median(&dataArray->detectors[di[i]].hValues[si], nSamples);
+            double scanMedian = median(asDoubles(dataArray->detectors[di[i]].hValues, si, nSamples, scratch), nSamples);
             for (size_t j=0; j<nSamples; j++)
                 dataArray->detectors[di[i]].hValues[si+j]-=scanMedian;
         }
@@ -289,137 +344,54 @@ void CleanHigh::fullLinearCorrection (){
 }  // end fullLinearCorrection
 
  
-MatDoub CleanHigh::Average (MatDoub tods, MatDoub C){
+MatDoub CleanHigh::Average (const MatDoub &tods, const MatDoub &C){
     /* Toma los TODs y las posiciones y realiza un ajuste planar,
      creando un Template y regresadolo en formato MatDoub
      */
-    
-    size_t nPars = 1;
-    size_t nDetectors = tods.nrows() ;
-    size_t nSamples   = tods.ncols() ;
-    
-    // TODs en formato de gsl
-    gsl_matrix * TOD = gsl_matrix_alloc (nDetectors,nSamples);
-    gsl_matrix_set_zero (TOD) ;
-    for (size_t nb=0 ; nb<nDetectors ; nb++){
-        for (size_t ns=0 ; ns<nSamples ; ns++){
-            gsl_matrix_set (TOD, nb, ns,   tods[nb][ns]  ) ;
-        }
-    }
-    // reescribir la matriz de Covarianza en formato gsl
-    gsl_matrix * Cov = gsl_matrix_alloc (nDetectors,nDetectors);
-    gsl_matrix_set_zero (Cov) ;
-    for (size_t nb_row=0 ; nb_row<nDetectors ; nb_row++){
-        for (size_t nb_col=0 ; nb_col<nDetectors ; nb_col++){
-            gsl_matrix_set (Cov, nb_row, nb_col,   C[nb_row][nb_col]  ) ;
-        }
-    }
-    // definir la matriz gsl-S y rellenarla
-    gsl_matrix * S = gsl_matrix_alloc (nDetectors, nPars);
-    gsl_matrix_set_zero (S) ; // initiate to zero
-    for (size_t nb=0 ; nb<nDetectors ; nb++){
-        gsl_matrix_set (S, nb, 0, 1.0       ) ;
-    }
-    
-    MatDoub T(nDetectors,nSamples);
-    T = BuildTemplate(TOD , Cov , S);
-
-    
-    gsl_matrix_free(TOD);gsl_matrix_free(Cov);gsl_matrix_free(S);
-    return T ;
+    VecDoub x(tods.nrows(), 0.), y(tods.nrows(), 0.);
+    return fitTemplate(tods, C, x, y, 1);
 } // Average Template
 
 
-MatDoub CleanHigh::Planar (MatDoub tods, MatDoub C, VecDoub x, VecDoub y){
+MatDoub CleanHigh::Planar (const MatDoub &tods, const MatDoub &C, const VecDoub &x, const VecDoub &y){
     /* Toma los TODs y las posiciones y realiza un ajuste planar,
      creando un Template y regresadolo en formato MatDoub
      */
-    
-    size_t nPars = 3;
-    size_t nDetectors = tods.nrows() ;
-    size_t nSamples   = tods.ncols() ;
-    
-    // TODs en formato de gsl
-    gsl_matrix * TOD = gsl_matrix_alloc (nDetectors,nSamples);
-    gsl_matrix_set_zero (TOD) ;
-    for (size_t nb=0 ; nb<nDetectors ; nb++){
-        for (size_t ns=0 ; ns<nSamples ; ns++){
-            gsl_matrix_set (TOD, nb, ns,   tods[nb][ns]  ) ;
-        }
-    }
-    // reescribir la matriz de Covarianza en formato gsl
-    gsl_matrix * Cov = gsl_matrix_alloc (nDetectors,nDetectors);
-    gsl_matrix_set_zero (Cov) ;
-    for (size_t nb_row=0 ; nb_row<nDetectors ; nb_row++){
-        for (size_t nb_col=0 ; nb_col<nDetectors ; nb_col++){
-            gsl_matrix_set (Cov, nb_row, nb_col,   C[nb_row][nb_col]  ) ;
-        }
-    }
-    // definir la matriz gsl-S y rellenarla
-    gsl_matrix * S = gsl_matrix_alloc (nDetectors, nPars);
-    gsl_matrix_set_zero (S) ; // initiate to zero
-    for (size_t nb=0 ; nb<nDetectors ; nb++){
-        gsl_matrix_set (S, nb, 0, 1.0       ) ;
-        gsl_matrix_set (S, nb, 1, x[nb] );
-        gsl_matrix_set (S, nb, 2, y[nb] );
-    }
-    
-    MatDoub T(nDetectors,nSamples);
-    T = BuildTemplate(TOD , Cov , S);
-
-    
-    gsl_matrix_free(TOD);gsl_matrix_free(Cov);gsl_matrix_free(S);
-    return T ;
+    return fitTemplate(tods, C, x, y, 3);
 } // Planar Template
 
 
-MatDoub CleanHigh::Quadratic (MatDoub tods, MatDoub C, VecDoub x, VecDoub y){
+MatDoub CleanHigh::Quadratic (const MatDoub &tods, const MatDoub &C, const VecDoub &x, const VecDoub &y){
     /* Toma los TODs y las posiciones y realiza un ajuste cuadratico,
      creando un Template y regresadolo en formato MatDoub
      */
-    
-    size_t nPars = 6;
+    return fitTemplate(tods, C, x, y, 6);
+} // Quadratic Template
+
+
+///template of tods with an nPars basis and covariance C
+/** The gsl matrices are views of the MatDoub storage, only C is
+    copied since the inversion destroys it.
+**/
+MatDoub CleanHigh::fitTemplate (const MatDoub &tods, const MatDoub &C,
+                                const VecDoub &x, const VecDoub &y, size_t nPars){
     size_t nDetectors = tods.nrows() ;
     size_t nSamples   = tods.ncols() ;
-    
-    // TODs en formato de gsl
-    gsl_matrix * TOD = gsl_matrix_alloc (nDetectors,nSamples);
-    gsl_matrix_set_zero (TOD) ;
-    for (size_t nb=0 ; nb<nDetectors ; nb++){
-        for (size_t ns=0 ; ns<nSamples ; ns++){
-            gsl_matrix_set (TOD, nb, ns,   tods[nb][ns]  ) ;
-        }
-    }
-    // reescribir la matriz de Covarianza en formato gsl
+
+    gsl_matrix_const_view TOD = gsl_matrix_const_view_array (&tods[0][0], nDetectors, nSamples);
     gsl_matrix * Cov = gsl_matrix_alloc (nDetectors,nDetectors);
-    gsl_matrix_set_zero (Cov) ;
-    for (size_t nb_row=0 ; nb_row<nDetectors ; nb_row++){
-        for (size_t nb_col=0 ; nb_col<nDetectors ; nb_col++){
-            gsl_matrix_set (Cov, nb_row, nb_col,   C[nb_row][nb_col]  ) ;
-        }
-    }
-    // definir la matriz gsl-S y rellenarla
-    gsl_matrix * S = gsl_matrix_alloc (nDetectors, nPars);
-    gsl_matrix_set_zero (S) ; // initiate to zero
-    for (size_t nb=0 ; nb<nDetectors ; nb++){
-        gsl_matrix_set (S, nb, 0, 1.0       ) ;
-        gsl_matrix_set (S, nb, 1, x[nb]     );
-        gsl_matrix_set (S, nb, 2, y[nb]     );
-        gsl_matrix_set (S, nb, 3, x[nb]*y[nb] );
-        gsl_matrix_set (S, nb, 4, x[nb]*x[nb] );
-        gsl_matrix_set (S, nb, 5, y[nb]*y[nb] );
-    }
+    gsl_matrix_const_view Cin = gsl_matrix_const_view_array (&C[0][0], nDetectors, nDetectors);
+    gsl_matrix_memcpy (Cov, &Cin.matrix);
+    gsl_matrix * S = templateBasis (x, y, nPars);
 
-    MatDoub T(nDetectors,nSamples);
-    T = BuildTemplate(TOD , Cov , S);
+    MatDoub T = BuildTemplate(&TOD.matrix , Cov , S);
 
-    
-    gsl_matrix_free(TOD);gsl_matrix_free(Cov);gsl_matrix_free(S);
+    gsl_matrix_free(Cov);gsl_matrix_free(S);
     return T ;
-} // Quadratic Template
+}
 
 
-MatDoub CleanHigh::BuildTemplate (gsl_matrix *tods, gsl_matrix *C, gsl_matrix *S){
+MatDoub CleanHigh::BuildTemplate (const gsl_matrix *tods, gsl_matrix *C, gsl_matrix *S){
     size_t nDetectors = tods->size1;
     size_t nSamples = tods->size2;
     size_t nPars = S->size2;
@@ -458,24 +430,15 @@ MatDoub CleanHigh::BuildTemplate (gsl_matrix *tods, gsl_matrix *C, gsl_matrix *S
     gsl_matrix * SSCSSC = gsl_matrix_alloc (nDetectors, nDetectors);
     gsl_matrix_set_zero (SSCSSC) ;
     gsl_blas_dgemm (CblasNoTrans, CblasNoTrans, 1.0, S, SCSSC, 0.0, SSCSSC);
-    // T = SSCSSC * tods
-    gsl_matrix * T = gsl_matrix_alloc (nDetectors, nSamples);
-    gsl_matrix_set_zero (T) ;
-    gsl_blas_dgemm (CblasNoTrans, CblasNoTrans, 1.0, SSCSSC, tods, 0.0, T);
-    
-    // The template in MatDoub format
+    // T = SSCSSC * tods, written straight into the MatDoub
     MatDoub Template(nDetectors,nSamples) ;
-    // Fill the Template in MatDoub
-    for (size_t nb=0 ; nb<nDetectors ; nb++){
-        for(size_t ns=0 ; ns<nSamples ; ns++){
-            Template[nb][ns] = gsl_matrix_get(T,nb,ns) ;
-        }
-    }
+    gsl_matrix_view T = gsl_matrix_view_array (&Template[0][0], nDetectors, nSamples);
+    gsl_blas_dgemm (CblasNoTrans, CblasNoTrans, 1.0, SSCSSC, tods, 0.0, &T.matrix);
 
 
     gsl_matrix_free(Covinv);gsl_matrix_free(SC);gsl_matrix_free(SCS);
     gsl_matrix_free(SCSinv);gsl_matrix_free(SCSS);gsl_matrix_free(SCSSC);
-    gsl_matrix_free(SSCSSC);gsl_matrix_free(T);//gsl_matrix_free(tods);
+    gsl_matrix_free(SSCSSC);
 
     gsl_permutation_free(permDetect); gsl_permutation_free(permPars);
 
@@ -483,66 +446,48 @@ MatDoub CleanHigh::BuildTemplate (gsl_matrix *tods, gsl_matrix *C, gsl_matrix *S
 } // BuildTemplate
 
 
-MatDoub CleanHigh::IterTemp (MatDoub coef , MatDoub tods ) {
+MatDoub CleanHigh::IterTemp (const MatDoub &coef , const MatDoub &tods ) {
     // Construye un nuevo template Tnew = c * d
     // producto de una iteracion, en terminos de los coeficientes de correlacion y la senal
-    size_t nSamples = tods.nrows();
     size_t nDetectors = tods.ncols();
     // TT = tods.T * c / sum(c) [=] (nsamples,ndetector)
-    MatDoub Tnew (nSamples,nDetectors) ;
+    MatDoub Tnew = MatrixProduct(tods, coef);
     for (size_t bolcol=0 ; bolcol<nDetectors ; bolcol++){
-        
         double csum = 0. ;
         for (size_t bolrow=0 ; bolrow<nDetectors ; bolrow++){
             csum += coef[bolrow][bolcol] ;
         }
-        
-        for (size_t ns=0 ; ns<nSamples ; ns++){
-            Tnew[ns][bolcol] = 0. ; // initialize to zero
-            for (size_t k=0 ; k<nDetectors ; k++){
-                Tnew[ns][bolcol] += tods[ns][k] * coef[k][bolcol] / csum ;
-            }
-        }
+        gsl_matrix_view T = gsl_matrix_view_array (&Tnew[0][0], Tnew.nrows(), nDetectors);
+        gsl_vector_view col = gsl_matrix_column (&T.matrix, bolcol);
+        gsl_blas_dscal (1./csum, &col.vector);
     }
     return Tnew;
 } // IterTemp
 
 
-MatDoub CleanHigh::Coefficients (MatDoub Template, MatDoub tods){
+MatDoub CleanHigh::Coefficients (const MatDoub &Template, const MatDoub &tods){
     // Calcula los coeficientes de correlacion, c = Temp * d.T / Temp^2_n :
     // la correlacion entre el template con la senal de los bolometros.
     size_t nSamples     = tods.nrows();
     size_t nDetectors   = tods.ncols();
-    // Primero sacamos la traspuesta de los TODs
-    MatDoub todsT(nSamples,nDetectors) ;
-    for(size_t R=0 ; R<nSamples ; R++){
-        for(size_t C=0 ; C<nDetectors ; C++){
-            todsT[R][C] = tods[C][R] ;
-        }
-    }
-    MatDoub coefs(nDetectors,nDetectors);
     // coefs = tods.T * Temp / Temp^2_n
+    MatDoub coefs(nDetectors,nDetectors);
+    gsl_matrix_const_view d = gsl_matrix_const_view_array (&tods[0][0], nSamples, nDetectors);
+    gsl_matrix_const_view t = gsl_matrix_const_view_array (&Template[0][0], nSamples, nDetectors);
+    gsl_matrix_view c = gsl_matrix_view_array (&coefs[0][0], nDetectors, nDetectors);
+    gsl_blas_dgemm (CblasTrans, CblasNoTrans, 1.0, &d.matrix, &t.matrix, 0.0, &c.matrix);
     for (size_t bolcol = 0 ; bolcol<nDetectors ; bolcol++){
-        // primero sumamos el factor de normalizacion T^2[nbol][0..nsample]
-        double Tsq = 0. ;
-        for (size_t ns=0 ; ns<nSamples ; ns++){
-            double t = Template[ns][bolcol] ;
-            Tsq += t*t ;
-        }
-        // multiplicamos Temp y TODs dividiendo por el factor de normalizacion
-        for (size_t bolrow=0 ; bolrow<nDetectors ; bolrow++){
-            coefs[bolrow][bolcol] = 0. ; // initialize coefs to zero
-            for (size_t ns=0 ; ns<nSamples ; ns++){
-                coefs[bolrow][bolcol] += todsT[bolrow][ns] * Template[ns][bolcol] / Tsq ;
-            }
-        }
-        Tsq = 0. ;
+        // el factor de normalizacion T^2[nbol][0..nsample]
+        gsl_vector_const_view tcol = gsl_matrix_const_column (&t.matrix, bolcol);
+        double Tnorm = gsl_blas_dnrm2 (&tcol.vector);
+        gsl_vector_view ccol = gsl_matrix_column (&c.matrix, bolcol);
+        gsl_blas_dscal (1./(Tnorm*Tnorm), &ccol.vector);
     }
     return coefs ;
     
 } // Coefficients
 
-MatDoub CleanHigh::Trp (MatDoub M){
+MatDoub CleanHigh::Trp (const MatDoub &M){
     size_t nCols = M.nrows();
     size_t nRows = M.ncols();
     MatDoub MT(nRows,nCols) ;
@@ -554,7 +499,7 @@ MatDoub CleanHigh::Trp (MatDoub M){
     return MT ;
 }
 
-MatDoub CleanHigh::MatrixProduct (MatDoub A, MatDoub B){
+MatDoub CleanHigh::MatrixProduct (const MatDoub &A, const MatDoub &B){
     size_t nRows = A.nrows();
     size_t nCols = B.ncols();
     size_t nIntern = A.ncols();
@@ -563,62 +508,55 @@ MatDoub CleanHigh::MatrixProduct (MatDoub A, MatDoub B){
         cerr<<"Attempted to multiply matrices not aligned"<<endl;
         exit(-1);
     }
-    for(size_t R=0 ; R<nRows ; R++){
-        for(size_t C=0 ; C<nCols ; C++){
-            M[R][C] = 0. ;
-            for(size_t k=0 ; k<nIntern ; k++){
-                M[R][C] += A[R][k] * B[k][C];
-            }
-        }
-    }
+    gsl_matrix_const_view a = gsl_matrix_const_view_array (&A[0][0], nRows, nIntern);
+    gsl_matrix_const_view b = gsl_matrix_const_view_array (&B[0][0], nIntern, nCols);
+    gsl_matrix_view m = gsl_matrix_view_array (&M[0][0], nRows, nCols);
+    gsl_blas_dgemm (CblasNoTrans, CblasNoTrans, 1.0, &a.matrix, &b.matrix, 0.0, &m.matrix);
     return M ;
 }
 
 MatDoub CleanHigh::IdMat (size_t size){
-    MatDoub I(size,size);
+    MatDoub I(size,size,0.);
     for (size_t i=0 ; i<size ; i++){
-        for (size_t j=0 ; j<size ; j++){
-            if (i == j) {I[i][j] = 1. ;}
-            else {I[i][j] = 0. ;}
-        }
+        I[i][i] = 1. ;
     }
     return I;
 }
 
-MatDoub CleanHigh::CovMat (MatDoub d){
+MatDoub CleanHigh::CovMat (const MatDoub &d){
     size_t nRows = d.nrows();
     size_t nCols = d.ncols();
     MatDoub Cov(nRows,nRows);
-    
-    MatDoub dT(nCols,nRows);
-    dT = Trp(d);
-    
+
+    // Cov = d * d.T / nCols, the lower triangle then mirrored
+    gsl_matrix_const_view dv = gsl_matrix_const_view_array (&d[0][0], nRows, nCols);
+    gsl_matrix_view cv = gsl_matrix_view_array (&Cov[0][0], nRows, nRows);
+    gsl_blas_dsyrk (CblasLower, CblasNoTrans, 1./nCols, &dv.matrix, 0.0, &cv.matrix);
     for(size_t i=0 ; i<nRows ; i++){
-        for(size_t j=0 ; j<nRows ; j++){
-            Cov[i][j] = 0. ;
-            for(size_t k=0 ; k<nCols ; k++){
-                Cov[i][j] += d[i][k] * dT[k][j] / nCols ;
-            }
+        for(size_t j=i+1 ; j<nRows ; j++){
+            Cov[i][j] = Cov[j][i] ;
         }
     }
     return Cov;
 }
 
-MatDoub CleanHigh::CorMat (MatDoub d){
+MatDoub CleanHigh::CorMat (const MatDoub &d){
     size_t nRows = d.nrows();
-    MatDoub Cov(nRows,nRows);
-    MatDoub Cor(nRows,nRows);
-    
-    Cov = CovMat(d);
+    MatDoub Cor = CovMat(d);
+    VecDoub sd(nRows);
+    for (size_t i=0 ; i<nRows ; i++){
+        sd[i] = sqrt(Cor[i][i]);
+    }
     for (size_t i=0 ; i<nRows ; i++){
         for (size_t j=0 ; j<nRows ; j++){
-            Cor[i][j] = Cov[i][j]/( sqrt(Cov[i][i]*Cov[j][j]) );
+            Cor[i][j] /= sd[i]*sd[j];
         }
     }
     return Cor;
 }
 
 CleanHigh::~CleanHigh(){
-
+    if (geometry) gsl_matrix_free(geometry);
+    if (geometryPinv) gsl_matrix_free(geometryPinv);
 }
 
@@ -1,7 +1,6 @@
 #include <cmath>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_blas.h>
-#include <gsl/gsl_eigen.h>
 #include <gsl/gsl_statistics.h>
 #include <omp.h>
 
@@ -12,7 +11,7 @@ using namespace std;
 #include "Detector.h"
 #include "GslRandom.h"
 #include "vector_utilities.h"
-
+#include "linalgBackend.h"
 
 
 CleanPCA::CleanPCA(Array *dataArray,Telescope *telescope) : 
@@ -23,243 +22,276 @@ CleanPCA::CleanPCA(Array *dataArray,Telescope *telescope) :
   
 }
 
+Clean* CleanPCA::create(Array *dataArray, Telescope *telescope){
+  return new CleanPCA(dataArray, telescope);
+}
+
 
 
 bool CleanPCA::clean(){
   //this cleaning is done scan by scan
-  int nScans = telescope->scanIndex.ncols();
-  Telescope *tel = telescope;
-  //update and get the array of good detectors
-  Array *dataArray = this->dataArray; 
-  //dataArray->updateDetectorIndices();
-  int* di=dataArray->getDetectorIndices();
+  Clean *self = this;
+  return runScans(dataArray, telescope, &self, 1);
+}
+
+
+bool CleanPCA::scanWise(){
+  return true;
+}
 
+///allocates the per-scan mode record and the per-thread warm starts
+void CleanPCA::beginScans(int nScans){
+  dataArray->pcaModes.resize(nScans);
+  warmStart.assign(omp_get_max_threads(), (gsl_matrix*) NULL);
+}
+
+///frees the warm start bases
+void CleanPCA::endScans(){
+  for(size_t t=0;t<warmStart.size();t++)
+    if(warmStart[t]) gsl_matrix_free(warmStart[t]);
+  warmStart.clear();
+}
+
+
+///removes the leading correlated modes of one scan
+/** The data and the kernel of the block are median subtracted, flagged
+    samples are zeroed and the same modes, found from the data, are
+    projected out of both in place.  In truncated mode the leading
+    modes of the last scan cleaned by the same thread are used to warm
+    start this one.
+**/
+bool CleanPCA::cleanScan(ScanBlock &block){
   double neigToCut = ap->getNeigToCut();
   double cutStd = ap->getCutStd();
-  int si=0;
-  int ei=0;
-  int npts=0;
-  int k=0;
-  int i=0;
-  int j=0;
-  int nDetectors = dataArray->getNDetectors();
-  
-  gsl_matrix* det = NULL;
-  gsl_matrix* ker = NULL;
-  gsl_matrix* flag = NULL;
-  gsl_matrix* denom = NULL;
-  gsl_matrix* pcaCorr = NULL;
-  
-  double mn=0.;
-  double mk=0.;
+  bool truncated = ap->getPcaTruncated();
+  int k = block.scan;
+  int si = block.si;
+  int npts = block.nSamples;
+  int nDetectors = block.nDetectors;
+  int *di = block.di;
+  gsl_matrix* &basis = warmStart[omp_get_thread_num()];
 
-  dataArray->eVectors.resize(nDetectors,nDetectors);
-  
-   #pragma omp  parallel shared (dataArray, tel, di, nScans, nDetectors, neigToCut, cutStd,cerr)\
-			  private (k,i,j, si, ei, npts, det, ker,flag, \
-				   mn,mk, denom, pcaCorr) default (none)
-  {
-#pragma omp for schedule(dynamic)
-    for(k=0;k<nScans;k++){
-      
-      si=tel->scanIndex[0][k];
-      ei=tel->scanIndex[1][k]+1;
-      npts = ei-si;
-      
-      
-      //allocate a gsl_matrix to store the values
-      det = gsl_matrix_alloc(nDetectors,npts);
-      ker = gsl_matrix_alloc(nDetectors,npts);
-      flag = gsl_matrix_alloc(nDetectors,npts);
-      
-      VecBool scanFlags (npts);
-      double dist;
-      //copy the data into them
-      for(i=0;i<nDetectors;i++){
-	//Get flags
-	for(j=si;j<ei;j++){
-	  dist = sqrt (pow(dataArray->detectors[di[i]].azElRaPhys[j],2.0)+pow(dataArray->detectors[di[i]].azElDecPhys[j],2.0));
-	  if (dist < 0.0/60.0)
-	    scanFlags[j-si] = false;
-	  else
-	    scanFlags[j-si] = true;
-	}
-	//mn = median(&dataArray->detectors[di[i]].hValues[si], ei-si);
-	//mk = median(&dataArray->detectors[di[i]].hKernel[si], ei-si);
-	mn = median(&dataArray->detectors[di[i]].hValues[si], &scanFlags[0] , ei-si);
-	mk = median(&dataArray->detectors[di[i]].hKernel[si], &scanFlags[0] , ei-si);
-	for(j=si;j<ei;j++){
-	  gsl_matrix_set(det,i,j-si,dataArray->detectors[di[i]].hValues[j]-mn);
-	  gsl_matrix_set(ker,i,j-si,dataArray->detectors[di[i]].hKernel[j]-mk);
-	  gsl_matrix_set(flag,i,j-si,dataArray->detectors[di[i]].hSampleFlags[j]);
-	}
-      }
-      
-      
-      //calculate the denom of the pca_corr
-      denom = gsl_matrix_alloc(nDetectors,nDetectors);
-      gsl_blas_dgemm(CblasNoTrans,CblasTrans,1.,flag,flag,0.,denom);
-      gsl_matrix_add_constant(denom,-1.);
-      
-      //calculate the the pcaCorr matrix
-      pcaCorr = gsl_matrix_alloc(nDetectors,nDetectors);
-      gsl_matrix_mul_elements (det,flag);
-      gsl_matrix_mul_elements (ker,flag);
-      
-      gsl_blas_dgemm(CblasNoTrans,CblasTrans,1.,det,det,0.,pcaCorr);
-      gsl_matrix_div_elements(pcaCorr,denom);
-      gsl_matrix_free(denom);
-      gsl_matrix_free(flag);
-      
-      if (dataArray->detectors[di[0]].atmTemplate.size()>0){
-	gsl_matrix * corrMatrix = gsl_matrix_alloc (nDetectors,nDetectors);
-	double corTmp=0;
-	for (size_t icor = 0; icor < (size_t)nDetectors; icor++){
-	  gsl_matrix_set(corrMatrix,icor,icor,1.0);
-	  for (size_t jcor = icor+1; jcor <(size_t)nDetectors; jcor++){
-	    corTmp =gsl_stats_correlation(&(dataArray->detectors[di[icor]].atmTemplate[si]),1,&(dataArray->detectors[di[jcor]].atmTemplate[si]),1, npts);
-	    if (abs(corTmp) > 0.7)
-	      corTmp = 0.0;
-	    else
-						  corTmp = 1.0;
-	    gsl_matrix_set(corrMatrix,icor,jcor, corTmp);
-	    gsl_matrix_set (corrMatrix,jcor, icor, corTmp);
-	  }
-	}
-	gsl_matrix_mul_elements(pcaCorr,corrMatrix);
-	gsl_matrix_free(corrMatrix);
+  //subtract the scan medians
+  VecBool scanFlags (npts, true);
+  for(int i=0;i<nDetectors;i++){
+    double mn = median(block.data[i], &scanFlags[0], npts);
+    double mk = median(block.kernel[i], &scanFlags[0], npts);
+    for(int j=0;j<npts;j++){
+      block.data[i][j] -= mn;
+      block.kernel[i][j] -= mk;
+    }
+  }
+  gsl_matrix_view detView = block.dataMatrix();
+  gsl_matrix_view kerView = block.kernelMatrix();
+  gsl_matrix_view flagView = block.flagMatrix();
+  gsl_matrix* det = &detView.matrix;
+  gsl_matrix* ker = &kerView.matrix;
+  gsl_matrix* flag = &flagView.matrix;
+
+  //calculate the denom of the pca_corr
+  //both products are symmetric, only the lower triangles are
+  //computed and the eigen-solve only reads those
+  gsl_matrix* denom = gsl_matrix_calloc(nDetectors,nDetectors);
+  gsl_blas_dsyrk(CblasLower,CblasNoTrans,1.,flag,0.,denom);
+  gsl_matrix_add_constant(denom,-1.);
+
+  //calculate the the pcaCorr matrix
+  gsl_matrix* pcaCorr = gsl_matrix_calloc(nDetectors,nDetectors);
+  gsl_matrix_mul_elements (det,flag);
+  gsl_matrix_mul_elements (ker,flag);
+
+  gsl_blas_dsyrk(CblasLower,CblasNoTrans,1.,det,0.,pcaCorr);
+  gsl_matrix_div_elements(pcaCorr,denom);
+  gsl_matrix_free(denom);
+
+  if (dataArray->detectors[di[0]].atmTemplate.size()>0){
+    gsl_matrix * corrMatrix = gsl_matrix_alloc (nDetectors,nDetectors);
+    double corTmp=0;
+    for (size_t icor = 0; icor < (size_t)nDetectors; icor++){
+      gsl_matrix_set(corrMatrix,icor,icor,1.0);
+      for (size_t jcor = icor+1; jcor <(size_t)nDetectors; jcor++){
+	corTmp =gsl_stats_correlation(&(dataArray->detectors[di[icor]].atmTemplate[si]),1,&(dataArray->detectors[di[jcor]].atmTemplate[si]),1, npts);
+	if (abs(corTmp) > 0.7)
+	  corTmp = 0.0;
+	else
+	  corTmp = 1.0;
+	gsl_matrix_set(corrMatrix,icor,jcor, corTmp);
+	gsl_matrix_set (corrMatrix,jcor, icor, corTmp);
       }
-      
-      //calculate the eigenvalues and eigenvectors of pcaCorr
-      gsl_eigen_symmv_workspace* w=gsl_eigen_symmv_alloc(nDetectors);
-      gsl_vector* eVals = gsl_vector_alloc(nDetectors);
-      gsl_matrix* eVecs = gsl_matrix_alloc(nDetectors,nDetectors);
-      gsl_eigen_symmv(pcaCorr,eVals,eVecs,w);
-      gsl_eigen_symmv_sort(eVals, eVecs, GSL_EIGEN_SORT_VAL_DESC);
-      gsl_eigen_symmv_free(w);
-      gsl_matrix_free(pcaCorr);
-      
-      //the transpose of the eigenfunction
-      gsl_matrix* eFunc = gsl_matrix_alloc(nDetectors,npts);
-      gsl_blas_dgemm(CblasTrans,CblasNoTrans,1.,eVecs,det,0.,eFunc);
-      gsl_matrix* eFunk = gsl_matrix_alloc(nDetectors,npts);
-      gsl_blas_dgemm(CblasTrans,CblasNoTrans,1.,eVecs,ker,0.,eFunk);
-      
-      //zero unwanted eFunc and eigenvectors here      
-      if(neigToCut > 0){
-	if(cutStd > 0){
-	  cerr << "Can't have both neigToCut and cutStd non-zero." << endl;
-	  exit(1);
-	}
-	//	double cDamping=0.0;
-	//zero the proper values in the eigenVectors
-	for(i=0;i<neigToCut;i++) {
-	  for(j=0;j<npts;j++){
-	    gsl_matrix_set(eFunc,i,j,0.0);
-	    gsl_matrix_set(eFunk,i,j,0.0);
-	  }
-	}
-      } else {
-	//in this case we'd better have non-zero cutStd
-	if(cutStd < 1.){
-	  cerr << "cutStd must be greater than 1 ";
-	  cerr << "(larger than 2. is recommended)" << endl;
-	  exit(1);
-	}
-
-	VecDoub eV(nDetectors);
-	VecDoub whichGood(nDetectors,1.);
-	for(i=0;i<nDetectors;i++){
-	  eV[i] = log10(abs(gsl_vector_get(eVals,i)));
-	}
-	double std = stddev(eV);
-	double mev = mean(eV);
-	bool keepGoing=1;
-	int nKeepLast = nDetectors;
-	
-	int iterator=0;
-	while(keepGoing){
-	  //count up number of eigenvalues that pass the cut
-	  int count=0;
-	  for(i=0;i<nDetectors;i++){
-	    if(whichGood[i] > 0){
-	      if(abs(eV[i]-mev) > abs(cutStd*std)){
-		whichGood[i]=0;
-	      } else count++;
-	    }
-	  }
-	  if(count >= nKeepLast){
-	    //cerr << "k=" << k << ": Cutting " << nDetectors-count;
-	    //cerr << " eigenvectors." << endl;
-	    keepGoing=0;
-	  } else {
-	    //get new mean and stddev for only the good eigenvectors
-	    mev=0.;
-	    for(i=0;i<nDetectors;i++)
-	      if(whichGood[i]>0) mev+=eV[i];
-	    mev /= count;
-	    std=0.;
-	    for(i=0;i<nDetectors;i++)
-	      if(whichGood[i]>0) std += (eV[i]-mev)*(eV[i]-mev);
-	    std = std/(count-1.);
-	    std = sqrt(std);
-	    nKeepLast = count;
-	  }
-	  iterator++;
-	}
-	
-	double cut=mev+cutStd*std;
-	cut = pow(10.,cut);
-	int cutIndex=0;
-	for(i=0;i<nDetectors;i++)
-	  if(gsl_vector_get(eVals,i) <= cut){
-	    cutIndex=i;
-	    break;
-	  }
-	
-	//zero the proper values in the eigenVectors
-	for(i=0;i<cutIndex;i++)
-	  for(j=0;j<npts;j++){
-	    gsl_matrix_set(eFunc,i,j,0.0);
-	    gsl_matrix_set(eFunk,i,j,0.0);
-	  }
+    }
+    gsl_matrix_mul_elements(pcaCorr,corrMatrix);
+    gsl_matrix_free(corrMatrix);
+  }
+
+  //which modes to cut
+  if(neigToCut > 0 && cutStd > 0){
+    cerr << "Can't have both neigToCut and cutStd non-zero." << endl;
+    exit(1);
+  }
+  if(neigToCut <= 0 && cutStd < 1.){
+    //in this case we'd better have non-zero cutStd
+    cerr << "cutStd must be greater than 1 ";
+    cerr << "(larger than 2. is recommended)" << endl;
+    exit(1);
+  }
+
+  //calculate the eigenvalues and eigenvectors of pcaCorr
+  gsl_vector* eVals = gsl_vector_alloc(nDetectors);
+  gsl_matrix* eVecs = gsl_matrix_calloc(nDetectors,nDetectors);
+  int cutIndex=0;
+  int nValues=nDetectors;
+  int nIter=0;
+  if(truncated){
+    cutIndex = leadingModes(pcaCorr, eVals, eVecs, neigToCut, cutStd, k+1,
+			    basis, &nValues, &nIter);
+    if(cutIndex > 0){
+      if(basis) gsl_matrix_free(basis);
+      basis = gsl_matrix_alloc(nDetectors, cutIndex);
+      gsl_matrix_view lead = gsl_matrix_submatrix(eVecs, 0, 0,
+						   nDetectors, cutIndex);
+      gsl_matrix_memcpy(basis, &lead.matrix);
+    }
+  } else {
+    if(!symmEigen(pcaCorr,eVals,eVecs))
+      cutIndex = -1;
+    else if(neigToCut > 0)
+      cutIndex = min((int) neigToCut, nDetectors);
+    else
+      cutIndex = cutStdIndex(eVals, nDetectors, cutStd);
+  }
+  if(cutIndex < 0){
+    cerr << "CleanPCA::clean(): eigen-solve failed on scan " << k << endl;
+    exit(1);
+  }
+  gsl_matrix_free(pcaCorr);
+
+  //the output data set is the data with the projection onto the
+  //cut eigenvectors removed
+  removeModes(eVecs, cutIndex, det);
+  removeModes(eVecs, cutIndex, ker);
+
+  //save the modes of this scan before deleting them
+  dataArray->pcaModes.store(k, eVals, nValues, eVecs, cutIndex, nIter);
+  gsl_matrix_free(eVecs);
+  gsl_vector_free(eVals);
+
+  return 1;
+}
+
+
+///index of the first eigenvalue not cut by the cutStd criterion
+/** eVals holds all n eigenvalues in descending order.  The mean and
+    standard deviation of log10|eVals| are iterated, dropping outliers
+    at each pass, and every mode above mean + cutStd*std is cut.
+**/
+int CleanPCA::cutStdIndex(gsl_vector* eVals, int nDetectors, double cutStd){
+  int i;
+  VecDoub eV(nDetectors);
+  VecDoub whichGood(nDetectors,1.);
+  for(i=0;i<nDetectors;i++){
+    eV[i] = log10(abs(gsl_vector_get(eVals,i)));
+  }
+  double std = stddev(eV);
+  double mev = mean(eV);
+  bool keepGoing=1;
+  int nKeepLast = nDetectors;
+  
+  while(keepGoing){
+    //count up number of eigenvalues that pass the cut
+    int count=0;
+    for(i=0;i<nDetectors;i++){
+      if(whichGood[i] > 0){
+	if(abs(eV[i]-mev) > abs(cutStd*std)){
+	  whichGood[i]=0;
+	} else count++;
       }
-      
-      //the output data set is the trans(eigenvects) x eigenfunc
-      gsl_blas_dgemm(CblasNoTrans,CblasNoTrans,1.,eVecs,eFunc,0.,det);
-      gsl_matrix_free(eFunc);
-      gsl_blas_dgemm(CblasNoTrans,CblasNoTrans,1.,eVecs,eFunk,0.,ker);
-      gsl_matrix_free(eFunk);
-      
-      //save the eigenvectors before deleting them
-      
+    }
+    if(count >= nKeepLast){
+      keepGoing=0;
+    } else {
+      //get new mean and stddev for only the good eigenvectors
+      mev=0.;
       for(i=0;i<nDetectors;i++)
-	for(j=0;j<nDetectors;j++)
-	  dataArray->eVectors[i][j] = gsl_matrix_get(eVecs,i,j);
-      gsl_matrix_free(eVecs);
-      
-      //replace the data in the detectors and the kernels
-      
-      //double debug [nDetectors*npts];
-      for(i=0;i<nDetectors;i++){
-	for(j=si;j<ei;j++){
-	  dataArray->detectors[di[i]].hValues[j] = gsl_matrix_get(det,i,j-si);
-	  dataArray->detectors[di[i]].hKernel[j] = gsl_matrix_get(ker,i,j-si);
-	  //debug[i*npts+(j-si)] = dataArray->detectors[di[i]].hValues[j];
-	}
-	
-	
-      }
-      //      if (k==1)
-      //    	  writeVecOut("pca_v1.txt",debug, nDetectors*npts);
-      
-      gsl_vector_free(eVals);
-      gsl_matrix_free(det);
-      gsl_matrix_free(ker);
-    }//iterating on scans, k
+	if(whichGood[i]>0) mev+=eV[i];
+      mev /= count;
+      std=0.;
+      for(i=0;i<nDetectors;i++)
+	if(whichGood[i]>0) std += (eV[i]-mev)*(eV[i]-mev);
+      std = std/(count-1.);
+      std = sqrt(std);
+      nKeepLast = count;
+    }
   }
-  return 1;
   
+  double cut=mev+cutStd*std;
+  cut = pow(10.,cut);
+  int cutIndex=0;
+  for(i=0;i<nDetectors;i++)
+    if(gsl_vector_get(eVals,i) <= cut){
+      cutIndex=i;
+      break;
+    }
+  return cutIndex;
+}
+
+
+///leading eigenmodes of pcaCorr and how many of them to cut
+/** Only the modes to cut are computed, with symmEigenTop() warm
+    started from the columns of start if given.  With neigToCut those
+    are the neigToCut leading modes.  With cutStd the test is the same
+    as in the full solve, on all of the eigenvalues, which are found
+    first without their eigenvectors.  If the subspace iteration does
+    not converge the full decomposition is done instead.  The number
+    of eigenvalues in eVals and the number of subspace iterations are
+    returned in nValues and nIter.  pcaCorr is destroyed.  Returns -1
+    if the eigen-solve fails.
+**/
+int CleanPCA::leadingModes(gsl_matrix* pcaCorr, gsl_vector* eVals,
+			   gsl_matrix* eVecs, int neigToCut, double cutStd,
+			   long seed, const gsl_matrix* start,
+			   int* nValues, int* nIter){
+  int n = pcaCorr->size1;
+  *nIter = 0;
+  int nCut;
+  gsl_vector* lTop = eVals;
+  if(neigToCut > 0){
+    nCut = min(neigToCut, n);
+    *nValues = nCut;
+  } else {
+    gsl_matrix* aCopy = gsl_matrix_alloc(n, n);
+    gsl_matrix_memcpy(aCopy, pcaCorr);
+    bool ok = symmEigenValues(aCopy, eVals);
+    gsl_matrix_free(aCopy);
+    if(!ok) return -1;
+    nCut = cutStdIndex(eVals, n, cutStd);
+    *nValues = n;
+    if(nCut == 0) return 0;
+    //keep the exact eigenvalues, the Ritz values go elsewhere
+    lTop = gsl_vector_alloc(n);
+  }
+
+  bool ok = symmEigenTop(pcaCorr, nCut, lTop, eVecs, seed, start, nIter);
+  if(!ok){
+    ok = symmEigen(pcaCorr, lTop, eVecs);
+    if(ok && neigToCut > 0) *nValues = n;
+  }
+  if(lTop != eVals) gsl_vector_free(lTop);
+  return (ok) ? nCut : -1;
+}
+
+
+///removes the first nCut eigenvectors from x: x -= V_c (V_c^T x)
+/** Since the eigenvectors are orthonormal this is the same as
+    projecting onto all of them, zeroing the cut eigenfunctions and
+    projecting back, for a fraction of the cost.
+**/
+void CleanPCA::removeModes(gsl_matrix* eVecs, int nCut, gsl_matrix* x){
+  if(nCut <= 0) return;
+  gsl_matrix_view vc = gsl_matrix_submatrix(eVecs, 0, 0, eVecs->size1, nCut);
+  gsl_matrix* p = gsl_matrix_alloc(nCut, x->size2);
+  gsl_blas_dgemm(CblasTrans,CblasNoTrans,1.,&vc.matrix,x,0.,p);
+  gsl_blas_dgemm(CblasNoTrans,CblasNoTrans,-1.,&vc.matrix,p,1.,x);
+  gsl_matrix_free(p);
 }
 
 void CleanPCA::setDamping(double damping){
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "CleanRegistry.h"
+#include "CleanPCA.h"
+#include "CleanBspline.h"
+#include "CleanHigh.h"
+#include "CleanChain.h"
+
+///the name to factory table, with the library's cleaners in it
+/** Kept out of the header since nr3.h, included by every cleaner,
+    redefines throw and breaks <map> when included after it.
+**/
+static map<string, CleanFactory>& table()
+{
+  static map<string, CleanFactory> factories = {
+    {"pca", &CleanPCA::create},
+    {"bspline", &CleanBspline::create},
+    {"high", &CleanHigh::create},
+    {"median", &CleanMedian::create},
+    {"azel", &CleanAzEl::create}
+  };
+  return factories;
+}
+
+///adds a cleaner, returns 0 if the name is already taken
+bool CleanRegistry::add(const string &name, CleanFactory factory)
+{
+  bool added;
+#pragma omp critical (cleanRegistry)
+  added = table().insert(make_pair(name, factory)).second;
+  return added;
+}
+
+bool CleanRegistry::has(const string &name)
+{
+  bool found;
+#pragma omp critical (cleanRegistry)
+  found = table().count(name) > 0;
+  return found;
+}
+
+///creates the cleaner registered as name, NULL if there is none
+Clean* CleanRegistry::create(const string &name, Array *dataArray,
+                             Telescope *telescope)
+{
+  CleanFactory factory = NULL;
+#pragma omp critical (cleanRegistry)
+  {
+    map<string, CleanFactory>::iterator it = table().find(name);
+    if(it != table().end()) factory = it->second;
+  }
+  if(!factory) return NULL;
+  return factory(dataArray, telescope);
+}
+
+vector<string> CleanRegistry::names()
+{
+  vector<string> n;
+#pragma omp critical (cleanRegistry)
+  for(map<string, CleanFactory>::iterator it = table().begin();
+      it != table().end(); it++)
+    n.push_back(it->first);
+  return n;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+CleanRegistrar::CleanRegistrar(const string &name, CleanFactory factory)
+{
+  if(!CleanRegistry::add(name, factory))
+    cerr << "CleanRegistrar(): cleaner " << name << " already registered"
+         << endl;
+}
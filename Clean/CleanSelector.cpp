@@ -1,8 +1,18 @@
 #include "CleanSelector.h"
+#include "CleanRegistry.h"
+#include "CleanChain.h"
 
 Clean * CleanSelector::getCleaner(Array *dataArray, Telescope *telescope){
   AnalParams *ap = dataArray->getAp();
-  
+
+  //an explicit chain of cleaners takes precedence over the legacy selection
+  if (ap->getCleanChain().size() > 0){
+    cout<<"CleanSelector(): Selected cleaning chain";
+    for (size_t i=0; i<ap->getCleanChain().size(); i++)
+      cout<<" "<<ap->getCleanChain()[i];
+    cout<<endl;
+    return new CleanChain(dataArray, telescope, ap->getCleanChain());
+  }
 
   if (ap->getCutStd() <= 0 && ap->getNeigToCut() <= 0 && ap->getOrder() <= 0 && ap->getTOrder() <=0){
 	printErrorMessage("Cannot determinate desired cleaning method!!!\n\tSet cutStd >0 or neigToCut > 0 for PCA Cleaning.\n\tSet splineOrder >=3 for Cottingham method.");
@@ -21,8 +31,7 @@ Clean * CleanSelector::getCleaner(Array *dataArray, Telescope *telescope){
       exit(-1);
     } else{
       cout<<"CleanSelector(): Selected Cottingham Method for Cleaning" <<endl;
-      CleanBspline *bspline = new CleanBspline(dataArray,telescope);
-      return bspline;
+      return CleanRegistry::create("bspline", dataArray, telescope);
     }
   }
   else if (ap->getTOrder()>0){
@@ -31,7 +40,7 @@ Clean * CleanSelector::getCleaner(Array *dataArray, Telescope *telescope){
 		exit(-1);
 	}else{
 		cout<<"CleanSelector(): Selected High Order Atmosphere Template Subtraction for Cleaning" <<endl;
-		return new CleanHigh(dataArray,telescope);
+		return CleanRegistry::create("high", dataArray, telescope);
 	}
   }else{
 	  if (ap->getCutStd() > 0 && ap->getNeigToCut() >0){
@@ -39,7 +48,7 @@ Clean * CleanSelector::getCleaner(Array *dataArray, Telescope *telescope){
 		  exit(-1);
 	  }
 	  cerr<<"CleanSelector():Selected PCA Cleaning"<<endl;
-	  return new CleanPCA(dataArray, telescope);
+	  return CleanRegistry::create("pca", dataArray, telescope);
   }
   return NULL;
 }
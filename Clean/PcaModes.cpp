@@ -0,0 +1,119 @@
+#include <netcdfcpp.h>
+#include <iostream>
+#include <algorithm>
+using namespace std;
+
+#include "nr3.h"
+#include "PcaModes.h"
+
+///allocates empty slots for nScans scans
+void PcaModes::resize(int nScans)
+{
+  eValues.assign(nScans, VecDoub());
+  eVectors.assign(nScans, MatDoub());
+  nCut.assign(nScans, 0);
+  nIterations.assign(nScans, 0);
+}
+
+
+///records the result of cleaning one scan
+/** Keeps the first nValues eigenvalues and the first nModesCut columns
+    of eVecs.
+**/
+void PcaModes::store(int scan, const gsl_vector *eVals, int nValues,
+                     const gsl_matrix *eVecs, int nModesCut, int nIter)
+{
+  int nDetectors = eVecs->size1;
+  VecDoub &l = eValues[scan];
+  MatDoub &v = eVectors[scan];
+  l.resize(nValues);
+  for(int i=0;i<nValues;i++)
+    l[i] = gsl_vector_get(eVals, i);
+  v.resize(nDetectors, nModesCut);
+  for(int i=0;i<nDetectors;i++)
+    for(int j=0;j<nModesCut;j++)
+      v[i][j] = gsl_matrix_get(eVecs, i, j);
+  nCut[scan] = nModesCut;
+  nIterations[scan] = nIter;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+int PcaModes::getNScans() const
+{
+  return nCut.size();
+}
+
+int PcaModes::getNCut(int scan) const
+{
+  return nCut[scan];
+}
+
+int PcaModes::getNIterations(int scan) const
+{
+  return nIterations[scan];
+}
+
+const VecDoub& PcaModes::getEValues(int scan) const
+{
+  return eValues[scan];
+}
+
+const MatDoub& PcaModes::getEVectors(int scan) const
+{
+  return eVectors[scan];
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///writes the per-scan modes to an open netcdf file
+/** Scans store different numbers of eigenvalues and modes, so the
+    pcaEValues [nScans, nPcaValues] and pcaEVectors [nScans,
+    nDetectors, nPcaModes] variables are padded with zeros and
+    pcaModesCut tells how many modes of each scan are real.
+**/
+bool PcaModes::writeToNcdf(NcFile &ncfid, NcDim *scanDim,
+                           NcDim *detectorDim) const
+{
+  int nScans = getNScans();
+  int nDetectors = detectorDim->size();
+  int nValues = 1;
+  int nModes = 1;
+  for(int k=0;k<nScans;k++){
+    nValues = max(nValues, (int) eValues[k].size());
+    nModes = max(nModes, nCut[k]);
+  }
+
+  NcDim *valueDim = ncfid.add_dim("nPcaValues", nValues);
+  NcDim *modeDim = ncfid.add_dim("nPcaModes", nModes);
+  NcVar *lVar = ncfid.add_var("pcaEValues", ncDouble, scanDim, valueDim);
+  NcVar *vVar = ncfid.add_var("pcaEVectors", ncDouble, scanDim,
+                              detectorDim, modeDim);
+  NcVar *cVar = ncfid.add_var("pcaModesCut", ncInt, scanDim);
+  NcVar *iVar = ncfid.add_var("pcaIterations", ncInt, scanDim);
+  if(!lVar || !vVar || !cVar || !iVar) return 0;
+
+  //one scan at a time, zero padded
+  VecDoub l(nValues);
+  MatDoub v(nDetectors, nModes);
+  for(int k=0;k<nScans;k++){
+    for(int i=0;i<nValues;i++)
+      l[i] = (i < (int) eValues[k].size()) ? eValues[k][i] : 0.;
+    for(int i=0;i<nDetectors;i++)
+      for(int j=0;j<nModes;j++)
+        v[i][j] = (j < nCut[k]) ? eVectors[k][i][j] : 0.;
+    lVar->set_cur(k, 0);
+    vVar->set_cur(k, 0, 0);
+    if(!lVar->put(&l[0], 1, nValues)) return 0;
+    if(!vVar->put(&v[0][0], 1, nDetectors, nModes)) return 0;
+  }
+  if(nScans > 0){
+    if(!cVar->put(&nCut[0], nScans)) return 0;
+    if(!iVar->put(&nIterations[0], nScans)) return 0;
+  }
+  return 1;
+}
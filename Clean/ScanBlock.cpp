@@ -0,0 +1,57 @@
+#include <gsl/gsl_matrix.h>
+using namespace std;
+
+#include "nr3.h"
+#include "ScanBlock.h"
+
+///copies scan k of the good detectors into the block
+void ScanBlock::gather(Array *dataArray, Telescope *telescope, int k)
+{
+  scan = k;
+  si = telescope->scanIndex[0][k];
+  nSamples = telescope->scanIndex[1][k]+1 - si;
+  nDetectors = dataArray->getNDetectors();
+  di = dataArray->getDetectorIndices();
+
+  hasKernel = (nDetectors > 0 &&
+               dataArray->detectors[di[0]].hKernel.size() >= (size_t)(si+nSamples));
+
+  data.resize(nDetectors, nSamples);
+  kernel.assign(nDetectors, nSamples, 0.);
+  flags.resize(nDetectors, nSamples);
+  for(int i=0;i<nDetectors;i++){
+    Detector &det = dataArray->detectors[di[i]];
+    for(int j=0;j<nSamples;j++){
+      data[i][j] = det.hValues[si+j];
+      flags[i][j] = det.hSampleFlags[si+j];
+    }
+    if(hasKernel)
+      for(int j=0;j<nSamples;j++) kernel[i][j] = det.hKernel[si+j];
+  }
+}
+
+///copies the data and kernel back into the detectors
+void ScanBlock::scatter(Array *dataArray)
+{
+  for(int i=0;i<nDetectors;i++){
+    Detector &det = dataArray->detectors[di[i]];
+    for(int j=0;j<nSamples;j++) det.hValues[si+j] = data[i][j];
+    if(hasKernel)
+      for(int j=0;j<nSamples;j++) det.hKernel[si+j] = kernel[i][j];
+  }
+}
+
+gsl_matrix_view ScanBlock::dataMatrix()
+{
+  return gsl_matrix_view_array(&data[0][0], nDetectors, nSamples);
+}
+
+gsl_matrix_view ScanBlock::kernelMatrix()
+{
+  return gsl_matrix_view_array(&kernel[0][0], nDetectors, nSamples);
+}
+
+gsl_matrix_view ScanBlock::flagMatrix()
+{
+  return gsl_matrix_view_array(&flags[0][0], nDetectors, nSamples);
+}
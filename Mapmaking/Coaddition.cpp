@@ -19,6 +19,9 @@ using namespace std;
 #include <gsl/gsl_spline.h>
 #include <gsl/gsl_math.h>
 #include "Coaddition.h"
+#include "ObsIndex.h"
+#include "Distributor.h"
+#include "TiledMap.h"
 #include "Telescope.h"
 #include "vector_utilities.h"
 #include "PointSource.h"
@@ -74,7 +77,7 @@ bool Coaddition::coaddMaps()
 {
   //start by running through map files to determine the coadded
   //maps bounds and to check that all the mastergrids are 
-  //identical
+  //identical, all from the files' indexes
   int nFiles = ap->getNFiles();
   VecDoub mg(2);
   double minRowVal=0., minColVal=0.;
@@ -82,48 +85,37 @@ bool Coaddition::coaddMaps()
   string sourceNameString;
   individualMapsTau.resize(nFiles);
   for(int i=0;i<nFiles;i++){
-    NcFile ncfid = NcFile(ap->getMapFileList(i).c_str(), NcFile::ReadOnly);
-    NcDim* rowDimVar = ncfid.get_dim("nrows");
-    NcDim* colDimVar = ncfid.get_dim("ncols");
-    double rowDim = rowDimVar->size();
-    double colDim = colDimVar->size();
-    NcAtt* mg0Att = ncfid.get_att("MasterGrid[0]");
-    NcAtt* mg1Att = ncfid.get_att("MasterGrid[1]");
-    NcAtt* sourceName = ncfid.get_att("source");
-
-    individualMapsTau[i] = ncfid.get_att("ArrayAvgTau")->as_double(0);
+    ObsIndex* index = ObsIndex::forMapFile(ap->getMapFileList(i).c_str());
+    individualMapsTau[i] = index->getDouble("ArrayAvgTau");
 
     //find minimum and maximum row and column values
-    NcVar* rcpv = ncfid.get_var("rowCoordsPhys");
-    NcVar* ccpv = ncfid.get_var("colCoordsPhys");
+    double rcpFirst = index->getDouble("rowCoordsPhysFirst");
+    double rcpLast = index->getDouble("rowCoordsPhysLast");
+    double ccpFirst = index->getDouble("colCoordsPhysFirst");
+    double ccpLast = index->getDouble("colCoordsPhysLast");
     if(i == 0){
-      mg[0] = mg0Att->as_double(0);
-      mg[1] = mg1Att->as_double(0);
-      minRowVal = rcpv->as_double(0);
-      maxRowVal = rcpv->as_double(rowDim-1);
-      minColVal = ccpv->as_double(0);
-      maxColVal = ccpv->as_double(colDim-1);
-      char* tmpSourceName = sourceName->as_string(0);
-      sourceNameString = tmpSourceName;
-      delete [] tmpSourceName;
+      mg[0] = index->getDouble("MasterGrid[0]");
+      mg[1] = index->getDouble("MasterGrid[1]");
+      minRowVal = rcpFirst;
+      maxRowVal = rcpLast;
+      minColVal = ccpFirst;
+      maxColVal = ccpLast;
+      sourceNameString = index->getString("source");
     }
     else {
-      if(mg0Att->as_double(0) != mg[0] || mg1Att->as_double(0) != mg[1]){
+      if(index->getDouble("MasterGrid[0]") != mg[0] ||
+	 index->getDouble("MasterGrid[1]") != mg[1]){
     	  cerr << "Mastergrid is not consistent in file ";
     	  cerr << ap->getMapFileList(i) << " ... aborting coadd." << endl;
     	  exit(1);
       }
 
-      if(rcpv->as_double(0) < minRowVal) minRowVal = rcpv->as_double(0);
-      if(rcpv->as_double(rowDim-1) > maxRowVal) 
-	maxRowVal = rcpv->as_double(rowDim-1);
-      if(ccpv->as_double(0) < minColVal) minColVal = ccpv->as_double(0);
-      if(ccpv->as_double(colDim-1) > maxColVal) 
-	maxColVal = ccpv->as_double(colDim-1);
+      if(rcpFirst < minRowVal) minRowVal = rcpFirst;
+      if(rcpLast > maxRowVal) maxRowVal = rcpLast;
+      if(ccpFirst < minColVal) minColVal = ccpFirst;
+      if(ccpLast > maxColVal) maxColVal = ccpLast;
     }
-    delete mg0Att;
-    delete mg1Att;
-    delete sourceName;
+    delete index;
   }
 
   //set the mastergrid
@@ -157,15 +149,9 @@ bool Coaddition::coaddMaps()
     exit(1);
   }
 
-  //matrices of absolute coordinates
-  xCoordsAbs.resize(nrows,ncols);
-  yCoordsAbs.resize(nrows,ncols);
-  for(int i=0;i<nrows;i++)
-    for(int j=0;j<ncols;j++){
-      physToAbs(&rowCoordsPhys[i], &colCoordsPhys[j], 
-		&masterGrid[0], &masterGrid[1],
-		&xCoordsAbs[i][j], &yCoordsAbs[i][j], 1);
-    }
+  //absolute coordinates are computed on demand from the projection
+  projection = MapProjection(masterGrid[0], masterGrid[1],
+                             rowCoordsPhys, colCoordsPhys);
 
   //allocate space for the maps
   MatDoub wtt;
@@ -190,40 +176,67 @@ bool Coaddition::coaddMaps()
 		     weight->image, rowCoordsPhys, colCoordsPhys);
   }
 
-  //now do a simpleminded coaddition
+  //now do a simpleminded coaddition, of this rank's share of the maps
+  //if the run is distributed
+  Distributor* dist = ap->getDistributor();
   for(int k=0;k<nFiles;k++){
+    if(dist && !dist->owns(k)) continue;
+    ObsIndex* index = ObsIndex::forMapFile(ap->getMapFileList(k).c_str());
+    double onrows = index->getInt("nrows");
+    double oncols = index->getInt("ncols");
+    double rcp0 = index->getDouble("rowCoordsPhysFirst");
+    double ccp0 = index->getDouble("colCoordsPhysFirst");
+    delete index;
     NcFile ncfid = NcFile(ap->getMapFileList(k).c_str(), NcFile::ReadOnly);
-    double onrows = ncfid.get_dim("nrows")->size();
-    double oncols = ncfid.get_dim("ncols")->size();
-    NcVar* rcpv = ncfid.get_var("rowCoordsPhys");
-    NcVar* ccpv = ncfid.get_var("colCoordsPhys");
-    VecDoub rcp(onrows);
-    VecDoub ccp(oncols);
-    for(int i=0;i<onrows;i++) rcp[i] = rcpv->as_double(i);
-    for(int j=0;j<oncols;j++) ccp[j] = ccpv->as_double(j);
-    NcVar* osVar = ncfid.get_var("signal");
-    NcVar* owVar = ncfid.get_var("weight");
-    NcVar* okVar = ncfid.get_var("kernel");
-    MatDoub os(onrows,oncols);
-    MatDoub ow(onrows,oncols);
-    MatDoub ok(onrows,oncols);
-    osVar->get(&os[0][0], onrows, oncols);
-    owVar->get(&ow[0][0], onrows, oncols);
-    okVar->get(&ok[0][0], onrows, oncols);
+
+    //read the observation maps as tiles, this works for both dense
+    //and tiled files and skips the empty regions of either
+    TiledMap* otm = TiledMap::readFromNcdf(ncfid, {"signal","weight","kernel"},
+                                           ap->getMapTileSize());
+    if(!otm){
+      cerr << "Coaddition::coaddMaps(): cannot read maps from ";
+      cerr << ap->getMapFileList(k) << endl;
+      exit(1);
+    }
+    int ts = otm->getTileSize();
 
     //the index deltas
-    int deltai = (rcp[0]-rowCoordsPhys[0])/pixelSize;
-    int deltaj = (ccp[0]-colCoordsPhys[0])/pixelSize;
-
-    //now loop through the observation maps
-    for(int oi=0;oi<onrows;oi++){
-      for(int oj=0;oj<oncols;oj++){
-	weight->image[oi+deltai][oj+deltaj] += ow[oi][oj];
-	signal->image[oi+deltai][oj+deltaj] += ow[oi][oj]*os[oi][oj];
-	kernel->image[oi+deltai][oj+deltaj] += ow[oi][oj]*ok[oi][oj];
-	inttime->image[oi+deltai][oj+deltaj] += ow[oi][oj]*1./64.;
+    int deltai = (rcp0-rowCoordsPhys[0])/pixelSize;
+    int deltaj = (ccp0-colCoordsPhys[0])/pixelSize;
+
+    //now loop through the observation map tiles
+    for(int s=0;s<otm->getNTiles();s++){
+      const double* os = otm->getTile(s, 0);
+      const double* ow = otm->getTile(s, 1);
+      const double* ok = otm->getTile(s, 2);
+      int r0 = otm->getTileRow0(s);
+      int c0 = otm->getTileCol0(s);
+      int tnr = min(ts, (int) onrows-r0);
+      int tnc = min(ts, (int) oncols-c0);
+      for(int ti=0;ti<tnr;ti++){
+	int i = r0+ti+deltai;
+	for(int tj=0;tj<tnc;tj++){
+	  int p = ti*ts+tj;
+	  if(ow[p] == 0.) continue;
+	  int j = c0+tj+deltaj;
+	  weight->image[i][j] += ow[p];
+	  signal->image[i][j] += ow[p]*os[p];
+	  kernel->image[i][j] += ow[p]*ok[p];
+	  inttime->image[i][j] += ow[p]*1./64.;
+	}
       }
     }
+    delete otm;
+  }
+
+  //add up the shares of all the ranks
+  if(dist && dist->isDistributed()){
+    cerr << "Coaddition(): summing the coadds of " << dist->getNRanks();
+    cerr << " ranks." << endl;
+    dist->allReduce("coadd.weight", &weight->image[0][0], nPixels);
+    dist->allReduce("coadd.signal", &signal->image[0][0], nPixels);
+    dist->allReduce("coadd.kernel", &kernel->image[0][0], nPixels);
+    dist->allReduce("coadd.inttime", &inttime->image[0][0], nPixels);
   }
 
   //normalization
@@ -357,7 +370,9 @@ bool Coaddition::coaddTimeStreams(){
 bool Coaddition::writeCoadditionToNcdf()
 {
   //create the file
-  NcFile ncfid = NcFile(ap->getCoaddOutFile().c_str(), NcFile::Replace, NULL, 0, NcFile::Offset64Bits);
+  NcCompression nc = ap->getNcCompression();
+  NcFile ncfid = NcFile(ap->getCoaddOutFile().c_str(), NcFile::Replace, NULL, 0,
+                        nc.getFileFormat());
   if (!ncfid.is_valid()){
     cerr << "Couldn't open " << ap->getCoaddOutFile() << " for writing.";
     cerr << endl;
@@ -372,19 +387,17 @@ bool Coaddition::writeCoadditionToNcdf()
   NcDim* colDim = ncfid.add_dim("ncols", ncols);
 
   //define variables for maps
-  NcVar *signalVar = ncfid.add_var("signal", ncDouble, rowDim, colDim);
-  NcVar *kernelVar = ncfid.add_var("kernel", ncDouble, rowDim, colDim);
-  NcVar *weightVar = ncfid.add_var("weight", ncDouble, rowDim, colDim);
-  NcVar *inttimeVar = ncfid.add_var("inttime", ncDouble, rowDim, colDim);
+  NcVar *signalVar = nc.addMapVar(ncfid, "signal", ncDouble, rowDim, colDim);
+  NcVar *kernelVar = nc.addMapVar(ncfid, "kernel", ncDouble, rowDim, colDim);
+  NcVar *weightVar = nc.addMapVar(ncfid, "weight", ncDouble, rowDim, colDim);
+  NcVar *inttimeVar = nc.addMapVar(ncfid, "inttime", ncDouble, rowDim, colDim);
   NcVar *rCPhysVar = ncfid.add_var("rowCoordsPhys", ncDouble, rowDim);
   NcVar *cCPhysVar = ncfid.add_var("colCoordsPhys", ncDouble, colDim);
-  NcVar *xCAbsVar = ncfid.add_var("xCoordsAbs", ncDouble, rowDim, colDim);
-  NcVar *yCAbsVar = ncfid.add_var("yCoordsAbs", ncDouble, rowDim, colDim);
 
   if (tWeight){
-	  NcVar *tsignalVar = ncfid.add_var("tSignal", ncDouble, rowDim, colDim);
-	  NcVar *tkernelVar = ncfid.add_var("tKernel", ncDouble, rowDim, colDim);
-	  NcVar *tweightVar = ncfid.add_var("tWeight", ncDouble, rowDim, colDim);
+	  NcVar *tsignalVar = nc.addMapVar(ncfid, "tSignal", ncDouble, rowDim, colDim);
+	  NcVar *tkernelVar = nc.addMapVar(ncfid, "tKernel", ncDouble, rowDim, colDim);
+	  NcVar *tweightVar = nc.addMapVar(ncfid, "tWeight", ncDouble, rowDim, colDim);
 
 	  tsignalVar->put(&tSignal->image[0][0], nrows, ncols);
 	  tkernelVar->put(&tKernel->image[0][0], nrows, ncols);
@@ -400,8 +413,7 @@ bool Coaddition::writeCoadditionToNcdf()
   inttimeVar->put(&inttime->image[0][0], nrows, ncols);
   rCPhysVar->put(&rowCoordsPhys[0], nrows);
   cCPhysVar->put(&colCoordsPhys[0], ncols);
-  xCAbsVar->put(&xCoordsAbs[0][0], nrows, ncols);
-  yCAbsVar->put(&yCoordsAbs[0][0], nrows, ncols);
+  projection.writeToNcdf(ncfid, rowDim, colDim, !ap->getWriteAbsCoords(), nc);
 
 
   //get the time and date of this analysis
@@ -584,10 +596,12 @@ bool Coaddition::writeFilteredMapsToNcdf()
   NcDim* rowDim = ncfid.get_dim("nrows");
   NcDim* colDim = ncfid.get_dim("ncols");
 
-  //define variables for maps
-  NcVar *signalVar = ncfid.add_var("filteredSignal", ncDouble, rowDim, colDim);
-  NcVar *kernelVar = ncfid.add_var("filteredKernel", ncDouble, rowDim, colDim);
-  NcVar *weightVar = ncfid.add_var("filteredWeight", ncDouble, rowDim, colDim);
+  //define variables for maps, compression only applies if the file
+  //was created as netcdf-4 by writeCoadditionToNcdf()
+  NcCompression nc = ap->getNcCompression();
+  NcVar *signalVar = nc.addMapVar(ncfid, "filteredSignal", ncDouble, rowDim, colDim);
+  NcVar *kernelVar = nc.addMapVar(ncfid, "filteredKernel", ncDouble, rowDim, colDim);
+  NcVar *weightVar = nc.addMapVar(ncfid, "filteredWeight", ncDouble, rowDim, colDim);
 
   //and write the maps
   signalVar->put(&filteredSignal->image[0][0], nrows, ncols);
@@ -647,8 +661,7 @@ bool Coaddition::findSources(double* signalMap, double* s2nMap,
   //set up coverage boolean map
   rowCoordsPhys.resize(nrows);
   colCoordsPhys.resize(ncols);
-  xCoordsAbs.resize(nrows, ncols);
-  yCoordsAbs.resize(nrows, ncols);
+  projection = realCoadd->getProjection();
   filteredSignal->coverageBool.resize(nrows, ncols);
   for(int i=0;i<nrows;i++){
     for(int j=0;j<ncols;j++){
@@ -657,8 +670,6 @@ bool Coaddition::findSources(double* signalMap, double* s2nMap,
       filteredWeight->image[i][j] = realCoadd->filteredWeight->image[i][j];
       filteredSignal->coverageBool[i][j] =
 	realCoadd->filteredSignal->coverageBool[i][j];
-      xCoordsAbs[i][j] = realCoadd->getXCoordsAbs(i, j);
-      yCoordsAbs[i][j] = realCoadd->getYCoordsAbs(i , j);
     }
   }
   for(int i=0;i<nrows;i++){
@@ -907,8 +918,8 @@ bool Coaddition::findSources()
   for(int i=0;i<nSources;i++){
     sources[i].sID = i;
     sources[i].nSourcesParentMap = nSources;
-    sources[i].centerRaAbs = xCoordsAbs[rSourceLoc[i]][cSourceLoc[i]];
-    sources[i].centerDecAbs = yCoordsAbs[rSourceLoc[i]][cSourceLoc[i]];
+    projection.pixelToAbs(rSourceLoc[i], cSourceLoc[i],
+                          &sources[i].centerRaAbs, &sources[i].centerDecAbs);
     sources[i].centerRaPhys = rowCoordsPhys[rSourceLoc[i]];
     sources[i].centerDecPhys = colCoordsPhys[cSourceLoc[i]];
     sources[i].centerXPos = rSourceLoc[i];
@@ -923,8 +934,7 @@ bool Coaddition::findSources()
 			  &filteredSignal->weight[0][0],
 			  &rowCoordsPhys[0],
 			  &colCoordsPhys[0],
-			  &xCoordsAbs[0][0],
-			  &yCoordsAbs[0][0],
+			  &projection,
 			  nrows, ncols,
 			  pixelSize, ap->getCoaddOutFile().c_str());
 
@@ -1032,12 +1042,17 @@ double Coaddition::getColCoordsPhys(int i)
 
 double Coaddition::getXCoordsAbs(int i, int j)
 {
-  return xCoordsAbs[i][j];
+  return projection.getXAbs(i, j);
 }
 
 double Coaddition::getYCoordsAbs(int i, int j)
 {
-  return yCoordsAbs[i][j];
+  return projection.getYAbs(i, j);
+}
+
+const MapProjection& Coaddition::getProjection()
+{
+  return projection;
 }
 
 int Coaddition::getNSources()
@@ -19,6 +19,10 @@ using namespace std;
 #include <gsl/gsl_sort_vector.h>
 #include "Coaddition.h"
 #include "NoiseRealizations.h"
+#include "ObsIndex.h"
+#include "Distributor.h"
+#include "Journal.h"
+#include "TiledMap.h"
 #include "Telescope.h"
 #include "vector_utilities.h"
 
@@ -36,20 +40,12 @@ NoiseRealizations::NoiseRealizations(AnalParams* analParams)
   //the number of noise files to produce
   nNoiseFiles = ap->getNRealizations();
 
-  //the path for the produced noise files
+  //all realizations go into a single store in the noise path
   noisePath = ap->getNoisePath();
-  string np = noisePath;
-  np.append("noise");
-
-  //a string array for the filenames
-  noiseFiles = new string [nNoiseFiles];
-  for(int i=0;i<nNoiseFiles;i++){
-    noiseFiles[i] = np;
-    stringstream o;
-    o << i;
-    noiseFiles[i].append(o.str());
-    noiseFiles[i].append(".nc");
-  }
+  noiseFile = noisePath;
+  noiseFile.append("noiseRealizations.nc");
+  store = NULL;
+  noise = NULL;
 
   //save typing
   pixelSize = ap->getPixelSize()/3600./360.*TWO_PI;
@@ -65,6 +61,71 @@ NoiseRealizations::NoiseRealizations(AnalParams* analParams)
 }
 
 
+//----------------------------- o ---------------------------------------
+
+///flattens a realization (map, histogram and psds) into one message
+/** The layout is image, then each vector preceded by its length and
+    each 2d psd by its two dimensions.
+**/
+static void packRealization(Map* m, VecDoub &packed)
+{
+  int nr = m->image.nrows();
+  int nc = m->image.ncols();
+  int nh = m->histBins.size();
+  int np = m->psd.size();
+  int nx = m->psd2d.nrows();
+  int ny = m->psd2d.ncols();
+  packed.resize(2+nr*nc + 1+2*nh + 1+2*np + 2+2*nx*ny);
+  long p = 0;
+  packed[p++] = nr;
+  packed[p++] = nc;
+  for(int i=0;i<nr;i++) for(int j=0;j<nc;j++) packed[p++] = m->image[i][j];
+  packed[p++] = nh;
+  for(int i=0;i<nh;i++) packed[p++] = m->histBins[i];
+  for(int i=0;i<nh;i++) packed[p++] = m->histVals[i];
+  packed[p++] = np;
+  for(int i=0;i<np;i++) packed[p++] = m->psd[i];
+  for(int i=0;i<np;i++) packed[p++] = m->psdFreq[i];
+  packed[p++] = nx;
+  packed[p++] = ny;
+  for(int i=0;i<nx;i++) for(int j=0;j<ny;j++) packed[p++] = m->psd2d[i][j];
+  for(int i=0;i<nx;i++) for(int j=0;j<ny;j++) packed[p++] = m->psd2dFreq[i][j];
+}
+
+///the inverse of packRealization(), false if packed is malformed
+static bool unpackRealization(VecDoub &packed, Map* m)
+{
+  long n = packed.size();
+  long p = 0;
+  if(n < 2) return 0;
+  int nr = packed[p++];
+  int nc = packed[p++];
+  if(nr != m->image.nrows() || nc != m->image.ncols() || p+(long) nr*nc >= n)
+    return 0;
+  for(int i=0;i<nr;i++) for(int j=0;j<nc;j++) m->image[i][j] = packed[p++];
+  int nh = packed[p++];
+  if(nh < 0 || p+2*nh >= n) return 0;
+  m->histBins.resize(nh);
+  m->histVals.resize(nh);
+  for(int i=0;i<nh;i++) m->histBins[i] = packed[p++];
+  for(int i=0;i<nh;i++) m->histVals[i] = packed[p++];
+  int np = packed[p++];
+  if(np < 0 || p+2*np+1 >= n) return 0;
+  m->psd.resize(np);
+  m->psdFreq.resize(np);
+  for(int i=0;i<np;i++) m->psd[i] = packed[p++];
+  for(int i=0;i<np;i++) m->psdFreq[i] = packed[p++];
+  int nx = packed[p++];
+  int ny = packed[p++];
+  if(nx < 0 || ny < 0 || p+2*(long) nx*ny != n) return 0;
+  m->psd2d.resize(nx, ny);
+  m->psd2dFreq.resize(nx, ny);
+  for(int i=0;i<nx;i++) for(int j=0;j<ny;j++) m->psd2d[i][j] = packed[p++];
+  for(int i=0;i<nx;i++) for(int j=0;j<ny;j++) m->psd2dFreq[i][j] = packed[p++];
+  return 1;
+}
+
+
 //----------------------------- o ---------------------------------------
 
 ///the workhorse of NoiseRealizations - generates them all
@@ -76,8 +137,10 @@ NoiseRealizations::NoiseRealizations(AnalParams* analParams)
      - coadd them using the corresponding weight maps
      - generate the histogram of each coadded noise map
      - generate the 1-d psd of each coadded noise map
-     - write this all to a netcdf file
+     - write this all into the realization store
      - repeat this a bunch of times.
+    In a distributed run every rank makes its share of the realizations
+    and sends them to the root, which alone writes the store.
     Note that the idea of 5 jacknifed maps for each observation is 
     hard coded.  This should probably be made into an AnalParam parameter.
     \todo There could be significant savings in the psd generation for
@@ -99,14 +162,8 @@ bool NoiseRealizations::generateNoiseRealizations(Coaddition* cmap)
   for(int i=0;i<nrows;i++) rowCoordsPhys[i] = cmap->getRowCoordsPhys(i);
   for(int i=0;i<ncols;i++) colCoordsPhys[i] = cmap->getColCoordsPhys(i);
 
-  //matrices of absolute coordinates
-  xCoordsAbs.resize(nrows,ncols);
-  yCoordsAbs.resize(nrows,ncols);
-  for(int i=0;i<nrows;i++)
-    for(int j=0;j<ncols;j++){
-      xCoordsAbs[i][j] = cmap->getXCoordsAbs(i,j);
-      yCoordsAbs[i][j] = cmap->getYCoordsAbs(i,j);
-    }
+  //absolute coordinates
+  projection = cmap->getProjection();
 
   //and the weight map
   //the weights are the same as in cmap but we need them here later
@@ -120,6 +177,37 @@ bool NoiseRealizations::generateNoiseRealizations(Coaddition* cmap)
   noise = new Map(string("noise"), nrows, ncols, pixelSize,
 		  weight, rowCoordsPhys, colCoordsPhys);
 
+  //and the file holding all of the realizations, which in a
+  //distributed run only the root rank writes.  When resuming, the
+  //realizations of a store left by an earlier run are kept.
+  Distributor* dist = ap->getDistributor();
+  Journal* journal = ap->getJournal();
+  if(!dist || dist->isRoot())
+    store = new NoiseStore(ap, noiseFile, nNoiseFiles, rowCoordsPhys,
+                           colCoordsPhys, projection, masterGrid,
+                           journal && ap->getResume());
+
+  //the realizations already in the store, all ranks need to know
+  double storeId = (store) ? store->getStoreId() : 0.;
+  if(dist && dist->isDistributed()){
+    VecDoub id(1, storeId);
+    if(store) dist->send("noiseStore", &id[0], 1);
+    else dist->receive("noiseStore", 0, id);
+    storeId = id[0];
+  }
+  VecBool done(nNoiseFiles);
+  vector<string> stamps(nNoiseFiles);
+  int nDone = 0;
+  for(int inoise=0;inoise<nNoiseFiles;inoise++){
+    done[inoise] = 0;
+    if(!journal) continue;
+    stamps[inoise] = journal->noiseStamp(storeId, inoise);
+    done[inoise] = journal->isDone(stamps[inoise]);
+    if(done[inoise]) nDone++;
+  }
+  if(nDone > 0) cerr << "NoiseRealizations(): " << nDone << " of " << nNoiseFiles
+		     << " noise maps are in the store already." << endl;
+
   Map *myNoise=NULL;
   int mynrows= nrows;
   int myncols = ncols;
@@ -137,29 +225,24 @@ bool NoiseRealizations::generateNoiseRealizations(Coaddition* cmap)
   {
   #pragma omp for schedule(dynamic)
   for(int inoise=0;inoise<nNoiseFiles;inoise++){
+    if(done[inoise] || (dist && !dist->ownsTask(inoise))) continue;
 	myNoise = new Map(string("noise"), mynrows, myncols, myPixelSize,
 			  weight, myRow, myCol);
     myNoise->image.assign(mynrows,myncols,0.);
     for(int k=0;k<nFiles;k++){
-    	VecDoub rcp(0);
-    	VecDoub ccp(0);
-    	MatDoub os(0,0);
-    	MatDoub ow(0,0);
-    	double onrows=0;
-    	double oncols=0;
+    	TiledMap* otm = NULL;
+
+	//the map geometry from the index the coaddition left behind
+	ObsIndex* index = ObsIndex::forMapFile(ap->getMapFileList(k).c_str());
+	double onrows = index->getInt("nrows");
+	double oncols = index->getInt("ncols");
+	double rcp0 = index->getDouble("rowCoordsPhysFirst");
+	double ccp0 = index->getDouble("colCoordsPhysFirst");
+	delete index;
 #pragma omp critical (noiseDataIO)
     	{
 	  NcFile ncfid = NcFile(ap->getMapFileList(k).c_str(), NcFile::ReadOnly);
 	  
-	  onrows = ncfid.get_dim("nrows")->size();
-	  oncols = ncfid.get_dim("ncols")->size();
-	  NcVar* rcpv = ncfid.get_var("rowCoordsPhys");
-	  NcVar* ccpv = ncfid.get_var("colCoordsPhys");
-	  rcp.resize(onrows);
-	  ccp.resize(oncols);
-	  for(int i=0;i<onrows;i++) rcp[i] = rcpv->as_double(i);
-	  for(int j=0;j<oncols;j++) ccp[j] = ccpv->as_double(j);
-	  
 	  //randomly choose one of the noise maps
 	  int nN = ap->getNNoiseMapsPerObs();
 	  n = floor(ran->uniformDeviate(1,nN));
@@ -168,23 +251,34 @@ bool NoiseRealizations::generateNoiseRealizations(Coaddition* cmap)
 	  stringstream o;
 	  o << n;
 	  onoise.append(o.str());
-	  NcVar* osVar = ncfid.get_var(onoise.c_str());
-	  NcVar* owVar = ncfid.get_var("weight");
-	  os.resize(onrows,oncols);
-	  ow.resize(onrows,oncols);
-	  osVar->get(&os[0][0], onrows, oncols);
-	  owVar->get(&ow[0][0], onrows, oncols);
+	  otm = TiledMap::readFromNcdf(ncfid, {onoise, "weight"},
+	                               ap->getMapTileSize());
     	}
+      if(!otm){
+        cerr << "NoiseRealizations(): cannot read noise maps from ";
+        cerr << ap->getMapFileList(k) << endl;
+        exit(1);
+      }
+      int ts = otm->getTileSize();
+
       //the index deltas
-      int deltai = (rcp[0]-rowCoordsPhys[0])/pixelSize;
-      int deltaj = (ccp[0]-colCoordsPhys[0])/pixelSize;
+      int deltai = (rcp0-rowCoordsPhys[0])/pixelSize;
+      int deltaj = (ccp0-colCoordsPhys[0])/pixelSize;
       
-      //now loop through the observation maps
-      for(int oi=0;oi<onrows;oi++){
-    	  for(int oj=0;oj<oncols;oj++){
-    		  myNoise->image[oi+deltai][oj+deltaj] += ow[oi][oj]*os[oi][oj];
-    	  }
+      //now loop through the covered tiles of the observation maps
+      for(int s=0;s<otm->getNTiles();s++){
+    	  const double* os = otm->getTile(s, 0);
+    	  const double* ow = otm->getTile(s, 1);
+    	  int r0 = otm->getTileRow0(s);
+    	  int c0 = otm->getTileCol0(s);
+    	  int tnr = min(ts, (int) onrows-r0);
+    	  int tnc = min(ts, (int) oncols-c0);
+    	  for(int ti=0;ti<tnr;ti++)
+    		  for(int tj=0;tj<tnc;tj++)
+    			  myNoise->image[r0+ti+deltai][c0+tj+deltaj] +=
+    				  ow[ti*ts+tj]*os[ti*ts+tj];
       }
+      delete otm;
     }
 
 
@@ -201,10 +295,31 @@ bool NoiseRealizations::generateNoiseRealizations(Coaddition* cmap)
     //calculate the noise map psd
     myNoise->calcMapPsd(ap->getCoverageThreshold());
 
-    //write the noise map, psd, and histogram out to a file
+    //store the noise map, psd, and histogram, or send them to the
+    //root rank to store
+    bool stored = 1;
+    if(store){
 	#pragma omp critical (noiseDataIO)
-    {
-    	writeNoiseMapToNcdf(noiseFiles[inoise], myNoise);
+      {
+	stored = store->writeRealization(inoise, myNoise);
+	if(stored && journal){
+	  stored = store->sync();
+	  ostringstream what;
+	  what << "noise " << inoise;
+	  if(stored) journal->markDone(stamps[inoise], what.str());
+	}
+      }
+    } else {
+      VecDoub packed;
+      packRealization(myNoise, packed);
+      ostringstream name;
+      name << "noise." << inoise;
+      dist->send(name.str(), &packed[0], packed.size());
+    }
+    if(!stored){
+      cerr << "NoiseRealizations(): failed to store noise map " << inoise
+           << " in " << noiseFile << endl;
+      exit(1);
     }
     //what a waste of time this is ... sigh
     int tid;
@@ -219,107 +334,37 @@ bool NoiseRealizations::generateNoiseRealizations(Coaddition* cmap)
 
   }
   }
-  cerr << endl;
-  cerr << "Noise maps, psds and histograms written to " << noisePath << endl;
-  
-  return 1;
-}
-
-
-//----------------------------- o ---------------------------------------
-
-///writes noise maps, histograms, psds and metadata to netcdf file
-bool NoiseRealizations::writeNoiseMapToNcdf(string mapFileName, Map *noise)
-{
-  //create the file
-  NcFile ncfid = NcFile(mapFileName.c_str(), NcFile::Replace, NULL, 0, NcFile::Offset64Bits);
-  if (!ncfid.is_valid()){
-    cerr << "Couldn't open map netcdf file for writing!\n";
-    return 0;
+  //the root stores the realizations made by the other ranks
+  if(dist && dist->isDistributed() && store){
+    VecDoub packed;
+    for(int inoise=0;inoise<nNoiseFiles;inoise++){
+      if(done[inoise] || dist->ownsTask(inoise)) continue;
+      ostringstream name;
+      name << "noise." << inoise;
+      dist->receive(name.str(), dist->taskOwner(inoise), packed);
+      if(!unpackRealization(packed, noise) ||
+	 !store->writeRealization(inoise, noise)){
+	cerr << "NoiseRealizations(): failed to store noise map " << inoise
+	     << " from rank " << dist->taskOwner(inoise) << endl;
+	exit(1);
+      }
+      if(journal){
+	ostringstream what;
+	what << "noise " << inoise;
+	if(store->sync()) journal->markDone(stamps[inoise], what.str());
+      }
+      cerr << "NoiseRealizations(): Stored noise map " << inoise+1
+	   << " from rank " << dist->taskOwner(inoise) << endl;
+    }
   }
 
-  //create dimensions
-  NcDim* rowDim = ncfid.add_dim("nrows", nrows);
-  NcDim* colDim = ncfid.add_dim("ncols", ncols);
-
-  //define variables for maps
-  NcVar *noiseVar = ncfid.add_var("noise", ncDouble, rowDim, colDim);
-  NcVar *weightVar = ncfid.add_var("weight", ncDouble, rowDim, colDim);
-  NcVar *rCPhysVar = ncfid.add_var("rowCoordsPhys", ncDouble, rowDim);
-  NcVar *cCPhysVar = ncfid.add_var("colCoordsPhys", ncDouble, colDim);
-  NcVar *xCAbsVar = ncfid.add_var("xCoordsAbs", ncDouble, rowDim, colDim);
-  NcVar *yCAbsVar = ncfid.add_var("yCoordsAbs", ncDouble, rowDim, colDim);
-
-  //and write the maps
-  noiseVar->put(&noise->image[0][0], nrows, ncols);
-  weightVar->put(&noise->weight[0][0], nrows, ncols);
-  rCPhysVar->put(&rowCoordsPhys[0], nrows);
-  cCPhysVar->put(&colCoordsPhys[0], ncols);
-  xCAbsVar->put(&xCoordsAbs[0][0], nrows, ncols);
-  yCAbsVar->put(&yCoordsAbs[0][0], nrows, ncols);
-
-  //the histogram bins and values
-  //create dimension
-  NcDim* histDim = ncfid.add_dim("nhist", noise->histBins.size());
-  //define hist variables
-  NcVar *binVar = ncfid.add_var("histBins", ncDouble, histDim);
-  NcVar *valVar = ncfid.add_var("histVals", ncDouble, histDim);
-  //put in the values
-  binVar->put(&noise->histBins[0], noise->histBins.size());
-  valVar->put(&noise->histVals[0], noise->histBins.size());
-
-  //the psd freqs and values
-  //create dimension
-  NcDim* psdDim = ncfid.add_dim("npsd", noise->psd.size());
-  //define psd variables
-  NcVar *freqVar = ncfid.add_var("psdFreq", ncDouble, psdDim);
-  NcVar *psdVar = ncfid.add_var("psd", ncDouble, psdDim);
-  //put in the values
-  freqVar->put(&noise->psdFreq[0], noise->psd.size());
-  psdVar->put(&noise->psd[0], noise->psd.size());
-
-  string psdDimName = "nxpsd_2d";
-
-  int nx = noise->psd2d.nrows();
-  int ny = noise->psd2d.ncols();
-
-  NcDim* psdDim2d_x = ncfid.add_dim(psdDimName.c_str(), nx);
-  psdDimName = "nypsd_2d";
-  NcDim* psdDim2d_y = ncfid.add_dim(psdDimName.c_str(), ny);
-
-  string psdVarName = "psd_2d";
-  string psdFreqName = "psdFreq_2d";
-
-  NcVar *psdVar2d = ncfid.add_var(psdVarName.c_str(), ncDouble, psdDim2d_x, psdDim2d_y);
-  NcVar *psdFreqVar2d = ncfid.add_var(psdFreqName.c_str(), ncDouble, psdDim2d_x, psdDim2d_y);
-
-  psdVar2d->put(&noise->psd2d[0][0], nx,ny);
-  psdFreqVar2d->put(&noise->psd2dFreq[0][0], nx,ny);
-
-
-  //get the time and date of this analysis
-  time_t rawtime;
-  struct tm* timeinfo;
-  time(&rawtime);
-  timeinfo = localtime(&rawtime);
-  string t = asctime(timeinfo);
-  t = t.substr(0,t.length()-1);
-
-  //also log all of the analysis parameters used as global atributes
-  ncfid.add_att("source",ap->getSourceName().c_str());
-  ncfid.add_att("analysisDate", t.c_str());
-  ncfid.add_att("dataFile", ap->getCoaddOutFile().c_str());
-  ncfid.add_att("despikeSigma", ap->getDespikeSigma());
-  ncfid.add_att("lowpassFilterKnee", ap->getLowpassFilterKnee());
-  ncfid.add_att("timeOffset", ap->getTimeOffset());
-  ncfid.add_att("timeChunk", ap->getTimeChunk());
-  ncfid.add_att("neigToCut", ap->getNeigToCut());
-  ncfid.add_att("cutStd", ap->getCutStd());
-  ncfid.add_att("pixelSize", ap->getPixelSize());
-  ncfid.add_att("approximateWeights", ap->getApproximateWeights());
-  ncfid.add_att("MasterGrid[0]",masterGrid[0]);
-  ncfid.add_att("MasterGrid[1]",masterGrid[1]);
- 
+  cerr << endl;
+  if(!store){
+    cerr << "Noise maps sent to the root rank." << endl;
+    return 1;
+  }
+  cerr << "Noise maps, psds and histograms written to " << noiseFile << endl;
+  
   return 1;
 }
 
@@ -348,16 +393,20 @@ bool NoiseRealizations::makeAverageHistogram(bool filtered)
 
 
   //loop through the noise histograms and generate an average histogram
-  //start by finding the min and max bins
+  //start by finding the min and max bins, the histograms are small so
+  //they are all kept rather than read from the store twice
   double binmin=0., binmax=0.;
-  VecDoub bins;
+  vector<VecDoub> allBins(nNoiseFiles);
+  vector<VecDoub> allVals(nNoiseFiles);
   int nhist=0;
   for(int i=0;i<nNoiseFiles;i++){
-    NcFile ncfid = NcFile(noiseFiles[i].c_str(), NcFile::ReadOnly);
-    nhist = ncfid.get_dim(dimname.c_str())->size();
-    NcVar* histbinv = ncfid.get_var(binname.c_str());
-    bins.resize(nhist);
-    for(int j=0;j<nhist;j++) bins[j] = histbinv->as_double(j);
+    if(!store->readHistogram(i, filtered, allBins[i], allVals[i])){
+      cerr << "NoiseRealizations::makeAverageHistogram(): ";
+      cerr << "cannot read histogram " << i << endl;
+      exit(1);
+    }
+    VecDoub &bins = allBins[i];
+    nhist = bins.size();
     if(i == 0){
       binmin = bins[0];
       binmax = bins[0];
@@ -376,18 +425,10 @@ bool NoiseRealizations::makeAverageHistogram(bool filtered)
   //set new bin ranges
   gsl_histogram_set_ranges_uniform(h, binmin, binmax);
 
-  //fill up the histogram by looping back through the files
+  //fill up the histogram from the stored realization histograms
   for(int i=0;i<nNoiseFiles;i++){
-    NcFile ncfid = NcFile(noiseFiles[i].c_str(), NcFile::ReadOnly);
-    int nhisti = ncfid.get_dim(dimname.c_str())->size();
-    if (nhisti != nhist){
-      cerr << "Noise map histogram bins are not consistently sized." << endl;
-      exit(1);
-    }
-    NcVar* histbinv = ncfid.get_var(binname.c_str());
-    NcVar* histvalv = ncfid.get_var(valname.c_str());
     for(int j=0;j<nhist;j++){
-      gsl_histogram_accumulate(h, histbinv->as_double(j), histvalv->as_double(j));
+      gsl_histogram_accumulate(h, allBins[i][j], allVals[i][j]);
     }
     cerr << "Histogram for noise map " << i << "\r";
   }
@@ -427,9 +468,8 @@ bool NoiseRealizations::makeAverageHistogram(bool filtered)
 //----------------------------- o ---------------------------------------
 
 //makes the average noise psd from the set of coadded noise maps
-/** Simply reads the individual noise psds from the coadded noise
-    map files and averages them.  The output is written to its own
-    netcdf file.
+/** Simply reads the individual noise psds from the realization store
+    and averages them.  The output is written to its own netcdf file.
     \todo Check output to verify that it is indeed the average psd.
 **/
 bool NoiseRealizations::makeAveragePsd()
@@ -437,41 +477,32 @@ bool NoiseRealizations::makeAveragePsd()
   //use the last noise file to initially size the psd vectors
   //psdFreq.assign(noise->psdFreq.size(),0.);
   //psd.assign(noise->psd.size(),0.);
+	VecDoub tmp;
+	VecDoub tmpFreq;
 	MatDoub tmpPsd;
 	MatDoub tmpPsdFreq;
   //loop through the noise psd and generate an average psd
 	for(int i=0;i<nNoiseFiles;i++){
-		NcFile ncfid = NcFile(noiseFiles[i].c_str(), NcFile::ReadOnly);
-		uint npsd = ncfid.get_dim("npsd")->size();
-		uint nxpsd2d = ncfid.get_dim("nxpsd_2d")->size();
-		uint nypsd2d = ncfid.get_dim("nypsd_2d")->size();
+		if(!store->readPsd(i, tmp, tmpFreq, tmpPsd, tmpPsdFreq)){
+			cerr << "NoiseRealizations::makeAveragePsd(): ";
+			cerr << "cannot read psd " << i << endl;
+			exit(1);
+		}
+		uint npsd = tmp.size();
+		uint nxpsd2d = tmpPsd.nrows();
+		uint nypsd2d = tmpPsd.ncols();
 		if (i==0){
 			cerr<< "PSD: "<< nxpsd2d<<","<<nypsd2d;
 			psdFreq.assign(npsd,0.);
 			psd.assign(npsd,0.);
 			psd2d.assign(nxpsd2d,nypsd2d,0.);
 			psd2dFreq.assign (nxpsd2d,nypsd2d,0.);
-			tmpPsd.assign(nxpsd2d,nypsd2d,0.);
-			tmpPsdFreq.assign(nxpsd2d,nypsd2d,0.);
-		} else{
-			if(npsd != psd.size()){
-				cerr << "NoiseRealizations::makeAveragePsd(): ";
-				cerr << "variation in psd lengths.  Check noise files." << endl;
-				exit(1);
-			}
 		}
-		NcVar* psdv = ncfid.get_var("psd");
-		NcVar* psdfv = ncfid.get_var("psdFreq");
-		NcVar* psdv2d = ncfid.get_var("psd_2d");
-		NcVar* psdf2d = ncfid.get_var("psdFreq_2d");
 		for(uint ip=0;ip<npsd;ip++){
-			psd[ip] += psdv->as_double(ip);
-			psdFreq[ip] = psdfv->as_double(ip);
+			psd[ip] += tmp[ip];
+			psdFreq[ip] = tmpFreq[ip];
 		}
 
-		psdv2d->get(&tmpPsd[0][0], nxpsd2d,nypsd2d);
-		psdf2d->get(&tmpPsdFreq[0][0], nxpsd2d,nypsd2d);
-
 		for (uint ip=0; ip<nxpsd2d; ip++)
 			for (uint jp=0; jp<nypsd2d; jp++){
 				psd2d[ip][jp]+=  tmpPsd[ip][jp] /nNoiseFiles;
@@ -522,177 +553,100 @@ bool NoiseRealizations::makeAveragePsd()
 
 //----------------------------- o ---------------------------------------
 
-bool NoiseRealizations::calculateAverageFilteredRms(double cov)
+///normalizes, measures and histograms the filtered noise realizations
+/** One sweep over the store that does for every filtered realization
+    what used to be three separate passes over the noise files:
+     - renormalizes the filtered weight map so that the weights match
+       the measured noise in the coverage region and stores it back,
+     - measures the rms of the filtered noise in the coverage region,
+     - histograms the filtered noise map with coverage cut cov.
+    The weight threshold only scales with the renormalization so it is
+    found once on the input weights.  The average rms is left in
+    averageFilteredRms.
+**/
+bool NoiseRealizations::analyzeFilteredNoise(double cov)
 {
   VecDoub mapRms(nNoiseFiles);
 
+  #pragma omp parallel for schedule(dynamic)
   for(int k=0;k<nNoiseFiles;k++){
-    //open the noise file
-    NcFile ncfid = NcFile(noiseFiles[k].c_str());
-    
-    //the input array dims
-    int nr = ncfid.get_dim("nrows")->size();
-    int nc = ncfid.get_dim("ncols")->size();
-    
-    //the actual noise matrix
-    MatDoub mynoise(nr, nc);
-    NcVar* noisev = ncfid.get_var("filteredNoise");
-    noisev->get(&mynoise[0][0], nr, nc);
-
-    //the corresponding weight matrix
-    MatDoub myweight(nr, nc);
-    NcVar* weightv = ncfid.get_var("filteredWeight");
-    weightv->get(&myweight[0][0], nr, nc);
-
-    //find the weight threshold corresponding to coverage cut=cov
-    double myWeightCut = findWeightThreshold(myweight,cov);
-
-    //find the rms of the pixels with weight greater than myWeightCut
-    int counter=0;
-    double rms=0.;
-    for(int i=0;i<nr;i++)
-      for(int j=0;j<nc;j++){
-	if(myweight[i][j] > myWeightCut){
-	  counter++;
-	  rms += pow(mynoise[i][j],2);
-	}
-      }
-    rms /= (counter);
-    mapRms[k] = sqrt(rms);
-
-    cerr << "Filtered noise rms for map " << k << " = " << mapRms[k] 
-	 << "\r";
-  }
-  cerr << endl;
-
-  //calculate the average rms
-  double rms=0.;
-  for(int k=0;k<nNoiseFiles;k++) rms += mapRms[k];
-  rms /= nNoiseFiles;
-  averageFilteredRms = rms;
-
-  cerr << "Noise Realizations: Average Filtered RMS=" << averageFilteredRms << endl;
-
-  return 1;
-}
-
-
-
-//----------------------------- o ---------------------------------------
-
-bool NoiseRealizations::normalizeErrors(double cov)
-{
-  for(int k=0;k<nNoiseFiles;k++){
-
-    //open the noise file
-    NcFile ncfid = NcFile(noiseFiles[k].c_str(), NcFile::Write);
-    
-    //the input array dims
-    int nr = ncfid.get_dim("nrows")->size();
-    int nc = ncfid.get_dim("ncols")->size();
-    
-    //the actual noise matrix
-    MatDoub myNoise(nr, nc);
-    NcVar* noisev = ncfid.get_var("filteredNoise");
-    noisev->get(&myNoise[0][0], nr, nc);
-
-    //the corresponding weight matrix
-    MatDoub myWeight(nr, nc);
-    NcVar* weightv = ncfid.get_var("filteredWeight");
-    weightv->get(&myWeight[0][0], nr, nc);
+    MatDoub myNoise;
+    MatDoub myWeight;
+    bool ok;
+#pragma omp critical (noiseDataIO)
+    {
+      ok = store->readFiltered(k, myNoise, myWeight);
+    }
+    if(!ok){
+      cerr << "NoiseRealizations::analyzeFilteredNoise(): ";
+      cerr << "cannot read filtered noise map " << k << endl;
+      exit(1);
+    }
 
     //find the weight threshold corresponding to coverage cut=cov
     double myWeightCut = findWeightThreshold(myWeight,cov);
 
-    //find the rms of the pixels with weight greater than myWeightCut
-    double counter=0;
+    //sums over the good coverage region for the rms, the map sigma
+    //and the mean sqerr (mean(1/wt))
+    double rmsCounter=0.;
+    double rms=0.;
+    double counter=0.;
     double sig_of_map=0.;
-    for(int i=0;i<nr;i++)
-      for(int j=0;j<nc;j++){
-	if(myWeight[i][j] >= myWeightCut){
-	  counter++;
-	  sig_of_map += pow(myNoise[i][j],2);
-	}
-      }
-    sig_of_map /= (counter-1);
-    sig_of_map = sqrt(sig_of_map);
-
-    //find the mean sqerr (mean(1/wt) for good coverage region
-    double mean_sqerr=0;
-    counter=0.;
-    for(int i=0;i<nr;i++)
-      for(int j=0;j<nc;j++){
-	if(myWeight[i][j] >= myWeightCut){
+    double mean_sqerr=0.;
+    for(int i=0;i<nrows;i++)
+      for(int j=0;j<ncols;j++){
+	double w = myWeight[i][j];
+	double n2 = myNoise[i][j]*myNoise[i][j];
+	if(w >= myWeightCut){
 	  counter++;
-	  mean_sqerr += (1./myWeight[i][j]);
+	  sig_of_map += n2;
+	  mean_sqerr += 1./w;
+	  if(w > myWeightCut){
+	    rmsCounter++;
+	    rms += n2;
+	  }
 	}
       }
+    mapRms[k] = sqrt(rms/rmsCounter);
+    sig_of_map = sqrt(sig_of_map/(counter-1));
     mean_sqerr /= counter;
 
     //the renormalization factor
     double nfac = (1./pow(sig_of_map,2.))*mean_sqerr;
-
-    for(int i=0;i<nr;i++)
-      for(int j=0;j<nc;j++)
+    for(int i=0;i<nrows;i++)
+      for(int j=0;j<ncols;j++)
 	myWeight[i][j] *= nfac;
 
-    //write the updated weight map back into the noise file
-    weightv->put(&myWeight[0][0], nr, nc);
-  }
-  cerr << endl;
-  return 1;
-}
-
-
-//----------------------------- o ---------------------------------------
+    //histogram the map with the renormalized weights
+    Map myNoiseMap(string("filteredNoise"), nrows, ncols, pixelSize,
+		   myWeight, rowCoordsPhys, colCoordsPhys);
+    myNoiseMap.image = myNoise;
+    myNoiseMap.calcMapHistogram(200, cov);
 
-bool NoiseRealizations::calcFilteredNoiseMapsHistogram(double cov)
-{
-  for(int k=0;k<nNoiseFiles;k++){
+#pragma omp critical (noiseDataIO)
+    {
+      ok = store->writeFilteredWeight(k, myWeight) &&
+	store->writeFilteredHistogram(k, myNoiseMap.histBins,
+				      myNoiseMap.histVals);
+    }
+    if(!ok){
+      cerr << "NoiseRealizations::analyzeFilteredNoise(): ";
+      cerr << "cannot store results for filtered noise map " << k << endl;
+      exit(1);
+    }
+  }
 
-    //open the noise file
-    NcFile ncfid = NcFile(noiseFiles[k].c_str(), NcFile::Write);
-    
-    //the input array dims
-    int nr = ncfid.get_dim("nrows")->size();
-    int nc = ncfid.get_dim("ncols")->size();
-    
-    //the actual noise matrix
-    MatDoub myNoise(nr, nc);
-    NcVar* noisev = ncfid.get_var("filteredNoise");
-    noisev->get(&myNoise[0][0], nr, nc);
-
-    //the corresponding weight matrix
-    MatDoub myWeight(nr, nc);
-    NcVar* weightv = ncfid.get_var("filteredWeight");
-    weightv->get(&myWeight[0][0], nr, nc);
-
-    //grab the row and column coordinates (physical)
-    VecDoub myRow(nr);
-    VecDoub myCol(nc);
-    NcVar* rcp = ncfid.get_var("rowCoordsPhys");
-    rcp->get(&myRow[0],nr);
-    NcVar* ccp = ncfid.get_var("colCoordsPhys");
-    ccp->get(&myCol[0],nc);
-
-    //pack these into a Map object
-    Map *myNoiseMap;
-    myNoiseMap = new Map(string("filteredNoise"), nr, nc, pixelSize,
-			 myWeight, myRow, myCol);
-    for(int i=0;i<nr;i++)
-      for(int j=0;j<nc;j++){
-	myNoiseMap->image[i][j] = myNoise[i][j];
-	myNoiseMap->weight[i][j] = myWeight[i][j];
-      }
+  for(int k=0;k<nNoiseFiles;k++)
+    cerr << "Filtered noise rms for map " << k << " = " << mapRms[k] << endl;
 
-    //histogram the map and write into mapFile
-    myNoiseMap->mapFile = noiseFiles[k].c_str();
-    myNoiseMap->calcMapHistogram(200, cov);
+  //calculate the average rms
+  double rms=0.;
+  for(int k=0;k<nNoiseFiles;k++) rms += mapRms[k];
+  rms /= nNoiseFiles;
+  averageFilteredRms = rms;
 
-   delete myNoiseMap;
+  cerr << "Noise Realizations: Average Filtered RMS=" << averageFilteredRms << endl;
 
-  }
-  cerr << endl;
   return 1;
 }
 
@@ -702,5 +656,5 @@ bool NoiseRealizations::calcFilteredNoiseMapsHistogram(double cov)
 NoiseRealizations::~NoiseRealizations()
 {
   delete noise;
-  delete [] noiseFiles;
+  delete store;
 }
@@ -0,0 +1,397 @@
+#include <netcdfcpp.h>
+#include <iostream>
+#include <string>
+#include <ctime>
+#include <algorithm>
+#include <unistd.h>
+using namespace std;
+
+#include "nr3.h"
+#include "AnalParams.h"
+#include "Map.h"
+#include "MapProjection.h"
+#include "NcCompression.h"
+#include "Journal.h"
+#include "NoiseStore.h"
+
+///NoiseStore constructor
+/** Creates the store file and writes everything that is common to all
+    of the realizations: coordinates, projection and the analysis
+    parameters.  The realization variables are defined when the first
+    realization is written since the psd sizes are only known then.
+    With reopen set an existing store of the same map is kept, with
+    the realizations already in it, instead.
+**/
+NoiseStore::NoiseStore(AnalParams* analParams, string fName, int nReal,
+                       VecDoub &rowCoordsPhys, VecDoub &colCoordsPhys,
+                       const MapProjection &projection, VecDoub &masterGrid,
+                       bool reopen)
+{
+  ap = analParams;
+  fileName = fName;
+  nRealizations = nReal;
+  nrows = rowCoordsPhys.size();
+  ncols = colCoordsPhys.size();
+  defined = false;
+  reopened = false;
+
+  if(reopen && reopenStore(rowCoordsPhys, colCoordsPhys, masterGrid)) return;
+
+  //a new store gets a new id, so that nothing done in an older one
+  //can be mistaken for being in it
+  storeId = (double) time(NULL)*1.e3 + getpid()%1000;
+
+  NcCompression nc = ap->getNcCompression();
+  ncfid = new NcFile(fileName.c_str(), NcFile::Replace, NULL, 0,
+                     nc.getFileFormat());
+  if (!ncfid->is_valid()){
+    cerr << "Couldn't open " << fileName << " for writing." << endl;
+    exit(1);
+  }
+  //every value of the cubes is written, skip the fill pass
+  ncfid->set_fill(NcFile::NoFill);
+
+  //create dimensions, the realizations along the record dimension
+  //since in 64 bit offset files only the last fixed size variable
+  //may be larger than 4 GiB, and a record only holds one realization
+  ncfid->add_dim("nRealizations");
+  NcDim* rowDim = ncfid->add_dim("nrows", nrows);
+  NcDim* colDim = ncfid->add_dim("ncols", ncols);
+
+  //get the time and date of this analysis
+  time_t rawtime;
+  struct tm* timeinfo;
+  time(&rawtime);
+  timeinfo = localtime(&rawtime);
+  string t = asctime(timeinfo);
+  t = t.substr(0,t.length()-1);
+
+  //also log all of the analysis parameters used as global atributes
+  ncfid->add_att("source",ap->getSourceName().c_str());
+  ncfid->add_att("analysisDate", t.c_str());
+  ncfid->add_att("dataFile", ap->getCoaddOutFile().c_str());
+  ncfid->add_att("despikeSigma", ap->getDespikeSigma());
+  ncfid->add_att("lowpassFilterKnee", ap->getLowpassFilterKnee());
+  ncfid->add_att("timeOffset", ap->getTimeOffset());
+  ncfid->add_att("timeChunk", ap->getTimeChunk());
+  ncfid->add_att("neigToCut", ap->getNeigToCut());
+  ncfid->add_att("cutStd", ap->getCutStd());
+  ncfid->add_att("pixelSize", ap->getPixelSize());
+  ncfid->add_att("approximateWeights", ap->getApproximateWeights());
+  ncfid->add_att("MasterGrid[0]",masterGrid[0]);
+  ncfid->add_att("MasterGrid[1]",masterGrid[1]);
+  ncfid->add_att("storeId", storeId);
+  ncfid->add_att("nRealizations", nRealizations);
+
+  NcVar *rCPhysVar = ncfid->add_var("rowCoordsPhys", ncDouble, rowDim);
+  NcVar *cCPhysVar = ncfid->add_var("colCoordsPhys", ncDouble, colDim);
+  projection.writeToNcdf(*ncfid, rowDim, colDim, !ap->getWriteAbsCoords(), nc);
+  rCPhysVar->put(&rowCoordsPhys[0], nrows);
+  cCPhysVar->put(&colCoordsPhys[0], ncols);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///opens an existing store for more realizations, false if there is
+///none of this map
+/** The store must have the shape, the coordinates and the master grid
+    of this coaddition, and the journal must hold a current entry for
+    at least one of its realizations.  Only then were its weight map
+    and realizations made from the observation maps as they are now;
+    any other store is replaced by a new one.
+**/
+bool NoiseStore::reopenStore(VecDoub &rowCoordsPhys, VecDoub &colCoordsPhys,
+                             VecDoub &masterGrid)
+{
+  Journal* journal = ap->getJournal();
+  if(!journal) return 0;
+
+  NcError ncerror(NcError::silent_nonfatal);
+  ncfid = new NcFile(fileName.c_str(), NcFile::Write);
+  if(ncfid->is_valid()){
+    NcDim* realDim = ncfid->get_dim("nRealizations");
+    NcDim* rowDim = ncfid->get_dim("nrows");
+    NcDim* colDim = ncfid->get_dim("ncols");
+    NcAtt* idAtt = ncfid->get_att("storeId");
+    NcAtt* nAtt = ncfid->get_att("nRealizations");
+    NcAtt* mg0Att = ncfid->get_att("MasterGrid[0]");
+    NcAtt* mg1Att = ncfid->get_att("MasterGrid[1]");
+    NcVar* rCPhysVar = ncfid->get_var("rowCoordsPhys");
+    NcVar* cCPhysVar = ncfid->get_var("colCoordsPhys");
+    bool ok = realDim && rowDim && colDim && idAtt && nAtt && mg0Att &&
+      mg1Att && rCPhysVar && cCPhysVar && realDim->is_unlimited() &&
+      nAtt->as_int(0) == nRealizations && rowDim->size() == nrows &&
+      colDim->size() == ncols && ncfid->get_var("noise") &&
+      (!ap->getApplyWienerFilter() || ncfid->get_var("filteredNoise")) &&
+      mg0Att->as_double(0) == masterGrid[0] &&
+      mg1Att->as_double(0) == masterGrid[1];
+
+    //the coordinates as they were written, so compared exactly
+    if(ok){
+      VecDoub r(nrows);
+      VecDoub c(ncols);
+      ok = rCPhysVar->get(&r[0], nrows) && cCPhysVar->get(&c[0], ncols);
+      for(int i=0;ok && i<nrows;i++) ok = r[i] == rowCoordsPhys[i];
+      for(int i=0;ok && i<ncols;i++) ok = c[i] == colCoordsPhys[i];
+    }
+
+    if(ok){
+      storeId = idAtt->as_double(0);
+      ok = 0;
+      for(int k=0;!ok && k<nRealizations;k++)
+        ok = journal->isDone(journal->noiseStamp(storeId, k));
+    }
+    delete idAtt;
+    delete nAtt;
+    delete mg0Att;
+    delete mg1Att;
+    if(ok){
+      defined = true;
+      reopened = true;
+      return 1;
+    }
+  }
+  delete ncfid;
+  ncfid = NULL;
+  return 0;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+int NoiseStore::getNRealizations()
+{
+  return nRealizations;
+}
+
+int NoiseStore::getNrows()
+{
+  return nrows;
+}
+
+int NoiseStore::getNcols()
+{
+  return ncols;
+}
+
+string NoiseStore::getFileName()
+{
+  return fileName;
+}
+
+///identifies this store among all stores ever written to the file
+double NoiseStore::getStoreId()
+{
+  return storeId;
+}
+
+bool NoiseStore::isReopened()
+{
+  return reopened;
+}
+
+///flushes what was written so far to disk
+bool NoiseStore::sync()
+{
+  return ncfid->sync();
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///defines all of the per-realization variables in one go
+/** Sized from the first realization, all realizations share the same
+    weight map and therefore the same histogram and psd sizes.
+**/
+bool NoiseStore::defineRealizations(Map* noise)
+{
+  NcCompression nc = ap->getNcCompression();
+  NcDim* realDim = ncfid->get_dim("nRealizations");
+  NcDim* rowDim = ncfid->get_dim("nrows");
+  NcDim* colDim = ncfid->get_dim("ncols");
+  NcDim* histDim = ncfid->add_dim("nhist", noise->histBins.size());
+  NcDim* psdDim = ncfid->add_dim("npsd", noise->psd.size());
+  NcDim* psdDim2d_x = ncfid->add_dim("nxpsd_2d", noise->psd2d.nrows());
+  NcDim* psdDim2d_y = ncfid->add_dim("nypsd_2d", noise->psd2d.ncols());
+
+  //one realization per chunk, in blocks of whole rows
+  size_t chunks[3] = {1, (size_t) max(1, min(nrows, 131072/max(ncols, 1))),
+                      (size_t) ncols};
+  NcType noiseType = (ap->getNoiseFloat32()) ? ncFloat : ncDouble;
+
+  NcVar* noiseVar = ncfid->add_var("noise", noiseType, realDim, rowDim, colDim);
+  if(!nc.setStorage(*ncfid, noiseVar, chunks)) return 0;
+  NcVar* weightVar = nc.addMapVar(*ncfid, "weight", ncDouble, rowDim, colDim);
+  ncfid->add_var("histBins", ncDouble, realDim, histDim);
+  ncfid->add_var("histVals", ncDouble, realDim, histDim);
+  ncfid->add_var("psdFreq", ncDouble, realDim, psdDim);
+  ncfid->add_var("psd", ncDouble, realDim, psdDim);
+  ncfid->add_var("psd_2d", ncDouble, realDim, psdDim2d_x, psdDim2d_y);
+  ncfid->add_var("psdFreq_2d", ncDouble, realDim, psdDim2d_x, psdDim2d_y);
+
+  if(ap->getApplyWienerFilter()){
+    NcDim* fHistDim = ncfid->add_dim("nhist_filteredNoise",
+                                     noise->histBins.size());
+    NcVar* fnVar = ncfid->add_var("filteredNoise", noiseType,
+                                  realDim, rowDim, colDim);
+    NcVar* fwVar = ncfid->add_var("filteredWeight", ncDouble,
+                                  realDim, rowDim, colDim);
+    if(!nc.setStorage(*ncfid, fnVar, chunks)) return 0;
+    if(!nc.setStorage(*ncfid, fwVar, chunks)) return 0;
+    ncfid->add_var("histBins_filteredNoise", ncDouble, realDim, fHistDim);
+    ncfid->add_var("histVals_filteredNoise", ncDouble, realDim, fHistDim);
+  }
+
+  weightVar->put(&noise->weight[0][0], nrows, ncols);
+  defined = true;
+  return 1;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///reads realization k of a variable whose first dimension is the index
+bool NoiseStore::getSlab(const char* varName, int k, double* data)
+{
+  NcVar* v = ncfid->get_var(varName);
+  if(!v) return 0;
+  long cur[3] = {k, 0, 0};
+  long* counts = v->edges();
+  counts[0] = 1;
+  bool ok = v->set_cur(cur) && v->get(data, counts);
+  delete [] counts;
+  return ok;
+}
+
+///writes realization k of a variable whose first dimension is the index
+bool NoiseStore::putSlab(const char* varName, int k, const double* data)
+{
+  NcVar* v = ncfid->get_var(varName);
+  if(!v) return 0;
+  long cur[3] = {k, 0, 0};
+  long* counts = v->edges();
+  counts[0] = 1;
+  bool ok = v->set_cur(cur) && v->put(data, counts);
+  delete [] counts;
+  return ok;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///stores noise realization k along with its histogram and psds
+bool NoiseStore::writeRealization(int k, Map* noise)
+{
+  if(!defined && !defineRealizations(noise)) return 0;
+
+  if((int) noise->psd.size() != ncfid->get_dim("npsd")->size() ||
+     (int) noise->histBins.size() != ncfid->get_dim("nhist")->size()){
+    cerr << "NoiseStore::writeRealization(): ";
+    cerr << "variation in psd or histogram lengths." << endl;
+    return 0;
+  }
+
+  return putSlab("noise", k, &noise->image[0][0]) &&
+    putSlab("histBins", k, &noise->histBins[0]) &&
+    putSlab("histVals", k, &noise->histVals[0]) &&
+    putSlab("psdFreq", k, &noise->psdFreq[0]) &&
+    putSlab("psd", k, &noise->psd[0]) &&
+    putSlab("psd_2d", k, &noise->psd2d[0][0]) &&
+    putSlab("psdFreq_2d", k, &noise->psd2dFreq[0][0]);
+}
+
+bool NoiseStore::readNoise(int k, MatDoub &noise)
+{
+  noise.resize(nrows, ncols);
+  return getSlab("noise", k, &noise[0][0]);
+}
+
+///the weight map common to all unfiltered realizations
+bool NoiseStore::readWeight(MatDoub &weight)
+{
+  weight.resize(nrows, ncols);
+  NcVar* v = ncfid->get_var("weight");
+  return v && v->get(&weight[0][0], nrows, ncols);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+bool NoiseStore::writeFiltered(int k, MatDoub &filteredNoise,
+                               MatDoub &filteredWeight)
+{
+  return putSlab("filteredNoise", k, &filteredNoise[0][0]) &&
+    putSlab("filteredWeight", k, &filteredWeight[0][0]);
+}
+
+bool NoiseStore::readFiltered(int k, MatDoub &filteredNoise,
+                              MatDoub &filteredWeight)
+{
+  filteredNoise.resize(nrows, ncols);
+  filteredWeight.resize(nrows, ncols);
+  return getSlab("filteredNoise", k, &filteredNoise[0][0]) &&
+    getSlab("filteredWeight", k, &filteredWeight[0][0]);
+}
+
+bool NoiseStore::writeFilteredWeight(int k, MatDoub &filteredWeight)
+{
+  return putSlab("filteredWeight", k, &filteredWeight[0][0]);
+}
+
+bool NoiseStore::writeFilteredHistogram(int k, VecDoub &bins, VecDoub &vals)
+{
+  return putSlab("histBins_filteredNoise", k, &bins[0]) &&
+    putSlab("histVals_filteredNoise", k, &vals[0]);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///histogram of realization k, of the filtered noise map if filtered is set
+bool NoiseStore::readHistogram(int k, bool filtered,
+                               VecDoub &bins, VecDoub &vals)
+{
+  string dimname = (filtered) ? "nhist_filteredNoise" : "nhist";
+  string binname = (filtered) ? "histBins_filteredNoise" : "histBins";
+  string valname = (filtered) ? "histVals_filteredNoise" : "histVals";
+  NcDim* histDim = ncfid->get_dim(dimname.c_str());
+  if(!histDim) return 0;
+  bins.resize(histDim->size());
+  vals.resize(histDim->size());
+  return getSlab(binname.c_str(), k, &bins[0]) &&
+    getSlab(valname.c_str(), k, &vals[0]);
+}
+
+bool NoiseStore::readPsd(int k, VecDoub &psd, VecDoub &psdFreq,
+                         MatDoub &psd2d, MatDoub &psd2dFreq)
+{
+  int npsd = ncfid->get_dim("npsd")->size();
+  int nx = ncfid->get_dim("nxpsd_2d")->size();
+  int ny = ncfid->get_dim("nypsd_2d")->size();
+  psd.resize(npsd);
+  psdFreq.resize(npsd);
+  psd2d.resize(nx, ny);
+  psd2dFreq.resize(nx, ny);
+  return getSlab("psd", k, &psd[0]) &&
+    getSlab("psdFreq", k, &psdFreq[0]) &&
+    getSlab("psd_2d", k, &psd2d[0][0]) &&
+    getSlab("psdFreq_2d", k, &psd2dFreq[0][0]);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+NoiseStore::~NoiseStore()
+{
+  ncfid->close();
+  delete ncfid;
+}
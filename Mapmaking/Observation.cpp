@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <time.h>
 #include <fftw3.h>
+#include <omp.h>
 #include <CCfits/CCfits>
 using namespace std;
 
@@ -22,6 +23,9 @@ using namespace std;
 #include "vector_utilities.h"
 #include "intarray2bmp.h"
 
+//row bands per thread when binning, so uneven coverage still balances
+#define OBS_BANDS_PER_THREAD 4
+
 
 ///Observation constructor
 /** Just simple initialization going on here.
@@ -124,6 +128,202 @@ bool Observation::generateBeammaps(Array* a, Telescope* tel)
 }
 
 
+//----------------------------- o ---------------------------------------
+
+///binSamples() target summing into the dense maps
+struct DenseBins
+{
+  Observation* obs;
+  int nNoise;
+
+  DenseBins(Observation* o, int n) : obs(o), nNoise(n) {}
+  int rowQuantum() {return 1;}
+  bool sparse() {return 0;}
+  void touch(int, int) {}
+  void allocate() {}
+  void add(int irow, int icol, double w, double hx, double hk, double ha,
+	   const double* sn)
+  {
+    //weight map
+    obs->weight->image[irow][icol] += w;
+
+    //inttime map
+    obs->inttime->image[irow][icol] += 1./64.;
+
+    //signal map
+    obs->signal->image[irow][icol] += hx;
+
+    //kernel map
+    obs->kernel->image[irow][icol] += hk;
+
+    //noise maps
+    for(int kk=0;kk<nNoise;kk++)
+      obs->noiseMaps[kk][irow*obs->ncols+icol] += sn[kk]*hx;
+
+    if(obs->atmTemplate)
+      obs->atmTemplate->image[irow][icol] += ha;
+  }
+};
+
+///binSamples() target summing into the tiles of a TiledMap
+/** The planes are signal, weight, kernel, inttime, the noise maps and
+    the atmosphere template if there is one.  The tiles are allocated
+    before anything is summed so that the bands only look them up.
+**/
+struct TiledBins
+{
+  TiledMap* tiles;
+  int nNoise;
+  int atmPlane;
+  size_t ps;
+  vector<char> hit;
+
+  TiledBins(TiledMap* t, int n)
+    : tiles(t), nNoise(n), atmPlane(t->getPlaneIndex("atmTemplate")),
+      ps(t->getPlaneStride()), hit(t->getNTileIds(), 0) {}
+  int rowQuantum() {return tiles->getTileSize();}
+  bool sparse() {return 1;}
+  void touch(int irow, int icol) {hit[tiles->getTileId(irow, icol)] = 1;}
+  void allocate() {tiles->allocateTiles(hit);}
+  void add(int irow, int icol, double w, double hx, double hk, double ha,
+	   const double* sn)
+  {
+    double* px = tiles->pixel(irow, icol);
+    px[0] += hx;
+    px[ps] += w;
+    px[2*ps] += hk;
+    px[3*ps] += 1./64.;
+    for(int kk=0;kk<nNoise;kk++)
+      px[(4+kk)*ps] += sn[kk]*hx;
+    if(atmPlane >= 0) px[atmPlane*ps] += ha;
+  }
+};
+
+///sums the flagged-in samples of the observation into bins
+/** This is where generateMaps() and generateTiledMaps() put their
+    maps together.  The noise map signs are drawn scan by scan in the
+    order they always were.  The map is split into bands of whole rows
+    (of whole rows of tiles for tiled maps) which are summed in
+    parallel.  The flagged-in samples are first bucketed by band with
+    a counting sort, scan by scan in parallel, which keeps the serial
+    order within every bucket.  Each pixel is then summed in the same
+    order as before and the maps don't depend on the number of
+    threads.  For tiled maps every band first marks the tiles it
+    touches, and those are allocated in order.
+**/
+template <class Bins>
+void Observation::binSamples(Array* a, MatDoub &tmpwt, Bins &bins)
+{
+  int* di=a->getDetectorIndices();
+  int nDetectors = a->getNDetectors();
+  int nScans = tel->scanIndex.ncols();
+  int nSamples = a->detectors[di[0]].getNSamples();
+
+  int nNoise = ap->getNNoiseMapsPerObs();
+  MatDoub sn(max(nScans,1), max(nNoise,1));
+  for(int k=0;k<nScans;k++)
+    for(int kk=0;kk<nNoise;kk++)
+      sn[k][kk] = (ap->macanaRandom->uniformDeviate(-1.,1.)<0) ? -1. : 1.;
+
+  //the band of each row
+  int q = bins.rowQuantum();
+  int nUnits = (nrows+q-1)/q;
+  int nBands = min(nUnits, OBS_BANDS_PER_THREAD*omp_get_max_threads());
+  VecInt rowBand(nrows);
+  for(int b=0;b<nBands;b++){
+    int r0 = min(nrows, (int) ((long) nUnits*b/nBands)*q);
+    int r1 = min(nrows, (int) ((long) nUnits*(b+1)/nBands)*q);
+    for(int r=r0;r<r1;r++) rowBand[r] = b;
+  }
+
+  //count the flagged-in samples of each scan in each band
+  VecLlong first(nBands*nScans+1, 0LL);
+#pragma omp parallel for schedule(dynamic)
+  for(int k=0;k<nScans;k++){
+    int si=tel->scanIndex[0][k];
+    int ei=tel->scanIndex[1][k]+1;
+    for(int i=0;i<nDetectors;i++){
+      Detector &d = a->detectors[di[i]];
+      for(int j=si;j<ei;j++){
+	if(!d.hSampleFlags[j]) continue;
+	//get the row and column index corresponding to the ra and
+	//dec
+	int irow;
+	int icol;
+	physToMapIndex(d.hRa[j], d.hDec[j], &irow, &icol);
+	first[rowBand[irow]*nScans+k+1]++;
+
+	//check for NaN
+	double hx = tmpwt[i][k]*d.hValues[j];
+	double hk = tmpwt[i][k]*d.hKernel[j];
+	if(hx != hx || hk != hk){
+#pragma omp critical (dataio)
+	  {
+	    cerr << "NaN detected on file: "<<ap->getMapFile() << endl;
+	    cerr << "tmpwt: " << tmpwt[i][k] << endl;
+	    cerr << "det: " << d.hValues[j] << endl;
+	    cerr << "ker: " << d.hKernel[j] << endl;
+	    cerr << "  i=" << i << endl;
+	    cerr << "  j=" << j << endl;
+	    cerr << "  k=" << k << endl;
+	    exit(1);
+	  }
+	}
+      }
+    }
+  }
+
+  //the buckets run band by band, and scan by scan within a band
+  for(int c=0;c<nBands*nScans;c++) first[c+1] += first[c];
+  long nIn = first[nBands*nScans];
+  VecLlong sample(max(nIn,1L));
+  VecInt pixel(max(nIn,1L));
+#pragma omp parallel for schedule(dynamic)
+  for(int k=0;k<nScans;k++){
+    int si=tel->scanIndex[0][k];
+    int ei=tel->scanIndex[1][k]+1;
+    VecLlong next(nBands);
+    for(int b=0;b<nBands;b++) next[b] = first[b*nScans+k];
+    for(int i=0;i<nDetectors;i++){
+      Detector &d = a->detectors[di[i]];
+      for(int j=si;j<ei;j++){
+	if(!d.hSampleFlags[j]) continue;
+	int irow;
+	int icol;
+	physToMapIndex(d.hRa[j], d.hDec[j], &irow, &icol);
+	Llong n = next[rowBand[irow]]++;
+	sample[n] = (Llong) i*nSamples+j;
+	pixel[n] = irow*ncols+icol;
+      }
+    }
+  }
+
+  if(bins.sparse()){
+#pragma omp parallel for schedule(dynamic)
+    for(int b=0;b<nBands;b++)
+      for(Llong n=first[b*nScans];n<first[(b+1)*nScans];n++)
+	bins.touch(pixel[n]/ncols, pixel[n]%ncols);
+    bins.allocate();
+  }
+
+#pragma omp parallel for schedule(dynamic)
+  for(int b=0;b<nBands;b++){
+    for(int k=0;k<nScans;k++){
+      for(Llong n=first[b*nScans+k];n<first[b*nScans+k+1];n++){
+	int i = sample[n]/nSamples;
+	int j = sample[n]%nSamples;
+	int p = pixel[n];
+	Detector &d = a->detectors[di[i]];
+	double w = tmpwt[i][k];
+	bins.add(p/ncols, p%ncols, w, w*d.hValues[j], w*d.hKernel[j],
+		 (d.atmTemplate.size() > 0) ? w*d.atmTemplate[j] : 0.,
+		 &sn[k][0]);
+      }
+    }
+  }
+}
+
+
 //----------------------------- o ---------------------------------------
 
 ///generates coordinates, signal, weight, kernel and noise maps
@@ -136,6 +336,9 @@ bool Observation::generateBeammaps(Array* a, Telescope* tel)
  **/
 bool Observation::generateMaps(Array* a, Telescope* tel)
 {
+  if(ap->getMapTileSize() > 0 && !ap->getBeammapping())
+    return generateTiledMaps(a, tel);
+
   this->tel = tel;
 
   //set up coordinate systems and map size and initialize maps
@@ -165,8 +368,6 @@ bool Observation::generateMaps(Array* a, Telescope* tel)
     //populate the maps
     a->updateDetectorIndices();
     int* di=a->getDetectorIndices();
-    int nDetectors = a->getNDetectors();
-    int nScans = tel->scanIndex.ncols();
 
     if (a->detectors[di[0]].atmTemplate.size() > 0.0){
       atmTemplate = new Map(mname.assign("atmTemplate"), nrows, ncols, pixelSize,
@@ -177,64 +378,8 @@ bool Observation::generateMaps(Array* a, Telescope* tel)
     MatDoub tmpwt = calculateWeights(a, tel);
 
     //put together the maps
-    for(int k=0;k<nScans;k++){
-      VecDoub sn(ap->getNNoiseMapsPerObs());
-    for(int kk=0;kk<ap->getNNoiseMapsPerObs();kk++){
-	      sn[kk] = (ap->macanaRandom->uniformDeviate(-1.,1.)<0) ? -1. : 1.;
-	    }
-	    int si=tel->scanIndex[0][k];
-	    int ei=tel->scanIndex[1][k]+1;
-	    for(int i=0;i<nDetectors;i++){
-	      for(int j=si;j<ei;j++){
-		if(a->detectors[di[i]].hSampleFlags[j]){
-		  //get the row and column index corresponding to the ra and
-		  //dec
-		  int irow;
-		  int icol;
-		  weight->raDecPhysToIndex(a->detectors[di[i]].hRa[j],
-					   a->detectors[di[i]].hDec[j],
-					   &irow, &icol);
-		  //weight map
-		  weight->image[irow][icol] += tmpwt[i][k];
-
-		  //inttime map
-		  inttime->image[irow][icol] += 1./64.;
-
-		  //check for NaN
-		  double hx = tmpwt[i][k]*a->detectors[di[i]].hValues[j];
-		  double hk = tmpwt[i][k]*a->detectors[di[i]].hKernel[j];
-
-		  double ha = 0.0;
-		  if (atmTemplate)
-			  ha = tmpwt[i][k]*a->detectors[di[i]].atmTemplate[j];
-		  if(hx != hx || hk != hk){
-		    cerr << "NaN detected on file: "<<ap->getMapFile() << endl;
-		    cerr << "tmpwt: " << tmpwt[i][k] << endl;
-		    cerr << "det: " << a->detectors[di[i]].hValues[j] << endl;
-		    cerr << "ker: " << a->detectors[di[i]].hKernel[j] << endl;
-		    cerr << "  i=" << i << endl;
-		    cerr << "  j=" << j << endl;
-		    cerr << "  k=" << k << endl;
-		    exit(1);
-		  }
-
-		  //signal map
-		  signal->image[irow][icol] += hx;
-
-		  //kernel map
-		  kernel->image[irow][icol] += hk;
-
-		  //noise maps
-		  for(int kk=0;kk<ap->getNNoiseMapsPerObs();kk++){
-		    noiseMaps[kk][irow*ncols+icol] += sn[kk]*hx;
-		  }
-
-		  if (atmTemplate)
-			  atmTemplate->image[irow][icol] += ha;
-		}
-	      }
-	    }
-	  }
+    DenseBins bins(this, ap->getNNoiseMapsPerObs());
+    binSamples(a, tmpwt, bins);
 
 	  //some maps need weight normalization
 	  //also invert sign of signal map
@@ -267,6 +412,130 @@ bool Observation::generateMaps(Array* a, Telescope* tel)
 }
 
 
+//----------------------------- o ---------------------------------------
+
+///generates the observation maps into sparse tiled storage
+/** Same algorithm as generateMaps() but the signal, weight, kernel,
+    inttime and noise maps are accumulated into a TiledMap so that only
+    the tiles crossed by a detector are ever allocated.  This is the
+    mode to use for wide, shallow scans where most of the bounding box
+    of the detector tracks has no coverage.  The dense Map members stay
+    NULL until densifyMaps() is called.
+ **/
+bool Observation::generateTiledMaps(Array* a, Telescope* tel)
+{
+  this->tel = tel;
+
+  mapGenerationPrep(a);
+
+  a->updateDetectorIndices();
+  int* di=a->getDetectorIndices();
+
+  int nNoise = ap->getNNoiseMapsPerObs();
+  vector<string> planes = {"signal", "weight", "kernel", "inttime"};
+  for(int kk=0;kk<nNoise;kk++){
+    stringstream o;
+    o << "noise" << kk+1;
+    planes.push_back(o.str());
+  }
+  if(a->detectors[di[0]].atmTemplate.size() > 0)
+    planes.push_back("atmTemplate");
+  tiles = new TiledMap(nrows, ncols, ap->getMapTileSize(), planes);
+  size_t ps = tiles->getPlaneStride();
+  cerr << "Observation(): nrows=" << nrows << ", ncols=" << ncols
+       << ", tiles of " << tiles->getTileSize() << " pixels" << endl;
+
+  //calculate or set the weights
+  MatDoub tmpwt = calculateWeights(a, tel);
+
+  //put together the maps
+  TiledBins bins(tiles, nNoise);
+  binSamples(a, tmpwt, bins);
+
+  //weight normalization and sign inversion of the signal map, only
+  //pixels of allocated tiles can be non-zero
+  for(int s=0;s<tiles->getNTiles();s++){
+    double* t = tiles->getTile(s, 0);
+    for(size_t p=0;p<ps;p++){
+      double wt = t[ps+p];
+      if(wt != 0.){
+        t[p] = -t[p]/wt;
+        t[2*ps+p] /= wt;
+        for(int kk=0;kk<nNoise;kk++)
+          t[(4+kk)*ps+p] /= wt;
+      }
+    }
+  }
+
+  cerr << "Observation(): " << tiles->getNTiles() << " tiles allocated ("
+       << tiles->getAllocatedBytes()/1048576. << " MB)" << endl;
+
+  return 1;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+///builds the dense signal, weight, kernel and inttime maps from tiles
+/** Only needed by methods that work on full images (psd, histogram,
+    gaussian fits).  Does nothing if the maps are not tiled or were
+    already expanded.
+ **/
+bool Observation::densifyMaps()
+{
+  if(!tiles || signal) return 1;
+
+  MatDoub wtt;
+  tiles->toDense(tiles->getPlaneIndex("weight"), wtt);
+  string mname;
+  weight = new Map(mname.assign("weight"), nrows, ncols, pixelSize,
+	   wtt, rowCoordsPhys, colCoordsPhys);
+  weight->image = wtt;
+  signal = new Map(mname.assign("signal"), nrows, ncols, pixelSize,
+	   wtt, rowCoordsPhys, colCoordsPhys);
+  tiles->toDense(tiles->getPlaneIndex("signal"), signal->image);
+  kernel = new Map(mname.assign("kernel"), nrows, ncols, pixelSize,
+	   wtt, rowCoordsPhys, colCoordsPhys);
+  tiles->toDense(tiles->getPlaneIndex("kernel"), kernel->image);
+  inttime = new Map(mname.assign("inttime"), nrows, ncols, pixelSize,
+	   wtt, rowCoordsPhys, colCoordsPhys);
+  tiles->toDense(tiles->getPlaneIndex("inttime"), inttime->image);
+  if(tiles->getPlaneIndex("atmTemplate") >= 0){
+    atmTemplate = new Map(mname.assign("atmTemplate"), nrows, ncols,
+	     pixelSize, wtt, rowCoordsPhys, colCoordsPhys);
+    tiles->toDense(tiles->getPlaneIndex("atmTemplate"), atmTemplate->image);
+  }
+  if(!ncdfFile.empty()){
+    signal->mapFile = ncdfFile;
+    weight->mapFile = ncdfFile;
+    inttime->mapFile = ncdfFile;
+    kernel->mapFile = ncdfFile;
+  }
+  return 1;
+}
+
+bool Observation::isTiled()
+{
+  return tiles != nullptr;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+///row and column index of a physical position, same convention as Map
+void Observation::physToMapIndex(double ra, double dec, int* irow, int* icol)
+{
+  *irow = ra / pixelSize + (nrows + 1.) / 2.;
+  *icol = dec / pixelSize + (ncols + 1.) / 2.;
+  if (*irow < 0 || *irow >= nrows || *icol < 0 || *icol >= ncols) {
+    cerr << "Observation::physToMapIndex(): ";
+    cerr << "Map index [" << *irow << "," << *icol << "] is out of bounds."
+         << endl;
+    exit(1);
+  }
+}
+
+
 //----------------------------- o ---------------------------------------
 
 ///Prepares for map generation. Sets map size and prepares coordinate vectors
@@ -309,14 +578,9 @@ void Observation::mapGenerationPrep(Array *a) {
         throw runtime_error("Map is too big");
     }
 
-    // matrices of absolute coordinates
-    xCoordsAbs.resize(nrows, ncols);
-    yCoordsAbs.resize(nrows, ncols);
-    for (int i = 0; i < nrows; i++)
-        for (int j = 0; j < ncols; j++) {
-            physToAbs(&rowCoordsPhys[i], &colCoordsPhys[j], &masterGrid[0],
-                      &masterGrid[1], &xCoordsAbs[i][j], &yCoordsAbs[i][j], 1);
-        }
+    // absolute coordinates are computed on demand from the projection
+    projection = MapProjection(masterGrid[0], masterGrid[1], rowCoordsPhys,
+                               colCoordsPhys);
 }
 
 //----------------------------- o ---------------------------------------
@@ -472,8 +736,6 @@ bool Observation::writeBeammapsToNcdf(string ncdfFilename)
 
   NcVar *rCPhysVar = ncfid.add_var("rowCoordsPhys", ncDouble, rowDim);
   NcVar *cCPhysVar = ncfid.add_var("colCoordsPhys", ncDouble, colDim);
-  NcVar *xCAbsVar = ncfid.add_var("xCoordsAbs", ncDouble, rowDim, colDim);
-  NcVar *yCAbsVar = ncfid.add_var("yCoordsAbs", ncDouble, rowDim, colDim);
 
   size_t nDetectors = array->getNDetectors();
   size_t nSamples = array->getNSamples();
@@ -481,8 +743,7 @@ bool Observation::writeBeammapsToNcdf(string ncdfFilename)
 
   rCPhysVar->put(&rowCoordsPhys[0], nrows);
   cCPhysVar->put(&colCoordsPhys[0], ncols);
-  xCAbsVar->put(&xCoordsAbs[0][0], nrows, ncols);
-  yCAbsVar->put(&yCoordsAbs[0][0], nrows, ncols);
+  projection.writeToNcdf(ncfid, rowDim, colDim, !ap->getWriteAbsCoords());
 
   /*
   NcDim* dimDetector = ncfid.add_dim("nDetectors", nDetectors);
@@ -614,7 +875,10 @@ bool Observation::writeFitParamsToNcdf(string mapFile, MatDoub &fitParams)
 bool Observation::writeObservationToNcdf(string ncdfFilename)
 {
   //create the file
-  NcFile ncfid = NcFile(ncdfFilename.c_str(), NcFile::Replace, NULL, 0, NcFile::Offset64Bits);
+  NcCompression nc = ap->getNcCompression();
+  NcType noiseType = (ap->getNoiseFloat32()) ? ncFloat : ncDouble;
+  NcFile ncfid = NcFile(ncdfFilename.c_str(), NcFile::Replace, NULL, 0,
+                        nc.getFileFormat());
   if (!ncfid.is_valid()){
     cerr << "Couldn't open map netcdf file for writing!\n";
     return 0;
@@ -627,15 +891,50 @@ bool Observation::writeObservationToNcdf(string ncdfFilename)
   NcDim* rowDim = ncfid.add_dim("nrows", nrows);
   NcDim* colDim = ncfid.add_dim("ncols", ncols);
 
-  //define variables for maps
-  NcVar *signalVar = ncfid.add_var("signal", ncDouble, rowDim, colDim);
-  NcVar *kernelVar = ncfid.add_var("kernel", ncDouble, rowDim, colDim);
-  NcVar *weightVar = ncfid.add_var("weight", ncDouble, rowDim, colDim);
-  NcVar *inttimeVar = ncfid.add_var("inttime", ncDouble, rowDim, colDim);
   NcVar *rCPhysVar = ncfid.add_var("rowCoordsPhys", ncDouble, rowDim);
   NcVar *cCPhysVar = ncfid.add_var("colCoordsPhys", ncDouble, colDim);
-  NcVar *xCAbsVar = ncfid.add_var("xCoordsAbs", ncDouble, rowDim, colDim);
-  NcVar *yCAbsVar = ncfid.add_var("yCoordsAbs", ncDouble, rowDim, colDim);
+  rCPhysVar->put(&rowCoordsPhys[0], nrows);
+  cCPhysVar->put(&colCoordsPhys[0], ncols);
+
+  //tiled files never get the dense absolute coordinate grids
+  projection.writeToNcdf(ncfid, rowDim, colDim,
+                         tiles || !ap->getWriteAbsCoords(), nc);
+
+  //sparse maps carry all of their planes, including the noise maps
+  if(tiles){
+    vector<NcType> planeTypes(tiles->getNPlanes(), noiseType);
+    for(int i=0;i<4;i++) planeTypes[i] = ncDouble;
+    if(!tiles->writeToNcdf(ncfid, nc, planeTypes)){
+      cerr << "Observation::writeObservationToNcdf(): failed to write tiles"
+           << endl;
+      return 0;
+    }
+  } else {
+    //define variables for maps
+    NcVar *signalVar = nc.addMapVar(ncfid, "signal", ncDouble, rowDim, colDim);
+    NcVar *kernelVar = nc.addMapVar(ncfid, "kernel", ncDouble, rowDim, colDim);
+    NcVar *weightVar = nc.addMapVar(ncfid, "weight", ncDouble, rowDim, colDim);
+    NcVar *inttimeVar = nc.addMapVar(ncfid, "inttime", ncDouble, rowDim, colDim);
+
+    //and write the maps
+    signalVar->put(&signal->image[0][0], nrows, ncols);
+    kernelVar->put(&kernel->image[0][0], nrows, ncols);
+    weightVar->put(&weight->image[0][0], nrows, ncols);
+    inttimeVar->put(&inttime->image[0][0], nrows, ncols);
+
+    //the noise maps are done individually
+    int nNoiseMaps =  ap->getNNoiseMapsPerObs();
+    string onoise;
+    NcVar* nVar;
+    for(int i=0;i<nNoiseMaps;i++){
+      onoise.assign("noise");
+      stringstream o;
+      o << i+1;
+      onoise.append(o.str());
+      nVar = nc.addMapVar(ncfid, onoise.c_str(), noiseType, rowDim, colDim);
+      nVar->put(&noiseMaps[i][0], nrows, ncols);
+    }
+  }
 
   //define variables for clean time-streams
   size_t nDetectors = array->getNDetectors();
@@ -650,29 +949,6 @@ bool Observation::writeObservationToNcdf(string ncdfFilename)
   NcDim* dimScansLimit = ncfid.add_dim("scanLimit", 2);
   NcVar* scansVar = ncfid.add_var("scanIndex",ncInt,dimScansLimit,dimScans);
 
-  //and write the maps
-  signalVar->put(&signal->image[0][0], nrows, ncols);
-  kernelVar->put(&kernel->image[0][0], nrows, ncols);
-  weightVar->put(&weight->image[0][0], nrows, ncols);
-  inttimeVar->put(&inttime->image[0][0], nrows, ncols);
-  rCPhysVar->put(&rowCoordsPhys[0], nrows);
-  cCPhysVar->put(&colCoordsPhys[0], ncols);
-  xCAbsVar->put(&xCoordsAbs[0][0], nrows, ncols);
-  yCAbsVar->put(&yCoordsAbs[0][0], nrows, ncols);
-
-  //the noise maps are done individually
-  int nNoiseMaps =  ap->getNNoiseMapsPerObs();
-  string onoise;
-  NcVar* nVar;
-  for(int i=0;i<nNoiseMaps;i++){
-    onoise.assign("noise");
-    stringstream o;
-    o << i+1;
-    onoise.append(o.str());
-    nVar = ncfid.add_var(onoise.c_str(), ncDouble, rowDim, colDim);
-    nVar->put(&noiseMaps[i][0], nrows, ncols);
-  }
-
   //add timestream data only if Cottinham method is invoked
   if(ap->getOrder() > 0){
     Mat3DDoub boloData (nvars, nDetectors, nSamples);
@@ -693,6 +969,14 @@ bool Observation::writeObservationToNcdf(string ncdfFilename)
     scansVar->put(&tel->scanIndex[0][0], 2, nScans);
   }
 
+  //PCA diagnostics, only there if the array was PCA cleaned
+  if(ap->getWritePcaModes() && array->pcaModes.getNScans() == (int) nScans)
+    if(!array->pcaModes.writeToNcdf(ncfid, dimScans, dimDetectors)){
+      cerr << "Observation::writeObservationToNcdf(): failed to write ";
+      cerr << "the PCA modes" << endl;
+      return 0;
+    }
+
   //get the time and date of this analysis
   time_t rawtime;
   struct tm* timeinfo;
@@ -747,10 +1031,12 @@ bool Observation::writeObservationToNcdf(string ncdfFilename)
   cerr << ncdfFilename << endl;
 
   //set the netcdf filename for all the maps in the obs
-  signal->mapFile = ncdfFile;
-  weight->mapFile = ncdfFile;
-  inttime->mapFile = ncdfFile;
-  kernel->mapFile = ncdfFile;
+  if(signal){
+    signal->mapFile = ncdfFile;
+    weight->mapFile = ncdfFile;
+    inttime->mapFile = ncdfFile;
+    kernel->mapFile = ncdfFile;
+  }
 
   //free the memory in the large noiseMaps array
   cerr << "Observation::Deleting noiseMaps array." << endl;
@@ -784,6 +1070,15 @@ bool Observation::writeObservationToNcdf(string ncdfFilename)
 
 		size_t nScans = tel->scanIndex.ncols();
 
+		//timestreams are read back a scan at a time for a given type,
+		//so chunk by the longest scan over a block of detectors
+		size_t scanLength = 1;
+		for (size_t k=0; k<nScans; k++)
+			scanLength = max(scanLength, (size_t)(tel->scanIndex[1][k]-tel->scanIndex[0][k]+1));
+		scanLength = min(scanLength, nSamples);
+		size_t boloChunks[3] = {1, max((size_t)1, min(nDetectors, (size_t)131072/scanLength)), scanLength};
+		nc.setStorage(ncfid, bArray, boloChunks);
+
 		NcDim* dimScans =ncfid.add_dim("nScans", nScans);
 		NcDim* dimScansLimit = ncfid.add_dim("scanLimit", 2);
 		NcVar* scansVar = ncfid.add_var("scanIndex",ncInt,dimScansLimit,dimScans);
@@ -913,6 +1208,7 @@ bool Observation::writeBeammapsToBmp(string bmpFilename, int nDetectors)
  **/
 bool Observation::histogramSignal(int nbins, double cc)
 {
+	densifyMaps();
 	signal->calcMapHistogram(nbins, cc);
 	return 1;
 }
@@ -942,6 +1238,7 @@ bool Observation::histogramSignal()
  **/
 bool Observation::signalMapPsd(double cc)
 {
+	densifyMaps();
 	signal->calcMapPsd(cc);
 	return 1;
 }
@@ -949,6 +1246,7 @@ bool Observation::signalMapPsd(double cc)
 bool Observation::signalMapPsd()
 {
   double coverage_cut = ap->getCoverageThreshold();
+  densifyMaps();
   signal->calcMapPsd(coverage_cut);
   return 1;
 }
@@ -970,4 +1268,6 @@ Observation::~Observation()
     delete inttime;
   if (atmTemplate)
     delete atmTemplate;
+  if (tiles)
+    delete tiles;
 }
@@ -50,10 +50,8 @@ PointSource::PointSource()
       - mapColCoordsPhys - VecDoub containing physical
                            (delta-source) column coordinates of
                            parent map
-      - mapXCoordsAbs - MatDoub containing absolute row coordinates
-                        of parent map
-      - mapYCoordsAbs - MatDoub containing absolute column
-                        coordinates of parent map
+      - mapProjection - MapProjection giving the absolute
+                        coordinates of the parent map pixels
       - mapNRows - number of rows in parent map
       - mapNCols - number of columns in parent map
       - pixSize - pixel size in radians
@@ -65,8 +63,7 @@ bool PointSource::initialize(AnalParams* analParams,
 			     double* mWeight,
 			     double* mRowCoordsPhys,
 			     double* mColCoordsPhys,
-			     double* mXCoordsAbs,
-			     double* mYCoordsAbs,
+			     const MapProjection* mProjection,
 			     int mNRows, int mNCols,
 			     double pixSize, std::string parentMFile)
 {
@@ -78,8 +75,7 @@ bool PointSource::initialize(AnalParams* analParams,
   mapWeight = mWeight;
   mapRowCoordsPhys = mRowCoordsPhys;
   mapColCoordsPhys = mColCoordsPhys;
-  mapXCoordsAbs = mXCoordsAbs;
-  mapYCoordsAbs = mYCoordsAbs;
+  mapProjection = mProjection;
 
   //simply store some other variables
   mapNRows = mNRows;
@@ -158,8 +154,8 @@ bool PointSource::makePostageStamp()
 	weightPS[rCount][cCount] = mapWeight[mapNCols*j + k];
         rowCoordsPhys[rCount] = mapRowCoordsPhys[j];
         colCoordsPhys[cCount] = mapColCoordsPhys[k];
-	xCoordsAbs[rCount][cCount] = mapXCoordsAbs[mapNCols*j + k];
-	yCoordsAbs[rCount][cCount] = mapYCoordsAbs[mapNCols*j + k];
+	mapProjection->pixelToAbs(j, k, &xCoordsAbs[rCount][cCount],
+	                          &yCoordsAbs[rCount][cCount]);
       }
       cCount++;
     }
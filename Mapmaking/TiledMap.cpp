@@ -0,0 +1,307 @@
+#include <netcdfcpp.h>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "nr3.h"
+#include "TiledMap.h"
+
+///TiledMap constructor
+/** Sets up an empty tile directory for an nr x nc map.  No pixel
+    storage is allocated until pixels are written.
+**/
+TiledMap::TiledMap(int nr, int nc, int tsz, const vector<string> &planes)
+{
+  nrows = nr;
+  ncols = nc;
+  tileSize = (tsz > 0) ? tsz : 64;
+  nTileRows = (nrows + tileSize - 1)/tileSize;
+  nTileCols = (ncols + tileSize - 1)/tileSize;
+  planeNames = planes;
+  tileSlot.assign(nTileRows*nTileCols, -1);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///allocates a zeroed tile and returns its storage slot
+int TiledMap::allocateTile(int tileId)
+{
+  int slot = tiles.size();
+  tiles.push_back(vector<double>(planeNames.size()*getPlaneStride(), 0.));
+  slotTile.push_back(tileId);
+  tileSlot[tileId] = slot;
+  return slot;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+int TiledMap::getNrows() const
+{
+  return nrows;
+}
+
+int TiledMap::getNcols() const
+{
+  return ncols;
+}
+
+int TiledMap::getTileSize() const
+{
+  return tileSize;
+}
+
+int TiledMap::getNPlanes() const
+{
+  return planeNames.size();
+}
+
+///returns the index of the named plane or -1 if it is not stored
+int TiledMap::getPlaneIndex(const string &name) const
+{
+  for(size_t i=0;i<planeNames.size();i++)
+    if(planeNames[i] == name) return i;
+  return -1;
+}
+
+size_t TiledMap::getPlaneStride() const
+{
+  return (size_t) tileSize*tileSize;
+}
+
+///number of allocated tiles
+int TiledMap::getNTiles() const
+{
+  return tiles.size();
+}
+
+///number of tiles covering the map, allocated or not
+int TiledMap::getNTileIds() const
+{
+  return nTileRows*nTileCols;
+}
+
+///id (row major) of the tile holding pixel (irow, icol)
+int TiledMap::getTileId(int irow, int icol) const
+{
+  return (irow/tileSize)*nTileCols + icol/tileSize;
+}
+
+///map row index of the first pixel in the tile stored in slot
+int TiledMap::getTileRow0(int slot) const
+{
+  return (slotTile[slot]/nTileCols)*tileSize;
+}
+
+///map column index of the first pixel in the tile stored in slot
+int TiledMap::getTileCol0(int slot) const
+{
+  return (slotTile[slot]%nTileCols)*tileSize;
+}
+
+double* TiledMap::getTile(int slot, int plane)
+{
+  return &tiles[slot][plane*getPlaneStride()];
+}
+
+const double* TiledMap::getTile(int slot, int plane) const
+{
+  return &tiles[slot][plane*getPlaneStride()];
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///pointer to plane 0 of pixel (irow, icol), allocating its tile if needed
+/** The other planes of the same pixel follow at multiples of
+    getPlaneStride().
+**/
+double* TiledMap::pixel(int irow, int icol)
+{
+  int tileId = getTileId(irow, icol);
+  int slot = tileSlot[tileId];
+  if(slot < 0) slot = allocateTile(tileId);
+  return &tiles[slot][(irow%tileSize)*tileSize + icol%tileSize];
+}
+
+
+///allocates, in tile id order, the tiles flagged in hit
+/** Once all of the tiles a pass will touch are allocated, pixel() only
+    looks them up and several threads can fill different tiles at once.
+**/
+void TiledMap::allocateTiles(const vector<char> &hit)
+{
+  for(int t=0;t<getNTileIds();t++)
+    if(hit[t] && tileSlot[t] < 0) allocateTile(t);
+}
+
+
+///value of a pixel, 0 if its tile was never allocated
+double TiledMap::get(int plane, int irow, int icol) const
+{
+  int slot = tileSlot[(irow/tileSize)*nTileCols + icol/tileSize];
+  if(slot < 0) return 0.;
+  return tiles[slot][plane*getPlaneStride() +
+                     (irow%tileSize)*tileSize + icol%tileSize];
+}
+
+
+///memory held by the allocated tiles
+size_t TiledMap::getAllocatedBytes() const
+{
+  return tiles.size()*planeNames.size()*getPlaneStride()*sizeof(double);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///expands one plane into a dense nrows x ncols matrix
+void TiledMap::toDense(int plane, MatDoub &dense) const
+{
+  dense.assign(nrows, ncols, 0.);
+  for(size_t s=0;s<tiles.size();s++){
+    const double* t = getTile(s, plane);
+    int r0 = getTileRow0(s);
+    int c0 = getTileCol0(s);
+    int nr = min(tileSize, nrows-r0);
+    int nc = min(tileSize, ncols-c0);
+    for(int i=0;i<nr;i++)
+      for(int j=0;j<nc;j++)
+        dense[r0+i][c0+j] = t[i*tileSize+j];
+  }
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///writes the allocated tiles to an open netcdf file
+/** Each plane is written as "<plane>Tiles" with dimensions
+    [nTiles, tileSize, tileSize], together with a "tileIndex" variable
+    holding the [tile row, tile column] of every tile.  The global
+    attribute mapTileSize marks the file as tiled.  The caller is
+    responsible for the nrows/ncols dimensions and the coordinates.
+    Compressed files are chunked one tile per chunk.  planeTypes may
+    give a storage type per plane, all planes are ncDouble otherwise.
+**/
+bool TiledMap::writeToNcdf(NcFile &ncfid, const NcCompression &comp,
+                           const vector<NcType> &planeTypes) const
+{
+  //netcdf dimensions cannot be empty
+  int nTiles = max((int) tiles.size(), 1);
+  size_t stride = getPlaneStride();
+
+  NcDim* tileDim = ncfid.add_dim("nTiles", nTiles);
+  NcDim* tileRowDim = ncfid.add_dim("tileRows", tileSize);
+  NcDim* tileColDim = ncfid.add_dim("tileCols", tileSize);
+  NcDim* tileLocDim = ncfid.add_dim("tileLoc", 2);
+  NcVar* indexVar = ncfid.add_var("tileIndex", ncInt, tileDim, tileLocDim);
+  ncfid.add_att("mapTileSize", tileSize);
+
+  MatInt tileIndex(nTiles, 2, 0);
+  for(size_t s=0;s<tiles.size();s++){
+    tileIndex[s][0] = slotTile[s]/nTileCols;
+    tileIndex[s][1] = slotTile[s]%nTileCols;
+  }
+  if(!indexVar->put(&tileIndex[0][0], nTiles, 2)) return 0;
+
+  size_t chunks[3] = {1, (size_t) tileSize, (size_t) tileSize};
+  vector<double> buffer(nTiles*stride, 0.);
+  for(size_t p=0;p<planeNames.size();p++){
+    string vname = planeNames[p] + "Tiles";
+    NcType type = (p < planeTypes.size()) ? planeTypes[p] : ncDouble;
+    NcVar* pVar = ncfid.add_var(vname.c_str(), type, tileDim,
+                                tileRowDim, tileColDim);
+    if(!comp.setStorage(ncfid, pVar, chunks)) return 0;
+    for(size_t s=0;s<tiles.size();s++){
+      const double* t = getTile(s, p);
+      copy(t, t+stride, &buffer[s*stride]);
+    }
+    if(!pVar->put(&buffer[0], nTiles, tileSize, tileSize)) return 0;
+  }
+
+  return 1;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///true if the file holds tiled maps written by writeToNcdf
+bool TiledMap::isTiledFile(NcFile &ncfid)
+{
+  NcError ncerror(NcError::silent_nonfatal);
+  NcAtt* tAtt = ncfid.get_att("mapTileSize");
+  bool tiled = (tAtt != NULL);
+  delete tAtt;
+  return tiled;
+}
+
+
+///reads the named planes of an observation file into a TiledMap
+/** Works for both tiled and dense files.  Dense planes are read one at
+    a time and only the tiles holding non-zero pixels are allocated, so
+    zero-coverage regions of old files do not cost memory either.  The
+    tileSize argument is only used for dense files.  Returns NULL if a
+    plane is missing.
+**/
+TiledMap* TiledMap::readFromNcdf(NcFile &ncfid, const vector<string> &planes,
+                                 int tileSize)
+{
+  int nr = ncfid.get_dim("nrows")->size();
+  int nc = ncfid.get_dim("ncols")->size();
+
+  if(isTiledFile(ncfid)){
+    NcAtt* tAtt = ncfid.get_att("mapTileSize");
+    int tsz = tAtt->as_int(0);
+    delete tAtt;
+    TiledMap* tm = new TiledMap(nr, nc, tsz, planes);
+    int nTiles = ncfid.get_dim("nTiles")->size();
+    size_t stride = tm->getPlaneStride();
+
+    MatInt tileIndex(nTiles, 2);
+    if(!ncfid.get_var("tileIndex")->get(&tileIndex[0][0], nTiles, 2)){
+      delete tm;
+      return NULL;
+    }
+    for(int s=0;s<nTiles;s++)
+      tm->allocateTile(tileIndex[s][0]*tm->nTileCols + tileIndex[s][1]);
+
+    vector<double> buffer(nTiles*stride);
+    for(size_t p=0;p<planes.size();p++){
+      string vname = planes[p] + "Tiles";
+      NcVar* pVar = ncfid.get_var(vname.c_str());
+      if(!pVar || !pVar->get(&buffer[0], nTiles, tsz, tsz)){
+        cerr << "TiledMap::readFromNcdf(): cannot read " << vname << endl;
+        delete tm;
+        return NULL;
+      }
+      for(int s=0;s<nTiles;s++)
+        copy(&buffer[s*stride], &buffer[s*stride]+stride, tm->getTile(s, p));
+    }
+    return tm;
+  }
+
+  //a dense file
+  TiledMap* tm = new TiledMap(nr, nc, tileSize, planes);
+  MatDoub plane(nr, nc);
+  for(size_t p=0;p<planes.size();p++){
+    NcVar* pVar = ncfid.get_var(planes[p].c_str());
+    if(!pVar || !pVar->get(&plane[0][0], nr, nc)){
+      cerr << "TiledMap::readFromNcdf(): cannot read " << planes[p] << endl;
+      delete tm;
+      return NULL;
+    }
+    size_t offset = p*tm->getPlaneStride();
+    for(int i=0;i<nr;i++)
+      for(int j=0;j<nc;j++)
+        if(plane[i][j] != 0.) tm->pixel(i,j)[offset] = plane[i][j];
+  }
+  return tm;
+}
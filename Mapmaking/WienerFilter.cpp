@@ -22,6 +22,7 @@ using namespace std;
 #include "WienerFilter.h"
 #include "Coaddition.h"
 #include "NoiseRealizations.h"
+#include "Journal.h"
 #include "Telescope.h"
 #include "vector_utilities.h"
 #include "PointSource.h"
@@ -152,30 +153,36 @@ bool WienerFilter::filterCoaddition(Coaddition* cmap){
 /** This is the main driver for rapidly filtering the images from
     a complete set of coadded noise realizations.  Unlike
     the coaddition filtering above, this code directly writes
-    the filtered noise map into the appropriate netcdf file.
+    the filtered noise map into the realization store.
     It requires that vvq, rr, tplate, and Denom are already
     calculated.
  **/
 bool WienerFilter::filterNoiseMaps(NoiseRealizations *nr){
 
-	//The strategy here is to loop through the noise files one
+	//The strategy here is to loop through the realizations one
 	//by one, pulling in the noise image, filtering it, and then
-	//writing it back into the file.
+	//writing it back into the store.
+	NoiseStore* store = nr->store;
+	nrows = store->getNrows();
+	ncols = store->getNcols();
+	MatDoub noise(nrows, ncols);
+	Journal* journal = ap->getJournal();
 	for(int k=0;k<nr->nNoiseFiles;k++){
+		//maps filtered by an earlier run of a resumed store are kept
+		string stamp;
+		if(journal){
+		  stamp = journal->filteredNoiseStamp(store->getStoreId(), k);
+		  if(journal->isDone(stamp)) continue;
+		}
+
 	  // print out what's happening
 	  cerr << "WienerFilter(): Filtering noise map " << k << ".\r";
 
-		//open the noise file
-		NcFile ncfid = NcFile(nr->noiseFiles[k].c_str(), NcFile::Write);
-
-		//the input array dims
-		nrows = ncfid.get_dim("nrows")->size();
-		ncols = ncfid.get_dim("ncols")->size();
-
 		//the actual noise matrix
-		MatDoub noise(nrows, ncols);
-		NcVar* noisev = ncfid.get_var("noise");
-		noisev->get(&noise[0][0], nrows, ncols);
+		if(!store->readNoise(k, noise)){
+		  cerr << "WienerFilter(): cannot read noise map " << k << endl;
+		  exit(1);
+		}
 
 		//do the filtering
 		MatDoub filteredNoise(nrows,ncols,0.);
@@ -188,13 +195,16 @@ bool WienerFilter::filterNoiseMaps(NoiseRealizations *nr){
 		    }
 		  }
 
-		//write the result back into the netcdf file
-		NcDim* rowDim = ncfid.get_dim("nrows");
-		NcDim* colDim = ncfid.get_dim("ncols");
-		NcVar *fnVar = ncfid.add_var("filteredNoise", ncDouble, rowDim, colDim);
-		fnVar->put(&filteredNoise[0][0], nrows, ncols);
-		NcVar *fwVar = ncfid.add_var("filteredWeight", ncDouble, rowDim, colDim);
-		fwVar->put(&filteredWeight[0][0], nrows, ncols);
+		//write the result back into the store
+		if(!store->writeFiltered(k, filteredNoise, filteredWeight)){
+		  cerr << "WienerFilter(): cannot store filtered noise map " << k << endl;
+		  exit(1);
+		}
+		if(journal && store->sync()){
+		  ostringstream what;
+		  what << "filteredNoise " << k;
+		  journal->markDone(stamp, what.str());
+		}
 	}
 	cerr << endl;
 	return 1;
@@ -30,8 +30,6 @@ using namespace std;
 Array::Array(AnalParams* anal)
 {
 int samplerate;
-#pragma omp critical (dataio)
-{
   //initialize filenames and ap
   ap = anal;
   dataFile = ap->getDataFile();
@@ -101,29 +99,21 @@ int samplerate;
   tau = 0;
 
   //get ref pix info
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
+  ObsReader* reader = ap->getObsReader();
   string refpixfilename;
   bool LMT=0;
   bool ASTE=0;
-  char *strRefPixAtt;
 
 
   if(observatory.compare("LMT") == 0){
     LMT=1;
     //get the reference pixel from the netcdf file data
-    NcVar* refPixVar=ncfid.get_var("Header.AztecBackend.ReferenceChannel");
-    strRefPixAtt = refPixVar->as_string(0);
-    refpixfilename.assign(strRefPixAtt);
+    refpixfilename = reader->getString("Header.AztecBackend.ReferenceChannel");
     refpixfilename.erase(refpixfilename.find(" "));
-    delete [] strRefPixAtt;
   } else if(observatory.compare("ASTE") == 0){
     ASTE=1;
     //get the reference pixel from the netcdf file header
-    NcAtt* refpixAtt = ncfid.get_att("reference_channel");
-    char *strRefPixAtt = refpixAtt->as_string(0);
-    refpixfilename.assign(strRefPixAtt);
-    delete [] strRefPixAtt;
-    delete refpixAtt;
+    refpixfilename = reader->getAttString("reference_channel");
   }    
 
   //find the corresponding id matching the list of good detectors
@@ -159,10 +149,8 @@ int samplerate;
 
   if(LMT) dimname.assign("Data.AztecBackend.time_xlen");
   if(ASTE) dimname.assign("mfpersf");
-  NcDim* mfPerSf=ncfid.get_dim(dimname.c_str());
-  samplerate = mfPerSf->size();
-  ncfid.close();
-}
+  samplerate = reader->getDimSize(dimname.c_str());
+
   nFiltTerms=32;   //the number of digital filter terms
   digFiltTerms.resize(2*nFiltTerms+1);
   double nyquist = samplerate/2.;
@@ -600,8 +588,17 @@ bool Array::fakeAtmData(bool addToKernel) {
 	int *di = getDetectorIndices();
 	nb  = size_t(round(detectors[di[0]].getNSamples()/detectors[di[0]].getSamplerate()*atmFreq));
 	SBSM *bspline = new SBSM(4,nSamples, nb);
+	MatDoub atmCoeff;
+	vector<const double*> atmData (getNDetectors());
+	vector<VecDoub> scratch (getNDetectors());
 	for (size_t i=0; i<(size_t)getNDetectors();i++)
-		detectors[di[i]].setAtmTemplate(bspline->fitData(detectors[di[i]].hValues));
+		atmData[i] = &asDoubles(detectors[di[i]].hValues, scratch[i])[0];
+	bspline->fitCoefficients(atmData, atmCoeff);
+	VecDoub atm (nSamples);
+	for (size_t i=0; i<(size_t)getNDetectors();i++){
+		bspline->evaluate(atmCoeff, i, &atm[0]);
+		detectors[di[i]].setAtmTemplate(atm);
+	}
 
 	delete bspline;
 
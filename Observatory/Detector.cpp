@@ -155,31 +155,31 @@ void Detector::initialize(AnalParams* analParams, const char* dId)
   ntmp = strlen(dId);
   char stmp[10];
   id = atol(strcpy(stmp,dId+1));
-  int test;
-//#pragma omp critical (dataio)
-//{
-  //open the file 
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcVar* bolo=ncfid.get_var(n.c_str());
-  if(!bolo->is_valid()){
+  //the observation's file is already open
+  ObsReader* reader = ap->getObsReader();
+  vector<long> edges = reader->getShape(n.c_str());
+  if(edges.size() != 2){
     cerr << "Detector:: bolometer variable not fetched from ncfile." << endl;
     exit(1);
   }
 
   //assign the detector name
-  //strcpy(name,bolo->name());
-  name.assign(bolo->name());
+  name.assign(n);
 
   //number of samples and variable edges
-  long int* edges = bolo->edges();
   nSamples = edges[0]*edges[1];
   rawSamplerate = edges[1];
   samplerate=rawSamplerate;
-  delete [] edges;
 
   //create the detector value array and pack it
   hValues.resize(nSamples);
+#ifdef FLOAT32_SAMPLES
+  VecDoub raw(nSamples);
+  getBoloValues(&raw[0]);
+  for(int i=0;i<nSamples;i++) hValues[i] = raw[i];
+#else
   getBoloValues(&hValues[0]);
+#endif
   hSampleFlags.resize(nSamples);
   atmTemplate.resize(0);
   for(int i=0;i<nSamples;i++) hSampleFlags[i]=1;
@@ -196,37 +196,18 @@ void Detector::initialize(AnalParams* analParams, const char* dId)
   estimateResponsivity();
 
   //get the electronics gain
-  NcError ncerror(NcError::silent_nonfatal);
-  NcVar* fec1cmd=ncfid.get_var("Data.AztecBackend.fec1_cntl");
-  if(!fec1cmd){
-    fec1cmd=ncfid.get_var("fec1_cntl");
-    if(!fec1cmd){
+  const char* fecName = "Data.AztecBackend.fec1_cntl";
+  if(!reader->has(fecName)){
+    fecName = "fec1_cntl";
+    if(!reader->has(fecName)){
       cerr << "Can't find fec1_cntl in data file. Aborting." << endl;
       exit(1);
     }
   }
-  long int* cmdEdge = fec1cmd->edges();
-  VecInt fec1cmdVec(*cmdEdge);
-  test = fec1cmd->get(&fec1cmdVec[0],cmdEdge[0],0,0,0,0);
-  if(!test){
-    cerr << "Detector:: Failed to get fec1_cntl: " << name << 
-      " data from datafile" << endl;
-    exit(1);
-  }
   //take the value half-way through the data file
-  int cmd = fec1cmdVec[*cmdEdge/2.];
+  long nCmd = reader->getShape(fecName)[0];
+  int cmd = reader->getInt(fecName, nCmd/2);
   fecGain = cmdToGain(cmd);
-  
-  //cleanup
-  delete [] cmdEdge;
-
-  //close the ncfile just to be sure
-  test = ncfid.close();
-//}
-  if(!test){
-    cerr << "Detector:: Failed to close the netcdf datafile." << endl;
-    exit(1);
-  }
 }
 
 
@@ -236,38 +217,8 @@ void Detector::initialize(AnalParams* analParams, const char* dId)
 ///returns vector of detector values
 bool Detector::getBoloValues(double *bData)
 {
-  //open the netcdf file
-//#pragma omp critical (dataio)
-//{
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcVar* bolo=ncfid.get_var(name.c_str());
-  
-  //need size of detector array
-  long int* edges = bolo->edges();
-  
-  //here's a vector for the data
-  MatDoub hm(*edges,*(edges+1));
-  Doub *phm = &hm[0][0];
-  
-  //fetch the data from the file and put it in something pointing at hm
-  NcBool test;
-  test = bolo->get(phm,*edges,*(edges+1),0,0,0);
-  
-  //repack the data into vector form
-  int i;
-  int j;
-  for(i=0;i<*edges;i++){
-    for(j=0;j<*(edges+1);j++){
-      bData[*(edges+1)*i+j]=hm[i][j];
-    }
-  }
-
-  //cleanup
-  delete [] edges;
-  ncfid.close();
-//}
-
-  return 1;
+  //straight from the observation's open file
+  return ap->getObsReader()->getValues(name.c_str(), bData);
 }
 
 
@@ -739,6 +690,8 @@ bool Detector::calculateScanWeight(Telescope* tel)
   //for each scan
   int nScans = tel->scanIndex.ncols();
   scanWeight.resize(nScans);
+  VecDoub scratch;
+  VecDoub &values = asDoubles(hValues, scratch);
 
   //loop through the scans
   for(int i=0;i<nScans;i++){
@@ -746,7 +699,7 @@ bool Detector::calculateScanWeight(Telescope* tel)
     int ei = tel->scanIndex[1][i];
     double tmp=0.;
     double count=0.;
-    tmp = stddev(hValues, hSampleFlags, si, ei, &count);
+    tmp = stddev(values, hSampleFlags, si, ei, &count);
  
     //insist on at least 1s of good samples
     if (tmp!=tmp || count < samplerate)
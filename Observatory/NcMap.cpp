@@ -0,0 +1,415 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+#include "NcMap.h"
+
+//header tags
+#define NCMAP_ABSENT    0
+#define NCMAP_DIMENSION 10
+#define NCMAP_VARIABLE  11
+#define NCMAP_ATTRIBUTE 12
+
+//numrecs of a file still being written
+#define NCMAP_STREAMING 0xFFFFFFFFL
+
+
+//----------------------------- o ---------------------------------------
+
+
+///m values of one block starting at value j, decoded into out
+/** The type is fixed inside each loop so the decoding inlines to a
+    byte swap.
+**/
+template <typename T>
+static void decodeBlock(const unsigned char* p, int type, long j, long m,
+			T *out)
+{
+  switch(type){
+  case NCMAP_DOUBLE:
+    for(long k=0;k<m;k++) out[k] = ncMapDecode(p, NCMAP_DOUBLE, j+k);
+    break;
+  case NCMAP_FLOAT:
+    for(long k=0;k<m;k++) out[k] = ncMapDecode(p, NCMAP_FLOAT, j+k);
+    break;
+  case NCMAP_INT:
+    for(long k=0;k<m;k++) out[k] = ncMapDecode(p, NCMAP_INT, j+k);
+    break;
+  case NCMAP_SHORT:
+    for(long k=0;k<m;k++) out[k] = ncMapDecode(p, NCMAP_SHORT, j+k);
+    break;
+  case NCMAP_BYTE:
+    for(long k=0;k<m;k++) out[k] = ncMapDecode(p, NCMAP_BYTE, j+k);
+    break;
+  default:
+    for(long k=0;k<m;k++) out[k] = p[j+k];
+  }
+}
+
+template <typename T>
+static void viewGet(const NcMapView &v, T *data, long first, long n)
+{
+  if(n < 0) n = v.size()-first;
+  if(n <= 0 || v.nPerRecord == 0) return;
+  long r = first/v.nPerRecord;
+  long j = first-r*v.nPerRecord;
+  while(n > 0){
+    long m = (n < v.nPerRecord-j) ? n : v.nPerRecord-j;
+    decodeBlock(v.base+r*v.recordStride, v.type, j, m, data);
+    data += m;
+    n -= m;
+    r++;
+    j = 0;
+  }
+}
+
+///copies n values starting at first into data, all of them by default
+void NcMapView::get(double *data, long first, long n) const
+{
+  viewGet(*this, data, first, n);
+}
+
+void NcMapView::get(int *data, long first, long n) const
+{
+  viewGet(*this, data, first, n);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///NcMap constructor, maps the file and parses its header
+/** Failing to open or map the file is not an error here: the map is
+    left invalid and the netcdf library gets to report it.
+**/
+NcMap::NcMap(const char* ncFile)
+{
+  fileName.assign(ncFile);
+  valid = 0;
+  data = NULL;
+  fileSize = 0;
+  pos = 0;
+  version = 0;
+  numRecs = 0;
+  recSize = 0;
+
+  int fd = open(ncFile, O_RDONLY);
+  if(fd < 0) return;
+  struct stat st;
+  if(fstat(fd, &st) == 0 && st.st_size > 0){
+    void* m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(m != MAP_FAILED){
+      data = (unsigned char*) m;
+      fileSize = st.st_size;
+    }
+  }
+  close(fd);
+  if(!data) return;
+
+  valid = parseHeader();
+  if(!valid){
+    munmap(data, fileSize);
+    data = NULL;
+    fileSize = 0;
+  }
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///parses the classic header, false for anything it can't map
+bool NcMap::parseHeader()
+{
+  if(fileSize < 8 || data[0] != 'C' || data[1] != 'D' || data[2] != 'F')
+    return 0;
+  version = data[3];
+  if(version != 1 && version != 2) return 0;
+  pos = 4;
+
+  long nr;
+  if(!readInt(nr)) return 0;
+  bool streaming = (nr == NCMAP_STREAMING);
+  numRecs = nr;
+
+  //dimensions
+  long tag, n;
+  if(!readInt(tag) || !readInt(n)) return 0;
+  if(tag != NCMAP_DIMENSION && (tag != NCMAP_ABSENT || n != 0)) return 0;
+  if(n > fileSize/8) return 0;
+  dims.resize(n);
+  for(long i=0;i<n;i++)
+    if(!readName(dims[i].name) || !readInt(dims[i].size)) return 0;
+
+  //global attributes
+  if(!readAtts(&atts)) return 0;
+
+  //variables
+  if(!readInt(tag) || !readInt(n)) return 0;
+  if(tag != NCMAP_VARIABLE && (tag != NCMAP_ABSENT || n != 0)) return 0;
+  if(n > fileSize/8) return 0;
+  vars.resize(n);
+  int nRecVars = 0;
+  for(long i=0;i<n;i++){
+    Var &v = vars[i];
+    long nd, t, vsize;
+    if(!readName(v.name) || !readInt(nd) || nd > fileSize/4) return 0;
+    v.dimIds.resize(nd);
+    v.nValues = 1;
+    v.isRecord = 0;
+    for(long d=0;d<nd;d++){
+      long id;
+      if(!readInt(id) || id >= (long) dims.size()) return 0;
+      v.dimIds[d] = id;
+      if(dims[id].size == 0){
+	if(d != 0) return 0;
+	v.isRecord = 1;
+      } else v.nValues *= dims[id].size;
+    }
+    if(!readAtts(NULL) || !readInt(t) || !readInt(vsize) ||
+       !readOffset(v.begin)) return 0;
+    v.type = t;
+    if(typeSize(v.type) == 0) return 0;
+    if(v.isRecord) nRecVars++;
+  }
+
+  //the record size, unpadded when there is a single record variable
+  for(size_t i=0;i<vars.size();i++)
+    if(vars[i].isRecord){
+      long bytes = vars[i].nValues*typeSize(vars[i].type);
+      recSize += (nRecVars == 1) ? bytes : ((bytes+3)/4)*4;
+    }
+
+  //number of records of a file that was never closed
+  if(streaming){
+    numRecs = 0;
+    long recStart = fileSize;
+    for(size_t i=0;i<vars.size();i++)
+      if(vars[i].isRecord && vars[i].begin < recStart)
+	recStart = vars[i].begin;
+    if(recSize > 0) numRecs = (fileSize-recStart)/recSize;
+  }
+
+  //everything has to lie inside the file
+  for(size_t i=0;i<vars.size();i++){
+    const Var &v = vars[i];
+    long bytes = v.nValues*typeSize(v.type);
+    long end = v.begin + bytes;
+    if(v.isRecord){
+      if(numRecs == 0) continue;
+      end += (numRecs-1)*recSize;
+    }
+    if(v.begin < pos || end > fileSize) return 0;
+  }
+  return 1;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///reads a 4 byte big endian non-negative integer
+bool NcMap::readInt(long &v)
+{
+  if(pos+4 > fileSize) return 0;
+  v = ((long) data[pos] << 24) | ((long) data[pos+1] << 16) |
+    ((long) data[pos+2] << 8) | (long) data[pos+3];
+  pos += 4;
+  return 1;
+}
+
+///reads a variable's begin, 4 bytes in version 1 and 8 in version 2
+bool NcMap::readOffset(long &v)
+{
+  if(version == 1) return readInt(v);
+  long hi, lo;
+  if(!readInt(hi) || !readInt(lo)) return 0;
+  v = (hi << 32) | lo;
+  return 1;
+}
+
+///reads a name, padded to 4 bytes
+bool NcMap::readName(string &name)
+{
+  long n;
+  if(!readInt(n) || pos+n > fileSize) return 0;
+  name.assign((const char*) data+pos, n);
+  pos += ((n+3)/4)*4;
+  return 1;
+}
+
+///reads an attribute list, keeping it in keep if that isn't NULL
+bool NcMap::readAtts(vector<Var> *keep)
+{
+  long tag, n;
+  if(!readInt(tag) || !readInt(n)) return 0;
+  if(tag != NCMAP_ATTRIBUTE && (tag != NCMAP_ABSENT || n != 0)) return 0;
+  for(long i=0;i<n;i++){
+    Var a;
+    long t;
+    if(!readName(a.name) || !readInt(t) || !readInt(a.nValues)) return 0;
+    a.type = t;
+    int size = typeSize(a.type);
+    if(size == 0) return 0;
+    a.begin = pos;
+    a.isRecord = 0;
+    pos += ((a.nValues*size+3)/4)*4;
+    if(pos > fileSize) return 0;
+    if(keep) keep->push_back(a);
+  }
+  return 1;
+}
+
+///bytes per value of a classic type, 0 for anything else
+int NcMap::typeSize(int type)
+{
+  switch(type){
+  case NCMAP_BYTE:
+  case NCMAP_CHAR:
+    return 1;
+  case NCMAP_SHORT:
+    return 2;
+  case NCMAP_INT:
+  case NCMAP_FLOAT:
+    return 4;
+  case NCMAP_DOUBLE:
+    return 8;
+  }
+  return 0;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///the variable called name, NULL if there is none
+const NcMap::Var* NcMap::findVar(const char* name) const
+{
+  for(size_t i=0;i<vars.size();i++)
+    if(!vars[i].name.compare(name)) return &vars[i];
+  return NULL;
+}
+
+///the global attribute called name, NULL if there is none
+const NcMap::Var* NcMap::findAtt(const char* name) const
+{
+  for(size_t i=0;i<atts.size();i++)
+    if(!atts[i].name.compare(name)) return &atts[i];
+  return NULL;
+}
+
+bool NcMap::isValid() const
+{
+  return valid;
+}
+
+const char* NcMap::getFileName() const
+{
+  return fileName.c_str();
+}
+
+bool NcMap::has(const char* name) const
+{
+  return findVar(name) != NULL;
+}
+
+bool NcMap::hasAtt(const char* name) const
+{
+  return findAtt(name) != NULL;
+}
+
+///number of values in variable name, 0 if there is none
+long NcMap::getLength(const char* name) const
+{
+  const Var* v = findVar(name);
+  if(!v) return 0;
+  return (v->isRecord) ? numRecs*v->nValues : v->nValues;
+}
+
+///size of dimension name, -1 if there is none
+long NcMap::getDimSize(const char* name) const
+{
+  for(size_t i=0;i<dims.size();i++)
+    if(!dims[i].name.compare(name))
+      return (dims[i].size == 0) ? numRecs : dims[i].size;
+  return -1;
+}
+
+///edges of variable name, empty if there is none
+vector<long> NcMap::getShape(const char* name) const
+{
+  vector<long> shape;
+  const Var* v = findVar(name);
+  if(!v) return shape;
+  for(size_t d=0;d<v->dimIds.size();d++){
+    long s = dims[v->dimIds[d]].size;
+    shape.push_back((s == 0) ? numRecs : s);
+  }
+  return shape;
+}
+
+///a view of variable name, false if there is none
+bool NcMap::getView(const char* name, NcMapView &view) const
+{
+  const Var* v = findVar(name);
+  if(!v) return 0;
+  view.base = data+v->begin;
+  view.type = v->type;
+  view.typeSize = typeSize(v->type);
+  view.nPerRecord = v->nValues;
+  view.nRecords = (v->isRecord) ? numRecs : 1;
+  view.recordStride = (v->isRecord) ? recSize : 0;
+  return 1;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///the character variable name as a string, up to its first null
+string NcMap::getString(const char* name) const
+{
+  NcMapView view;
+  string s;
+  if(!getView(name, view)) return s;
+  for(long i=0;i<view.size();i++){
+    char c = (char) view[i];
+    if(c == 0) break;
+    s.push_back(c);
+  }
+  return s;
+}
+
+///the global attribute name as a string
+/** Character attributes are returned up to their first null, numbers
+    as their first value would print.
+**/
+string NcMap::getAttString(const char* name) const
+{
+  const Var* a = findAtt(name);
+  if(!a) return string();
+  const char* p = (const char*) data+a->begin;
+  if(a->type == NCMAP_CHAR){
+    long n = 0;
+    while(n < a->nValues && p[n] != 0) n++;
+    return string(p, n);
+  }
+  ostringstream os;
+  if(a->nValues > 0) os << ncMapDecode(data+a->begin, a->type, 0);
+  return os.str();
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+NcMap::~NcMap()
+{
+  if(data) munmap(data, fileSize);
+}
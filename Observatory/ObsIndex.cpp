@@ -0,0 +1,301 @@
+#include <netcdfcpp.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+#include "ObsIndex.h"
+#include "ObsReader.h"
+
+//first line of every sidecar, bump when the keys change meaning
+#define OBSINDEX_TAG "macanaIndex 1"
+
+
+///ObsIndex constructor, loads the sidecar of file if it is current
+ObsIndex::ObsIndex(const char* file)
+{
+  fileName.assign(file);
+  indexName = fileName + ".idx";
+  fileSize = -1;
+  fileTime = -1;
+  current = load();
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///the index of a raw data file, built from it if need be
+ObsIndex* ObsIndex::forDataFile(const char* file)
+{
+  ObsIndex* index = new ObsIndex(file);
+  if(!index->current){
+    index->indexDataFile();
+    index->save();
+  }
+  return index;
+}
+
+///the index of an observation map file, built from it if need be
+ObsIndex* ObsIndex::forMapFile(const char* file)
+{
+  ObsIndex* index = new ObsIndex(file);
+  if(!index->current){
+    index->indexMapFile();
+    index->save();
+  }
+  return index;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///reads the scalars of a raw data file
+/** The observatory is told by the variables present, as
+    AnalParams::determineObservatory() always did.
+**/
+void ObsIndex::indexDataFile()
+{
+  keys.clear();
+  values.clear();
+  stat(fileSize, fileTime);
+  ObsReader reader(fileName.c_str());
+
+  string observatory, timeVarName;
+  if(reader.has("Data.AztecBackend.time")){
+    observatory.assign("LMT");
+    timeVarName.assign("Data.AztecBackend.time");
+  } else {
+    observatory.assign((reader.has("aste_windtime")) ? "ASTE" : "JCMT");
+    timeVarName.assign("time");
+  }
+  set("observatory", observatory);
+  set("timeVarName", timeVarName);
+  set("nSamples", (int) reader.getLength(timeVarName.c_str()));
+  if(reader.has("Header.Dcs.ObsNum"))
+    set("obsNum", reader.getInt("Header.Dcs.ObsNum"));
+  if(reader.has("Header.Dcs.ProjectId"))
+    set("projectID", reader.getString("Header.Dcs.ProjectId"));
+}
+
+
+///reads the scalars of an observation map file
+/** Only the header and the ends of the coordinate vectors are read.
+    Missing values are left out of the index and are an error only
+    for whoever asks for them.
+**/
+void ObsIndex::indexMapFile()
+{
+  keys.clear();
+  values.clear();
+  stat(fileSize, fileTime);
+#pragma omp critical (dataio)
+{
+  NcError ncerror(NcError::silent_nonfatal);
+  NcFile ncfid(fileName.c_str(), NcFile::ReadOnly);
+  if(ncfid.is_valid()){
+    NcDim* rowDim = ncfid.get_dim("nrows");
+    NcDim* colDim = ncfid.get_dim("ncols");
+    NcVar* rcpv = ncfid.get_var("rowCoordsPhys");
+    NcVar* ccpv = ncfid.get_var("colCoordsPhys");
+    if(rowDim && colDim && rcpv && ccpv){
+      int nrows = rowDim->size();
+      int ncols = colDim->size();
+      set("nrows", nrows);
+      set("ncols", ncols);
+      set("rowCoordsPhysFirst", rcpv->as_double(0));
+      set("rowCoordsPhysLast", rcpv->as_double(nrows-1));
+      set("colCoordsPhysFirst", ccpv->as_double(0));
+      set("colCoordsPhysLast", ccpv->as_double(ncols-1));
+    }
+    const char* doubleAtts[] = {"MasterGrid[0]", "MasterGrid[1]",
+				"ArrayAvgTau", "pixelSize"};
+    for(int i=0;i<4;i++){
+      NcAtt* att = ncfid.get_att(doubleAtts[i]);
+      if(att) set(doubleAtts[i], att->as_double(0));
+      delete att;
+    }
+    NcAtt* att = ncfid.get_att("ObsNum");
+    if(att) set("ObsNum", att->as_int(0));
+    delete att;
+    att = ncfid.get_att("source");
+    if(att){
+      char* tmp = att->as_string(0);
+      set("source", string(tmp));
+      delete [] tmp;
+    }
+    delete att;
+  }
+}
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///size and modification time of the indexed file
+bool ObsIndex::stat(long &size, long &time)
+{
+  struct stat st;
+  if(::stat(fileName.c_str(), &st) != 0) return 0;
+  size = st.st_size;
+  time = st.st_mtime;
+  return 1;
+}
+
+///reads the sidecar, true if it describes the file as it is now
+bool ObsIndex::load()
+{
+  long size, time;
+  if(!stat(size, time)) return 0;
+  ifstream in(indexName.c_str());
+  if(!in.good()) return 0;
+  string line;
+  if(!getline(in, line) || line.compare(OBSINDEX_TAG)) return 0;
+
+  vector<string> k, v;
+  while(getline(in, line)){
+    size_t sp = line.find(' ');
+    if(sp == string::npos) continue;
+    k.push_back(line.substr(0, sp));
+    v.push_back(line.substr(sp+1));
+  }
+
+  //the stamp comes first
+  if(k.size() < 2 || k[0].compare("fileSize") || k[1].compare("fileTime"))
+    return 0;
+  fileSize = atol(v[0].c_str());
+  fileTime = atol(v[1].c_str());
+  if(fileSize != size || fileTime != time) return 0;
+  keys.assign(k.begin()+2, k.end());
+  values.assign(v.begin()+2, v.end());
+  return 1;
+}
+
+///writes the sidecar, false if it can't be
+/** The sidecar is written to a temporary file made by mkstemp next to
+    it and renamed into place so that a reader never sees half of one.
+    mkstemp creates the name exclusively, so writers on other hosts
+    sharing the data directory can't collide on it either.
+**/
+bool ObsIndex::save()
+{
+  string tmpPattern = indexName + ".tmpXXXXXX";
+  vector<char> tmpBuf(tmpPattern.begin(), tmpPattern.end());
+  tmpBuf.push_back('\0');
+  int fd = mkstemp(&tmpBuf[0]);
+  if(fd < 0) return 0;
+  //mkstemp makes it owner only, the sidecar is meant to be shared
+  fchmod(fd, 0644);
+  close(fd);
+  string tmpName(&tmpBuf[0]);
+  {
+    ofstream out(tmpName.c_str());
+    if(!out.good()){
+      remove(tmpName.c_str());
+      return 0;
+    }
+    out << OBSINDEX_TAG << endl;
+    out << "fileSize " << fileSize << endl;
+    out << "fileTime " << fileTime << endl;
+    for(size_t i=0;i<keys.size();i++)
+      out << keys[i] << " " << values[i] << endl;
+    if(!out.good()){
+      out.close();
+      remove(tmpName.c_str());
+      return 0;
+    }
+  }
+  if(rename(tmpName.c_str(), indexName.c_str()) != 0){
+    remove(tmpName.c_str());
+    return 0;
+  }
+  current = 1;
+  return 1;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///whether the index came from a sidecar that is still current
+bool ObsIndex::isCurrent()
+{
+  return current;
+}
+
+int ObsIndex::find(const char* key)
+{
+  for(size_t i=0;i<keys.size();i++)
+    if(!keys[i].compare(key)) return i;
+  return -1;
+}
+
+bool ObsIndex::has(const char* key)
+{
+  return find(key) >= 0;
+}
+
+///the value of key, which must be in the index
+string ObsIndex::getString(const char* key)
+{
+  int i = find(key);
+  if(i < 0){
+    cerr << "ObsIndex::getString(): no " << key << " for ";
+    cerr << fileName << endl;
+    exit(1);
+  }
+  return values[i];
+}
+
+double ObsIndex::getDouble(const char* key)
+{
+  return atof(getString(key).c_str());
+}
+
+int ObsIndex::getInt(const char* key)
+{
+  return atoi(getString(key).c_str());
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///sets key to value, which is kept on one line
+void ObsIndex::set(const char* key, const string &value)
+{
+  string v(value);
+  for(size_t i=0;i<v.size();i++)
+    if(v[i] == '\n' || v[i] == '\r' || v[i] == 0) v[i] = ' ';
+  int i = find(key);
+  if(i >= 0){
+    values[i] = v;
+    return;
+  }
+  keys.push_back(key);
+  values.push_back(v);
+}
+
+///doubles are written with enough digits to read back exactly
+void ObsIndex::set(const char* key, double value)
+{
+  ostringstream os;
+  os << setprecision(17) << value;
+  set(key, os.str());
+}
+
+void ObsIndex::set(const char* key, int value)
+{
+  ostringstream os;
+  os << value;
+  set(key, os.str());
+}
@@ -0,0 +1,347 @@
+#include <netcdfcpp.h>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "ObsReader.h"
+
+///ObsReader constructor, maps or opens the file
+ObsReader::ObsReader(const char* dataFile)
+{
+  fileName.assign(dataFile);
+  ncfid = NULL;
+  ncMap = new NcMap(dataFile);
+  if(ncMap->isValid()) return;
+  delete ncMap;
+  ncMap = NULL;
+
+  //not a classic file, through the netcdf library
+#pragma omp critical (dataio)
+{
+  ncfid = new NcFile(fileName.c_str(), NcFile::ReadOnly);
+}
+  if(!ncfid->is_valid()){
+    cerr << "ObsReader(): couldn't open " << fileName << endl;
+    exit(1);
+  }
+}
+
+const char* ObsReader::getFileName()
+{
+  return fileName.c_str();
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///the variable called name, NULL if there is none
+/** Called from inside the dataio critical section.
+**/
+NcVar* ObsReader::findVar(const char* name)
+{
+  NcError ncerror(NcError::silent_nonfatal);
+  return ncfid->get_var(name);
+}
+
+bool ObsReader::has(const char* name)
+{
+  if(ncMap) return ncMap->has(name);
+  bool found;
+#pragma omp critical (dataio)
+  found = (findVar(name) != NULL);
+  return found;
+}
+
+///whether the file has the global attribute name
+bool ObsReader::hasAtt(const char* name)
+{
+  if(ncMap) return ncMap->hasAtt(name);
+  bool found;
+#pragma omp critical (dataio)
+{
+  NcError ncerror(NcError::silent_nonfatal);
+  NcAtt* att = ncfid->get_att(name);
+  found = (att != NULL);
+  delete att;
+}
+  return found;
+}
+
+///number of values in variable name, 0 if there is none
+long ObsReader::getLength(const char* name)
+{
+  if(ncMap) return ncMap->getLength(name);
+  long n=0;
+#pragma omp critical (dataio)
+{
+  NcVar* var = findVar(name);
+  if(var) n = var->num_vals();
+}
+  return n;
+}
+
+///size of dimension name, -1 if there is none
+long ObsReader::getDimSize(const char* name)
+{
+  if(ncMap) return ncMap->getDimSize(name);
+  long n=-1;
+#pragma omp critical (dataio)
+{
+  NcError ncerror(NcError::silent_nonfatal);
+  NcDim* dim = ncfid->get_dim(name);
+  if(dim) n = dim->size();
+}
+  return n;
+}
+
+
+///edges of variable name, empty if there is none
+vector<long> ObsReader::getShape(const char* name)
+{
+  if(ncMap) return ncMap->getShape(name);
+  vector<long> shape;
+#pragma omp critical (dataio)
+{
+  NcVar* var = findVar(name);
+  if(var){
+    long* edges = var->edges();
+    shape.assign(edges, edges+var->num_dims());
+    delete [] edges;
+  }
+}
+  return shape;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///reads all of variable name into data, in file order
+/** data must hold getLength(name) values.  A missing variable is
+    fatal, as it was for the readers this replaces.
+**/
+bool ObsReader::getValues(const char* name, double *data)
+{
+  if(ncMap){
+    NcMapView view;
+    if(!ncMap->getView(name, view)){
+      cerr << "ObsReader::getValues(): no variable " << name;
+      cerr << " in " << fileName << endl;
+      exit(1);
+    }
+    view.get(data);
+    return 1;
+  }
+  bool ok;
+#pragma omp critical (dataio)
+{
+  NcVar* var = findVar(name);
+  if(!var){
+    cerr << "ObsReader::getValues(): no variable " << name;
+    cerr << " in " << fileName << endl;
+    exit(1);
+  }
+  long* edges = var->edges();
+  ok = var->get(data, edges);
+  delete [] edges;
+}
+  return ok;
+}
+
+bool ObsReader::getValues(const char* name, int *data)
+{
+  if(ncMap){
+    NcMapView view;
+    if(!ncMap->getView(name, view)){
+      cerr << "ObsReader::getValues(): no variable " << name;
+      cerr << " in " << fileName << endl;
+      exit(1);
+    }
+    view.get(data);
+    return 1;
+  }
+  bool ok;
+#pragma omp critical (dataio)
+{
+  NcVar* var = findVar(name);
+  if(!var){
+    cerr << "ObsReader::getValues(): no variable " << name;
+    cerr << " in " << fileName << endl;
+    exit(1);
+  }
+  long* edges = var->edges();
+  ok = var->get(data, edges);
+  delete [] edges;
+}
+  return ok;
+}
+
+
+///queues variable name to be read into data by readRequested()
+void ObsReader::request(const char* name, double *data)
+{
+  requestNames.push_back(name);
+  requestData.push_back(data);
+}
+
+///reads every queued variable in one pass and clears the queue
+bool ObsReader::readRequested()
+{
+  bool ok=true;
+  if(ncMap){
+    //no lock, so the copies may as well run side by side
+    int nReq = requestNames.size();
+#pragma omp parallel for schedule(dynamic)
+    for(int r=0;r<nReq;r++) getValues(requestNames[r].c_str(), requestData[r]);
+    requestNames.clear();
+    requestData.clear();
+    return ok;
+  }
+#pragma omp critical (dataio)
+{
+  for(size_t r=0;r<requestNames.size();r++){
+    NcVar* var = findVar(requestNames[r].c_str());
+    if(!var){
+      cerr << "ObsReader::readRequested(): no variable " << requestNames[r];
+      cerr << " in " << fileName << endl;
+      exit(1);
+    }
+    long* edges = var->edges();
+    ok = var->get(requestData[r], edges) && ok;
+    delete [] edges;
+  }
+}
+  requestNames.clear();
+  requestData.clear();
+  return ok;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///value i of variable name
+double ObsReader::getDouble(const char* name, long i)
+{
+  double v;
+  if(ncMap){
+    NcMapView view;
+    if(!ncMap->getView(name, view)){
+      cerr << "ObsReader::getDouble(): no variable " << name;
+      cerr << " in " << fileName << endl;
+      exit(1);
+    }
+    return view[i];
+  }
+#pragma omp critical (dataio)
+{
+  NcVar* var = findVar(name);
+  if(!var){
+    cerr << "ObsReader::getDouble(): no variable " << name;
+    cerr << " in " << fileName << endl;
+    exit(1);
+  }
+  v = var->as_double(i);
+}
+  return v;
+}
+
+int ObsReader::getInt(const char* name, long i)
+{
+  int v;
+  if(ncMap){
+    NcMapView view;
+    if(!ncMap->getView(name, view)){
+      cerr << "ObsReader::getInt(): no variable " << name;
+      cerr << " in " << fileName << endl;
+      exit(1);
+    }
+    return (int) view[i];
+  }
+#pragma omp critical (dataio)
+{
+  NcVar* var = findVar(name);
+  if(!var){
+    cerr << "ObsReader::getInt(): no variable " << name;
+    cerr << " in " << fileName << endl;
+    exit(1);
+  }
+  v = var->as_int(i);
+}
+  return v;
+}
+
+///the character variable name as a string
+string ObsReader::getString(const char* name)
+{
+  string s;
+  if(ncMap){
+    if(!ncMap->has(name)){
+      cerr << "ObsReader::getString(): no variable " << name;
+      cerr << " in " << fileName << endl;
+      exit(1);
+    }
+    return ncMap->getString(name);
+  }
+#pragma omp critical (dataio)
+{
+  NcVar* var = findVar(name);
+  if(!var){
+    cerr << "ObsReader::getString(): no variable " << name;
+    cerr << " in " << fileName << endl;
+    exit(1);
+  }
+  char* tmp = var->as_string(0);
+  s.assign(tmp);
+  delete [] tmp;
+}
+  return s;
+}
+
+///the global attribute name as a string
+string ObsReader::getAttString(const char* name)
+{
+  string s;
+  if(ncMap){
+    if(!ncMap->hasAtt(name)){
+      cerr << "ObsReader::getAttString(): no attribute " << name;
+      cerr << " in " << fileName << endl;
+      exit(1);
+    }
+    return ncMap->getAttString(name);
+  }
+#pragma omp critical (dataio)
+{
+  NcError ncerror(NcError::silent_nonfatal);
+  NcAtt* att = ncfid->get_att(name);
+  if(!att){
+    cerr << "ObsReader::getAttString(): no attribute " << name;
+    cerr << " in " << fileName << endl;
+    exit(1);
+  }
+  char* tmp = att->as_string(0);
+  s.assign(tmp);
+  delete [] tmp;
+  delete att;
+}
+  return s;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+ObsReader::~ObsReader()
+{
+  if(ncMap){
+    delete ncMap;
+    return;
+  }
+#pragma omp critical (dataio)
+{
+  ncfid->close();
+  delete ncfid;
+}
+}
@@ -33,17 +33,8 @@ Telescope::Telescope(AnalParams* anal, TimePlace* tP, Source* source)
 
 
 
-  long int * edges = NULL;
   //set the number of available samples
-#pragma omp critical (dataio)
-{
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcVar* timeVar = ncfid.get_var(timeVarName.c_str());
-  edges = timeVar->edges();
-  nSamples = edges[0]*edges[1];
-  ncfid.close();
-}
-  delete [] edges;
+  nSamples = ap->getObsReader()->getLength(timeVarName.c_str());
 
   //get the pointing signals
   if(observatory.compare("LMT") == 0){
@@ -90,27 +81,29 @@ Telescope::Telescope(AnalParams* anal, TimePlace* tP, Source* source)
 **/
 bool Telescope::getLMTPointing()
 {
-  //in this case we just grab the pointing data directly from the file
+  //in this case we just grab the pointing data directly from the file,
+  //all nine signals in one pass
+  ObsReader* reader = ap->getObsReader();
   paraAngle.resize(nSamples);
-  //getTelescopeValues("Data.AztecBackend.ParAng", &paraAngle[0]);
-  getTelescopeValues("Data.AztecBackend.ParAng", &paraAngle[0]);
-  for(int i=0;i<nSamples;i++) paraAngle[i] = TWO_PI/2.-paraAngle[i];
   hTelRa.resize(nSamples);
-  getTelescopeValues("Data.AztecBackend.SourceRaAct", &hTelRa[0]);
   hTelDec.resize(nSamples);
-  getTelescopeValues("Data.AztecBackend.SourceDecAct", &hTelDec[0]);
   hTelAzAct.resize(nSamples);
-  getTelescopeValues("Data.AztecBackend.TelAzAct", &hTelAzAct[0]);
   hTelElAct.resize(nSamples);
-  getTelescopeValues("Data.AztecBackend.TelElAct", &hTelElAct[0]);
   hTelAzDes.resize(nSamples);
-  getTelescopeValues("Data.AztecBackend.TelAzDes", &hTelAzDes[0]);
   hTelElDes.resize(nSamples);
-  getTelescopeValues("Data.AztecBackend.TelElDes", &hTelElDes[0]);
   hTelAzCor.resize(nSamples);
-  getTelescopeValues("Data.AztecBackend.TelAzCor", &hTelAzCor[0]);
   hTelElCor.resize(nSamples);
-  getTelescopeValues("Data.AztecBackend.TelElCor", &hTelElCor[0]);
+  reader->request("Data.AztecBackend.ParAng", &paraAngle[0]);
+  reader->request("Data.AztecBackend.SourceRaAct", &hTelRa[0]);
+  reader->request("Data.AztecBackend.SourceDecAct", &hTelDec[0]);
+  reader->request("Data.AztecBackend.TelAzAct", &hTelAzAct[0]);
+  reader->request("Data.AztecBackend.TelElAct", &hTelElAct[0]);
+  reader->request("Data.AztecBackend.TelAzDes", &hTelAzDes[0]);
+  reader->request("Data.AztecBackend.TelElDes", &hTelElDes[0]);
+  reader->request("Data.AztecBackend.TelAzCor", &hTelAzCor[0]);
+  reader->request("Data.AztecBackend.TelElCor", &hTelElCor[0]);
+  reader->readRequested();
+  for(int i=0;i<nSamples;i++) paraAngle[i] = TWO_PI/2.-paraAngle[i];
 
   //calcParallacticAngle();
   cerr<<"Got Values from file"<<endl;
@@ -127,15 +120,8 @@ bool Telescope::getLMTPointing()
   alignWithDetectors();
 
   //fetch the az and el user offsets
-#pragma omp critical (dataio)
-{
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcVar* azo=ncfid.get_var("Header.PointModel.AzUserOff");
-  NcVar* elo=ncfid.get_var("Header.PointModel.ElUserOff");
-  azUserOff = azo->as_double(0);
-  elUserOff = elo->as_double(0);
-  ncfid.close();
-}
+  azUserOff = reader->getDouble("Header.PointModel.AzUserOff");
+  elUserOff = reader->getDouble("Header.PointModel.ElUserOff");
 
   //calculate the parallactic angle used to make bolo pointings
 //  calcParallacticAngle();
@@ -158,16 +144,18 @@ bool Telescope::getASTEPointing()
   //get Az and El from file, they are called Act but are actually Des
   //swap the sign on the error signals so that the sign convention 
   //matches the LMT's Cor signals.
+  ObsReader* reader = ap->getObsReader();
   hTelAzDes.resize(nSamples);
-  getTelescopeValues("aste_azact", &hTelAzDes[0]);
-  for(int i=0;i<nSamples;i++) hTelAzDes[i] /= DEG_RAD;
   hTelElDes.resize(nSamples);
-  getTelescopeValues("aste_elact", &hTelElDes[0]);
-  for(int i=0;i<nSamples;i++) hTelElDes[i] /= DEG_RAD;
   hTelAzCor.resize(nSamples);
-  getTelescopeValues("aste_azerr", &hTelAzCor[0]);
   hTelElCor.resize(nSamples);
-  getTelescopeValues("aste_elerr", &hTelElCor[0]);  
+  reader->request("aste_azact", &hTelAzDes[0]);
+  reader->request("aste_elact", &hTelElDes[0]);
+  reader->request("aste_azerr", &hTelAzCor[0]);
+  reader->request("aste_elerr", &hTelElCor[0]);
+  reader->readRequested();
+  for(int i=0;i<nSamples;i++) hTelAzDes[i] /= DEG_RAD;
+  for(int i=0;i<nSamples;i++) hTelElDes[i] /= DEG_RAD;
 
   //the other signals need storage space with zeros
   paraAngle.assign(nSamples,1.);
@@ -210,31 +198,22 @@ bool Telescope::getASTEPointing()
 
 ///pulls the M2 offsets from the data file
 bool Telescope::getM2Offsets()
-{
-  //open the netcdf file
-#pragma omp critical (dataio)
 {
   if (ap->getObservatory().compare("LMT")==0){
-	  NcFile ncfid(dataFile, NcFile::ReadOnly);
-	  NcVar* var=ncfid.get_var("Header.M2.XReq");
-
-	  if (!var){
+	  ObsReader* reader = ap->getObsReader();
+	  if (!reader->has("Header.M2.XReq")){
 		  cerr<<"Telescope(): Warning no Header data in NetCDF file."<<endl;
 		  exit(-1);
 	  }
 
-	  M2XReq = var->as_double(0);
-	  var=ncfid.get_var("Header.M2.YReq");
-	  M2YReq = var->as_double(0);
-	  var=ncfid.get_var("Header.M2.ZReq");
-	  M2ZReq = var->as_double(0);
-	  ncfid.close();
+	  M2XReq = reader->getDouble("Header.M2.XReq");
+	  M2YReq = reader->getDouble("Header.M2.YReq");
+	  M2ZReq = reader->getDouble("Header.M2.ZReq");
   }else{ ///TODO: Set apropiate ASTE/JCMT variables if necessary
 	  M2XReq = 0.0;
 	  M2YReq = 0.0;
 	  M2ZReq = 0.0;
   }
-}
   return 1;
 }
 
@@ -243,27 +222,21 @@ bool Telescope::getM2Offsets()
 
 ///pulls the M2 offsets from the data file
 bool Telescope::getM1Zernike()
-{
-  //open the netcdf file
-#pragma omp critical (dataio)
 {
   if (ap->getObservatory().compare("LMT")==0 && utDate>=2014.82235488798){
-	  NcFile ncfid(dataFile, NcFile::ReadOnly);
-	  NcVar* var=ncfid.get_var("Header.M1.ZernikeC");
-	  if (!var){
+	  ObsReader* reader = ap->getObsReader();
+	  if (!reader->has("Header.M1.ZernikeC")){
 		  cerr<<"Telescope(): Warning no Zernike Header data in NetCDF file."<<endl;
 		  exit(-1);
 	  }
-	  M1ZernikeC0 = var->as_double(0);
-	  M1ZernikeC1 = var->as_double(1);
-	  M1ZernikeC2 = var->as_double(2);
-	  ncfid.close();
+	  M1ZernikeC0 = reader->getDouble("Header.M1.ZernikeC", 0);
+	  M1ZernikeC1 = reader->getDouble("Header.M1.ZernikeC", 1);
+	  M1ZernikeC2 = reader->getDouble("Header.M1.ZernikeC", 2);
   }else{ ///TODO: Set apropiate ASTE/JCMT variables if necessary
 	  M1ZernikeC0 = 0.;
 	  M1ZernikeC1 = 0.;
 	  M1ZernikeC2 = 0.;
   }
-}
   return 1;
 
 }
@@ -272,24 +245,17 @@ bool Telescope::getM1Zernike()
 
 ///pulls the obsnum from the data file
 bool Telescope::getObsNumFromFile()
-{
-  //open the netcdf file
-#pragma omp critical (dataio)
 {
   if (ap->getObservatory().compare("LMT")==0){
-	  NcFile ncfid(dataFile, NcFile::ReadOnly);
-	  NcVar* var=ncfid.get_var("Header.Dcs.ObsNum");
-
-	  if (!var){
+	  ObsIndex* index = ap->getObsIndex();
+	  if (!index->has("obsNum")){
 		  cerr<<"Telescope(): Warning no Header data in NetCDF file."<<endl;
 		  exit(-1);
 	  }
-	  obsNum = var->as_int(0);
-	  ncfid.close();
+	  obsNum = index->getInt("obsNum");
   }else{ ///TODO: Set apropiate ASTE/JCMT variables if necessary
           obsNum = 0;
   }
-}
   return 1;
 
 }
@@ -298,25 +264,18 @@ bool Telescope::getObsNumFromFile()
 
 ///pulls the project ID from the data file
 bool Telescope::getProjectIDFromFile()
-{
-  //open the netcdf file
-#pragma omp critical (dataio)
 {
   if (ap->getObservatory().compare("LMT")==0 && utDate>=2014.75){
-    NcFile ncfid(dataFile, NcFile::ReadOnly);
-    NcVar* var=ncfid.get_var("Header.Dcs.ProjectId");
-    
-    if (!var){
+    ObsIndex* index = ap->getObsIndex();
+    if (!index->has("projectID")){
       cerr<<"Telescope(): Warning no Header data in NetCDF file."<<endl;
       exit(-1);
     }
-    projectID.assign(var->as_string(0));
+    projectID = index->getString("projectID");
     projectID.erase(projectID.find_last_not_of(" \n\r\t")+1);
-    ncfid.close();
   }else{ ///TODO: Set apropiate ASTE/JCMT variables if necessary
     projectID.assign("");
   }
-}
 
   return 1;
 }
@@ -328,38 +287,8 @@ bool Telescope::getProjectIDFromFile()
 ///returns vector of Telescope values
 bool Telescope::getTelescopeValues(const char* sigName, double *tData)
 {
-
-  //open the netcdf file
-#pragma omp critical (dataio)
-{
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcVar* tele=ncfid.get_var(sigName);
-  
-  //need size of detector array
-  long int* edges = tele->edges();
-  
-  //here's a vector for the data
-  MatDoub hm(edges[0],edges[1]);
-  Doub *phm = &hm[0][0];
-  
-  //fetch the data from the file and put it in something pointing at hm
-  NcBool test;
-  test = tele->get(phm,edges[0],edges[1],0,0,0);
-  
-  //repack the data into vector form
-  int i;
-  int j;
-  for(i=0;i<edges[0];i++){
-    for(j=0;j<edges[1];j++){
-      tData[edges[1]*i+j]=hm[i][j];
-    }
-  }
-  
-  //cleanup
-  delete [] edges;
-  ncfid.close();
-}
-  return 1;
+  //straight from the observation's open file
+  return ap->getObsReader()->getValues(sigName, tData);
 }
 
 
@@ -438,70 +367,22 @@ bool Telescope::alignWithDetectors()
   //here we interpolate them to detUtc to align them
   //with the detector signals
 
-  //here's the model for this
-  VecDoub xx(timePlace->nUnique),yy(timePlace->nUnique);   //original signals
-
   cerr << "Telescope::alignWithDetectors() with " << nSamples;
   cerr << " samples." << endl;
 
-  //deal with the xx vector first
-  for(int i=0;i<timePlace->nUnique;i++)
-    xx[i] = timePlace->telUtcUnique[i]+timePlace->timeOffset;
-
-  //interpolate paraAngle
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=paraAngle[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &paraAngle[0], nSamples);
-
-  //interpolate hTelRa
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hTelRa[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hTelRa[0], nSamples);
-
-  //interpolate hTelDec
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hTelDec[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hTelDec[0], nSamples);
-
-  //interpolate hTelAzAct
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hTelAzAct[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hTelAzAct[0], nSamples);
-
-  //interpolate hTelElAct
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hTelElAct[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hTelElAct[0], nSamples);
-
-  //interpolate hTelAzDes
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hTelAzDes[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hTelAzDes[0], nSamples);
-
-  //interpolate hTelElDes
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hTelElDes[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hTelElDes[0], nSamples);
-
-  //interpolate hTelAzCor
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hTelAzCor[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hTelAzCor[0], nSamples);
-
-  //interpolate hTelElCor
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hTelElCor[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hTelElCor[0], nSamples);
-
+  //all of the pointing signals are resampled together with the
+  //brackets and weights already found by timePlace
+  vector<double*> signals;
+  signals.push_back(&paraAngle[0]);
+  signals.push_back(&hTelRa[0]);
+  signals.push_back(&hTelDec[0]);
+  signals.push_back(&hTelAzAct[0]);
+  signals.push_back(&hTelElAct[0]);
+  signals.push_back(&hTelAzDes[0]);
+  signals.push_back(&hTelElDes[0]);
+  signals.push_back(&hTelAzCor[0]);
+  signals.push_back(&hTelElCor[0]);
+  timePlace->toDetectors.resample(signals, &timePlace->locUnique[0]);
 
   cerr << "Telescope::alignWithDetectors(): done." << endl;
   return 1;
@@ -536,15 +417,9 @@ bool Telescope::defineScans(AnalParams* ap, double timeChunk)
   //need samplerate from dataFile
   int samplerate;
   string dimname;
-#pragma omp critical (dataio)
-{
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
   if(LMT) dimname.assign("Data.AztecBackend.time_xlen");
   if(ASTE) dimname.assign("mfpersf");
-  NcDim* mfPerSf=ncfid.get_dim(dimname.c_str());
-  samplerate = mfPerSf->size();
-  ncfid.close();
-}
+  samplerate = ap->getObsReader()->getDimSize(dimname.c_str());
   //the goal is to pack up the turning array
   VecBool turning(nSamples);
   VecBool flagT2(nSamples,1);
@@ -816,8 +691,8 @@ bool Telescope::calcParallacticAngle()
   double* sel = &hTelElAct[0];
   physToAbs(&daz[0],&del[0],&saz[0],&sel[0],&naz[0],&nel[0],nSamples);
   azElToRaDec2000(timePlace, &naz[0], &nel[0], &nra[0], &ndec[0], nSamples);
-  for(int i=0;i<nSamples;i++)
-    absToPhys(&nra[i], &ndec[i], hTelRa[i], hTelDec[i], &dra[i], &ddec[i], 1);
+  absToPhys(&nra[0], &ndec[0], &hTelRa[0], &hTelDec[0], &dra[0], &ddec[0],
+	    nSamples);
   for(int i=0;i<nSamples;i++) paraAngle[i] = atan2(ddec[i],dra[i]);
   return 1;
 }
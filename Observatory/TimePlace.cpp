@@ -9,6 +9,7 @@ using namespace std;
 #include "tinyxml2.h"
 #include "AnalParams.h"
 #include "TimePlace.h"
+#include "TimeModel.h"
 #include "Telescope.h"
 #include "astron_utilities.h"
 #include "vector_utilities.h"
@@ -22,20 +23,13 @@ TimePlace::TimePlace(AnalParams* anal)
 {
   //preliminaries
   ap = anal;
+  timeModel = NULL;
   dataFile = ap->getDataFile();
   string timeVarName = ap->getTimeVarName();
   string observatory = ap->getObservatory();
 
-  //open the file and get dimensions 
-#pragma omp critical (dataio)
-{
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcVar* timeVar = ncfid.get_var(timeVarName.c_str());
-  long int* edges = timeVar->edges();
-  nSamples = edges[0]*edges[1];
-  ncfid.close();
-  delete [] edges;
-}
+  //get dimensions from the observation's open file
+  nSamples = ap->getObsReader()->getLength(timeVarName.c_str());
   //get the timing signals
   if(observatory.compare("LMT") == 0){
     getLMTTiming();
@@ -61,26 +55,20 @@ TimePlace::TimePlace(AnalParams* anal)
 bool TimePlace::getLMTTiming()
 {
   //get the single-valued signals
-#pragma omp critical (dataio)
-{
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcVar* longVar = ncfid.get_var("Header.TimePlace.ObsLongitude");
-  longVar->get(&longitude,1,0,0,0,0);
-  NcVar* latVar = ncfid.get_var("Header.TimePlace.ObsLatitude");
-  latVar->get(&latitude,1,0,0,0,0);
-  NcVar* elevVar = ncfid.get_var("Header.TimePlace.ObsElevation");
-  elevVar->get(&elevation,1,0,0,0,0);
-  NcVar* utdVar = ncfid.get_var("Header.TimePlace.UTDate");
-  utdVar->get(&utDate,1,0,0,0,0);
-  ncfid.close();
-}
-  //now run through variables and fetch them
+  ObsReader* reader = ap->getObsReader();
+  longitude = reader->getDouble("Header.TimePlace.ObsLongitude");
+  latitude = reader->getDouble("Header.TimePlace.ObsLatitude");
+  elevation = reader->getDouble("Header.TimePlace.ObsElevation");
+  utDate = reader->getDouble("Header.TimePlace.UTDate");
+
+  //now fetch the timing signals in one pass
   telUtc.resize(nSamples);
-  getTimePlaceValues("Data.AztecBackend.TelUtc", &telUtc[0]);
   detUtc.resize(nSamples);
-  getTimePlaceValues("Data.AztecBackend.AztecUtc", &detUtc[0]);
   lst.resize(nSamples);
-  getTimePlaceValues("Data.AztecBackend.TelLst", &lst[0]);
+  reader->request("Data.AztecBackend.TelUtc", &telUtc[0]);
+  reader->request("Data.AztecBackend.AztecUtc", &detUtc[0]);
+  reader->request("Data.AztecBackend.TelLst", &lst[0]);
+  reader->readRequested();
 
   //apply levels 0 signal conditioning
   signalCondition0();
@@ -143,16 +131,8 @@ bool TimePlace::getASTETiming()
   longitude = -67.703304 / DEG_RAD;
   latitude = -22.971657 / DEG_RAD;
   elevation = 4861.9;
-  string date;
-#pragma omp critical (dataio)
-{
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcAtt* dateAtt = ncfid.get_att("data_file");
-  char *tmpDate = dateAtt->as_string(0);
-  date.assign(tmpDate);
-  delete [] tmpDate;
-  delete dateAtt;
-}
+  ObsReader* reader = ap->getObsReader();
+  string date = reader->getAttString("data_file");
   int hour, minute, second;
   string smonth, sday, syear, shour, sminute, ssecond;
   int found=date.find_first_of("_",1);
@@ -189,11 +169,12 @@ bool TimePlace::getASTETiming()
   utDate = epoch(month, day, year);
   //now run through variables and fetch them
   telUtc.resize(nSamples);
-  getTimePlaceValues("aste_utc", &telUtc[0]);
   detUtc.resize(nSamples);
-  getTimePlaceValues("aztec_utc", &detUtc[0]);
   lst.resize(nSamples);
-  getTimePlaceValues("aste_lst", &lst[0]);
+  reader->request("aste_utc", &telUtc[0]);
+  reader->request("aztec_utc", &detUtc[0]);
+  reader->request("aste_lst", &lst[0]);
+  reader->readRequested();
   for(int i=0;i<nSamples;i++) lst[i] = lst[i]/24.*TWO_PI;
 
   //apply levels 0 signal conditioning
@@ -272,38 +253,8 @@ bool TimePlace::fixRollover()
 ///returns vector of TimePlace values
 bool TimePlace::getTimePlaceValues(const char* sigName, double *tData)
 {
-  //open the netcdf file
-
-#pragma omp critical (dataio)
-{
-  NcFile ncfid(dataFile, NcFile::ReadOnly);
-  NcVar* timer=ncfid.get_var(sigName);
-  
-  //need size of detector array
-  long int* edges = timer->edges();
-  
-  //here's a vector for the data
-  MatDoub hm(*edges,*(edges+1));
-  Doub *phm = &hm[0][0];
-  
-  //fetch the data from the file and put it in something pointing at hm
-  NcBool test;
-  test = timer->get(phm,*edges,*(edges+1),0,0,0);
-
-  //repack the data into vector form
-  int i;
-  int j;
-  for(i=0;i<*edges;i++){
-    for(j=0;j<*(edges+1);j++){
-      tData[*(edges+1)*i+j]=hm[i][j];
-    }
-  }
-
-  //cleanup
-  delete [] edges;
-  ncfid.close();
-}
-  return 1;
+  //straight from the observation's open file
+  return ap->getObsReader()->getValues(sigName, tData);
 }
 
 
@@ -376,18 +327,19 @@ bool TimePlace::alignWithDetectors()
   //we also have to add an offset to the time to best align them
 
   //here's the model for this
-  VecDoub xx(nUnique),yy(nUnique);       //original signals
+  VecDoub xx(nUnique);                   //original sample times
 
   cerr << "TimePlace::alignWithDetectors() with " << nSamples;
   cerr << " samples." << endl;
 
+  //the bracketing samples and weights are the same for every signal
+  //so find them once here; Telescope and Source reuse them
+  for(int i=0;i<nUnique;i++) xx[i] = telUtcUnique[i]+timeOffset;
+  toDetectors.setup(&xx[0], nUnique, &detUtc[0], nSamples);
+
   //lst
-  for(int i=0;i<nUnique;i++){
-    xx[i] = telUtcUnique[i]+timeOffset;
-    yy[i] = lst[locUnique[i]];
-  }
-  interpolateLinear(xx, yy, nUnique,
-		    &detUtc[0], &lst[0], nSamples);
+  vector<double*> signals(1, &lst[0]);
+  toDetectors.resample(signals, &locUnique[0]);
 
   cerr << "TimePlace::alignWithDetectors(): done." << endl;
 
@@ -398,7 +350,25 @@ bool TimePlace::alignWithDetectors()
 //----------------------------- o ---------------------------------------
 
 
-TimePlace::~TimePlace()
+///returns the observation's ephemeris tables, building them if needed
+/** The tables are built from NOVAS, which is not thread safe, so the
+    build is done in the novas critical section.  Once built they are
+    only read.
+**/
+TimeModel* TimePlace::getTimeModel()
 {
+#pragma omp critical (novas)
+  {
+    if(!timeModel) timeModel = new TimeModel(this);
+  }
+  return timeModel;
+}
+
+
+//----------------------------- o ---------------------------------------
 
+
+TimePlace::~TimePlace()
+{
+  delete timeModel;
 }
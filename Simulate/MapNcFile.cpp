@@ -1,4 +1,5 @@
 #include <netcdfcpp.h>
+#include <algorithm>
 
 #include "vector_utilities.h"
 #include "MapNcFile.h"
@@ -111,188 +112,114 @@ void MapNcFile::init(){
 	this->raCoords.resize(0);
 	this->signalMap.resize(0,0);
 	this->weightMap.resize(0,0);
+	this->raStep = 0.0;
+	this->decStep = 0.0;
+	this->regularGrid = false;
 }
 
+///Finds the coordinate limits and checks whether the map grid is regular.
+/** On a regular grid the bracketing pixel of a sample is computed
+    arithmetically, otherwise sampleSignal falls back to a binary search.
+**/
 void MapNcFile::setLimits(){
 	maxmin(this->raCoords, &(this->raMax), &(this->raMin));
 	maxmin(this->decCoords, &(this->decMax), &(this->decMin));
 	cout<<"RaCoords range: ("<<this->raMin<<","<<this->raMax<<")"<<endl;
 	cout<<"DecCoords range: ("<<this->decMin<<","<<this->decMax<<")"<<endl;
-}
-
-VecDoub MapNcFile::mapSignal(VecDoub rapoint, VecDoub decpoint){
-	size_t npoints = rapoint.size();
-	VecDoub outSignal (npoints,0.0);
-
-	size_t xposb;
-	size_t yposb;
-	size_t xposb1;
-	size_t yposb1;
-
-	double intx;
-	double intx1;
-	double inty;
 
-	xposb=0;
-	yposb=0;
-	xposb1=0;
-	yposb1=0;
-
-	for (size_t ip = 0; ip<npoints; ip ++){
+	size_t nx = this->raCoords.size();
+	size_t ny = this->decCoords.size();
+	this->regularGrid = (nx > 1 && ny > 1);
+	if (this->regularGrid){
+		this->raStep = (this->raMax - this->raMin)/(nx-1);
+		this->decStep = (this->decMax - this->decMin)/(ny-1);
+		for (size_t ix = 0; ix < nx && this->regularGrid; ix++)
+			if (abs(this->raCoords[ix] - (this->raMin + ix*this->raStep)) > 1e-6*this->raStep)
+				this->regularGrid = false;
+		for (size_t iy = 0; iy < ny && this->regularGrid; iy++)
+			if (abs(this->decCoords[iy] - (this->decMin + iy*this->decStep)) > 1e-6*this->decStep)
+				this->regularGrid = false;
+	}
+	if (!this->regularGrid)
+		cout<<"MapNcFile::setLimits(). Map grid is not regular, using binary search for pixel lookup"<<endl;
+}
 
+///Returns the lower bracketing index of x in coords, clipped to [0, n-2].
+size_t MapNcFile::locateIndex (const VecDoub &coords, double minCoord, double step, double x) const{
+	size_t n = coords.size();
+	size_t idx;
+	if (this->regularGrid){
+		idx = (size_t) ((x - minCoord)/step);
+	}else{
+		const double *first = &coords[0];
+		idx = upper_bound(first, first+n, x) - first;
+		idx = (idx > 0) ? idx-1 : 0;
+	}
+	return (idx > n-2) ? n-2 : idx;
+}
 
-		if (rapoint[ip]>= raMax || rapoint[ip] <raMin || decpoint[ip]>=decMax || decpoint[ip]< decMin){
+///Bilinear interpolation of the map signal at the given positions.
+/** Samples are processed in blocks: the bracketing indices and
+    interpolation weights of a block are computed first, then the four
+    neighbouring pixels are gathered and combined. Both passes are
+    written as simd loops. Positions outside the map return 0.
+    The method is const and keeps no state, so it can be called
+    concurrently for several detectors.
+**/
+void MapNcFile::sampleSignal (const double *rapoint, const double *decpoint, size_t npoints, double *outSignal) const{
+	const size_t blockSize = 256;
+	size_t ixb[blockSize];
+	size_t iyb[blockSize];
+	double tx[blockSize];
+	double ty[blockSize];
+	bool inside[blockSize];
+
+	size_t ny = this->decCoords.size();
+	if (this->raCoords.size() < 2 || ny < 2){
+		for (size_t ip = 0; ip < npoints; ip++)
 			outSignal[ip] = 0.0;
-			continue;
-		}
-
-		for (size_t ira = 0; ira<this->raCoords.size(); ira++){
-			if (rapoint[ip] < this->raCoords[ira]){
-				xposb=ira-1;
-				break;
-			}
-		}
-		for (size_t idec = 0; idec<this->decCoords.size(); idec++){
-			if (decpoint[ip] < this->decCoords[idec]){
-				yposb=idec-1;
-				break;
-			}
-		}
-		xposb1 = xposb+1;
-		yposb1 = yposb+1;
-		if (xposb1 >= this->raCoords.size() || xposb1 == 0){
-			xposb1 = xposb;
-		}
-		if (yposb1 >= this->decCoords.size() || yposb1 == 0){
-			yposb1 = yposb;
+		return;
+	}
+	const double *sig = this->signalMap[0];
+
+	for (size_t ib = 0; ib < npoints; ib += blockSize){
+		size_t nb = MIN(blockSize, npoints-ib);
+		const double *ra = rapoint + ib;
+		const double *dec = decpoint + ib;
+		double *out = outSignal + ib;
+
+		//negated test so that NaN positions are also rejected
+		for (size_t ip = 0; ip < nb; ip++){
+			inside[ip] = (ra[ip] >= raMin && ra[ip] < raMax && dec[ip] >= decMin && dec[ip] < decMax);
+			ixb[ip] = inside[ip] ? locateIndex(this->raCoords, raMin, raStep, ra[ip]) : 0;
+			iyb[ip] = inside[ip] ? locateIndex(this->decCoords, decMin, decStep, dec[ip]) : 0;
 		}
-
-		intx = (this->signalMap[xposb1][yposb]-this->signalMap[xposb][yposb])*(rapoint[ip]-raCoords[xposb]);
-		intx1 = (this->signalMap[xposb1][yposb1]-this->signalMap[xposb][yposb1])*(rapoint[ip]-raCoords[xposb]);
-		if (xposb == xposb1){
-			intx = this->signalMap[xposb][yposb];
-			intx1 = this->signalMap[xposb][yposb1];
-		}else{
-			intx = intx/(raCoords[xposb1]-raCoords[xposb]) + this->signalMap[xposb][yposb];
-			intx1 = intx1/(raCoords[xposb1]-raCoords[xposb]) + this->signalMap[xposb][yposb1];
+		#pragma omp simd
+		for (size_t ip = 0; ip < nb; ip++){
+			tx[ip] = (ra[ip] - raCoords[ixb[ip]])/(raCoords[ixb[ip]+1] - raCoords[ixb[ip]]);
+			ty[ip] = (dec[ip] - decCoords[iyb[ip]])/(decCoords[iyb[ip]+1] - decCoords[iyb[ip]]);
 		}
-
-		inty = (intx1-intx)*(decpoint[ip]- decCoords[yposb]);
-
-		if (yposb == yposb1){
-			inty = intx;
-		}else{
-			inty =inty / (decCoords[xposb1]-decCoords[xposb]) + intx;
+		#pragma omp simd
+		for (size_t ip = 0; ip < nb; ip++){
+			const double *p0 = sig + ixb[ip]*ny + iyb[ip];
+			const double *p1 = p0 + ny;
+			double v0 = p0[0] + tx[ip]*(p1[0] - p0[0]);
+			double v1 = p0[1] + tx[ip]*(p1[1] - p0[1]);
+			double v = v0 + ty[ip]*(v1 - v0);
+			out[ip] = inside[ip] ? v : 0.0;
 		}
-		outSignal[ip] = inty;
 	}
-
-	return outSignal;
 }
 
-
-VecDoub MapNcFile::fastMapSignal (VecDoub rapoint, VecDoub decpoint){
+VecDoub MapNcFile::mapSignal(const VecDoub &rapoint, const VecDoub &decpoint) const{
 	size_t npoints = rapoint.size();
-		VecDoub outSignal (npoints,0.0);
-
-		size_t xposb;
-		size_t yposb;
-		size_t xposb1;
-		size_t yposb1;
-
-		double intx;
-		double intx1;
-		double inty;
-
-		xposb=0;
-		yposb=0;
-		xposb1=0;
-		yposb1=0;
-
-		int dx = 1;
-		int dy = 1;
-
-		for (size_t ip = 0; ip<npoints; ip ++){
-
-			if (rapoint[ip]>= raMax || rapoint[ip] <raMin || decpoint[ip]>=decMax || decpoint[ip]< decMin){
-				outSignal[ip] = 0.0;
-			}else {
-				for (size_t ira = xposb; ira<this->raCoords.size()-1; ira=ira+dx){
-					if (rapoint[ip] >= this->raCoords[ira] && rapoint[ip] < this->raCoords[ira+1]){
-						xposb=ira;
-						xposb1=ira+1;
-						break;
-					}
-					if (ira == 0 && dx == -1){
-						xposb = 0;
-						xposb1 = xposb;
-						break;
-					}
-					if (ira == raCoords.size()-2 && dx == 1){
-						xposb = raCoords.size()-1;
-						xposb1 = xposb;
-						break;
-					}
-				}
-				for (size_t idec = yposb; idec<this->decCoords.size()-1; idec = idec +dy){
-					if (decpoint[ip] >= this->decCoords[idec] && decpoint[ip] < this->decCoords[idec+1]){
-						yposb=idec;
-						yposb1=idec+1;
-						break;
-					}
-					if (idec == 0 && dy == -1){
-						yposb = 0;
-						yposb1 = yposb;
-						break;
-					}
-					if (idec == decCoords.size()-2 && dy == 1){
-						yposb = decCoords.size()-1;
-						yposb1 = yposb;
-						break;
-					}
-				}
-				//cout<< "Ra[i]"<<rapoint[ip] <<"XPos:"<< xposb<< " YPos: "<<yposb<<"dx: "<<dx << " dy: "<<dy<<endl;
-
-				intx = (this->signalMap[xposb1][yposb]-this->signalMap[xposb][yposb])*(rapoint[ip]-raCoords[xposb]);
-				intx1 = (this->signalMap[xposb1][yposb1]-this->signalMap[xposb][yposb1])*(rapoint[ip]-raCoords[xposb]);
-				if (xposb == xposb1){
-					intx = this->signalMap[xposb][yposb];
-					intx1 = this->signalMap[xposb][yposb1];
-				}else{
-					intx = intx/(raCoords[xposb1]-raCoords[xposb]) + this->signalMap[xposb][yposb];
-					intx1 = intx1/(raCoords[xposb1]-raCoords[xposb]) + this->signalMap[xposb][yposb1];
-				}
-
-				inty = (intx1-intx)*(decpoint[ip]- decCoords[yposb]);
-
-				if (yposb == yposb1 ){
-					inty = intx;
-				}else{
-					inty =inty / (decCoords[yposb1]-decCoords[yposb]) + intx;
-				}
-                if (!isfinite (inty)){
-					cerr<<" Not a valid floating point detected: "<<endl;
-					cerr << "intx: "<< intx<< endl;
-					cerr << "intx1: "<< intx1<< endl;
-					cerr << "Dec coords: "<<(decCoords[yposb1]-decCoords[yposb]) <<endl;
-				}
-				outSignal[ip] = inty;
-			}
-
-			if (ip == npoints-1)
-				break;
-			else{
-				if (rapoint[ip+1]<rapoint[ip])
-					dx = -1;
-				else
-					dx = 1;
-				if (decpoint[ip+1]<decpoint[ip])
-					dy = -1;
-				else
-					dy = 1;
-			}
-		}
+	VecDoub outSignal (npoints,0.0);
+	if (npoints > 0)
+		this->sampleSignal(&rapoint[0], &decpoint[0], npoints, outSignal.getData());
+	return outSignal;
+}
 
-		return outSignal;
 
+VecDoub MapNcFile::fastMapSignal (const VecDoub &rapoint, const VecDoub &decpoint) const{
+	return this->mapSignal(rapoint, decpoint);
 }
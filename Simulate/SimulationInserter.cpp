@@ -44,9 +44,6 @@ SimulatorInserter::SimulatorInserter(MapNcFile *map){
 bool SimulatorInserter::insertIntoArray(Array *arr){
 	int *di = NULL;
 	size_t nbolo = 0;
-	size_t np = 0;
-	VecDoub interp(0);
-	VecDoub noise (0);
 	arr->updateDetectorIndices();
 	di = arr->getDetectorIndices();
 	nbolo = arr->getNDetectors();
@@ -81,77 +78,100 @@ bool SimulatorInserter::insertIntoArray(Array *arr){
 	      exit (-1);
 	    }
 	  }
-	  double mBolo;
-	  double calFactor;
+	  //sameAtm uses the template of the first detector for all of them
+	  if (bspline && sameAtm){
+	    VecDoub scratch;
+	    atmTemplate = bspline->fitData(asDoubles(arr->detectors[di[0]].hValues,
+						     scratch));
+	  }
+
+	  //otherwise every detector gets its own template, all of them
+	  //fitted in one multiple right hand side solve
+	  MatDoub atmCoeff;
+	  if (bspline && !sameAtm){
+	    vector<const double*> atmData (nbolo);
+	    vector<VecDoub> scratch (nbolo);
+	    for (size_t i=0; i<nbolo; i++)
+	      atmData[i] = &asDoubles(arr->detectors[di[i]].hValues, scratch[i])[0];
+	    bspline->fitCoefficients(atmData, atmCoeff);
+	  }
+
+	  //Map sampling, signal insertion and the per detector atmosphere
+	  //fit are independent between detectors. Noise generation shares a
+	  //single gsl_rng, so only its scan stddev is collected here and the
+	  //noise itself is added serially afterwards.
+	  VecDoub noiseSdev (nbolo, 0.0);
+	  bool badSignal = false;
+	  #pragma omp parallel for schedule(dynamic)
 	  for (size_t i=0; i<nbolo; i++){
-	    np = arr->detectors[di[i]].hValues.size();
-	    mBolo = median(&arr->detectors[di[i]].hValues[0], np);
-	    calFactor = arr->detectors[di[i]].getCalibrationFactor();
-	    interp.resize(np);
-	    interp = this->map->fastMapSignal(arr->detectors[di[i]].hRa, arr->detectors[di[i]].hDec);
+	    Detector *det = &arr->detectors[di[i]];
+	    size_t np = det->hValues.size();
+	    double calFactor = det->getCalibrationFactor();
+	    VecDoub interp(np);
+	    VecDoub detAtm(0);
+	    this->map->sampleSignal(&det->hRa[0], &det->hDec[0], np, interp.getData());
 	    for (size_t is = 0; is < np; is++)
-          if (!isfinite(interp[is])){
-		char buff [200];
-		sprintf(buff, "Interp_%ul.txt", (unsigned int)i);
-		writeVecOut(buff, atmTemplate.getData(), atmTemplate.size());
-		exit(-1);
-	      }
-	    
-	    if (bspline){
-	      
-	      if (sameAtm && i==0){
-		atmTemplate = bspline->fitData(arr->detectors[di[0]].hValues);
-		//writeVecOut("atmTemp.txt", atmTemplate.getData(), atmTemplate.size());
-	      }else if (!sameAtm){
-		atmTemplate = bspline->fitData(arr->detectors[di[i]].hValues);
-		for (size_t is = 0; is < np; is++)
-          if (!isfinite(atmTemplate[is])){
-		    char buff [200];
-		    sprintf(buff, "atmTemp_%ul.txt", (unsigned int)i);
-		    writeVecOut(buff, atmTemplate.getData(), atmTemplate.size());
-		    sprintf(buff, "oData_%ul.txt", (unsigned int)i);
-		    writeVecOut(buff, &arr->detectors[di[i]].hValues[0], np);
-		    exit(-1);
-		  }
-		
+	      if (!isfinite(interp[is])){
+	        #pragma omp critical (simInsertError)
+	        {
+	          cerr<<"SimulatorInserter()::insertIntoArray(). Not a valid map signal on detector "<<det->getName()<<endl;
+	          badSignal = true;
+	        }
+	        break;
 	      }
+
+	    if (bspline && !sameAtm){
+	      detAtm.resize(np);
+	      bspline->evaluate(atmCoeff, i, &detAtm[0]);
+	      for (size_t is = 0; is < np; is++)
+	        if (!isfinite(detAtm[is])){
+	          #pragma omp critical (simInsertError)
+	          {
+	            char buff [200];
+	            sprintf(buff, "atmTemp_%ul.txt", (unsigned int)i);
+	            writeVecOut(buff, detAtm.getData(), detAtm.size());
+	            sprintf(buff, "oData_%ul.txt", (unsigned int)i);
+	            writeVecOut(buff, &det->hValues[0], np);
+	            badSignal = true;
+	          }
+	          break;
+	        }
 	    }
+	    const VecDoub &atm = sameAtm ? atmTemplate : detAtm;
+
+	    double scale = this->fluxFactor/calFactor;
 	    if (!sigOnly){
 	      for (size_t j=0; j<np; j++)
-		arr->detectors[di[i]].hValues[j] += this->fluxFactor*interp[j]/calFactor;
-	      
+	        det->hValues[j] += scale*interp[j];
 	    }else{
-	      
 	      for (size_t j=0; j<np; j++)
-		arr->detectors[di[i]].hValues[j] = this->fluxFactor*interp[j]/calFactor;
-	    }
-	    //arr->detectors[di[i]].setAtmTemplate(interp);
-	    if (this->noiseChunk != 0){
-	      noise = this->createNoiseSignal(arr->detectors[di[i]]);
-	      for (size_t j=0; j<np; j++)
-		arr->detectors[di[i]].hValues[j] += noise[j];
+	        det->hValues[j] = scale*interp[j];
 	    }
+	    if (this->noiseChunk != 0)
+	      noiseSdev[i] = this->getNoiseSdev(*det);
 	    if (bspline){
 	      for (size_t j=0; j<np; j++)
-		arr->detectors[di[i]].hValues[j] += atmTemplate[j];
-	    } else{
-	      for (size_t j=0; j<np; j++)
-		arr->detectors[di[i]].hValues[j] += 0.0;
+	        det->hValues[j] += atm[j];
 	    }
-	    
-	    
-	//		if (i==17){
-	//			writeVecOut ("interp_fast.txt",arr->detectors[di[i]].hValues.getData(), np);
-	//			exit(-1);
-	//		}
+	  }
+	  if (badSignal)
+	    exit(-1);
 
+	  if (this->noiseChunk != 0){
+	    for (size_t i=0; i<nbolo; i++){
+	      Detector *det = &arr->detectors[di[i]];
+	      size_t np = det->hValues.size();
+	      for (size_t j=0; j<np; j++)
+	        det->hValues[j] += gsl_ran_gaussian(this->r,noiseSdev[i]);
+	    }
 	  }
-	  //exit(-1);
-	  noise.resize(0);
 	}else{
 	  cerr<<"Creating template signals"<<endl;
+	  #pragma omp parallel for schedule(dynamic)
 	  for (size_t i=0; i<nbolo; i++){
-	    arr->detectors[di[i]].atmTemplate = this->map->fastMapSignal(arr->detectors[di[i]].hRa, arr->detectors[di[i]].hDec);
+	    Detector *det = &arr->detectors[di[i]];
+	    det->atmTemplate.resize(det->hRa.size());
+	    this->map->sampleSignal(&det->hRa[0], &det->hDec[0], det->hRa.size(), det->atmTemplate.getData());
 	  }
 	  
 	}
@@ -160,22 +180,17 @@ bool SimulatorInserter::insertIntoArray(Array *arr){
 	return true;
 }
 
-VecDoub SimulatorInserter::createNoiseSignal(Detector det){
+///Standard deviation of the detector signal used to scale the noise.
+double SimulatorInserter::getNoiseSdev(Detector &det){
 
 	//Number of samples to get the stddev from
 	double chunkSample = det.getSamplerate()*this->noiseChunk;
-	size_t  nSamples = det.getNSamples();
-	VecDoub noiseSignal (nSamples);
-	double scanSdev=0;
 	size_t si=floor (chunkSample);
 	size_t se=ceil (2*chunkSample);
-	scanSdev = stddev(det.hValues,si,se);
-    for (size_t j=0; j<nSamples; j++)
-			noiseSignal[j]= gsl_ran_gaussian(this->r,scanSdev);
-	return noiseSignal;
+	VecDoub scratch;
+	return stddev(asDoubles(det.hValues, scratch),si,se);
 }
 
-
 void SimulatorInserter::createNoiseGenerator(){
 	const gsl_rng_type * T=gsl_rng_default;
 	this->r= gsl_rng_alloc (T);
@@ -0,0 +1,158 @@
+#include <netcdfcpp.h>
+#include <iostream>
+#include <cmath>
+using namespace std;
+
+#include "nr3.h"
+#include "MapProjection.h"
+#include "gnomonic.h"
+
+///empty projection, use the full constructor before asking for coordinates
+MapProjection::MapProjection()
+{
+  centerX = 0.;
+  centerY = 0.;
+  sinCenterY = 0.;
+  cosCenterY = 1.;
+}
+
+///MapProjection constructor
+/** Inputs are the tangent point (the master grid) in radians and the
+    physical row and column coordinates of the map grid.
+**/
+MapProjection::MapProjection(double cx, double cy,
+                             const VecDoub &rowPhys, const VecDoub &colPhys)
+{
+  centerX = cx;
+  centerY = cy;
+  sinCenterY = sin(cy);
+  cosCenterY = cos(cy);
+  rowCoordsPhys = rowPhys;
+  colCoordsPhys = colPhys;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+int MapProjection::getNrows() const
+{
+  return rowCoordsPhys.size();
+}
+
+int MapProjection::getNcols() const
+{
+  return colCoordsPhys.size();
+}
+
+double MapProjection::getCenterX() const
+{
+  return centerX;
+}
+
+double MapProjection::getCenterY() const
+{
+  return centerY;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///inverse gnomonic projection of a single physical position
+/** Same result as physToAbs() in astron_utilities for a fixed tangent
+    point.
+**/
+void MapProjection::physToAbs(double px, double py,
+                              double *ax, double *ay) const
+{
+  gnomonicInverse(px, py, centerX, centerY, sinCenterY, cosCenterY, ax, ay);
+}
+
+///absolute coordinates of pixel [i][j]
+void MapProjection::pixelToAbs(int i, int j, double *ax, double *ay) const
+{
+  physToAbs(rowCoordsPhys[i], colCoordsPhys[j], ax, ay);
+}
+
+double MapProjection::getXAbs(int i, int j) const
+{
+  double ax, ay;
+  pixelToAbs(i, j, &ax, &ay);
+  return ax;
+}
+
+double MapProjection::getYAbs(int i, int j) const
+{
+  double ax, ay;
+  pixelToAbs(i, j, &ax, &ay);
+  return ay;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///absolute coordinates of all pixels in row i
+/** ax and ay must hold getNcols() values.  The loop over the row
+    vectorizes.
+**/
+void MapProjection::rowToAbs(int i, double *ax, double *ay) const
+{
+  double px = rowCoordsPhys[i];
+  int nc = colCoordsPhys.size();
+  const double *py = &colCoordsPhys[0];
+  #pragma omp simd
+  for(int j=0;j<nc;j++)
+    gnomonicInverse(px, py[j], centerX, centerY, sinCenterY, cosCenterY,
+                    &ax[j], &ay[j]);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///writes the projection to an open netcdf file
+/** The WCS-like parameters (tangent point, reference pixel and pixel
+    increment, 0-based) are always written as global attributes.
+    Unless wcsOnly is set the absolute coordinate grids are also
+    written as the xCoordsAbs and yCoordsAbs variables, one row at a
+    time so they are never held in memory in full.
+**/
+bool MapProjection::writeToNcdf(NcFile &ncfid, NcDim *rowDim, NcDim *colDim,
+                                bool wcsOnly,
+                                const NcCompression &comp) const
+{
+  int nr = rowCoordsPhys.size();
+  int nc = colCoordsPhys.size();
+  double cdeltRow = (nr > 1) ? rowCoordsPhys[1]-rowCoordsPhys[0] : 0.;
+  double cdeltCol = (nc > 1) ? colCoordsPhys[1]-colCoordsPhys[0] : 0.;
+
+  ncfid.add_att("projection", "TAN");
+  ncfid.add_att("projCenterX", centerX);
+  ncfid.add_att("projCenterY", centerY);
+  ncfid.add_att("projCdeltRow", cdeltRow);
+  ncfid.add_att("projCdeltCol", cdeltCol);
+  ncfid.add_att("projCrpixRow",
+                (cdeltRow != 0.) ? -rowCoordsPhys[0]/cdeltRow : 0.);
+  ncfid.add_att("projCrpixCol",
+                (cdeltCol != 0.) ? -colCoordsPhys[0]/cdeltCol : 0.);
+
+  if(wcsOnly) return 1;
+
+  NcVar *xCAbsVar = comp.addMapVar(ncfid, "xCoordsAbs", ncDouble,
+                                   rowDim, colDim);
+  NcVar *yCAbsVar = comp.addMapVar(ncfid, "yCoordsAbs", ncDouble,
+                                   rowDim, colDim);
+  VecDoub ax(nc);
+  VecDoub ay(nc);
+  for(int i=0;i<nr;i++){
+    rowToAbs(i, &ax[0], &ay[0]);
+    xCAbsVar->set_cur(i, 0);
+    yCAbsVar->set_cur(i, 0);
+    if(!xCAbsVar->put(&ax[0], 1, nc)) return 0;
+    if(!yCAbsVar->put(&ay[0], 1, nc)) return 0;
+  }
+
+  return 1;
+}
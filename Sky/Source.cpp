@@ -22,20 +22,9 @@ Source::Source(AnalParams* anal, TimePlace* tp)
   string timeVarName = ap->getTimeVarName();
   string observatory = ap->getObservatory();
   timePlace = tp;
-#pragma omp critical (dataio)
-  {
-	  //set the number of available samples
-	  NcFile ncfid(dataFile, NcFile::ReadOnly);
-	  NcVar* timeVar = ncfid.get_var(timeVarName.c_str());
-	  long int* edges = timeVar->edges();
-	  nSamples = edges[0]*edges[1];
-	  //cleanup
-	  delete [] edges;
+  //set the number of available samples
+  nSamples = ap->getObsReader()->getLength(timeVarName.c_str());
 
-
-
-	  ncfid.close();
-  }
   //get the source data
   if(observatory.compare("LMT") == 0){
     getLMTSourceData();
@@ -60,42 +49,32 @@ Source::Source(AnalParams* anal, TimePlace* tp)
 **/
 bool Source::getLMTSourceData()
 {
-  //open the datafile
-#pragma omp critical (dataio)
-	{
-		NcFile ncfid(dataFile, NcFile::ReadOnly);
-
-		//get the source Name
-		NcVar* sourceNameVar = ncfid.get_var("Header.Source.SourceName");
-		char* tmpStr;
-		tmpStr = sourceNameVar->as_string(0);
-		name.assign(tmpStr);
-		delete [] tmpStr;
-		name.erase(name.find(" "));
-		cerr << "Source:: source name is " << name << endl;
-
-		double* mg = ap->getMasterGridJ2000();
-		if(mg[0] == 0. && mg[1] == 0.){
-			//mastergrid to be set by source data from datafile
-			//J2000 data comes from netcdf file header
-			double sra, sdec;
-			NcVar* sraVar=ncfid.get_var("Header.Source.Ra");
-			sraVar->get(&sra,1,0,0,0,0);
-			NcVar* sdecVar=ncfid.get_var("Header.Source.Dec");
-			sdecVar->get(&sdec,1,0,0,0,0);
-			ap->setMasterGridJ2000(sra,sdec);
-		}
-		ncfid.close();
+	ObsReader* reader = ap->getObsReader();
+
+	//get the source Name
+	name = reader->getString("Header.Source.SourceName");
+	name.erase(name.find(" "));
+	cerr << "Source:: source name is " << name << endl;
+
+	double* mg = ap->getMasterGridJ2000();
+	if(mg[0] == 0. && mg[1] == 0.){
+		//mastergrid to be set by source data from datafile
+		//J2000 data comes from netcdf file header
+		double sra = reader->getDouble("Header.Source.Ra");
+		double sdec = reader->getDouble("Header.Source.Dec");
+		ap->setMasterGridJ2000(sra,sdec);
 	}
-		//get the rest of the source signals
+
+	//get the rest of the source signals in one pass
 	hSourceAz.resize(nSamples);
-	getSourceValues("Data.AztecBackend.SourceAz", &hSourceAz[0]);
 	hSourceEl.resize(nSamples);
-	getSourceValues("Data.AztecBackend.SourceEl", &hSourceEl[0]);
 	hSourceRa.resize(nSamples);
-	getSourceValues("Data.AztecBackend.SourceRa", &hSourceRa[0]);
 	hSourceDec.resize(nSamples);
-	getSourceValues("Data.AztecBackend.SourceDec", &hSourceDec[0]);
+	reader->request("Data.AztecBackend.SourceAz", &hSourceAz[0]);
+	reader->request("Data.AztecBackend.SourceEl", &hSourceEl[0]);
+	reader->request("Data.AztecBackend.SourceRa", &hSourceRa[0]);
+	reader->request("Data.AztecBackend.SourceDec", &hSourceDec[0]);
+	reader->readRequested();
 
 
 
@@ -131,68 +110,46 @@ bool Source::getLMTSourceData()
 **/
 bool Source::getASTESourceData()
 {
-	//open the datafile
-#pragma omp critical (dataio)
-	{
-		NcFile ncfid(dataFile, NcFile::ReadOnly);
-
-		//get the source Name
-		//source_name = "\"1310+323\""
-		NcAtt* nameAtt = ncfid.get_att("source_name");
-		char *tmpstr = NULL;
-		tmpstr = nameAtt->as_string(0);
-		name.assign(tmpstr);
-		delete [] tmpstr;
-		//name = name.substr(2,name.length()-3);
-		cerr << "Source:: source name is " << name << endl;
-
-		//use ra/dec from datafile attribute to generate
-		//source ra/dec
-		NcAtt* raAtt = ncfid.get_att("aste_header_SrcPosX");
-		tmpstr = raAtt->as_string(0);
-		string rastr = tmpstr;
-		delete [] tmpstr;
-		rastr = rastr.substr(0,rastr.length());
-		double t1, t2, t3;
-		parseRaDecString(rastr, &t1, &t2, &t3);
-		double sra = (t1+t2/60.+t3/3600.)/24.*TWO_PI;
-		NcAtt* decAtt = ncfid.get_att("aste_header_SrcPosY");
-		tmpstr = decAtt->as_string(0);
-		string decstr = tmpstr;
-		delete [] tmpstr;
-		decstr = decstr.substr(0,decstr.length());
-		parseRaDecString(decstr, &t1, &t2, &t3);
-		double st1 = (t1 < 0) ? -1. : 1;
-		double sdec = st1*(abs(t1)+t2/60.+t3/3600.) / DEG_RAD;
-
-		hSourceRa.resize(nSamples);
-		hSourceDec.resize(nSamples);
-		for(int i=0;i<nSamples;i++){
-			hSourceRa[i] = sra;
-			hSourceDec[i] = sdec;
-		}
-
-		//now use Novas to calculate Az/El for source
-		hSourceAz.resize(nSamples);
-		hSourceEl.resize(nSamples);
-		raDecToAzEl(timePlace, &hSourceRa[0], &hSourceDec[0],
-				&hSourceAz[0], &hSourceEl[0], nSamples);
-
-		//set the AnalParams.mastergrid if it is zeros
-		double* mg = ap->getMasterGridJ2000();
-		if(mg[0] == 0. && mg[1] == 0.){
-			//mastergrid to be set by source data from datafile
-			//J2000 data comes from netcdf file header
-			ap->setMasterGridJ2000(sra,sdec);
-		}
-
-		delete nameAtt;
-		delete raAtt;
-		delete decAtt;
-
-		//close the dataFile
-		ncfid.close();
+	ObsReader* reader = ap->getObsReader();
+
+	//get the source Name
+	//source_name = "\"1310+323\""
+	name = reader->getAttString("source_name");
+	//name = name.substr(2,name.length()-3);
+	cerr << "Source:: source name is " << name << endl;
+
+	//use ra/dec from datafile attribute to generate
+	//source ra/dec
+	string rastr = reader->getAttString("aste_header_SrcPosX");
+	double t1, t2, t3;
+	parseRaDecString(rastr, &t1, &t2, &t3);
+	double sra = (t1+t2/60.+t3/3600.)/24.*TWO_PI;
+	string decstr = reader->getAttString("aste_header_SrcPosY");
+	parseRaDecString(decstr, &t1, &t2, &t3);
+	double st1 = (t1 < 0) ? -1. : 1;
+	double sdec = st1*(abs(t1)+t2/60.+t3/3600.) / DEG_RAD;
+
+	hSourceRa.resize(nSamples);
+	hSourceDec.resize(nSamples);
+	for(int i=0;i<nSamples;i++){
+		hSourceRa[i] = sra;
+		hSourceDec[i] = sdec;
 	}
+
+	//now use Novas to calculate Az/El for source
+	hSourceAz.resize(nSamples);
+	hSourceEl.resize(nSamples);
+	raDecToAzEl(timePlace, &hSourceRa[0], &hSourceDec[0],
+			&hSourceAz[0], &hSourceEl[0], nSamples);
+
+	//set the AnalParams.mastergrid if it is zeros
+	double* mg = ap->getMasterGridJ2000();
+	if(mg[0] == 0. && mg[1] == 0.){
+		//mastergrid to be set by source data from datafile
+		//J2000 data comes from netcdf file header
+		ap->setMasterGridJ2000(sra,sdec);
+	}
+
 	return 1;
 }
 
@@ -228,36 +185,8 @@ bool Source::parseRaDecString(string ra, double* t1, double* t2, double* t3)
 ///returns vector of Source values
 bool Source::getSourceValues(const char* sigName, double *tData)
 {
-	//open the netcdf file
-#pragma omp critical (dataio)
-	{
-		NcFile ncfid(dataFile, NcFile::ReadOnly);
-		NcVar* tele=ncfid.get_var(sigName);
-
-		//need size of detector array
-		long int* edges = tele->edges();
-
-		//here's a vector for the data
-		MatDoub hm(*edges,*(edges+1));
-		Doub *phm = &hm[0][0];
-
-		//fetch the data from the file and put it in something pointing at hm
-		NcBool test;
-		test = tele->get(phm,edges[0],edges[1],0,0,0);
-
-		//repack the data into vector form
-		int i;
-		int j;
-		for(i=0;i<edges[0];i++){
-			for(j=0;j<edges[1];j++){
-				tData[edges[1]*i+j]=hm[i][j];
-			}
-		}
-
-		//cleanup
-		delete [] edges;
-	}
-	return 1;
+	//straight from the observation's open file
+	return ap->getObsReader()->getValues(sigName, tData);
 }
 
 
@@ -318,39 +247,16 @@ bool Source::alignWithDetectors()
   //here we interpolate them to detUtc to align them
   //with the detector signals
 
-  //here's the model for this
-  VecDoub xx(timePlace->nUnique),yy(timePlace->nUnique);   //original signals
-
   cerr << "Source::alignWithDetectors() with " << nSamples;
   cerr << " samples." << endl;
 
-  //deal with the xx vector first
-  for(int i=0;i<timePlace->nUnique;i++)
-    xx[i] = timePlace->telUtcUnique[i]+timePlace->timeOffset;
-
-  //interpolate hSourceAz
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hSourceAz[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hSourceAz[0], nSamples);
-
-  //interpolate hSourceEl
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hSourceEl[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hSourceEl[0], nSamples);
-
-  //interpolate hSourceRa
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hSourceRa[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hSourceRa[0], nSamples);
-
-  //interpolate hSourceDec
-  for(int i=0;i<timePlace->nUnique;i++) 
-    yy[i]=hSourceDec[timePlace->locUnique[i]];
-  interpolateLinear(xx, yy, timePlace->nUnique,
-		    &timePlace->detUtc[0], &hSourceDec[0], nSamples);
+  //resampled together with the brackets and weights found by timePlace
+  vector<double*> signals;
+  signals.push_back(&hSourceAz[0]);
+  signals.push_back(&hSourceEl[0]);
+  signals.push_back(&hSourceRa[0]);
+  signals.push_back(&hSourceDec[0]);
+  timePlace->toDetectors.resample(signals, &timePlace->locUnique[0]);
 
   cerr << "Source::alignWithDetectors(): done." << endl;
   return 1;
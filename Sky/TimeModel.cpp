@@ -0,0 +1,353 @@
+#include <iostream>
+#include <cmath>
+#include <string>
+#include <algorithm>
+using namespace std;
+
+#include "nr3.h"
+#include "astron_utilities.h"
+#include "TimePlace.h"
+#include "TimeModel.h"
+extern "C" {
+#include "eph_manager.h"
+#include "novas.h"
+}
+
+//node spacing and sample block size
+#define TIMEMODEL_STEP 300.
+#define TIMEMODEL_BLOCK 1024
+
+//columns of the node table
+enum {
+  TM_Q=0,           //true of date to ICRS rotation, 3x3 row major
+  TM_BGEO=9,        //geocentric velocity / c
+  TM_BTOPO=12,      //telescope velocity / c
+  TM_SUN=15,        //unit vector from the Sun to the Earth
+  TM_DEFL=18,       //light deflection factor of the Sun
+  TM_GAST=19,       //apparent sidereal time [rad]
+  TM_NCOL=20
+};
+
+//these values only very accurate for 2008
+static const double ut1_utc = -0.387845;
+static const int leap_secs = 33;
+
+
+//----------------------------- o ---------------------------------------
+
+
+///opens the JPL ephemeris used for the Earth's velocity
+/** Must be called from inside the novas critical section. **/
+static void openEphemeris()
+{
+  double jd_beg, jd_end;
+  short int de_num=0, error;
+  string jplpath;
+  jplpath.assign("Sky/Novas/JPLEPH");
+  char *macanaPath = getenv("AZTEC_MACANA_PATH");
+  if (macanaPath)
+	  jplpath = string(macanaPath) +"/" + jplpath;
+
+  if ((error = ephem_open (jplpath.c_str(), &jd_beg,&jd_end,&de_num)) != 0)
+    {
+      if (error == 1){
+	cerr << "JPL ephemeris file not found." << endl;
+	exit(1);
+      } else {
+	cerr << "Error reading JPL ephemeris file header." << endl;
+	exit(1);
+      }
+    }
+  else
+    {
+      cerr << "JPL ephemeris DE" << de_num << " open." << endl;
+    }
+}
+
+
+//unit vector from ra/dec [rad]
+static inline void unitVector(double ra, double dec, double *u)
+{
+  double cd = cos(dec);
+  u[0] = cd*cos(ra);
+  u[1] = cd*sin(ra);
+  u[2] = sin(dec);
+}
+
+
+//removes the Sun's light deflection from direction d, the inverse
+//of NOVAS' grav_vec() for a star
+static inline void undeflect(const double *node, double *d)
+{
+  const double *e = &node[TM_SUN];
+  double u[3] = {d[0], d[1], d[2]};
+  for(int it=0;it<2;it++){
+    double eu = e[0]*u[0]+e[1]*u[1]+e[2]*u[2];
+    if(abs(eu) > 0.99999999999) return;
+    double f = node[TM_DEFL]/(1.+eu);
+    for(int j=0;j<3;j++) u[j] = d[j] - f*(e[j]-eu*u[j]);
+  }
+  double n = sqrt(u[0]*u[0]+u[1]*u[1]+u[2]*u[2]);
+  for(int j=0;j<3;j++) d[j] = u[j]/n;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///TimeModel constructor
+/** Builds the node tables from NOVAS.  The calls into NOVAS are not
+    thread safe so the model must be built inside the novas critical
+    section, see TimePlace::getTimeModel().
+**/
+TimeModel::TimeModel(TimePlace* timePlace)
+{
+  int nSamples = timePlace->detUtc.size();
+  timeOffset = timePlace->timeOffset;
+  longitude = timePlace->longitude;
+  latitude = timePlace->latitude;
+  elevation = timePlace->elevation;
+  jdUtc0 = julian_date(timePlace->year, timePlace->month, timePlace->day, 0.);
+
+  //nodes span all of the sample times
+  double hMin = timePlace->detUtc[0];
+  double hMax = hMin;
+  for(int i=1;i<nSamples;i++){
+    hMin = min(hMin, timePlace->detUtc[i]);
+    hMax = max(hMax, timePlace->detUtc[i]);
+  }
+  step = TIMEMODEL_STEP/3600.;
+  hour0 = hMin+timeOffset;
+  nNodes = max(2, (int) ceil((hMax-hMin)/step)+1);
+
+  openEphemeris();
+
+  table.resize(nNodes, TM_NCOL);
+  for(int k=0;k<nNodes;k++) evaluate(hour0+k*step, table[k]);
+
+  //sidereal time is continuous across the nodes
+  for(int k=1;k<nNodes;k++)
+    while(table[k][TM_GAST] < table[k-1][TM_GAST])
+      table[k][TM_GAST] += TWO_PI;
+
+  //interpolation error at the middle of each interval, where it is
+  //largest.  The rotation error bounds the displacement of any
+  //direction, the velocity error that of its aberration.
+  rotError = 0.;
+  gastError = 0.;
+  for(int k=0;k<nNodes-1;k++){
+    double hour = hour0+(k+0.5)*step;
+    double ne[TM_NCOL], ni[TM_NCOL];
+    evaluate(hour, ne);
+    interpolate(hour, ni);
+    double dq=0., dbg=0., dbt=0.;
+    for(int j=0;j<9;j++) dq += pow(ni[TM_Q+j]-ne[TM_Q+j],2);
+    for(int j=0;j<3;j++){
+      dbg += pow(ni[TM_BGEO+j]-ne[TM_BGEO+j],2);
+      dbt += pow(ni[TM_BTOPO+j]-ne[TM_BTOPO+j],2);
+    }
+    rotError = max(rotError, sqrt(dq)+sqrt(max(dbg,dbt)));
+    double dg = fmod(ni[TM_GAST]-ne[TM_GAST], TWO_PI);
+    if(dg > PI) dg -= TWO_PI;
+    if(dg < -PI) dg += TWO_PI;
+    gastError = max(gastError, abs(dg));
+  }
+
+  cerr << "TimeModel(): " << nNodes << " nodes every " << TIMEMODEL_STEP;
+  cerr << "s, interpolation error < " << rotError*DEG_RAD*3600.;
+  cerr << " arcsec (rotation and aberration), ";
+  cerr << gastError*DEG_RAD*3600./15. << " s (sidereal time)" << endl;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///evaluates the tabulated quantities at one time with NOVAS
+/** hour is UTC in hours of the observation date, detUtc+timeOffset.
+    The timing is the same as the per-sample NOVAS calls it replaces
+    in azElToRaDec2000() and raDecToAzEl().
+**/
+void TimeModel::evaluate(double hour, double *node)
+{
+  double jd_utc = jdUtc0 + hour/24.;
+  double jd_tt = jd_utc + ((double)leap_secs + 32.184) / 86400.0;
+  //the following line has a correction designed to match LMT pointings
+  double jd_ut1 = jd_utc + ut1_utc / 86400.0 + 0.175/86400.0 - 0.12118220/86400.0;
+  double delta_t = 32.184 + leap_secs - ut1_utc;
+  double x, secdif;
+  tdb2tt(jd_tt, &x, &secdif);
+  double jd_tdb = jd_tt + secdif / 86400.0;
+
+  //columns of the rotation are the true of date axes in the ICRS
+  for(int j=0;j<3;j++){
+    double e[3] = {0.,0.,0.};
+    double p1[3], p2[3], p3[3];
+    e[j] = 1.;
+    nutation(jd_tdb, 1, 1, e, p1);
+    precession(jd_tdb, p1, T0, p2);
+    frame_tie(p2, -1, p3);
+    for(int i=0;i<3;i++) node[TM_Q+3*i+j] = p3[i];
+  }
+
+  //barycentric Earth and Sun
+  cat_entry dummy;
+  object earth, sun;
+  make_cat_entry("dummy", "   ", 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, &dummy);
+  make_object(0, 3, "Earth", &dummy, &earth);
+  make_object(0, 10, "Sun", &dummy, &sun);
+  double jd[2] = {jd_tdb, 0.};
+  double peb[3], veb[3], psb[3], vsb[3];
+  short int error;
+  if((error = ephemeris(jd, &earth, 0, 1, peb, veb)) != 0 ||
+     (error = ephemeris(jd, &sun, 0, 1, psb, vsb)) != 0){
+    cerr << "TimeModel::evaluate(): Error " << error;
+    cerr << " from ephemeris()" << endl;
+    exit(1);
+  }
+
+  //the telescope's velocity wrt the geocenter
+  observer obs;
+  make_observer_on_surface(latitude * DEG_RAD, longitude * DEG_RAD,
+                           elevation, 0., 640., &obs);
+  double pog[3], vog[3];
+  if((error = geo_posvel(jd_tt, delta_t, 1, &obs, pog, vog)) != 0){
+    cerr << "TimeModel::evaluate(): Error " << error;
+    cerr << " from geo_posvel()" << endl;
+    exit(1);
+  }
+
+  double pe[3];
+  for(int i=0;i<3;i++){
+    node[TM_BGEO+i] = veb[i] / C_AUDAY;
+    node[TM_BTOPO+i] = (veb[i] + vog[i]) / C_AUDAY;
+    pe[i] = peb[i] - psb[i];
+  }
+  double emag = sqrt(pe[0]*pe[0]+pe[1]*pe[1]+pe[2]*pe[2]);
+  for(int i=0;i<3;i++) node[TM_SUN+i] = pe[i]/emag;
+  node[TM_DEFL] = 2.0 * GS / (C * C * emag * AU);
+
+  double gst;
+  sidereal_time(jd_ut1, 0.0, delta_t, 1, 1, 1, &gst);
+  node[TM_GAST] = gst / 24. * TWO_PI;
+}
+
+
+///linear interpolation of the node table
+void TimeModel::interpolate(double hour, double *node) const
+{
+  double t = (hour-hour0)/step;
+  int k = max(0, min(nNodes-2, (int) floor(t)));
+  double f = t-k;
+  for(int j=0;j<TM_NCOL;j++)
+    node[j] = table[k][j] + f*(table[k+1][j]-table[k][j]);
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///apparent ra/dec of date to ICRS (J2000) ra/dec
+/** The replacement for mean_star() with zero proper motion and
+    parallax.  All angles are in radians.  The aberration is removed
+    by inverting the relativistic formula of NOVAS' aberration(), which
+    converges in a few iterations since beta is ~1e-4.
+**/
+void TimeModel::apparentToIcrs(const double *detUtc, const double *ra,
+                               const double *dec, double *ira, double *idec,
+                               int nSamples) const
+{
+  int nBlocks = (nSamples+TIMEMODEL_BLOCK-1)/TIMEMODEL_BLOCK;
+  #pragma omp parallel for schedule(static)
+  for(int b=0;b<nBlocks;b++){
+    int i1 = min(nSamples, (b+1)*TIMEMODEL_BLOCK);
+    for(int i=b*TIMEMODEL_BLOCK;i<i1;i++){
+      double node[TM_NCOL];
+      interpolate(detUtc[i]+timeOffset, node);
+      const double *q = &node[TM_Q];
+      const double *beta = &node[TM_BGEO];
+      double bb = beta[0]*beta[0]+beta[1]*beta[1]+beta[2]*beta[2];
+      double gi = sqrt(1.-bb);
+
+      //aberrated direction in the ICRS
+      double p[3], a[3];
+      unitVector(ra[i], dec[i], p);
+      for(int j=0;j<3;j++)
+        a[j] = q[3*j]*p[0] + q[3*j+1]*p[1] + q[3*j+2]*p[2];
+
+      //find u with  gi*u + (1+beta.u/(1+gi))*beta  parallel to a
+      double u[3] = {a[0], a[1], a[2]};
+      for(int it=0;it<3;it++){
+        double c = 1. + (beta[0]*u[0]+beta[1]*u[1]+beta[2]*u[2])/(1.+gi);
+        double w[3] = {c*beta[0], c*beta[1], c*beta[2]};
+        double s = a[0]*w[0]+a[1]*w[1]+a[2]*w[2];
+        double m = s + sqrt(s*s - c*c*bb + gi*gi);
+        for(int j=0;j<3;j++) u[j] = (m*a[j]-w[j])/gi;
+      }
+      undeflect(node, u);
+
+      ira[i] = atan2(u[1], u[0]);
+      if(ira[i] < 0.) ira[i] += TWO_PI;
+      idec[i] = atan2(u[2], sqrt(u[0]*u[0]+u[1]*u[1]));
+    }
+  }
+}
+
+
+///ICRS (J2000) ra/dec to topocentric az/el without refraction
+/** The replacement for topo_star() followed by equ2hor() with no
+    polar motion.  All angles are in radians.
+**/
+void TimeModel::icrsToAzEl(const double *detUtc, const double *ra,
+                           const double *dec, double *az, double *el,
+                           int nSamples) const
+{
+  double sLat = sin(latitude);
+  double cLat = cos(latitude);
+  int nBlocks = (nSamples+TIMEMODEL_BLOCK-1)/TIMEMODEL_BLOCK;
+  #pragma omp parallel for schedule(static)
+  for(int b=0;b<nBlocks;b++){
+    int i1 = min(nSamples, (b+1)*TIMEMODEL_BLOCK);
+    for(int i=b*TIMEMODEL_BLOCK;i<i1;i++){
+      double node[TM_NCOL];
+      interpolate(detUtc[i]+timeOffset, node);
+      const double *q = &node[TM_Q];
+      const double *beta = &node[TM_BTOPO];
+      const double *e = &node[TM_SUN];
+      double bb = beta[0]*beta[0]+beta[1]*beta[1]+beta[2]*beta[2];
+      double gi = sqrt(1.-bb);
+
+      //deflection, as in NOVAS' grav_vec()
+      double u[3], a[3], p[3];
+      unitVector(ra[i], dec[i], u);
+      double eu = e[0]*u[0]+e[1]*u[1]+e[2]*u[2];
+      if(abs(eu) <= 0.99999999999){
+        double f = node[TM_DEFL]/(1.+eu);
+        for(int j=0;j<3;j++) u[j] += f*(e[j]-eu*u[j]);
+      }
+
+      //aberration, as in NOVAS' aberration()
+      double bu = beta[0]*u[0]+beta[1]*u[1]+beta[2]*u[2];
+      double c = 1. + bu/(1.+gi);
+      for(int j=0;j<3;j++) a[j] = gi*u[j] + c*beta[j];
+
+      //to the true equator and equinox of date
+      for(int j=0;j<3;j++)
+        p[j] = q[j]*a[0] + q[3+j]*a[1] + q[6+j]*a[2];
+
+      //local zenith, north and west axes of date
+      double theta = node[TM_GAST] + longitude;
+      double ct = cos(theta);
+      double st = sin(theta);
+      double pz = cLat*ct*p[0] + cLat*st*p[1] + sLat*p[2];
+      double pn = -sLat*ct*p[0] - sLat*st*p[1] + cLat*p[2];
+      double pw = st*p[0] - ct*p[1];
+
+      double proj = sqrt(pn*pn + pw*pw);
+      az[i] = (proj > 0.) ? -atan2(pw, pn) : 0.;
+      if(az[i] < 0.) az[i] += TWO_PI;
+      if(az[i] >= TWO_PI) az[i] -= TWO_PI;
+      el[i] = PIO2 - atan2(proj, pz);
+    }
+  }
+}
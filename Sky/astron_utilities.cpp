@@ -9,12 +9,17 @@ using namespace std;
 #include "nr3.h"
 #include "astron_utilities.h"
 #include "TimePlace.h"
+#include "TimeModel.h"
+#include "gnomonic.h"
 #include "vector_utilities.h"
 extern "C" {
 #include "eph_manager.h"
 #include "novas.h"
 }
 
+//below this many samples the projections run on the calling thread
+#define GNOMONIC_PARALLEL_MIN 8192
+
 
 double epoch(int imo, int iday, int year)
 {
@@ -242,40 +247,43 @@ C ********************************************************************/
 //    Takes absolute ra/dec coordinates and a specified tangent point
 //    and returns physical coordinates, relative to the tangent point,
 //    using tangential (gnomic) projection.
+//    The loop vectorizes (see gnomonic.h) and runs in parallel for long
+//    arrays.  physRa/physDec may be absRa/absDec.
 bool absToPhys(double* absRa, double* absDec, 
 	       double  centerRa, double centerDec,
 	       double* physRa, double* physDec,
 	       int nSamples)
 {
-  //use temporary storage to avoid writing over absRa and absDec
-  VecDoub tRa(nSamples);
-  VecDoub tDec(nSamples);
-  for(int i=0;i<nSamples;i++) tDec[i]=absDec[i];
-
-  //tRa must range from -PI to PI
-  for(int i=0;i<nSamples;i++) 
-    tRa[i] = (absRa[i] > PI) ? absRa[i]-TWO_PI : absRa[i];
-
-  //same thing for centerRa
+  //centerRa must range from -PI to PI
   centerRa = (centerRa > PI) ? centerRa-TWO_PI : centerRa;
-
-  //the tangential projection
-  VecDoub cosc(nSamples);
   double sCD = sin(centerDec);
   double cCD = cos(centerDec);
-  for(int i=0;i<nSamples;i++)
-    cosc[i] = sCD*sin(absDec[i]) + cCD*cos(absDec[i])*cos(tRa[i]-centerRa);
 
+  #pragma omp parallel for simd schedule(static) if(nSamples > GNOMONIC_PARALLEL_MIN)
   for(int i=0;i<nSamples;i++)
-    if(cosc[i]==0.){
-      physRa[i] = 0.;
-      physDec[i] = 0;
-    } else {
-      physRa[i] = cos(absDec[i])*sin(tRa[i]-centerRa)/cosc[i];
-      physDec[i] = (cCD*sin(absDec[i]) - sCD*cos(absDec[i])*cos(tRa[i]-centerRa))/cosc[i];
-    }
-
-   return 1;
+    gnomonicForward(absRa[i], absDec[i], centerRa, sCD, cCD,
+		    &physRa[i], &physDec[i]);
+
+  return 1;
+}
+
+
+//same with a tangent point for every sample
+bool absToPhys(double* absRa, double* absDec, 
+	       double* centerRa, double* centerDec,
+	       double* physRa, double* physDec,
+	       int nSamples)
+{
+  #pragma omp parallel for simd schedule(static) if(nSamples > GNOMONIC_PARALLEL_MIN)
+  for(int i=0;i<nSamples;i++){
+    double cRa = (centerRa[i] > PI) ? centerRa[i]-TWO_PI : centerRa[i];
+    double sCD, cCD;
+    simdSincos(centerDec[i], &sCD, &cCD);
+    gnomonicForward(absRa[i], absDec[i], cRa, sCD, cCD,
+		    &physRa[i], &physDec[i]);
+  }
+
+  return 1;
 }
 
 
@@ -288,26 +296,14 @@ bool absToPhys(double* absRa, double* absDec,
 bool physToAbs(double* pra, double* pdec, double* cra, double* cdec,
 	       double* ara, double* adec, int nSamples)
 {
+  #pragma omp parallel for simd schedule(static) if(nSamples > GNOMONIC_PARALLEL_MIN)
   for(int i=0;i<nSamples;i++){
-    double rho = sqrt(pow(pra[i],2)+pow(pdec[i],2));
-    double c = atan(rho);
-    if(c == 0.){
-      ara[i] = cra[i];
-      adec[i] = cdec[i];
-    } else {
-      double ccwhn0 = cos(c);
-      double scwhn0 = sin(c);
-      double ccdec = cos(cdec[i]);
-      double scdec = sin(cdec[i]);
-      double a1;
-      double a2;
-      a1 = ccwhn0*scdec + pdec[i]*scwhn0*ccdec/rho;
-      adec[i] = asin(a1);
-      a2 = pra[i]*scwhn0/(rho*ccdec*ccwhn0 - pdec[i]*scdec*scwhn0);
-      ara[i] = cra[i] + atan(a2);
-    }
+    double scdec, ccdec;
+    simdSincos(cdec[i], &scdec, &ccdec);
+    gnomonicInverse(pra[i], pdec[i], cra[i], cdec[i], scdec, ccdec,
+		    &ara[i], &adec[i]);
   }
-    return 1;
+  return 1;
 }
 
 
@@ -336,50 +332,10 @@ bool azElToRaDec2000(TimePlace *timePlace,
     raAct[i] = timePlace->lst[i] - haAct[i];
     if(raAct[i] < 0.0) raAct[i] += TWO_PI;
   }
-  /*
-  //open the ephemeris calculation for NOVAS
-  double jd_beg, jd_end;
-  short int de_num=0, error;
-  if ((error = ephem_open ("Sky/Novas/JPLEPH", &jd_beg,&jd_end,&de_num)) != 0)
-    {
-      if (error == 1){
-	cerr << "JPL ephemeris file not found." << endl;
-	exit(1);
-      } else {
-	cerr << "Error reading JPL ephemeris file header." << endl;
-	exit(1);
-      }
-    }
-  else
-    {
-      cerr << "JPL ephemeris DY" << de_num << " open." << endl;
-    }
-  */
-
-  const int leap_secs = 33;
-
-  //do the precession and aberration with novas
-  for(int i=0;i<nSamples;i++){
-    int ms;
-    double ra1=raAct[i]*DEG_RAD/360.*24.;
-    double dec1=decAct[i]*DEG_RAD;
-    double jd_utc, jd_tt;
-#pragma omp critical(novas)
-{
-    jd_utc = julian_date(timePlace->year, timePlace->month, 
-			 timePlace->day, 
-			 timePlace->detUtc[i]+timePlace->timeOffset);
-    jd_tt = jd_utc + ((double)leap_secs + 32.184) / 86400.0;
-
-    ms = mean_star(jd_tt, ra1, dec1, 1, &ra[i], &dec[i]);
-}
-    if(ms){
-      cerr << "azElToRaDec2000(): Problem with mean_star(): ms=" << ms << endl;
-      exit(1);
-    }
-    ra[i] = ra[i]/24.*360./DEG_RAD;
-    dec[i] = dec[i]/DEG_RAD;
-  } 
+  //precession, nutation and aberration from the observation's tables
+  timePlace->getTimeModel()->apparentToIcrs(&timePlace->detUtc[0],
+					    &raAct[0], &decAct[0], ra, dec,
+					    nSamples);
 
   return 1;
 }
@@ -391,85 +347,10 @@ bool azElToRaDec2000(TimePlace *timePlace,
 bool raDecToAzEl(TimePlace *timePlace,
 		 double* ra, double* dec, double* az, double* el, int nSamples)
 {
-#pragma omp critical (novas)
-{
-  //open the ephemeris calculation for NOVAS
-  double jd_beg, jd_end;
-  short int de_num=0, error;
-  string jplpath;
-  jplpath.assign("Sky/Novas/JPLEPH");
-  char *macanaPath = getenv("AZTEC_MACANA_PATH");
-  if (macanaPath)
-	  jplpath = string(macanaPath) +"/" + jplpath;
-
-
-  if ((error = ephem_open (jplpath.c_str(), &jd_beg,&jd_end,&de_num)) != 0)
-    {
-      if (error == 1){
-	cerr << "JPL ephemeris file not found." << endl;
-	exit(1);
-      } else {
-	cerr << "Error reading JPL ephemeris file header." << endl;
-	exit(1);
-      }
-    }
-  else
-    {
-      cerr << "JPL ephemeris DE" << de_num << " open." << endl;
-    }
-
-
-  //set up the on_surface structure
-  on_surface geo_loc;
-  make_on_surface (timePlace->latitude * DEG_RAD,
-		   timePlace->longitude * DEG_RAD,
-		   timePlace->elevation,
-		   0., 640., &geo_loc);
-
-  //here's the timing
-  double jd_utc, jd_tt, jd_ut1, delta_t;
-  //these valuse only very accurate for 2008
-  const double ut1_utc = -0.387845;
-  const int leap_secs = 33;
-  
-  //storage space for the transformation
-  cat_entry star;
-  make_cat_entry ("dummy","FK6", 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, &star); 
-
-  //now cycle through the ra/dec values
-  for(int i=0;i<nSamples;i++){
-    //timing
-    jd_utc = julian_date(timePlace->year, timePlace->month, 
-			 timePlace->day, 
-			 timePlace->detUtc[i]+timePlace->timeOffset);
-    jd_tt = jd_utc + ((double)leap_secs + 32.184) / 86400.0;
-    //the following line has a correction designed to match LMT pointings
-    jd_ut1 = jd_utc + ut1_utc / 86400.0 + 0.175/86400.0 - 0.12118220/86400.0;
-    delta_t = 32.184 + leap_secs - ut1_utc;
-
-    //set the ra and dec
-    star.ra = ra[i]/TWO_PI*24.;
-    star.dec = dec[i]*DEG_RAD;
-
-    //topocentric place of star
-    short int error;
-    double rat, dect;
-    if ((error = topo_star (jd_tt,delta_t,&star,&geo_loc, 1, 
-			    &rat,&dect)) != 0){
-      cerr << "Error %d from topo_star: " << error << endl;
-      exit(1);
-    }
-
-    //azimuth and zenith distance with NO REFRACTION
-    double zd, rar, decr, azd;
-    equ2hor (jd_ut1,delta_t,1,0.0,0.0,&geo_loc,rat,dect,0,
-	     &zd,&azd,&rar,&decr);
-
-    //finally the azimuth and elvation in radians;
-    az[i] = azd / DEG_RAD;
-    el[i] = (90.-zd) / DEG_RAD;
-  }
-}
+  //topocentric place and horizon coordinates from the observation's
+  //tables, no refraction
+  timePlace->getTimeModel()->icrsToAzEl(&timePlace->detUtc[0], ra, dec,
+					az, el, nSamples);
   return 1;
 }
 
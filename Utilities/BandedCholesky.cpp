@@ -0,0 +1,122 @@
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+#include "nr3.h"
+#include "BandedCholesky.h"
+
+BandedCholesky::BandedCholesky()
+{
+  n = 0;
+  bw = 0;
+  factored = false;
+}
+
+BandedCholesky::BandedCholesky(int n, int bandwidth)
+{
+  resize(n, bandwidth);
+}
+
+///sets the size and clears the matrix
+void BandedCholesky::resize(int nn, int bandwidth)
+{
+  n = nn;
+  bw = bandwidth;
+  band.assign(n*(bw+1), 0.0);
+  factored = false;
+}
+
+int BandedCholesky::getN() const
+{
+  return n;
+}
+
+int BandedCholesky::getBandwidth() const
+{
+  return bw;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///adds value to element [i][j] of the matrix
+/** Only the lower band is stored, so [i][j] and [j][i] are the same
+    element.  Elements outside the band are an error.
+**/
+void BandedCholesky::add(int i, int j, double value)
+{
+  if(j > i) swap(i, j);
+  if(i-j > bw || factored){
+    cerr << "BandedCholesky::add(): element [" << i << "][" << j;
+    cerr << "] outside the band of width " << bw << endl;
+    exit(1);
+  }
+  band[i*(bw+1) + j-i+bw] += value;
+}
+
+
+///factors the matrix in place, A = L L^T
+/** Returns 0, leaving the object unusable, if the matrix is not
+    positive definite.
+**/
+bool BandedCholesky::factor()
+{
+  int w = bw+1;
+  for(int i=0;i<n;i++){
+    double *li = &band[i*w + bw-i];
+    for(int j=max(0, i-bw);j<=i;j++){
+      double *lj = &band[j*w + bw-j];
+      double s = li[j];
+      for(int k=max(0, i-bw);k<j;k++) s -= li[k]*lj[k];
+      if(i == j){
+        if(!(s > 0.)) return 0;
+        li[i] = sqrt(s);
+      } else li[j] = s/lj[j];
+    }
+  }
+  factored = true;
+  return 1;
+}
+
+
+///solves A x = b in place for nRhs right hand sides
+/** Element r of row i of b is b[i*ld + r], so a single vector is
+    nRhs=1, ld=1 and nRhs vectors stored as the columns of a row major
+    n x ld matrix are solved all at once, with the inner loops running
+    along the rows.
+**/
+void BandedCholesky::solve(double *b, int nRhs, int ld) const
+{
+  if(!factored){
+    cerr << "BandedCholesky::solve(): matrix not factored" << endl;
+    exit(1);
+  }
+  int w = bw+1;
+
+  //forward substitution, L y = b
+  for(int i=0;i<n;i++){
+    const double *li = &band[i*w + bw-i];
+    double *bi = &b[(size_t) i*ld];
+    for(int k=max(0, i-bw);k<i;k++){
+      const double *bk = &b[(size_t) k*ld];
+      double lik = li[k];
+      for(int r=0;r<nRhs;r++) bi[r] -= lik*bk[r];
+    }
+    double d = 1./li[i];
+    for(int r=0;r<nRhs;r++) bi[r] *= d;
+  }
+
+  //back substitution, L^T x = y
+  for(int i=n-1;i>=0;i--){
+    double *bi = &b[(size_t) i*ld];
+    for(int k=i+1;k<=min(n-1, i+bw);k++){
+      const double *bk = &b[(size_t) k*ld];
+      double lki = band[k*w + bw-k+i];
+      for(int r=0;r<nRhs;r++) bi[r] -= lki*bk[r];
+    }
+    double d = 1./band[i*w + bw];
+    for(int r=0;r<nRhs;r++) bi[r] *= d;
+  }
+}
@@ -0,0 +1,73 @@
+#include <netcdf.h>
+#include <netcdfcpp.h>
+#include <iostream>
+#include <algorithm>
+using namespace std;
+
+#include "NcCompression.h"
+
+///target number of values in a map chunk, 1MB of doubles
+#define MAP_CHUNK_VALUES 131072
+
+NcCompression::NcCompression(int level, bool shuf)
+{
+  deflateLevel = max(0, min(level, 9));
+  shuffle = shuf;
+}
+
+bool NcCompression::isEnabled() const
+{
+  return deflateLevel > 0;
+}
+
+///file format to hand to the NcFile constructor
+NcFile::FileFormat NcCompression::getFileFormat() const
+{
+  return (isEnabled()) ? NcFile::Netcdf4 : NcFile::Offset64Bits;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///sets chunk sizes and compression on a freshly defined variable
+/** chunks must hold one entry per dimension of var.  This has to be
+    called before any data is written to the variable.  Does nothing
+    if compression is disabled.
+**/
+bool NcCompression::setStorage(NcFile &ncfid, NcVar *var,
+                               const size_t *chunks) const
+{
+  if(!isEnabled()) return 1;
+
+  int status = nc_def_var_chunking(ncfid.id(), var->id(), NC_CHUNKED, chunks);
+  if(status == NC_NOERR)
+    status = nc_def_var_deflate(ncfid.id(), var->id(), shuffle, 1,
+                                deflateLevel);
+  if(status != NC_NOERR){
+    cerr << "NcCompression::setStorage(): " << var->name() << ": ";
+    cerr << nc_strerror(status) << endl;
+    return 0;
+  }
+  return 1;
+}
+
+
+///defines a compressed nrows x ncols map variable
+/** Maps are always read and written whole or by rows, so the chunks
+    are blocks of complete rows of about MAP_CHUNK_VALUES values.
+**/
+NcVar* NcCompression::addMapVar(NcFile &ncfid, const char *name, NcType type,
+                                NcDim *rowDim, NcDim *colDim) const
+{
+  NcVar *var = ncfid.add_var(name, type, rowDim, colDim);
+  if(!var || !isEnabled()) return var;
+
+  size_t ncols = colDim->size();
+  size_t chunks[2];
+  chunks[0] = max((size_t) 1, min((size_t) rowDim->size(),
+                                  MAP_CHUNK_VALUES/max(ncols, (size_t) 1)));
+  chunks[1] = ncols;
+  setStorage(ncfid, var, chunks);
+  return var;
+}
@@ -1,10 +1,13 @@
+#include <iostream>
+#include <vector>
+using namespace std;
+
 #include "SBSM.h"
 
 
 SBSM::SBSM (size_t order, size_t nSamples, size_t nBreaks){
 	baseMatrix = NULL;
 	baseMatrix_t = NULL;
-	btbMatrix = NULL;
 	bsw = NULL;
 	time = NULL;
 	resize(order,nSamples,nBreaks);
@@ -68,44 +71,77 @@ void SBSM::createBaseMatrix(){
 
 	baseMatrix = cs_compress(tmpbMatrix);
 	baseMatrix_t = cs_compress (tmpbMatrix_t);
-	btbMatrix = cs_multiply (baseMatrix,baseMatrix_t);
 	cs_spfree(tmpbMatrix);
 	cs_spfree(tmpbMatrix_t);
 
 	gsl_vector_free(btdata);
+
+	//B B^T from the splines of each sample, which are the columns of B
+	btbMatrix.resize(nSpline, order-1);
+	for (size_t i=0; i<nSamples; i++)
+		for (CS_INT p=baseMatrix->p[i]; p<baseMatrix->p[i+1]; p++)
+			for (CS_INT q=baseMatrix->p[i]; q<=p; q++)
+				btbMatrix.add(baseMatrix->i[p], baseMatrix->i[q], baseMatrix->x[p]*baseMatrix->x[q]);
+	if (!btbMatrix.factor()){
+		cerr<<"SBSM::createBaseMatrix(). Singular B-Spline normal matrix."<<endl;
+		exit(-1);
+	}
 }
 
-VecDoub SBSM::fitData (double *dataVector, size_t nSamples){
+cs *SBSM::getBaseMatrix(){
+	return baseMatrix;
+}
 
-	VecDoub tmpData(nSamples,0.0);
-	double *tsi = new double [nSamples];
-	double *coeff = new double [nSpline];
+cs *SBSM::getBaseMatrix_t(){
+	return baseMatrix_t;
+}
 
-	for (size_t i=0; i<nSamples; i++){
-	    	tmpData[i] = dataVector[i];
-	    	tsi[i] = 0.0;
+///B-Spline coefficients of every vector in data, as the columns of coeff
+/** All vectors must have nSamples samples.  The right hand sides are
+    formed in parallel and then solved together in one call against
+    the factored B B^T.
+**/
+void SBSM::fitCoefficients(const vector<const double*> &data, MatDoub &coeff){
+
+	size_t nVec = data.size();
+	coeff.assign(nSpline, nVec, 0.0);
+
+	#pragma omp parallel for schedule(static)
+	for (size_t k=0; k<nVec; k++){
+		const double *d = data[k];
+		for (size_t i=0; i<nSamples; i++)
+			for (CS_INT p=baseMatrix->p[i]; p<baseMatrix->p[i+1]; p++)
+				coeff[baseMatrix->i[p]][k] += baseMatrix->x[p]*d[i];
 	}
-	for (size_t i=0; i<nSpline; i++)
-		coeff[i] = 0.0;
-	cs_gaxpy (baseMatrix,tmpData.getData(),coeff);
-	if (!cs_qrsol(3, btbMatrix, coeff)){
-		cerr<<"SBSM::fitData(). Cannot create data B-Spline template."<<endl;
-		exit(-1);
-	}
-
 
-	cs_gaxpy(baseMatrix_t, coeff, tsi);
+	btbMatrix.solve(&coeff[0][0], nVec, nVec);
+}
 
+///B-Spline template of vector k from the coefficients of fitCoefficients()
+void SBSM::evaluate(const MatDoub &coeff, size_t k, double *templateOut){
 	for (size_t i=0; i<nSamples; i++){
-		tmpData[i]=tsi[i];
+		double v = 0.0;
+		for (CS_INT p=baseMatrix->p[i]; p<baseMatrix->p[i+1]; p++)
+			v += baseMatrix->x[p]*coeff[baseMatrix->i[p]][k];
+		templateOut[i] = v;
+	}
+}
+
+VecDoub SBSM::fitData (const double *dataVector, size_t nSamples){
+
+	if (nSamples != this->nSamples){
+		cerr<<"SBSM::fitData(). Wrong data size. Imploding"<<endl;
+		exit(-1);
 	}
-	delete [] tsi;
-	delete [] coeff;
+	MatDoub coeff;
+	VecDoub tmpData(nSamples);
+	fitCoefficients(vector<const double*>(1, dataVector), coeff);
+	evaluate(coeff, 0, &tmpData[0]);
 	return tmpData;
 }
 
-VecDoub SBSM::fitData (VecDoub dataVector){
-	return fitData(dataVector.getData(), dataVector.size());
+VecDoub SBSM::fitData (const VecDoub &dataVector){
+	return fitData(&dataVector[0], dataVector.size());
 }
 
 void SBSM::destroyBaseMatrix(){
@@ -113,12 +149,14 @@ void SBSM::destroyBaseMatrix(){
 		cs_spfree(baseMatrix);
 	if (baseMatrix_t)
 		cs_spfree(baseMatrix_t);
-	if (btbMatrix)
-		cs_spfree (btbMatrix);
 	if (bsw)
 		gsl_bspline_free(bsw);
 	if (time)
 		gsl_vector_free(time);
+	baseMatrix = NULL;
+	baseMatrix_t = NULL;
+	bsw = NULL;
+	time = NULL;
 }
 
 SBSM::~SBSM(){
@@ -0,0 +1,118 @@
+#include <iostream>
+#include <algorithm>
+using namespace std;
+
+#include "nr3.h"
+#include "TimeResampler.h"
+
+#define RESAMPLE_BLOCK 4096
+
+TimeResampler::TimeResampler()
+{
+  nKnots = 0;
+  nSamples = 0;
+}
+
+int TimeResampler::getNKnots() const
+{
+  return nKnots;
+}
+
+int TimeResampler::getNSamples() const
+{
+  return nSamples;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///finds the bracketing knots and weights of the output samples
+/** knots must be increasing.  Samples at or before the first knot
+    take its value and samples at or after the last knot take the
+    last value; the weight of those is 0 against a padding knot (see
+    resample()).  As in interpolateLinear() the first and last output
+    samples are then set to their neighbours.  The output times are
+    nearly always increasing so the search walks forward from the
+    previous bracket and only falls back to bisection on a jump.
+**/
+void TimeResampler::setup(const double *knots, int nK, const double *x,
+                          int nS)
+{
+  if(nK < 2 || nS < 2){
+    cerr << "TimeResampler::setup(): need at least two knots and two ";
+    cerr << "samples, got " << nK << " and " << nS << endl;
+    exit(1);
+  }
+  nKnots = nK;
+  nSamples = nS;
+  lo.resize(nSamples);
+  w.resize(nSamples);
+
+  double mn = knots[0];
+  double mx = knots[nKnots-1];
+  int j = 0;
+  for(int i=0;i<nSamples;i++){
+    if(x[i] <= mn){
+      lo[i] = 0;
+      w[i] = 0.;
+      continue;
+    }
+    if(x[i] >= mx){
+      lo[i] = nKnots-1;
+      w[i] = 0.;
+      continue;
+    }
+    if(x[i] < knots[j] || x[i] >= knots[j+1]){
+      if(j+2 < nKnots && x[i] >= knots[j+1] && x[i] < knots[j+2]) j++;
+      else j = upper_bound(knots, knots+nKnots, x[i]) - knots - 1;
+      j = max(0, min(nKnots-2, j));
+    }
+    lo[i] = j;
+    w[i] = (knots[j] == knots[j+1]) ? 0. :
+      (x[i]-knots[j])/(knots[j+1]-knots[j]);
+  }
+
+  //edges are not guaranteed to come out right so use adjacent values
+  lo[0] = lo[1];
+  w[0] = w[1];
+  lo[nSamples-1] = lo[nSamples-2];
+  w[nSamples-1] = w[nSamples-2];
+}
+
+
+///resamples each signal in place
+/** Signal s starts out holding its knot values at
+    signals[s][knotIndex[k]], k=0..nKnots-1, and ends up holding all
+    nSamples resampled values.  The knot values of every signal are
+    gathered first so the signals can be overwritten in one parallel
+    pass over blocks of samples.
+**/
+void TimeResampler::resample(const vector<double*> &signals,
+                             const int *knotIndex) const
+{
+  int nSig = signals.size();
+  if(nSig == 0) return;
+
+  //one padding knot so samples past the end read lo=nKnots-1, w=0
+  MatDoub k(nSig, nKnots+1);
+  for(int s=0;s<nSig;s++){
+    for(int i=0;i<nKnots;i++) k[s][i] = signals[s][knotIndex[i]];
+    k[s][nKnots] = k[s][nKnots-1];
+  }
+
+  int nBlocks = (nSamples+RESAMPLE_BLOCK-1)/RESAMPLE_BLOCK;
+  #pragma omp parallel for schedule(static)
+  for(int b=0;b<nBlocks;b++){
+    int i0 = b*RESAMPLE_BLOCK;
+    int i1 = min(nSamples, i0+RESAMPLE_BLOCK);
+    for(int s=0;s<nSig;s++){
+      const double *ks = k[s];
+      double *out = signals[s];
+      for(int i=i0;i<i1;i++){
+        int l = lo[i];
+        out[i] = ks[l] + w[i]*(ks[l+1]-ks[l]);
+      }
+    }
+  }
+}
@@ -0,0 +1,366 @@
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <gsl/gsl_eigen.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_sort_vector.h>
+#include <omp.h>
+
+using namespace std;
+
+#include "linalgBackend.h"
+#include "GslRandom.h"
+
+///extra random vectors carried along by symmEigenTop()
+#define TOP_EIGEN_OVERSAMPLE 10
+///most products with the matrix done by symmEigenTop()
+#define TOP_EIGEN_MAX_ITERATIONS 16
+///relative residual of the leading Ritz pairs taken as converged
+#define TOP_EIGEN_TOLERANCE 1e-6
+
+#if defined(HAVE_OPENBLAS)
+extern "C" void openblas_set_num_threads(int n);
+#elif defined(HAVE_MKL)
+extern "C" void MKL_Set_Num_Threads(int n);
+#elif defined(HAVE_BLIS)
+extern "C" void bli_thread_set_num_threads(long n);
+#endif
+
+#if defined(HAVE_LAPACK)
+extern "C" void dsyevr_(const char *jobz, const char *range, const char *uplo,
+                        const int *n, double *a, const int *lda,
+                        const double *vl, const double *vu,
+                        const int *il, const int *iu, const double *abstol,
+                        int *m, double *w, double *z, const int *ldz,
+                        int *isuppz, double *work, const int *lwork,
+                        int *iwork, const int *liwork, int *info);
+#endif
+
+
+///name of the BLAS the build is linked against
+const char* getBlasBackend()
+{
+#if defined(HAVE_OPENBLAS)
+  return "OpenBLAS";
+#elif defined(HAVE_MKL)
+  return "MKL";
+#elif defined(HAVE_BLIS)
+  return "BLIS";
+#elif defined(HAVE_LAPACK)
+  return "system BLAS/LAPACK";
+#else
+  return "gslcblas";
+#endif
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///sets the number of threads used inside each BLAS/LAPACK call
+/** All of the BLAS work of macanap is done by the cleaners, inside
+    the loop over the observations.  With nTeamThreads above one that
+    loop, the scan loops of the cleaners and the per-detector teams
+    are active parallel regions whose threads already hold the cores,
+    so every call is kept to one thread.  Only when the teams are
+    serial does BLAS thread, over nBlasThreads or, if that is 0, all
+    of the cores.  Returns the number of threads set, which is always
+    1 for gslcblas.
+**/
+int setBlasThreads(int nBlasThreads, int nTeamThreads)
+{
+  int n = 1;
+  if(nTeamThreads <= 1){
+    n = nBlasThreads;
+#if defined (_OPENMP)
+    if(n <= 0) n = omp_get_num_procs();
+#endif
+  }
+  n = max(n, 1);
+
+#if defined(HAVE_OPENBLAS)
+  openblas_set_num_threads(n);
+#elif defined(HAVE_MKL)
+  MKL_Set_Num_Threads(n);
+#elif defined(HAVE_BLIS)
+  bli_thread_set_num_threads(n);
+#else
+  n = 1;
+#endif
+  return n;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///eigenvalues and eigenvectors of a real symmetric matrix
+/** Only the diagonal and lower triangle of a are referenced, and a is
+    destroyed.  On return eVals holds the eigenvalues in descending
+    order and column i of eVecs the eigenvector of eVals[i], as after
+    gsl_eigen_symmv_sort(..., GSL_EIGEN_SORT_VAL_DESC).
+**/
+bool symmEigen(gsl_matrix *a, gsl_vector *eVals, gsl_matrix *eVecs)
+{
+  int n = a->size1;
+
+#if defined(HAVE_LAPACK)
+  //the row-major lower triangle is the column-major upper triangle
+  int lda = a->tda;
+  int m = 0;
+  int info = 0;
+  int lwork = -1;
+  int liwork = -1;
+  int il = 0;
+  int iu = 0;
+  double vl = 0.;
+  double vu = 0.;
+  double abstol = 0.;
+  double wkopt = 0.;
+  int iwkopt = 0;
+  vector<double> w(n);
+  vector<double> z((size_t) n*n);
+  vector<int> isuppz(2*n);
+
+  //workspace query first
+  dsyevr_("V", "A", "U", &n, a->data, &lda, &vl, &vu, &il, &iu, &abstol,
+          &m, &w[0], &z[0], &n, &isuppz[0], &wkopt, &lwork, &iwkopt, &liwork,
+          &info);
+  if(info == 0){
+    lwork = (int) wkopt;
+    liwork = iwkopt;
+    vector<double> work(lwork);
+    vector<int> iwork(liwork);
+    dsyevr_("V", "A", "U", &n, a->data, &lda, &vl, &vu, &il, &iu, &abstol,
+            &m, &w[0], &z[0], &n, &isuppz[0], &work[0], &lwork,
+            &iwork[0], &liwork, &info);
+  }
+  if(info != 0){
+    cerr << "symmEigen(): dsyevr failed with info = " << info << endl;
+    return 0;
+  }
+
+  //dsyevr sorts ascending and stores the vectors as columns of z
+  for(int i=0;i<n;i++){
+    gsl_vector_set(eVals, i, w[n-1-i]);
+    const double *zi = &z[(size_t) (n-1-i)*n];
+    for(int j=0;j<n;j++)
+      gsl_matrix_set(eVecs, j, i, zi[j]);
+  }
+#else
+  gsl_eigen_symmv_workspace* ws = gsl_eigen_symmv_alloc(n);
+  int status = gsl_eigen_symmv(a, eVals, eVecs, ws);
+  gsl_eigen_symmv_free(ws);
+  if(status != 0){
+    cerr << "symmEigen(): gsl_eigen_symmv failed." << endl;
+    return 0;
+  }
+  gsl_eigen_symmv_sort(eVals, eVecs, GSL_EIGEN_SORT_VAL_DESC);
+#endif
+
+  return 1;
+}
+
+
+///eigenvalues only of a real symmetric matrix
+/** As symmEigen() without the eigenvectors, which is several times
+    cheaper.  a is destroyed and eVals returned in descending order.
+**/
+bool symmEigenValues(gsl_matrix *a, gsl_vector *eVals)
+{
+  int n = a->size1;
+
+#if defined(HAVE_LAPACK)
+  int lda = a->tda;
+  int m = 0;
+  int info = 0;
+  int lwork = -1;
+  int liwork = -1;
+  int il = 0;
+  int iu = 0;
+  int ldz = 1;
+  double vl = 0.;
+  double vu = 0.;
+  double abstol = 0.;
+  double wkopt = 0.;
+  double z = 0.;
+  int iwkopt = 0;
+  vector<double> w(n);
+  vector<int> isuppz(2*n);
+
+  dsyevr_("N", "A", "U", &n, a->data, &lda, &vl, &vu, &il, &iu, &abstol,
+          &m, &w[0], &z, &ldz, &isuppz[0], &wkopt, &lwork, &iwkopt, &liwork,
+          &info);
+  if(info == 0){
+    lwork = (int) wkopt;
+    liwork = iwkopt;
+    vector<double> work(lwork);
+    vector<int> iwork(liwork);
+    dsyevr_("N", "A", "U", &n, a->data, &lda, &vl, &vu, &il, &iu, &abstol,
+            &m, &w[0], &z, &ldz, &isuppz[0], &work[0], &lwork,
+            &iwork[0], &liwork, &info);
+  }
+  if(info != 0){
+    cerr << "symmEigenValues(): dsyevr failed with info = " << info << endl;
+    return 0;
+  }
+  for(int i=0;i<n;i++)
+    gsl_vector_set(eVals, i, w[n-1-i]);
+#else
+  gsl_eigen_symm_workspace* ws = gsl_eigen_symm_alloc(n);
+  int status = gsl_eigen_symm(a, eVals, ws);
+  gsl_eigen_symm_free(ws);
+  if(status != 0){
+    cerr << "symmEigenValues(): gsl_eigen_symm failed." << endl;
+    return 0;
+  }
+  gsl_sort_vector(eVals);
+  gsl_vector_reverse(eVals);
+#endif
+
+  return 1;
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///orthonormalizes the columns of q in place
+/** Modified Gram-Schmidt, done twice to keep the columns orthogonal
+    to working precision.  q is tall and thin so this is cheap next to
+    the products with the full matrix.
+**/
+static void orthonormalizeColumns(gsl_matrix *q)
+{
+  size_t m = q->size2;
+  for(int pass=0;pass<2;pass++)
+    for(size_t j=0;j<m;j++){
+      gsl_vector_view qj = gsl_matrix_column(q, j);
+      for(size_t i=0;i<j;i++){
+        gsl_vector_view qi = gsl_matrix_column(q, i);
+        double d;
+        gsl_blas_ddot(&qi.vector, &qj.vector, &d);
+        gsl_blas_daxpy(-d, &qi.vector, &qj.vector);
+      }
+      double nrm = gsl_blas_dnrm2(&qj.vector);
+      if(nrm > 0.) gsl_blas_dscal(1./nrm, &qj.vector);
+    }
+}
+
+
+///leading nTop eigenpairs of a real symmetric matrix
+/** Randomized subspace iteration: a block of nTop+TOP_EIGEN_OVERSAMPLE
+    vectors is multiplied by a and re-orthonormalized until every one
+    of the nTop leading Rayleigh-Ritz pairs has a residual
+    |a v - theta v| below TOP_EIGEN_TOLERANCE |theta|, or after
+    TOP_EIGEN_MAX_ITERATIONS products.  The residual bounds the error
+    of the vectors themselves; the Ritz values settle much sooner, as
+    their error goes as the square of that of the vectors.  The cost
+    is O(n^2 nTop)
+    per product instead of O(n^3).  The subspace converges to the
+    modes of largest magnitude, which are the leading ones for the
+    correlation matrices this is meant for.
+
+    The block starts from the columns of start if given (typically the
+    modes of a similar matrix, which cuts the number of products
+    needed) and is filled up with gaussian vectors seeded with seed,
+    so the result is reproducible.  The number of products used is
+    returned in nIter if given.  Returns false if the solve fails or
+    the Ritz pairs have not converged after TOP_EIGEN_MAX_ITERATIONS
+    products, in which case the caller should do the full
+    decomposition instead.
+
+    Only the lower triangle of a is referenced and a is not modified.
+    eVals must hold at least nTop values and eVecs at least nTop
+    columns; they are returned in descending order as for symmEigen().
+    Falls back to the full decomposition when the block would cover
+    most of the matrix anyway.
+**/
+bool symmEigenTop(const gsl_matrix *a, int nTop, gsl_vector *eVals,
+                  gsl_matrix *eVecs, long seed, const gsl_matrix *start,
+                  int *nIter)
+{
+  int n = a->size1;
+  int m = nTop + TOP_EIGEN_OVERSAMPLE;
+  if(nIter) *nIter = 0;
+
+  if(2*m >= n){
+    gsl_matrix *aCopy = gsl_matrix_alloc(n, n);
+    gsl_matrix *vAll = gsl_matrix_alloc(n, n);
+    gsl_vector *lAll = gsl_vector_alloc(n);
+    gsl_matrix_memcpy(aCopy, a);
+    bool ok = symmEigen(aCopy, lAll, vAll);
+    if(ok)
+      for(int i=0;i<nTop;i++){
+        gsl_vector_set(eVals, i, gsl_vector_get(lAll, i));
+        for(int j=0;j<n;j++)
+          gsl_matrix_set(eVecs, j, i, gsl_matrix_get(vAll, j, i));
+      }
+    gsl_matrix_free(aCopy);
+    gsl_matrix_free(vAll);
+    gsl_vector_free(lAll);
+    return ok;
+  }
+
+  //starting block, warm start first
+  int nStart = (start) ? min((int) start->size2, m) : 0;
+  GslRandom ran(seed);
+  gsl_matrix *q = gsl_matrix_alloc(n, m);
+  gsl_matrix *y = gsl_matrix_alloc(n, m);
+  for(int i=0;i<n;i++)
+    for(int j=0;j<m;j++)
+      gsl_matrix_set(q, i, j, (j < nStart) ? gsl_matrix_get(start, i, j) :
+                     ran.gaussDeviate());
+  orthonormalizeColumns(q);
+
+  gsl_matrix *b = gsl_matrix_alloc(m, m);
+  gsl_matrix *w = gsl_matrix_alloc(m, m);
+  gsl_vector *theta = gsl_vector_alloc(m);
+  gsl_matrix *av = gsl_matrix_alloc(n, nTop);
+  gsl_matrix_view wTop = gsl_matrix_submatrix(w, 0, 0, m, nTop);
+  gsl_matrix_view vTop = gsl_matrix_submatrix(eVecs, 0, 0, n, nTop);
+  bool ok = 1;
+  bool converged = 0;
+  int it;
+  for(it=1;it<=TOP_EIGEN_MAX_ITERATIONS;it++){
+    //y = a q and the Rayleigh-Ritz problem on the span of q
+    gsl_blas_dsymm(CblasLeft, CblasLower, 1., a, q, 0., y);
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1., q, y, 0., b);
+    if(!(ok = symmEigen(b, theta, w))) break;
+
+    //the Ritz vectors q w and their products with a, y w
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1., q, &wTop.matrix,
+                   0., &vTop.matrix);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1., y, &wTop.matrix,
+                   0., av);
+    converged = 1;
+    for(int i=0;converged && i<nTop;i++){
+      double t = gsl_vector_get(theta, i);
+      gsl_vector_view vi = gsl_matrix_column(&vTop.matrix, i);
+      gsl_vector_view ri = gsl_matrix_column(av, i);
+      gsl_blas_daxpy(-t, &vi.vector, &ri.vector);
+      if(gsl_blas_dnrm2(&ri.vector) > TOP_EIGEN_TOLERANCE*abs(t))
+        converged = 0;
+    }
+    if(converged || it == TOP_EIGEN_MAX_ITERATIONS) break;
+
+    orthonormalizeColumns(y);
+    gsl_matrix_memcpy(q, y);
+  }
+  if(nIter) *nIter = it;
+  ok = ok && converged;
+
+  //the Ritz vectors are in eVecs already
+  if(ok)
+    for(int i=0;i<nTop;i++)
+      gsl_vector_set(eVals, i, gsl_vector_get(theta, i));
+
+  gsl_matrix_free(q);
+  gsl_matrix_free(y);
+  gsl_matrix_free(b);
+  gsl_matrix_free(w);
+  gsl_matrix_free(av);
+  gsl_vector_free(theta);
+  return ok;
+}
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <exception>
 #include <CCfits/CCfits>
@@ -84,36 +85,52 @@ bool writeFits(string fitsFile, MatDoub &arr, double xpixsz, double ypixsz,
 
 
 
+///reads map name, realization k of it if it is a noise store cube
+/** The noise store keeps noise, filteredNoise and filteredWeight as
+    [nRealizations, nrows, ncols] cubes; the other maps are 2d.
+**/
+bool readMap(NcFile &ncfid, const char* name, int k, MatDoub &arr)
+{
+  NcVar* v = ncfid.get_var(name);
+  if(!v) return 0;
+  int nrows = arr.nrows();
+  int ncols = arr.ncols();
+  if(v->num_dims() == 2) return v->get(&arr[0][0], nrows, ncols);
+  if(v->num_dims() != 3 || k < 0 || k >= v->get_dim(0)->size()) return 0;
+  return v->set_cur(k, 0, 0) && v->get(&arr[0][0], 1, nrows, ncols);
+}
+
+void usage()
+{
+  cerr << "fitswriter: writes fits files given map nc file input." << endl;
+  cerr << "  calling syntax: " << endl;
+  cerr << "     ./fitswriter <filename.nc> [-u | --unfiltered]" << endl;
+  cerr << "     ./fitswriter <filename.nc> [-p | --postageStamps]" << endl;
+  cerr << "  These modes are exclusive.  For a noise realization store" << endl;
+  cerr << "  add [-r | --realization] <k> to pick realization k (0)." << endl;
+  exit(1);
+}
+
 int main(int nArgs, char* args[])
 {
   //deal with command line inputs
   bool unfilt=0;
   bool postageStamps=0;
-  if((nArgs > 3) || (nArgs == 1)){
-    cerr << "fitswriter: writes fits files given map nc file input." << endl;
-    cerr << "  calling syntax: " << endl;
-    cerr << "     ./fitswriter <filename.nc> [-u | --unfiltered]" << endl;
-    cerr << "     ./fitswriter <filename.nc> [-p | --postageStamps]" << endl;
-    cerr << "  These modes are exclusive." << endl;
-    exit(1);
-  } else {
-    if(nArgs == 3){
-      string uft;
-      uft.assign(args[2]);
-      if((!uft.compare("--unfiltered")) || (!uft.compare("-u"))){
-	unfilt=1;
-      } else if ((!uft.compare("--postageStamps")) || (!uft.compare("-p"))){
-	postageStamps=1;
-      } else {
-	cerr << "fitswriter: writes fits files given map nc file input." << endl;
-	cerr << "  calling syntax: " << endl;
-	cerr << "     ./fitswriter <filename.nc> [-u | --unfiltered]" << endl;
-	cerr << "     ./fitswriter <filename.nc> [-p | --postageStamps]" << endl;
-	cerr << "  These modes are exclusive." << endl;
-	exit(1);
-      }
-    }
+  int realization=0;
+  if(nArgs == 1) usage();
+  for(int i=2;i<nArgs;i++){
+    string uft;
+    uft.assign(args[i]);
+    if((!uft.compare("--unfiltered")) || (!uft.compare("-u"))){
+      unfilt=1;
+    } else if ((!uft.compare("--postageStamps")) || (!uft.compare("-p"))){
+      postageStamps=1;
+    } else if (((!uft.compare("--realization")) || (!uft.compare("-r")))
+	       && i+1 < nArgs){
+      realization = atoi(args[++i]);
+    } else usage();
   }
+  if(unfilt && postageStamps) usage();
 
   //string for the ncdf filename
   string ncdfFile;
@@ -169,7 +186,20 @@ int main(int nArgs, char* args[])
     cerr << "unfiltered maps." << endl;
     exit(1);
   }
-  sVar->get(&arr[0][0], nrows, ncols);
+  if(!readMap(ncfid, sigName.c_str(), realization, arr)){
+    cerr << "fitswriter: cannot read " << sigName;
+    if(noiseFile) cerr << " realization " << realization;
+    cerr << " from " << ncdfFile << endl;
+    exit(1);
+  }
+
+  //a noise store holds many realizations, the fits files are per one
+  if(noiseFile){
+    stringstream o;
+    o << "_" << realization << ".nc";
+    ncdfFile.replace(ncdfFile.find(".nc"), 3, o.str());
+  }
+
   string sigFitsFile;
   sigFitsFile.assign(ncdfFile);
   if(unfilt){
@@ -184,8 +214,11 @@ int main(int nArgs, char* args[])
   //weight map to fits
   MatDoub wt(nrows,ncols);
   if(unfilt) sigName.assign("weight"); else sigName.assign("filteredWeight");
-  sVar = ncfid.get_var(sigName.c_str());
-  sVar->get(&wt[0][0], nrows, ncols);
+  if(!readMap(ncfid, sigName.c_str(), realization, wt)){
+    cerr << "fitswriter: cannot read " << sigName << " from " << args[1];
+    cerr << endl;
+    exit(1);
+  }
   string wtFitsFile;
   wtFitsFile.assign(ncdfFile);
   if(unfilt){
@@ -199,10 +232,13 @@ int main(int nArgs, char* args[])
 
   //inttime map to fits
   MatDoub it(nrows,ncols);
-  if(unfilt){
+  if(unfilt && !noiseFile){
     sigName.assign("inttime");
-    sVar = ncfid.get_var(sigName.c_str());
-    sVar->get(&it[0][0], nrows, ncols);
+    if(!readMap(ncfid, sigName.c_str(), realization, it)){
+      cerr << "fitswriter: cannot read " << sigName << " from " << args[1];
+      cerr << endl;
+      exit(1);
+    }
     string itFitsFile;
     itFitsFile.assign(ncdfFile);
     itFitsFile.replace(itFitsFile.find(".nc"), 3, "_zinttime_unfilt.fits");
@@ -231,8 +267,11 @@ int main(int nArgs, char* args[])
     
     //kernel map to fits
     if(unfilt) sigName.assign("kernel"); else sigName.assign("filteredKernel");
-    sVar = ncfid.get_var(sigName.c_str());
-    sVar->get(&wt[0][0], nrows, ncols);
+    if(!readMap(ncfid, sigName.c_str(), realization, wt)){
+      cerr << "fitswriter: cannot read " << sigName << " from " << args[1];
+      cerr << endl;
+      exit(1);
+    }
     string kerFitsFile;
     kerFitsFile.assign(ncdfFile);
     if(unfilt){
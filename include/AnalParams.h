@@ -13,6 +13,12 @@
 **/
 #include "SimParams.h"
 #include "GslRandom.h"
+#include "NcCompression.h"
+#include "ObsReader.h"
+#include "ObsIndex.h"
+#include "Distributor.h"
+
+class Journal;
 
 #include <stdexcept>
 
@@ -64,6 +70,10 @@ class AnalParams
   VecDoub beammapSourceFluxList;    ///<the list of beammap source fluxes 
 
   const char* dataFile;             ///<the current netcdf file to be reduced
+  ObsReader* obsReader;             ///<dataFile, open for the current observation
+  ObsIndex* obsIndex;               ///<the header scalars of dataFile
+  Distributor* distributor;         ///<the processes sharing the run, if any
+  Journal* journal;                 ///<the finished work of the run, if kept
   const char* bolostatsFile;        ///<the current bolostats file
   const char* mapFile;              ///<the current output map file name
   const char* outBeammapInfo;       ///<the current output bolostats file (beammapping)
@@ -138,9 +148,21 @@ class AnalParams
  
   ///Threaded operation parameters
   int nThreads;
+  int blasThreads;                    ///threads per BLAS call, 0 for auto
+  double jobMemoryBudget;             ///GB of observations in flight, 0 for no cap
+  bool resume;                        ///skip the work the journal says is done
 
   bool saveTimeStreams;
 
+  ///sparse observation maps
+  int mapTileSize;                    ///tile side in pixels, 0 for dense maps
+  bool writeAbsCoords;                ///write xCoordsAbs/yCoordsAbs grids
+
+  ///netcdf output storage
+  int ncDeflateLevel;                 ///0 for classic files, 1-9 for netcdf-4
+  bool ncShuffle;                     ///shuffle filter for compressed output
+  bool noiseFloat32;                  ///store noise maps as float
+
   ///Source finding parameters and switches
   bool findSources;                    ///switch to turn on source finding
   double beamSize;                     ///beam size in radians
@@ -182,6 +204,9 @@ class AnalParams
   ///cleaning PCA parameters
   double cutStd;
   int neigToCut;
+  bool pcaTruncated;                  ///leading modes only, no full eigen-solve
+  bool writePcaModes;                 ///per-scan modes in the observation files
+  vector<string> cleanChain;          ///registered cleaner names run in order
 
   ///cleanning Cuttingham method
   double cleanPixelSize;		///Pix size for pointing mat in arcsec
@@ -203,6 +228,13 @@ class AnalParams
   string getObservatory();
   string getTimeVarName();
   const char* getDataFile();
+  ObsReader* getObsReader();
+  ObsIndex* getObsIndex();
+  Distributor* getDistributor();
+  void setDistributor(Distributor* dist);
+  Journal* getJournal();
+  void setJournal(Journal* j);
+  string getApXml();
   const char* getBolostatsFile();
   const char* getOutBeammapInfo();
   const char* getOutBeammapNcdf();
@@ -228,6 +260,9 @@ class AnalParams
   int getCutSamplesAtEndOfScans();
   double getCutStd();
   int getNeigToCut();
+  bool getPcaTruncated();
+  bool getWritePcaModes();
+  vector<string> getCleanChain();
   double getCleanPixelSize();
   void setCleanPixelSize(double pixSize);
   int getOrder();
@@ -235,7 +270,14 @@ class AnalParams
   double getControlChunk();
   void setControlChunk(double control);
   int getNThreads();
+  int getBlasThreads();
+  double getJobMemoryBudget();
+  bool getResume();
   bool getSaveTimestreams();
+  int getMapTileSize();
+  bool getWriteAbsCoords();
+  NcCompression getNcCompression();
+  bool getNoiseFloat32();
   double* getBsOffset();
   double* getMasterGridJ2000();
   bool   setMasterGridJ2000(double ra, double dec);
@@ -281,7 +323,10 @@ class AnalParams
 
   int getNFiles();
   string getMapFile();
+  string getMapPath();
   string getMapFileList(int i);
+  string getFileList(int i);
+  string getBstatList(int i);
   string getSourceName();
   bool setSourceName(string name);
   string getCoaddOutFile();
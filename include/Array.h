@@ -5,6 +5,7 @@
 #include "Detector.h"
 #include "Telescope.h"
 #include "AnalParams.h"
+#include "PcaModes.h"
 
 ///Array - a collection of detectors
 /** The Array class is responsible for everything that is common
@@ -49,7 +50,7 @@ public:
   Detector* detectors;         ///<the set of detectors
   int nFiltTerms;              ///<the number of digital filter terms
   VecDoub digFiltTerms;        ///<the dig. filt. coef. to lowpass the det data
-  MatDoub eVectors;            ///<the saved PCA eigenvectors
+  PcaModes pcaModes;           ///<the saved PCA modes of each scan
 
   ///calibration
   double tau;                  ///<the array-averaged value of tau
@@ -24,6 +24,10 @@ class AzElTemplateCalculator{
 		bool matrixCoords;
 
 		void setMode();
+		void designMatrix(size_t i, gsl_matrix *coordMatrix);
+		void weightedPinv(const gsl_matrix *coordMatrix, const gsl_vector *weights, gsl_matrix *pinv,
+				gsl_matrix *aw, gsl_matrix *v, gsl_vector *s, gsl_vector *d, gsl_vector *work);
+		bool sameFlags(size_t i, size_t k);
 	public:
 		AzElTemplateCalculator (gsl_matrix *data, gsl_matrix *flags, gsl_vector *azOffsets,gsl_vector *elOffsets);
 		AzElTemplateCalculator(gsl_matrix* data,gsl_matrix* flags, gsl_matrix* azOffsets, gsl_matrix* elOffsets);
@@ -0,0 +1,33 @@
+#ifndef _BANDEDCHOLESKY_H_
+#define _BANDEDCHOLESKY_H_
+
+#include "nr3.h"
+
+///BandedCholesky - Cholesky factorization of a symmetric banded matrix
+/** Holds the lower band (the diagonal plus bandwidth subdiagonals) of
+    an n x n symmetric positive definite matrix, n*(bandwidth+1)
+    values.  The matrix is filled with add(), factored in place once
+    with factor() and can then be used to solve any number of right
+    hand sides.  solve() is const and may be called concurrently on
+    different right hand sides.
+**/
+class BandedCholesky
+{
+ protected:
+  int n;                        ///<matrix size
+  int bw;                       ///<number of subdiagonals
+  VecDoub band;                 ///<row i holds columns i-bw..i
+  bool factored;                ///<band holds L instead of the matrix
+
+ public:
+  BandedCholesky();
+  BandedCholesky(int n, int bandwidth);
+  void resize(int n, int bandwidth);
+  void add(int i, int j, double value);
+  bool factor();
+  void solve(double *b, int nRhs=1, int ld=1) const;
+  int getN() const;
+  int getBandwidth() const;
+};
+
+#endif
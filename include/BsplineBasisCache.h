@@ -0,0 +1,59 @@
+#ifndef _BSPLINEBASISCACHE_H_
+#define _BSPLINEBASISCACHE_H_
+
+#include <vector>
+#include <suitesparse/cs.h>
+
+using namespace std;
+
+///BsplineBasis - sparse B-spline design matrices of one scan shape
+/** b is the (nDetectors*nSamples) x nSpline base matrix with the same
+    uniform-knot basis repeated for every detector, bt its transpose
+    and btb the nSpline x nSpline product bt*b.  The matrices are only
+    read once built.
+**/
+class BsplineBasis
+{
+ public:
+  int nSamples;                 ///<samples per detector
+  int nBreaks;                  ///<number of spline breakpoints
+  int order;                    ///<spline order
+  int nDetectors;               ///<number of detectors stacked in b
+  cs *b;                        ///<base matrix
+  cs *bt;                       ///<base matrix transpose
+  cs *btb;                      ///<bt*b
+  int users;                    ///<scans holding it, see BsplineBasisCache
+
+  BsplineBasis(int nSamples, int nBreaks, int order, int nDetectors);
+  ~BsplineBasis();
+};
+
+
+///BsplineBasisCache - B-spline bases shared by the scans of a clean
+/** Scans of equal length and knot spacing have identical bases, so
+    each one is built on first request and shared.  Scan lengths
+    usually differ by a few samples though, and each basis is as large
+    as the scan's timestream, so beyond the ones in use only the
+    BSPLINE_CACHE_SIZE most recently requested are kept.  Every get()
+    must be matched by a release() once the scan is done with the
+    basis.  Both are thread safe and a basis may be used concurrently
+    by any number of scans.
+**/
+class BsplineBasisCache
+{
+ protected:
+  vector<BsplineBasis*> bases;  ///<the bases kept, most recent first
+  int nBuilt;                   ///<number of bases built so far
+
+  void trim();
+
+ public:
+  BsplineBasisCache();
+  const BsplineBasis* get(int nSamples, int nBreaks, int order,
+                          int nDetectors);
+  void release(const BsplineBasis* basis);
+  int size();
+  ~BsplineBasisCache();
+};
+
+#endif
@@ -5,7 +5,15 @@
 #include "Array.h"
 #include "Telescope.h"
 #include "AnalParams.h"
+#include "ScanBlock.h"
 
+///Clean - base class of the timestream cleaners
+/** A cleaner either works on the whole array in clean() or, if
+    scanWise() is true, one scan at a time in place on a ScanBlock
+    with cleanScan().  Scan-wise cleaners can be chained so that every
+    scan is copied out of the detectors and back only once for the
+    whole chain, see runScans() and CleanChain.
+**/
 class Clean{
   protected:
     Array *dataArray;
@@ -14,8 +22,14 @@ class Clean{
   public:
     Clean(Array *dataArray,Telescope *telescope);
     virtual bool clean()=0;
+    virtual bool scanWise();
+    virtual void beginScans(int nScans);
+    virtual bool cleanScan(ScanBlock &block);
+    virtual void endScans();
+    static bool runScans(Array *dataArray, Telescope *telescope,
+                         Clean **stages, int nStages);
     virtual ~Clean(){}
 };
 
 
-#endif
\ No newline at end of file
+#endif
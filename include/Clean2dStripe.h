@@ -6,6 +6,7 @@
 #include <gsl/gsl_spline.h>
 
 #include "Map.h"
+#include "BandedCholesky.h"
 
 class Clean2dStripe{
 	private:
@@ -19,42 +20,50 @@ class Clean2dStripe{
 
 
 
+///Spline2d - tensor product B-spline fit of a map
+/** The map, optionally downsampled, is fitted with cubic B-splines of
+    px breaks along the rows and py breaks along the columns.  The fit
+    is separable: every row is fitted along y and then every column of
+    the result along x, which is the least squares tensor product fit.
+    Each direction is a single banded normal-equation system, B B^T,
+    factored once and applied to all rows (columns) in parallel, so
+    besides the fitted surface only the two band factors and the
+    compact bases are kept.
+**/
 class Spline2d{
-	//Construnct a two dimentional spline interpolant based on gsl spline funcions
 	private:
-		double *x;
-		double *y;
-		double **map;
+		VecDoub x;							///<row coordinates of the fitted grid
+		VecDoub y;							///<column coordinates of the fitted grid
 		size_t nx;
 		size_t ny;
 		size_t px;
 		size_t py;
 		int order;
-		size_t downsample;
 		double dx;
 		double dy;
 
-		gsl_bspline_workspace *bswx;
-
-		double **coeff;
-		gsl_bspline_workspace *bswy;
 		size_t nSplinex;
 		size_t nSpliney;
-		cs *baseMatrix_x;
-		cs *baseMatrix_t_x;
-		cs *baseMatrix_y;
-		cs *baseMatrix_t_y;
-
-		void createBaseMatrix(gsl_bspline_workspace *bsw, double *time,cs **Matrix, cs **Matrix_t, size_t nSpline, size_t nData);
-		void create1DCoeffs(double *data, size_t nData, cs *bMatrix, cs *btbMatrix, size_t nSpline, double *coeffOut);
-		void createCoeffs();
+		VecInt firstx;						///<first nonzero spline of each row
+		VecInt firsty;						///<first nonzero spline of each column
+		VecDoub basisx;						///<order spline values per row
+		VecDoub basisy;						///<order spline values per column
+		BandedCholesky gramx;				///<factored B B^T along x
+		BandedCholesky gramy;				///<factored B B^T along y
+		MatDoub surface;					///<fitted map on the grid
+
+		void createBasis(const VecDoub &time, size_t nBreaks, size_t nSpline, VecInt &first, VecDoub &basis, BandedCholesky &gram);
+		void fitRows();
+		void fitColumns();
+		size_t gridRow(double xi);
+		size_t gridCol(double yi);
 
 	public:
 
-		Spline2d(double *x, size_t nx, double *y, size_t ny, double **map, size_t px, size_t py);
-		Spline2d(double *x, size_t nx, double *y, size_t ny, double **map, size_t px, size_t py, size_t downsample);
-		~Spline2d();
+		Spline2d(double *x, size_t nx, double *y, size_t ny, const MatDoub &map, size_t px, size_t py);
+		Spline2d(double *x, size_t nx, double *y, size_t ny, const MatDoub &map, size_t px, size_t py, size_t downsample);
 		void interpolate(double *xi, double *yi, size_t nData, double *dataOut);
+		void interpolateGrid(double *xi, size_t nxi, double *yi, size_t nyi, MatDoub &dataOut);
 		double interpolate_single(double xi, double yi);
 };
 
@@ -11,6 +11,7 @@
 
 
 #include "Clean.h"
+#include "BsplineBasisCache.h"
 
 
 
@@ -22,13 +23,12 @@ typedef enum  {STRIPE_NONE,STRIPE_PCA, STRIPE_FFT, SUBARRAY_SPLINE, STRIPE_SCAN,
 ///All matrix are represented using the sparse matrix library CXSparse. This increases the efficency of the code
 class CleanBspline : public Clean{
   private:
-    cs *baseMatrix;							///<Sparse B-Spline Base Matrix
-    cs *baseMatrix_t;						///<Sparse B-Spline Base Matrix transpose
-    gsl_bspline_workspace *bsw;				///<GSL B-Spline workspace
-    gsl_vector *time;						///<Time vector
+    BsplineBasisCache bases;				///<B-Spline bases of recent scan shapes
     bool calibrated;						///<Indicates is time stream is calibrated or not
-    int baseMatrixSamples;					///<Number of samples to clean
-    int baseMatrixDetectors;				///<Number of detectors to clean
+    VecDoub scanSetupTime;					///<Per-scan seconds spent building the spline system
+    VecDoub scanSolveTime;					///<Per-scan seconds spent in the QR solve
+    VecInt scanSystemNnz;					///<Per-scan nonzeros of the spline system
+    VecInt scanFactorNnz;					///<Per-scan nonzeros of its QR factors
 
     int **detPerHextant;
     VecInt nDetPerHextant;
@@ -47,17 +47,17 @@ class CleanBspline : public Clean{
 
 
   protected:  
-    ///Use GSL to create the B-Spline Base Matrix, store it in a sparse matrix
-    void createBaseMatrix(int nSamples, int nDetectors);
+    ///B-Spline Base Matrix of a scan, from the cache
+    const BsplineBasis* getBaseMatrix(int nSamples, int nDetectors);
     void createPointingMatrix();
-    void destroyBaseMatrix();
+    void reportSolves();
     void calibrate();
     void removeBadBolos();
     cs *getPMatrix(gsl_vector *ra, gsl_vector *dec, double pixelSize);
     void downSample(gsl_vector **out, double *data, bool *flags, long nSamples, long dowSample);
     bool fixFlags(double *dataVector, bool *flagsVector, int nDetectors, long nSamples);
     void subtractTemplate(double *detector,size_t oSamples, double *aTemplate, size_t nSamples, double increment, char *outName=NULL, bool overwrite = false);
-    double *cottingham(double *dataVector, gsl_vector *raVector, gsl_vector *decVector, bool *flags, size_t nDetectors, size_t nSamples, double cleanPixelSize, int refBolo=-1);
+    double *cottingham(double *dataVector, gsl_vector *raVector, gsl_vector *decVector, bool *flags, size_t nDetectors, size_t nSamples, double cleanPixelSize, int refBolo=-1, int scan=-1);
     bool cleanScans ();
     double *removeAzElResidual(double *dataVector, gsl_vector *raVector, gsl_vector *decVector, size_t nDetectors, size_t nSamples);
     void removeLargeScaleResiduals (CleanBsplineDestriping method,double correlate);
@@ -75,9 +75,9 @@ class CleanBspline : public Clean{
     CleanBsplineDestriping translateStripeMethod();
   public:
     CleanBspline(Array*  dataArray, Telescope *telescope);
+    static Clean* create(Array *dataArray, Telescope *telescope);
     ~CleanBspline();
     bool clean ();
-    cs* getBaseMatrix();
 };
 
 #endif
@@ -0,0 +1,64 @@
+#ifndef _CLEAN_CHAIN_H_
+#define _CLEAN_CHAIN_H_
+
+#include <string>
+#include <vector>
+#include <gsl/gsl_vector.h>
+
+#include "Clean.h"
+
+///CleanChain - runs registered cleaners one after the other
+/** Stages are created by name from the CleanRegistry.  Consecutive
+    scan-wise stages are run together with Clean::runScans(), so each
+    scan is copied out of the detectors once, cleaned in place by all
+    of them, data and kernel in the same pass, and copied back once.
+    Stages that only work on the whole array run on their own in
+    between.
+**/
+class CleanChain : public Clean {
+  protected:
+    std::vector<std::string> names;     ///<stage names, in order
+    std::vector<Clean*> stages;         ///<the stages
+  public:
+    CleanChain(Array *dataArray, Telescope *telescope,
+               const std::vector<std::string> &names);
+    bool clean();
+    ~CleanChain();
+};
+
+
+///CleanMedian - subtracts the scan median of every detector
+/** Applied to the data and the kernel.
+**/
+class CleanMedian : public Clean {
+  public:
+    CleanMedian(Array *dataArray, Telescope *telescope);
+    static Clean* create(Array *dataArray, Telescope *telescope);
+    bool clean();
+    bool scanWise();
+    bool cleanScan(ScanBlock &block);
+};
+
+
+///CleanAzEl - subtracts the az/el residual template of every sample
+/** A per-sample polynomial in the detector az/el offsets, fitted with
+    AzElTemplateCalculator and weighted by the inverse detector
+    sensitivities.  The same fit is applied to the kernel.
+**/
+class CleanAzEl : public Clean {
+  protected:
+    gsl_vector *azOffsets;              ///<detector az offsets
+    gsl_vector *elOffsets;              ///<detector el offsets
+    gsl_vector *weights;                ///<inverse detector sensitivities
+  public:
+    CleanAzEl(Array *dataArray, Telescope *telescope);
+    static Clean* create(Array *dataArray, Telescope *telescope);
+    bool clean();
+    bool scanWise();
+    void beginScans(int nScans);
+    bool cleanScan(ScanBlock &block);
+    void endScans();
+    ~CleanAzEl();
+};
+
+#endif
@@ -10,27 +10,38 @@
 class CleanHigh : public Clean{
     private:
         int order;			//Set 1 for average, 2 linear, 3 cuadratic template calculation
-        MatDoub Trp (MatDoub M) ;
-        MatDoub MatrixProduct (MatDoub A, MatDoub B) ;
+        gsl_matrix *geometry;		//quadratic template basis S from the detector offsets
+        gsl_matrix *geometryPinv;	//(S^T S)^-1 S^T, cached for all scans
+        MatDoub Trp (const MatDoub &M) ;
+        MatDoub MatrixProduct (const MatDoub &A, const MatDoub &B) ;
         MatDoub IdMat (size_t size) ;
-        MatDoub CorMat (MatDoub d);
-        MatDoub CovMat (MatDoub d);
+        MatDoub CorMat (const MatDoub &d);
+        MatDoub CovMat (const MatDoub &d);
+        gsl_matrix* templateBasis (const VecDoub &x, const VecDoub &y, size_t nPars);
+        MatDoub fitTemplate (const MatDoub &tods, const MatDoub &C,
+                             const VecDoub &x, const VecDoub &y, size_t nPars);
+        void buildGeometry ();
+        void subtractTemplate (gsl_matrix *d, gsl_matrix *C);
     
     protected:
-        MatDoub Coefficients (MatDoub Template, MatDoub tods) ;
-        MatDoub IterTemp (MatDoub coef , MatDoub tods ) ;
+        MatDoub Coefficients (const MatDoub &Template, const MatDoub &tods) ;
+        MatDoub IterTemp (const MatDoub &coef , const MatDoub &tods ) ;
 
     public:
         bool clean();
+        bool scanWise();
+        void beginScans(int nScans);
+        bool cleanScan(ScanBlock &block);
         CleanHigh(Array*  dataArray, Telescope *telescope);
+        static Clean* create(Array *dataArray, Telescope *telescope);
         void fullMedianSustraction ();
         void fullLinearCorrection ();
-        MatDoub Average (MatDoub tods, MatDoub C);
-        MatDoub Planar (MatDoub tods, MatDoub C, VecDoub x, VecDoub y) ;
-        MatDoub Quadratic (MatDoub tods, MatDoub C, VecDoub x, VecDoub y) ;
-        MatDoub BuildTemplate (gsl_matrix *tods, gsl_matrix *C, gsl_matrix *S);
-        MatDoub subTemplate (MatDoub tods, VecDoub x, VecDoub y, double crit[2],
-                             bool withCov, string method);
+        MatDoub Average (const MatDoub &tods, const MatDoub &C);
+        MatDoub Planar (const MatDoub &tods, const MatDoub &C, const VecDoub &x, const VecDoub &y) ;
+        MatDoub Quadratic (const MatDoub &tods, const MatDoub &C, const VecDoub &x, const VecDoub &y) ;
+        MatDoub BuildTemplate (const gsl_matrix *tods, gsl_matrix *C, gsl_matrix *S);
+        MatDoub subTemplate (const MatDoub &tods, const VecDoub &x, const VecDoub &y,
+                             double crit[2], bool withCov, string method);
         ~CleanHigh();
 
 
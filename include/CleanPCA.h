@@ -3,6 +3,10 @@
 
 
 
+#include <vector>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+
 #include "Clean.h"
 #include "Array.h"
 #include "Telescope.h"
@@ -12,9 +16,21 @@ class CleanPCA : public Clean {
   private:
     bool adaptive;
     double damping;
+    std::vector<gsl_matrix*> warmStart;   ///<leading modes of each thread's last scan
+    int cutStdIndex(gsl_vector* eVals, int nDetectors, double cutStd);
+    int leadingModes(gsl_matrix* pcaCorr, gsl_vector* eVals,
+		     gsl_matrix* eVecs, int neigToCut, double cutStd,
+		     long seed, const gsl_matrix* start,
+		     int* nValues, int* nIter);
+    void removeModes(gsl_matrix* eVecs, int nCut, gsl_matrix* x);
   public:
     CleanPCA(Array *dataArray,Telescope *telescope);
+    static Clean* create(Array *dataArray, Telescope *telescope);
     bool clean();
+    bool scanWise();
+    void beginScans(int nScans);
+    bool cleanScan(ScanBlock &block);
+    void endScans();
     void setAdaptive(bool adaptive);
     void setDamping(double damping);
     bool getAdaptive();
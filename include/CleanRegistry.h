@@ -0,0 +1,43 @@
+#ifndef _CLEAN_REGISTRY_H_
+#define _CLEAN_REGISTRY_H_
+
+#include <string>
+#include <vector>
+
+#include "Array.h"
+#include "Telescope.h"
+#include "Clean.h"
+
+typedef Clean* (*CleanFactory)(Array *dataArray, Telescope *telescope);
+
+///CleanRegistry - cleaners by name
+/** Every cleaner provides a static create() factory and is known by a
+    short name, the one used in the cleanChain analysis parameter.
+    The cleaners of this library are listed in a fixed table in
+    CleanRegistry.cpp, as static registrars in a static library are
+    dropped by the linker unless something else pulls in their object
+    file.  Others can be added with add(), or with a CleanRegistrar
+    defined in the program itself.  All of the calls take the
+    cleanRegistry critical section, so they may be made from anywhere.
+**/
+class CleanRegistry
+{
+ public:
+  static bool add(const std::string &name, CleanFactory factory);
+  static bool has(const std::string &name);
+  static Clean* create(const std::string &name, Array *dataArray,
+                       Telescope *telescope);
+  static std::vector<std::string> names();
+};
+
+
+///registers a cleaner when a static instance is constructed
+/** Only dependable in the program's own sources, see CleanRegistry.
+**/
+class CleanRegistrar
+{
+ public:
+  CleanRegistrar(const std::string &name, CleanFactory factory);
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include "Map.h"
 #include "Telescope.h"
 #include "PointSource.h"
+#include "MapProjection.h"
 
 ///Coaddition - a coaddition of many maps to form a single map set.
 /** The Coaddition class takes the output of many Observations 
@@ -29,8 +30,7 @@ class Coaddition
   double pixelSize;            ///<pixel size in radians
   VecDoub rowCoordsPhys;       ///<row coordinates in tangential projection
   VecDoub colCoordsPhys;       ///<column coordinates in tangential projection
-  MatDoub xCoordsAbs;          ///<matrix of sphere coordinates in ra/az
-  MatDoub yCoordsAbs;          ///<matrix of sphere coordinates in dec/el
+  MapProjection projection;    ///<sphere coordinates of the map grid
   VecDoub masterGrid;          ///<tangential point on sphere
 
   //source finding
@@ -79,6 +79,7 @@ class Coaddition
   double getColCoordsPhys(int i);
   double getXCoordsAbs(int i, int j);
   double getYCoordsAbs(int i, int j);
+  const MapProjection& getProjection();
   bool writeCoadditionToNcdf();
   bool writeCoadditionToFits(string fitsFilename);
   bool writeFilteredMapsToNcdf();
@@ -6,6 +6,19 @@
 #include "AnalParams.h"
 #include "Source.h"
 
+///the type the timestreams are stored in
+/** Single precision with the FLOAT32_SAMPLES build option, which
+    halves the memory and bandwidth of the detector signal and kernel.
+    Everything computed from them (cleaning, binning, weights) is
+    still done in double.
+**/
+#ifdef FLOAT32_SAMPLES
+typedef float Sample;
+#else
+typedef double Sample;
+#endif
+typedef NRvector<Sample> VecSample;
+
 ///Detector - the base element of an array.
 /**This class contains everything that a detector
    can do on its own.  It includes some elements of
@@ -74,11 +87,11 @@ public:
   double responsivity;               ///<responsivity (volts per watt)
 
   //time stream characteristics
-  VecDoub hValues;                   ///<pointer to det values on cpu host
+  VecSample hValues;                 ///<pointer to det values on cpu host
   VecBool hSampleFlags;              ///<pointer to sampleflags on host
   VecDoub hRa;                       ///<pointer to ra values on host
   VecDoub hDec;                      ///<pointer to dec values on host
-  VecDoub hKernel;                   ///<pointer to the kernel signal values
+  VecSample hKernel;                 ///<pointer to the kernel signal values
   VecDoub dValues;                   ///<pointer to det values on gpu device
   VecBool dSampleFlags;              ///<pointer to sampleflags on device
   VecDoub dRa;                       ///<pointer to ra values on device
@@ -0,0 +1,73 @@
+#ifndef _DISTRIBUTOR_H_
+#define _DISTRIBUTOR_H_
+
+#include <string>
+
+#include "nr3.h"
+
+///Distributor - splits a macanap run over several processes
+/** Each process (rank) of a distributed run reduces its own share of
+    the observations and of the noise realizations.  The ranks learn
+    who they are from the environment, so any launcher will do:
+    mpirun, srun, or a shell loop on one machine setting MACANA_RANK
+    and MACANA_NRANKS by hand.  Nothing is linked against mpi.
+
+    The ranks talk through small binary message files in a run
+    directory under a path they all share (the map path).  A message
+    is written to a temporary file and renamed into place, so a
+    reader that sees it sees all of it.  The run directory is named
+    after the launcher's job id, or MACANA_RUN, and must be new for
+    every run: one left behind by a run that died holds messages that
+    would be taken for this run's, so a run refuses to start in it.
+    The root rank removes it in finish().
+
+    A rank that leaves the run early, through exit() anywhere before
+    finish(), posts an "aborted" marker on its way out; a rank waiting
+    for a message gives up as soon as it sees one, so the survivors of
+    a failed run don't poll for ever.  A rank that dies without getting
+    to exit() can't post it, so every wait also has a timeout,
+    MACANA_WAIT_TIMEOUT seconds (a day if unset, 0 for none), after
+    which the rank gives up naming the message it was waiting for.
+
+    Without any of the environment variables a Distributor is a single
+    rank that owns everything and never touches the filesystem, so
+    the rest of the code doesn't need to care.
+**/
+class Distributor
+{
+ protected:
+  int rank;                     ///<this process
+  int nRanks;                   ///<number of processes in the run
+  std::string runDir;           ///<where the messages go
+  VecInt owner;                 ///<rank reducing each observation
+  double waitTimeout;           ///<longest wait for a message [s], 0 none
+
+  void init(const char* sharedDir, int rank, int nRanks, const char* runId);
+  std::string messageFile(const std::string &name, int from);
+  void waitFor(const std::string &file);
+
+ public:
+  Distributor(const char* sharedDir);
+  Distributor(const char* sharedDir, int rank, int nRanks,
+              const char* runId);
+  ~Distributor();
+  int getRank();
+  int getNRanks();
+  bool isRoot();
+  bool isDistributed();
+  void setWaitTimeout(double seconds);
+
+  void assignJobs(VecDoub &work);
+  bool owns(int job);
+  int taskOwner(int task);
+  bool ownsTask(int task);
+
+  void send(const std::string &name, const double* data, long n);
+  void receive(const std::string &name, int from, VecDoub &data);
+  void allReduce(const std::string &name, double* data, long n);
+  void barrier(const std::string &name);
+  void finish();
+  void abort();
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef _JOBSCHEDULER_H_
+#define _JOBSCHEDULER_H_
+
+#include "nr3.h"
+#include "AnalParams.h"
+
+///JobScheduler - hands out the observations of a macanap run
+/** Every observation is sized before any is started: its work from
+    nSamples x nDetectors (the data file's index and the bolostats
+    file) and its memory from that plus the area of its map, when a
+    previous run left an index of the map file.  Threads take the
+    largest job still queued that fits in the memory budget, so long
+    observations start first and don't hold up the end of the run,
+    and no more than the budget is in flight at once.  A job larger
+    than the whole budget still runs, by itself.
+
+    Once the queue is empty the threads that drop out are shared
+    among the jobs still running: threadsPerJob() is what each of
+    those jobs should give its own parallel stages.
+
+    In a distributed run (see Distributor) every rank sizes all of the
+    observations and then only hands out its own share.
+**/
+class JobScheduler
+{
+ protected:
+  int nJobs;                    ///<number of observations
+  int nThreads;                 ///<threads taking jobs
+  double budget;                ///<memory cap [bytes], 0 for none
+  VecDoub work;                 ///<nSamples x nDetectors of each job
+  VecDoub memory;               ///<estimated memory of each job [bytes]
+  VecInt order;                 ///<jobs, largest first
+  VecBool started;              ///<jobs handed out
+  int nStarted;                 ///<how many
+  int nRunning;                 ///<jobs handed out and not finished
+  double inFlight;              ///<memory of the running jobs
+
+  static int countDetectors(const char* bolostatsFile);
+
+ public:
+  JobScheduler(AnalParams* ap, int nThreads);
+  int nextJob();
+  void finishJob(int job);
+  int threadsPerJob();
+  double getWork(int job);
+  double getMemory(int job);
+};
+
+#endif
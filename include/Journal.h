@@ -0,0 +1,61 @@
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+#include <string>
+#include <vector>
+
+#include "AnalParams.h"
+
+///Journal - the finished work of a macanap campaign
+/** Every piece of work that completes (an observation reduced, a noise
+    realization made, a noise realization Wiener filtered) appends a
+    line to the journal: a stamp of everything the work depended on,
+    the size and modification time of its output, and what it was.
+    The stamp hashes the analysis parameters that matter to the work,
+    the entries of the input files and their sizes and modification
+    times, so a changed parameter or a touched input makes the entry
+    stale by itself.  The raw data files are stamped by size and time
+    rather than by their contents, as the ObsIndex sidecars are.
+
+    With resume set the journals in the map path are read at the start
+    and work with a current entry and an unchanged output is skipped.
+    Without it this process's journal is started afresh.  Each rank of
+    a distributed run keeps its own journal, macana.journal.<rank>,
+    and reads everyone's.
+
+    Lines are appended and synced one at a time so a run that dies
+    loses at most the work in flight.  Noise realizations live in one
+    store file; their stamps include the id of the store so that only
+    a reopened store's realizations count as done.
+**/
+class Journal
+{
+ protected:
+  AnalParams* ap;                        ///<pointer to our analysis parameters
+  std::string journalFile;               ///<this process's journal
+  std::string paramHash;                 ///<parameters the reductions use
+  std::string noiseHash;                 ///<the noise realization section
+  std::string wienerHash;                ///<the wiener filter section
+  std::vector<std::string> obsHash;      ///<each observation's entry
+  std::vector<std::string> stamps;       ///<the work done before this run
+  std::vector<std::string> outputs;      ///<and the state of its outputs
+  std::string coaddHash;                 ///<the coaddition's inputs, once known
+
+  void hashParameters();
+  void load(const std::string &file);
+
+ public:
+  Journal(AnalParams* ap);
+  static std::string hash(const std::string &s);
+  static std::string fileStamp(const std::string &file);
+  std::string reduceStamp(int i);
+  std::string noiseStamp(double storeId, int k);
+  std::string filteredNoiseStamp(double storeId, int k);
+  bool isDone(const std::string &stamp, const std::string &output);
+  bool isDone(const std::string &stamp);
+  void markDone(const std::string &stamp, const std::string &what,
+                const std::string &output);
+  void markDone(const std::string &stamp, const std::string &what);
+};
+
+#endif
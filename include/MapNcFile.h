@@ -17,12 +17,17 @@ class MapNcFile{
 		double raMin;
 		double decMax;
 		double decMin;
+		double raStep;				///<grid spacing in ra, valid if regularGrid
+		double decStep;				///<grid spacing in dec, valid if regularGrid
+		bool regularGrid;			///<both coordinate axes are evenly spaced
 		void init();
 		void setLimits();
+		size_t locateIndex (const VecDoub &coords, double minCoord, double step, double x) const;
 	public:
 		MapNcFile(string filename);
-		VecDoub mapSignal(VecDoub rapoint, VecDoub decpoint);
-		VecDoub fastMapSignal (VecDoub rapoint, VecDoub decpoint);
+		void sampleSignal (const double *rapoint, const double *decpoint, size_t npoints, double *outSignal) const;
+		VecDoub mapSignal(const VecDoub &rapoint, const VecDoub &decpoint) const;
+		VecDoub fastMapSignal (const VecDoub &rapoint, const VecDoub &decpoint) const;
 		~MapNcFile();
 };
 
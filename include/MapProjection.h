@@ -0,0 +1,45 @@
+#ifndef _MAPPROJECTION_H_
+#define _MAPPROJECTION_H_
+
+#include <netcdfcpp.h>
+
+#include "nr3.h"
+#include "NcCompression.h"
+
+///MapProjection - tangent plane projection of a map pixel grid
+/** Holds the tangent point and the physical row/column coordinates of
+    a map and computes absolute (sphere) coordinates of its pixels on
+    demand, so no map-owning object needs to hold dense absolute
+    coordinate matrices.  The gnomonic inversion is the same as
+    physToAbs() but with the tangent point trig hoisted out, and
+    rowToAbs() does a whole row at a time.
+**/
+class MapProjection
+{
+ protected:
+  double centerX;              ///<tangent point ra/az in radians
+  double centerY;              ///<tangent point dec/el in radians
+  double sinCenterY;           ///<sin(centerY)
+  double cosCenterY;           ///<cos(centerY)
+  VecDoub rowCoordsPhys;       ///<row coordinates in tangential projection
+  VecDoub colCoordsPhys;       ///<column coordinates in tangential projection
+
+ public:
+  MapProjection();
+  MapProjection(double cx, double cy,
+                const VecDoub &rowPhys, const VecDoub &colPhys);
+  int getNrows() const;
+  int getNcols() const;
+  double getCenterX() const;
+  double getCenterY() const;
+  void physToAbs(double px, double py, double *ax, double *ay) const;
+  void pixelToAbs(int i, int j, double *ax, double *ay) const;
+  double getXAbs(int i, int j) const;
+  double getYAbs(int i, int j) const;
+  void rowToAbs(int i, double *ax, double *ay) const;
+  bool writeToNcdf(NcFile &ncfid, NcDim *rowDim, NcDim *colDim,
+                   bool wcsOnly,
+                   const NcCompression &comp=NcCompression()) const;
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _NCCOMPRESSION_H_
+#define _NCCOMPRESSION_H_
+
+#include <netcdfcpp.h>
+
+///NcCompression - storage settings for netcdf output files
+/** With a deflate level of 0 files are written as 64-bit offset
+    netcdf exactly as before.  A level of 1-9 switches the output to
+    netcdf-4 and every variable created through this class is chunked
+    and deflate (and optionally shuffle) compressed.  Readers need no
+    changes since the netcdf library decompresses transparently.
+**/
+class NcCompression
+{
+ protected:
+  int deflateLevel;          ///<0 for uncompressed classic output, up to 9
+  bool shuffle;              ///<byte shuffle filter before deflate
+
+ public:
+  NcCompression(int level=0, bool shuf=true);
+  bool isEnabled() const;
+  NcFile::FileFormat getFileFormat() const;
+  bool setStorage(NcFile &ncfid, NcVar *var, const size_t *chunks) const;
+  NcVar* addMapVar(NcFile &ncfid, const char *name, NcType type,
+                   NcDim *rowDim, NcDim *colDim) const;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef _NCMAP_H_
+#define _NCMAP_H_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+//classic netcdf external types
+#define NCMAP_BYTE   1
+#define NCMAP_CHAR   2
+#define NCMAP_SHORT  3
+#define NCMAP_INT    4
+#define NCMAP_FLOAT  5
+#define NCMAP_DOUBLE 6
+
+///value i of an array of big endian netcdf type in the mapped file
+static inline double ncMapDecode(const unsigned char* p, int type, long i)
+{
+  switch(type){
+  case NCMAP_DOUBLE: {
+    p += 8*i;
+    uint64_t u = ((uint64_t) p[0] << 56) | ((uint64_t) p[1] << 48) |
+      ((uint64_t) p[2] << 40) | ((uint64_t) p[3] << 32) |
+      ((uint64_t) p[4] << 24) | ((uint64_t) p[5] << 16) |
+      ((uint64_t) p[6] << 8) | (uint64_t) p[7];
+    double d;
+    memcpy(&d, &u, 8);
+    return d;
+  }
+  case NCMAP_FLOAT: {
+    p += 4*i;
+    uint32_t u = ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+      ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+    float f;
+    memcpy(&f, &u, 4);
+    return f;
+  }
+  case NCMAP_INT:
+    p += 4*i;
+    return (int32_t) (((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+		      ((uint32_t) p[2] << 8) | (uint32_t) p[3]);
+  case NCMAP_SHORT:
+    p += 2*i;
+    return (int16_t) (((uint16_t) p[0] << 8) | (uint16_t) p[1]);
+  case NCMAP_BYTE:
+    return (signed char) p[i];
+  default:
+    return p[i];
+  }
+}
+
+
+//----------------------------- o ---------------------------------------
+
+
+///NcMapView - a read only view of one variable in a mapped file
+/** The values sit in nRecords blocks of nPerRecord contiguous values,
+    recordStride bytes apart: a single block for a fixed size
+    variable, one block per record for a record variable.  Nothing is
+    copied until values are asked for and the file is never touched
+    through the netcdf library, so any number of threads may read
+    views at once.  A view stays good while its NcMap exists.
+**/
+class NcMapView
+{
+ public:
+  const unsigned char* base;    ///<first value
+  int type;                     ///<netcdf type of the values
+  int typeSize;                 ///<bytes per value
+  long nRecords;                ///<number of blocks
+  long nPerRecord;              ///<values per block
+  long recordStride;            ///<bytes from one block to the next
+
+  NcMapView(): base(NULL), type(0), typeSize(0), nRecords(0),
+    nPerRecord(0), recordStride(0) {}
+
+  ///number of values in the view
+  long size() const {return nRecords*nPerRecord;}
+
+  ///value i, in file order
+  double operator[](long i) const
+  {
+    long r = i/nPerRecord;
+    return ncMapDecode(base+r*recordStride, type, i-r*nPerRecord);
+  }
+
+  void get(double *data, long first=0, long n=-1) const;
+  void get(int *data, long first=0, long n=-1) const;
+};
+
+
+//----------------------------- o ---------------------------------------
+
+
+///NcMap - zero copy reader of classic format netcdf files
+/** The file is memory mapped and its header parsed once; after that
+    every variable is a fixed offset into the mapping and reading is
+    just byte swapping, with no library calls, locks or intermediate
+    buffers.  Both the classic (CDF-1) and 64 bit offset (CDF-2)
+    formats are understood.  Anything else, netcdf-4/HDF5 files in
+    particular, leaves the map invalid (isValid() false) so that the
+    caller can fall back to the netcdf library.
+**/
+class NcMap
+{
+ protected:
+  ///a dimension
+  struct Dim {
+    std::string name;
+    long size;                  ///<0 for the record dimension
+  };
+  ///a variable or a global attribute
+  struct Var {
+    std::string name;
+    int type;
+    std::vector<int> dimIds;    ///<empty for attributes
+    long begin;                 ///<file offset of the (first) values
+    long nValues;               ///<per record for record variables
+    bool isRecord;
+  };
+
+  std::string fileName;         ///<the mapped file
+  bool valid;                   ///<header parsed and supported
+  unsigned char* data;          ///<the mapping
+  long fileSize;                ///<and its length
+  long pos;                     ///<read position while parsing
+  int version;                  ///<1 classic, 2 64 bit offset
+  long numRecs;                 ///<number of records
+  long recSize;                 ///<bytes per record
+  std::vector<Dim> dims;        ///<dimensions
+  std::vector<Var> atts;        ///<global attributes
+  std::vector<Var> vars;        ///<variables
+
+  bool parseHeader();
+  bool readInt(long &v);
+  bool readOffset(long &v);
+  bool readName(std::string &name);
+  bool readAtts(std::vector<Var> *keep);
+  static int typeSize(int type);
+  const Var* findVar(const char* name) const;
+  const Var* findAtt(const char* name) const;
+
+ public:
+  NcMap(const char* ncFile);
+  bool isValid() const;
+  const char* getFileName() const;
+  bool has(const char* name) const;
+  bool hasAtt(const char* name) const;
+  long getLength(const char* name) const;
+  long getDimSize(const char* name) const;
+  std::vector<long> getShape(const char* name) const;
+  bool getView(const char* name, NcMapView &view) const;
+  std::string getString(const char* name) const;
+  std::string getAttString(const char* name) const;
+  ~NcMap();
+};
+
+#endif
@@ -6,6 +6,8 @@
 #include "Array.h"
 #include "Map.h"
 #include "Telescope.h"
+#include "MapProjection.h"
+#include "NoiseStore.h"
 
 ///NoiseRealizations - noise realizations generated from Observations
 /** A NoiseRealizations object is a set of noise realizations generated
@@ -25,15 +27,15 @@ class NoiseRealizations
   double pixelSize;          ///<pixel size in radians
   VecDoub rowCoordsPhys;     ///<row coordinates in tangential projection
   VecDoub colCoordsPhys;     ///<column coordinates in tangential projection
-  MatDoub xCoordsAbs;        ///<matrix of sphere coordinates in ra/az
-  MatDoub yCoordsAbs;        ///<matrix of sphere coordinates in dec/el
+  MapProjection projection;  ///<sphere coordinates of the map grid
   VecDoub masterGrid;        ///<tangential point on sphere
 
  public:
   //the noise files
   int nNoiseFiles;           ///<number of noise realizations to make
   string noisePath;          ///<the full path to the directory of output files
-  string* noiseFiles;        ///<the noise realizations output filenames
+  string noiseFile;          ///<the file holding all of the realizations
+  NoiseStore* store;         ///<the open realization store
 
   //a noise map (really storage)
   Map* noise;                ///<storage for each noise realization
@@ -54,12 +56,9 @@ class NoiseRealizations
 
   NoiseRealizations(AnalParams* ap);
   bool generateNoiseRealizations(Coaddition* cmap);
-  bool writeNoiseMapToNcdf(string thisNoiseFile, Map* noise);
   bool makeAverageHistogram(bool filtered);
   bool makeAveragePsd();
-  bool calculateAverageFilteredRms(double cov);
-  bool normalizeErrors(double cov);
-  bool calcFilteredNoiseMapsHistogram(double cov);
+  bool analyzeFilteredNoise(double cov);
   ~NoiseRealizations();
 };
 
@@ -0,0 +1,69 @@
+#ifndef _NOISESTORE_H_
+#define _NOISESTORE_H_
+
+#include <netcdfcpp.h>
+#include <string>
+
+#include "nr3.h"
+#include "AnalParams.h"
+#include "Map.h"
+#include "MapProjection.h"
+
+///NoiseStore - all noise realizations of a coaddition in a single file
+/** The realizations are stored as [nRealizations, nrows, ncols] cubes
+    (noise and, with Wiener filtering, filteredNoise and
+    filteredWeight) together with per-realization histograms and
+    psds.  The realizations run along the record dimension, so no
+    single variable outgrows the 4 GiB limit of 64 bit offset files.
+    The weight map and coordinates, which are common to all
+    realizations, are stored once.  The file stays open for the
+    lifetime of the object and every realization is read or written
+    by index as a single hyperslab, so the passes over the
+    realizations cost one open in total instead of one per file.
+    Access is not thread safe; callers serialize it.
+**/
+class NoiseStore
+{
+ protected:
+  AnalParams* ap;              ///<pointer to our analysis parameters
+  string fileName;             ///<the store filename
+  NcFile* ncfid;               ///<the open store
+  int nRealizations;           ///<number of realizations in the store
+  int nrows;                   ///<number of rows in each realization
+  int ncols;                   ///<number of columns in each realization
+  bool defined;                ///<realization variables have been defined
+  bool reopened;               ///<an existing store was opened
+  double storeId;              ///<set when the store file was created
+
+  bool reopenStore(VecDoub &rowCoordsPhys, VecDoub &colCoordsPhys,
+                   VecDoub &masterGrid);
+  bool defineRealizations(Map* noise);
+  bool getSlab(const char* varName, int k, double* data);
+  bool putSlab(const char* varName, int k, const double* data);
+
+ public:
+  NoiseStore(AnalParams* ap, string fileName, int nReal,
+             VecDoub &rowCoordsPhys, VecDoub &colCoordsPhys,
+             const MapProjection &projection, VecDoub &masterGrid,
+             bool reopen=false);
+  int getNRealizations();
+  int getNrows();
+  int getNcols();
+  string getFileName();
+  double getStoreId();
+  bool isReopened();
+  bool sync();
+  bool writeRealization(int k, Map* noise);
+  bool readNoise(int k, MatDoub &noise);
+  bool readWeight(MatDoub &weight);
+  bool writeFiltered(int k, MatDoub &filteredNoise, MatDoub &filteredWeight);
+  bool readFiltered(int k, MatDoub &filteredNoise, MatDoub &filteredWeight);
+  bool writeFilteredWeight(int k, MatDoub &filteredWeight);
+  bool writeFilteredHistogram(int k, VecDoub &bins, VecDoub &vals);
+  bool readHistogram(int k, bool filtered, VecDoub &bins, VecDoub &vals);
+  bool readPsd(int k, VecDoub &psd, VecDoub &psdFreq,
+               MatDoub &psd2d, MatDoub &psd2dFreq);
+  ~NoiseStore();
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _OBSINDEX_H_
+#define _OBSINDEX_H_
+
+#include <string>
+#include <vector>
+
+///ObsIndex - the header scalars of one data or map file
+/** Planning a campaign needs only a handful of numbers from each file
+    (observatory, sample count, obsnum, map dimensions and bounds,
+    mastergrid, tau) and opening thousands of netcdf files to learn
+    them dominates the start up.  An ObsIndex holds them as key/value
+    pairs and is kept next to the file it describes in a small text
+    sidecar, <file>.idx, stamped with the size and modification time
+    of the file.  forDataFile() and forMapFile() load the sidecar when
+    it is still current and otherwise read the scalars from the file
+    once and write a new one.  If the sidecar can't be written (a read
+    only data directory) the index is simply rebuilt on every run.
+
+    Loading a sidecar is plain file io and safe from any thread;
+    building one goes through the netcdf library in the dataio
+    critical section.
+**/
+class ObsIndex
+{
+ protected:
+  std::string fileName;                  ///<the file described
+  std::string indexName;                 ///<its sidecar
+  long fileSize;                         ///<size of the file when indexed
+  long fileTime;                         ///<and its modification time
+  bool current;                          ///<loaded from a current sidecar
+  std::vector<std::string> keys;         ///<the scalars
+  std::vector<std::string> values;       ///<and their values, as text
+
+  bool stat(long &size, long &time);
+  bool load();
+  int find(const char* key);
+  void indexDataFile();
+  void indexMapFile();
+
+ public:
+  ObsIndex(const char* file);
+  static ObsIndex* forDataFile(const char* file);
+  static ObsIndex* forMapFile(const char* file);
+  bool isCurrent();
+  bool has(const char* key);
+  std::string getString(const char* key);
+  double getDouble(const char* key);
+  int getInt(const char* key);
+  void set(const char* key, const std::string &value);
+  void set(const char* key, double value);
+  void set(const char* key, int value);
+  bool save();
+};
+
+#endif
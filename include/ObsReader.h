@@ -0,0 +1,54 @@
+#ifndef _OBSREADER_H_
+#define _OBSREADER_H_
+
+#include <netcdfcpp.h>
+#include <string>
+#include <vector>
+
+#include "NcMap.h"
+
+///ObsReader - the raw data file of one observation, opened once
+/** TimePlace, Source, Telescope, Array and its Detectors all read
+    their signals and header values through the same reader, which
+    keeps the netcdf file open for the whole observation instead of
+    opening it for every variable.  Values are read straight into the
+    caller's buffers.  Signals can also be queued with request() and
+    read together with readRequested().
+
+    Classic format files (all of the LMT raw data) are memory mapped
+    through NcMap and read without any locking, so threads may read
+    them concurrently.  For anything else the netcdf library is used,
+    and as it is not thread safe every call then goes through the
+    dataio critical section and must not be made from inside it.
+**/
+class ObsReader
+{
+ protected:
+  std::string fileName;                     ///<the raw data file
+  NcMap *ncMap;                             ///<the mapped file, or NULL
+  NcFile *ncfid;                            ///<the open file, without a map
+  std::vector<std::string> requestNames;    ///<queued variables
+  std::vector<double*> requestData;         ///<and their destinations
+
+  NcVar* findVar(const char* name);
+
+ public:
+  ObsReader(const char* dataFile);
+  const char* getFileName();
+  bool has(const char* name);
+  bool hasAtt(const char* name);
+  long getLength(const char* name);
+  long getDimSize(const char* name);
+  std::vector<long> getShape(const char* name);
+  bool getValues(const char* name, double *data);
+  bool getValues(const char* name, int *data);
+  void request(const char* name, double *data);
+  bool readRequested();
+  double getDouble(const char* name, long i=0);
+  int getInt(const char* name, long i=0);
+  std::string getString(const char* name);
+  std::string getAttString(const char* name);
+  ~ObsReader();
+};
+
+#endif
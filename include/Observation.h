@@ -6,6 +6,8 @@
 #include "Array.h"
 #include "Map.h"
 #include "Telescope.h"
+#include "TiledMap.h"
+#include "MapProjection.h"
 
 ///Observation - a single observation (mapping) of one area of sky.
 /** The Observation class manages the mapmaking for a single observation
@@ -29,6 +31,9 @@ class Observation
   string ncdfFile;             ///<the output ncdf files containing everything
   bool saveTimestreams = false;
 
+  template <class Bins>
+  void binSamples(Array* a, MatDoub &tmpwt, Bins &bins);
+
  public:
   //dimensions
   int nrows = 0;                   ///<number of rows in the image
@@ -45,6 +50,7 @@ class Observation
   Map* kernel = nullptr;                 ///<kernel map
   Map* inttime = nullptr;                ///<inttime map (in seconds)
   MatDoub noiseMaps;           ///<array of noise map for each observaiton
+  TiledMap* tiles = nullptr;   ///<sparse storage of all maps if mapTileSize>0
 
   MatDoub beammapSignal;       ///<array of detector beammap signal values
   MatDoub beammapWeight;       ///<array of detector beammap weight values
@@ -54,8 +60,7 @@ class Observation
   //absolute coordinates
   double pixelSize=0;           ///<map pixel size in radians
   VecDoub masterGrid;         ///<map center coordinates (sky tangent point)
-  MatDoub xCoordsAbs;         ///<matrix of absolute on-sky x-coordinates
-  MatDoub yCoordsAbs;         ///<matrix of absolute on-sky y-coordinates
+  MapProjection projection;   ///<absolute on-sky coordinates of the map grid
 
   Array * array = nullptr;
   Telescope *tel = nullptr;
@@ -65,10 +70,14 @@ class Observation
   MatDoub calculateWeights(Array* a, Telescope* tel);
   bool generateBeammaps(Array* a, Telescope* tel);
   bool generateMaps(Array* a, Telescope* tel);
+  bool generateTiledMaps(Array* a, Telescope* tel);
+  bool densifyMaps();
+  bool isTiled();
   bool histogramSignal();
   bool histogramSignal(double cc);
   bool histogramSignal(int nbins, double cc);
   void mapGenerationPrep(Array* a);
+  void physToMapIndex(double ra, double dec, int* irow, int* icol);
   bool signalMapPsd();
   bool signalMapPsd(double cc);
   bool writeBeammapsToFits(string filename);
@@ -0,0 +1,39 @@
+#ifndef _PCAMODES_H_
+#define _PCAMODES_H_
+
+#include <netcdfcpp.h>
+#include <vector>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+
+#include "nr3.h"
+
+///PcaModes - per-scan record of a PCA clean
+/** One slot per scan holding the eigenvalues that were computed, the
+    eigenvectors of the modes that were cut, how many modes were cut
+    and how many subspace iterations it took (0 for a full
+    eigen-solve).  The slots are allocated with resize() before the
+    scans are cleaned and each scan only writes its own slot, so scans
+    can be cleaned in parallel without locking.
+**/
+class PcaModes
+{
+ protected:
+  vector<VecDoub> eValues;       ///<computed eigenvalues of each scan
+  vector<MatDoub> eVectors;      ///<nDetectors x nCut cut modes of each scan
+  VecInt nCut;                   ///<number of modes cut in each scan
+  VecInt nIterations;            ///<subspace iterations used in each scan
+
+ public:
+  void resize(int nScans);
+  void store(int scan, const gsl_vector *eVals, int nValues,
+             const gsl_matrix *eVecs, int nModesCut, int nIter);
+  int getNScans() const;
+  int getNCut(int scan) const;
+  int getNIterations(int scan) const;
+  const VecDoub& getEValues(int scan) const;
+  const MatDoub& getEVectors(int scan) const;
+  bool writeToNcdf(NcFile &ncfid, NcDim *scanDim, NcDim *detectorDim) const;
+};
+
+#endif
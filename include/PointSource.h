@@ -4,6 +4,7 @@
 #include "nr3.h"
 #include "AnalParams.h"
 #include "Map.h"
+#include "MapProjection.h"
 
 ///PointSource - what SourceLocate::findSources() found
 /**The PointSource class contains all information about the
@@ -23,8 +24,7 @@ public:
   double* mapWeight;               ///<parent weight map pointer
   double* mapRowCoordsPhys;        ///<parent map phys row coords pointer
   double* mapColCoordsPhys;        ///<parent map phys column coords pointer
-  double* mapXCoordsAbs;           ///<parent map absolute x coords pointer
-  double* mapYCoordsAbs;           ///<parent map absolute y coords pointer
+  const MapProjection* mapProjection; ///<parent map projection pointer
   int mapNRows;                    ///<number rows in parent map
   int mapNCols;                    ///<number columns in parent map
 
@@ -67,8 +67,7 @@ public:
                   double *mapWeight,
 		  double *mapRowCoordsPhys,
                   double* mapColCoordsPhys,
-		  double* mapXCoordsAbs,
-                  double* mapYCoordsAbs,
+		  const MapProjection* mapProjection,
 		  int mapNRows, int mapNCols,
 		  double pixelSize, std::string parentMapFile);
   bool makePostageStamp();
@@ -1,15 +1,20 @@
 #ifndef _SBSM_h_
 #define _SBSM_h_
 
+#include <vector>
 #include <suitesparse/cs.h>
 #include <gsl/gsl_bspline.h>
 #include <gsl/gsl_vector.h>
 
 #include "nr3.h"
+#include "BandedCholesky.h"
 
 ///SBSM (Sparse B-Spline Matrix).
 ///This class calculates and hold the base matrix for a B-spline of a given order,
 ///samples and number of breaks.
+///The normal matrix B B^T is banded and the same for every fitted vector, so
+///it is factored once and any number of vectors are fitted as a single multiple
+///right hand side solve with fitCoefficients() and expanded with evaluate().
 
 class SBSM{
 	private:
@@ -23,7 +28,7 @@ class SBSM{
 		gsl_bspline_workspace *bsw;
 		cs *baseMatrix;
 		cs *baseMatrix_t;
-		cs *btbMatrix;
+		BandedCholesky btbMatrix;
 
 		void createBaseMatrix();
 		void destroyBaseMatrix();
@@ -33,8 +38,10 @@ class SBSM{
 		cs *getBaseMatrix_t();
 		SBSM (size_t order, size_t nSamples, size_t nBreaks);
 		void resize(size_t order, size_t nSamples, size_t nBreaks);
-		VecDoub fitData (double *dataVector, size_t nSamples);
-		VecDoub fitData (VecDoub dataVector);
+		void fitCoefficients(const std::vector<const double*> &data, MatDoub &coeff);
+		void evaluate(const MatDoub &coeff, size_t k, double *templateOut);
+		VecDoub fitData (const double *dataVector, size_t nSamples);
+		VecDoub fitData (const VecDoub &dataVector);
 		~SBSM();
 };
 
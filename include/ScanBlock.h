@@ -0,0 +1,38 @@
+#ifndef _SCANBLOCK_H_
+#define _SCANBLOCK_H_
+
+#include <gsl/gsl_matrix.h>
+
+#include "nr3.h"
+#include "Array.h"
+#include "Telescope.h"
+
+///ScanBlock - one scan of all good detectors in contiguous storage
+/** data, kernel and flags are nDetectors x nSamples row major
+    matrices, detector i being dataArray->detectors[di[i]].  Cleaners
+    work on them in place, through the gsl views when they need BLAS,
+    and the data and kernel are copied back to the detectors with
+    scatter().  The flags are read only.  If the detectors have no
+    kernel timestreams the kernel is all zeros and is not copied back.
+**/
+class ScanBlock
+{
+ public:
+  int scan;                     ///<scan index
+  int si;                       ///<first sample of the scan
+  int nSamples;                 ///<samples in the scan
+  int nDetectors;               ///<number of good detectors
+  int *di;                      ///<indices of the good detectors
+  bool hasKernel;               ///<the detectors have kernel timestreams
+  MatDoub data;                 ///<detector values
+  MatDoub kernel;               ///<kernel values
+  MatDoub flags;                ///<sample flags, 1 for good samples
+
+  void gather(Array *dataArray, Telescope *telescope, int scan);
+  void scatter(Array *dataArray);
+  gsl_matrix_view dataMatrix();
+  gsl_matrix_view kernelMatrix();
+  gsl_matrix_view flagMatrix();
+};
+
+#endif
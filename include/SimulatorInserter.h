@@ -16,7 +16,7 @@ class SimulatorInserter{
 		void init();
 		void createNoiseGenerator();
 		void deleteNoiseGenerator();
-		VecDoub createNoiseSignal(Detector det);
+		double getNoiseSdev(Detector &det);
 	protected:
 		double atmFreq;
 		double noiseChunk;
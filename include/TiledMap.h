@@ -0,0 +1,65 @@
+#ifndef _TILEDMAP_H_
+#define _TILEDMAP_H_
+
+#include <netcdfcpp.h>
+#include <string>
+#include <vector>
+
+#include "nr3.h"
+#include "NcCompression.h"
+
+///TiledMap - sparse, tiled storage for a set of co-registered map planes
+/** The nrows x ncols map grid is divided into square tiles of
+    tileSize x tileSize pixels.  A tile is allocated the first time one
+    of its pixels is touched and holds all of the planes (signal,
+    weight, kernel, noise, ...) for that patch of the sky, so memory
+    scales with the coverage footprint instead of with the bounding box
+    of all detector tracks.  Pixels in tiles that were never hit read
+    as zero.  Inside a tile each plane is stored row major and the
+    planes follow each other, i.e. the planes of a pixel are
+    getPlaneStride() doubles apart.
+**/
+class TiledMap
+{
+ protected:
+  int nrows;                        ///<number of rows in the full map
+  int ncols;                        ///<number of columns in the full map
+  int tileSize;                     ///<tile side length in pixels
+  int nTileRows;                    ///<number of tile rows covering the map
+  int nTileCols;                    ///<number of tile columns covering the map
+  vector<string> planeNames;        ///<names of the stored planes
+  vector<int> tileSlot;             ///<storage slot of each tile, -1 if empty
+  vector<int> slotTile;             ///<tile id (row major) of each slot
+  vector<vector<double> > tiles;    ///<tile storage, one entry per slot
+
+  int allocateTile(int tileId);
+
+ public:
+  TiledMap(int nr, int nc, int tsz, const vector<string> &planes);
+  int getNrows() const;
+  int getNcols() const;
+  int getTileSize() const;
+  int getNPlanes() const;
+  int getPlaneIndex(const string &name) const;
+  size_t getPlaneStride() const;
+  int getNTiles() const;
+  int getNTileIds() const;
+  int getTileId(int irow, int icol) const;
+  int getTileRow0(int slot) const;
+  int getTileCol0(int slot) const;
+  double* getTile(int slot, int plane);
+  const double* getTile(int slot, int plane) const;
+  double* pixel(int irow, int icol);
+  void allocateTiles(const vector<char> &hit);
+  double get(int plane, int irow, int icol) const;
+  size_t getAllocatedBytes() const;
+  void toDense(int plane, MatDoub &dense) const;
+  bool writeToNcdf(NcFile &ncfid,
+                   const NcCompression &comp=NcCompression(),
+                   const vector<NcType> &planeTypes=vector<NcType>()) const;
+  static bool isTiledFile(NcFile &ncfid);
+  static TiledMap* readFromNcdf(NcFile &ncfid, const vector<string> &planes,
+                                int tileSize);
+};
+
+#endif
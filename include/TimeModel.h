@@ -0,0 +1,49 @@
+#ifndef _TIMEMODEL_H_
+#define _TIMEMODEL_H_
+
+#include "nr3.h"
+
+class TimePlace;
+
+///TimeModel - tabulated ephemeris quantities of one observation
+/** Everything the sky transformations need from NOVAS that depends
+    only on time is evaluated once per observation on a coarse grid of
+    nodes spanning the observation's detUtc+timeOffset: the rotation
+    from the true equator and equinox of date to the ICRS (nutation,
+    precession and frame tie), the velocity of the geocenter and of
+    the telescope in units of c (aberration), the direction of the Sun
+    and its light deflection, and the apparent sidereal time.  Between
+    nodes these are interpolated linearly and the conversions become
+    small matrix-vector products done in parallel over blocks of
+    samples, with no library calls or critical sections.  The
+    interpolation error, measured against NOVAS at the middle of every
+    node interval, is reported when the model is built.
+**/
+class TimeModel
+{
+ protected:
+  int nNodes;                   ///<number of nodes
+  double hour0;                 ///<time of the first node [hours]
+  double step;                  ///<node spacing [hours]
+  double jdUtc0;                ///<julian date at 0h UTC of the obs date
+  double timeOffset;            ///<offset added to detUtc [hours]
+  double longitude;             ///<telescope longitude [rad]
+  double latitude;              ///<telescope latitude [rad]
+  double elevation;             ///<telescope elevation [m]
+  MatDoub table;                ///<node values, columns in TimeModel.cpp
+  double rotError;              ///<interpolation error of the vectors [rad]
+  double gastError;             ///<interpolation error of gast [rad]
+
+  void evaluate(double hour, double *node);
+  void interpolate(double hour, double *node) const;
+
+ public:
+  TimeModel(TimePlace* timePlace);
+  void apparentToIcrs(const double *detUtc, const double *ra,
+                      const double *dec, double *ira, double *idec,
+                      int nSamples) const;
+  void icrsToAzEl(const double *detUtc, const double *ra, const double *dec,
+                  double *az, double *el, int nSamples) const;
+};
+
+#endif
@@ -2,6 +2,9 @@
 #define _TIMEPLACE_H_
 
 #include "AnalParams.h"
+#include "TimeResampler.h"
+
+class TimeModel;
 
 ///TimePlace - keeps track of where and when.
 /** The TimePlace object simply keeps the time and telescope location.
@@ -17,6 +20,7 @@ protected:
 
   const char* dataFile;        ///<netcdf data file for raw data
   int nSamples;                ///<number of data samples
+  TimeModel* timeModel;        ///<ephemeris tables, built on first use
 
   //protected methods
   bool getLMTTiming();
@@ -45,9 +49,11 @@ public:
   int     year;                 ///<year of data file
   int     month;                ///<month of data file
   int     day;                  ///<day of data file
+  TimeResampler toDetectors;    ///<telUtcUnique+timeOffset to detUtc
 
   //constructor
   TimePlace(AnalParams* ap);
+  TimeModel* getTimeModel();
   ~TimePlace();
 };
 
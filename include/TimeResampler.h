@@ -0,0 +1,31 @@
+#ifndef _TIMERESAMPLER_H_
+#define _TIMERESAMPLER_H_
+
+#include <vector>
+#include "nr3.h"
+
+///TimeResampler - linear interpolation of many signals onto one time axis
+/** Holds, for every output sample, the index of the knot below it and
+    the interpolation weight of the knot above.  These depend only on
+    the two time axes so they are found once, with setup(), and then
+    used to resample any number of signals with resample().  The
+    results are the same as those of interpolateLinear() on the same
+    axes, including its treatment of the ends.
+**/
+class TimeResampler
+{
+ protected:
+  int nKnots;                   ///<number of input (knot) samples
+  int nSamples;                 ///<number of output samples
+  VecInt lo;                    ///<knot at or below each output sample
+  VecDoub w;                    ///<weight of knot lo+1
+
+ public:
+  TimeResampler();
+  void setup(const double *knots, int nKnots, const double *x, int nSamples);
+  void resample(const vector<double*> &signals, const int *knotIndex) const;
+  int getNKnots() const;
+  int getNSamples() const;
+};
+
+#endif
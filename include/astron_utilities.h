@@ -38,6 +38,10 @@ bool absToPhys(double* absRa, double* absDec,
 	       double  centerRa, double centerDec,
 	       double* physRa, double* physDec,
 	       int nSamples);
+bool absToPhys(double* absRa, double* absDec, 
+	       double* centerRa, double* centerDec,
+	       double* physRa, double* physDec,
+	       int nSamples);
 bool parallacticAngle(double* hourAngle, double* dec, double latitude,
 		      int nSamples, double* paraAngle);
 bool azElToRaDec2000(TimePlace *timePlace, double* az, double* el, 
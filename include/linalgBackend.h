@@ -0,0 +1,24 @@
+#ifndef _LINALG_BACKEND_H_
+#define _LINALG_BACKEND_H_
+
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+
+///Dense linear algebra backend
+/** The gsl_blas calls go through whatever CBLAS the build links:
+    GSL's reference gslcblas by default or, with WITH_OPTIMIZED_BLAS,
+    OpenBLAS, BLIS or MKL.  These functions cover what the CBLAS
+    interface does not: the symmetric eigen-solves (LAPACK dsyevr when
+    HAVE_LAPACK is defined, gsl_eigen_symmv otherwise) and the number
+    of threads the library may use for each call.
+**/
+
+const char* getBlasBackend();
+int setBlasThreads(int nBlasThreads, int nTeamThreads);
+bool symmEigen(gsl_matrix *a, gsl_vector *eVals, gsl_matrix *eVecs);
+bool symmEigenValues(gsl_matrix *a, gsl_vector *eVals);
+bool symmEigenTop(const gsl_matrix *a, int nTop, gsl_vector *eVals,
+                  gsl_matrix *eVecs, long seed, const gsl_matrix *start=NULL,
+                  int *nIter=NULL);
+
+#endif
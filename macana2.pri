@@ -1,9 +1,21 @@
 DEFINES += QT_DEPRECATED_WARNINGS
 MACANA_LIB_DEPS = -L/usr/local/lib -lgsl -lgslcblas -lm -lnetcdf_c++ -lnetcdf -lfftw3 -lcxsparse -lCCfits -lcfitsio
+# qmake CONFIG+=openblas links OpenBLAS/LAPACK in place of gslcblas
+openblas {
+    MACANA_LIB_DEPS -= -lgslcblas
+    MACANA_LIB_DEPS += -lopenblas
+    DEFINES += HAVE_LAPACK HAVE_OPENBLAS
+}
+# qmake CONFIG+=float32 stores the detector timestreams in single precision
+float32 {
+    DEFINES += FLOAT32_SAMPLES
+}
 MACANA_LIB_OUT = macana2
 CONFIG += \
     c++1z \
     sdk_no_version_check
+# lets the branch free math of gnomonic.h vectorize
+QMAKE_CXXFLAGS += -fno-math-errno -fno-trapping-math
 INCLUDEPATH += \
     /usr/local/include \
     $$IN_PWD/include \
@@ -2,8 +2,11 @@ CONFIG += ordered
 TEMPLATE = subdirs
 SUBDIRS += \
     macana_core \
+    mapcompare \
     test \
     beammap_gui
 macana_core.file = macana_core.pro
+mapcompare.file = mapcompare.pro
+mapcompare.depends = macana_core
 test.depends = macana_core
 beammap_gui.depends = macana_core
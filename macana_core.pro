@@ -14,22 +14,35 @@ CONFIG += staticlib
 SOURCES += \
     Analysis/AnalParams.cpp \
     Analysis/SimParams.cpp \
+    Analysis/JobScheduler.cpp \
+    Analysis/Distributor.cpp \
+    Analysis/Journal.cpp \
     Clean/AzElTemplateCalculator.cpp \
     Clean/Clean.cpp \
     Clean/Clean2dStripe.cpp \
+    Clean/CleanChain.cpp \
     Clean/CleanBspline.cpp \
+    Clean/BsplineBasisCache.cpp \
     Clean/CleanHigh.cpp \
     Clean/CleanPCA.cpp \
+    Clean/PcaModes.cpp \
+    Clean/CleanRegistry.cpp \
     Clean/CleanSelector.cpp \
+    Clean/ScanBlock.cpp \
     Mapmaking/Coaddition.cpp \
     Mapmaking/CompletenessSim.cpp \
     Mapmaking/Map.cpp \
     Mapmaking/NoiseRealizations.cpp \
+    Mapmaking/NoiseStore.cpp \
     Mapmaking/Observation.cpp \
+    Mapmaking/TiledMap.cpp \
     Mapmaking/PointSource.cpp \
     Mapmaking/WienerFilter.cpp \
     Observatory/Array.cpp \
     Observatory/Detector.cpp \
+    Observatory/ObsReader.cpp \
+    Observatory/NcMap.cpp \
+    Observatory/ObsIndex.cpp \
     Observatory/Telescope.cpp \
     Observatory/TimePlace.cpp \
     Simulate/MapNcFile.cpp \
@@ -37,11 +50,17 @@ SOURCES += \
     Simulate/Subtractor.cpp \
     Sky/Source.cpp \
     Sky/astron_utilities.cpp \
+    Sky/MapProjection.cpp \
+    Sky/TimeModel.cpp \
+    Utilities/BandedCholesky.cpp \
     Utilities/BinomialStats.cpp \
     Utilities/GslRandom.cpp \
+    Utilities/NcCompression.cpp \
     Utilities/SBSM.cpp \
+    Utilities/TimeResampler.cpp \
     Utilities/convolution.cpp \
     Utilities/gaussFit.cpp \
+    Utilities/linalgBackend.cpp \
     Utilities/mpfit.cpp \
     Utilities/sparseUtilities.cpp \
     Utilities/tinyxml2.cpp \
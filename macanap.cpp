@@ -21,6 +21,7 @@ using namespace std;
 #include "Source.h"
 #include "AnalParams.h"
 #include "vector_utilities.h"
+#include "linalgBackend.h"
 #include "CleanPCA.h"
 #include "CleanBspline.h"
 #include "CleanSelector.h"
@@ -29,6 +30,9 @@ using namespace std;
 #include "MapNcFile.h"
 #include "SimulatorInserter.h"
 #include "Subtractor.h"
+#include "JobScheduler.h"
+#include "Distributor.h"
+#include "Journal.h"
 
 
 
@@ -54,6 +58,16 @@ int main(int nArgs, char* args[])
   
   AnalParams* ap = new AnalParams(apXml);
   if (ap->getBeammapping()) ap->BeamMapError("Error in xml file");
+
+  //the other processes of this run, if a launcher started several
+  Distributor dist(ap->getMapPath().c_str());
+  ap->setDistributor(&dist);
+
+  //the record of finished work, read back when resuming; every rank
+  //reads the journals before any rank adds to them
+  Journal journal(ap);
+  ap->setJournal(&journal);
+  dist.barrier("journal");
   Array *array=NULL;
   TimePlace *timePlace = NULL;
   Source *source = NULL;
@@ -61,7 +75,6 @@ int main(int nArgs, char* args[])
   Observation *obs = NULL;
   AnalParams *tap = NULL;
   string ofile;
-  int nFiles = ap->getNFiles();
   int filei=0;
   int tid = -1;
   Clean *cleaner=NULL;
@@ -85,6 +98,10 @@ int main(int nArgs, char* args[])
   omp_set_num_threads(ap->getNThreads());
   //omp_set_nested(1);
 #endif
+  //BLAS only gets threads of its own when the observation loop is serial
+  int nBlas = setBlasThreads(ap->getBlasThreads(), ap->getNThreads());
+  cerr << "Using " << getBlasBackend() << " with " << nBlas;
+  cerr << " thread(s) per call." << endl;
   
   
   cerr << endl;
@@ -95,23 +112,32 @@ int main(int nArgs, char* args[])
   if(ap->getMapIndividualObservations())
     {
       
+      //size the observations from their indexes so that the largest
+      //go first and the memory budget is kept
+      JobScheduler scheduler(ap, ap->getNThreads());
+#if defined (_OPENMP)
+      //threads left without a file go to the stages of the others
+      omp_set_max_active_levels(2);
+#endif
+
       //Begin the parallel execution.  Non threadsafe operations are
       //walled off with the "omp critical" pragma.
       
-#pragma omp parallel shared (ap,nFiles,simMap, subMap, cerr, cout) private(tap,array, timePlace, source, telescope, obs,cleaner, filei, di,i, tid,ofile) default (none)
+#pragma omp parallel shared (ap,simMap, subMap, scheduler, cerr, cout) private(tap,array, timePlace, source, telescope, obs,cleaner, filei, di,i, tid,ofile) default (none)
       {
 	
 	//cycle through the data files to do the reductions
-#pragma omp for schedule(dynamic)
-	for(filei=0;filei<nFiles;filei++){
+	while((filei = scheduler.nextJob()) >= 0){
 #if defined(_OPENMP)
 	  tid = omp_get_thread_num() + 1;
+	  omp_set_num_threads(scheduler.threadsPerJob());
 #else
 	  tid = 0;
 #endif
 	  
-	  //The following dataio section is walled off since netcdf is not
-	  //threadsafe.
+	  //The raw data file is opened once per observation by the
+	  //AnalParams copy and read through its ObsReader, which walls off
+	  //every netcdf call since netcdf is not threadsafe.
 	  
 	  //set the Analysis Parameters
 	  tap = new AnalParams(ap);
@@ -121,11 +147,8 @@ int main(int nArgs, char* args[])
 	  cerr << "Main("<<tid<<"): Creating an Array object." << endl;
 	  array = new Array(tap);
 	  
-#pragma omp critical (dataio)
-	  {
-	    cerr << "Main("<<tid<<"): Populating the array with detectors." << endl;
-	    array->populate();
-	  }
+	  cerr << "Main("<<tid<<"): Populating the array with detectors." << endl;
+	  array->populate();
 	  //make a TimePlace
 	  cerr << "Main("<<tid<<"): Creating the time and place." << endl;
 	  
@@ -159,6 +182,7 @@ int main(int nArgs, char* args[])
 	       << "to mastergrid tangent." << endl;
 	  telescope->absToPhysEqPointing();
 	  cerr << "Main("<<tid<<"): Generating pointing for each detector." << endl;
+#pragma omp parallel for schedule(dynamic)
 	  for(i=0;i<array->getNDetectors();i++){
 	    array->detectors[di[i]].getPointing(telescope, timePlace, source);
 	    array->detectors[di[i]].getAzElPointing(telescope);
@@ -169,6 +193,7 @@ int main(int nArgs, char* args[])
 	  
 	  //do the first round of despiking (steps 1 and 2)
 	  cerr << "Main("<<tid<<"): Finding and flagging spikes." << endl;
+#pragma omp parallel for schedule(dynamic)
 	  for(i=0;i<array->getNDetectors();i++){
 	    array->detectors[di[i]].despike(tap->getDespikeSigma());
 	  }
@@ -181,12 +206,14 @@ int main(int nArgs, char* args[])
 	  
 	  //make a fake source for psf detemination
 	  cerr << "Main("<<tid<<"): making kernel timestreams." << endl;
+#pragma omp parallel for schedule(dynamic)
 	  for(i=0;i<array->getNDetectors();i++){
 	    array->detectors[di[i]].makeKernelTimestream(telescope);
 	  }
 	  
 	  //lowpass the data
 	  cerr << "Main("<<tid<<"): Lowpassing the detector data." << endl;
+#pragma omp parallel for schedule(dynamic)
 	  for(i=0;i<array->getNDetectors();i++){
 	    array->detectors[di[i]].lowpass(&array->digFiltTerms[0],
 					    array->nFiltTerms);
@@ -203,6 +230,7 @@ int main(int nArgs, char* args[])
 	  //generate the pointing signals
 	  
 	  cerr << "Main("<<tid<<"): Estimate average extinction." << endl;
+#pragma omp parallel for schedule(dynamic)
 	  for(i=0;i<array->getNDetectors();i++){
 	    array->detectors[di[i]].estimateExtinction(array->getAvgTau());
 	  }
@@ -233,6 +261,9 @@ int main(int nArgs, char* args[])
 	  }
 	  
 	  
+#if defined(_OPENMP)
+	  omp_set_num_threads(scheduler.threadsPerJob());
+#endif
 	  cleaner = CleanSelector::getCleaner(array, telescope);
 	  cout << "Main("<<tid<<"): Cleaning Process Initiated." << endl;
 	  cleaner->clean();
@@ -248,8 +279,12 @@ int main(int nArgs, char* args[])
 	    exit(-1);
 	  }
 	  
+#if defined(_OPENMP)
+	  omp_set_num_threads(scheduler.threadsPerJob());
+#endif
 	  //calibrate timestreams
 	  cerr << "Main("<<tid<<"): Calibrating detector signals." << endl;
+#pragma omp parallel for schedule(dynamic)
 	  for(i=0;i<array->getNDetectors();i++){
 	    array->detectors[di[i]].estimateExtinction(array->getAvgTau());
 	    array->detectors[di[i]].calibrate();
@@ -259,6 +294,7 @@ int main(int nArgs, char* args[])
 	  //apply the same hack that is done in the IDL utilities by
 	  //knocking back absurdly highly weighted detectors.
 	  cerr << "Main("<<tid<<"): Generating scan weights." << endl;
+#pragma omp parallel for schedule(dynamic)
 	  for(i=0;i<array->getNDetectors();i++){
 	    array->detectors[di[i]].calculateScanWeight(telescope);
 	  }
@@ -289,6 +325,9 @@ int main(int nArgs, char* args[])
 	  //delete []medianWt;
 	  
 	  //create the maps
+#if defined(_OPENMP)
+	  omp_set_num_threads(scheduler.threadsPerJob());
+#endif
 	  cerr << "Main("<<tid<<"): Generating the observation maps." << endl;
 	  obs= new Observation(tap);
 	  obs->generateMaps(array, telescope);
@@ -299,12 +338,21 @@ int main(int nArgs, char* args[])
 	  {
 	    obs->writeObservationToNcdf(ofile);
 	  }
+	  //index the map file for the coaddition while it is fresh
+	  delete ObsIndex::forMapFile(ofile.c_str());
+	  //so that a resumed run won't reduce it again
+	  ap->getJournal()->markDone(ap->getJournal()->reduceStamp(filei),
+				     "reduce " + ofile, ofile);
 	  //fit obs signal map's central region to gaussian
 	  if (ap->getAzelMap()!=0){
 	    cerr << "Main("<<tid<<"): Fitting obs signal to gaussian." << endl;
+	    obs->densifyMaps();
 	    obs->signal->fitToGaussian();
 	  }
 	  
+	  //the psd and histogram are diagnostics that are not written
+	  //out, skip them for tiled maps rather than expanding to full size
+	  if(!obs->isTiled()){
 	  //calculate the obs signal map psd with coverage cut of 0.9
 	  cerr << "Main("<<tid<<"): generating the psd of the obs.signal map."
 	       << endl;
@@ -314,6 +362,7 @@ int main(int nArgs, char* args[])
 	  cerr << "Main("<<tid<<"): generating the histogram of "
 	       << "the signal obsmap." << endl;
 	  obs->histogramSignal(ap->getCoverageThreshold());
+	  }
 	  
 	  
 	  
@@ -325,6 +374,7 @@ int main(int nArgs, char* args[])
 	  delete array;
 	  delete tap;
 	  cerr <<"Main("<<tid<<"): memory deallocation succeded."<<endl;
+	  scheduler.finishJob(filei);
 	}
 	
       }
@@ -341,7 +391,21 @@ int main(int nArgs, char* args[])
       cerr << endl;
     }
   
-  if(ap->getCoaddObservations()){
+  //the coaddition needs every map
+  dist.barrier("reduced");
+
+  if(ap->getCoaddObservations() && !dist.isRoot()){
+    //the other ranks add their share of the maps to the coaddition and
+    //make their share of the noise realizations, the root does the rest
+    Coaddition cmap(ap);
+    cmap.coaddMaps();
+    if(ap->getProduceNoiseMaps()){
+      NoiseRealizations noiseMaps(ap);
+      noiseMaps.generateNoiseRealizations(&cmap);
+    }
+  }
+
+  if(ap->getCoaddObservations() && dist.isRoot()){
     //coadd the maps
     cerr << "Main(): Coadding Maps." << endl;
     Coaddition cmap(ap);
@@ -397,15 +461,11 @@ int main(int nArgs, char* args[])
     	  cerr << "Main(): This automatically adds them to the ncdf files." << endl;
     	  wf.filterNoiseMaps(&noiseMaps);
 
-    	  //normalize the errors of the noise maps
-    	  cerr << "Main(): normalizing errors of filtered noise maps." << endl;
-    	  noiseMaps.normalizeErrors(ap->getCoverageThreshold());
-
-    	  //find the average rms of the filtered noise maps with coverage cut of 0.9
-    	  cerr << "Main(): calculating average rms of the filtered noise maps"
-    			  << endl;
-    	  cerr << "Main(): Using coverage cut of 0.9." << endl;
-    	  noiseMaps.calculateAverageFilteredRms(ap->getCoverageThreshold());
+    	  //normalize the errors of the noise maps, find their average rms
+    	  //and histogram them in a single pass over the realizations
+    	  cerr << "Main(): normalizing errors, rms and histograms of "
+    			  << "filtered noise maps." << endl;
+    	  noiseMaps.analyzeFilteredNoise(ap->getCoverageThreshold());
 
     	  //normalize the errors in the filtered signal map with coverage cut of 0.9
     	  cmap.normalizeErrors(noiseMaps.averageFilteredRms, ap->getCoverageThreshold());
@@ -414,7 +474,6 @@ int main(int nArgs, char* args[])
     	  //calculate the flux histograms of all filtered maps
     	  cerr << "Main(): finding histogram of filtered signal map." << endl;
     	  cmap.histogramFilteredSignal(ap->getCoverageThreshold());
-    	  noiseMaps.calcFilteredNoiseMapsHistogram(ap->getCoverageThreshold());
 
     	  cerr << "Main(): Making average noise histogram (filtered)." << endl;
     	  noiseMaps.makeAverageHistogram(1);
@@ -441,6 +500,7 @@ int main(int nArgs, char* args[])
   }
 
   //cleanup
+  dist.finish();
   delete ap;
   
   cerr << "Main(): Finished." << endl;
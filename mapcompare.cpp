@@ -0,0 +1,142 @@
+#include <netcdfcpp.h>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+#include "nr3.h"
+#include "TiledMap.h"
+
+void usage()
+{
+  cerr << "mapcompare: rms differences between the maps of two nc files." << endl;
+  cerr << "  calling syntax: " << endl;
+  cerr << "     ./mapcompare <reference.nc> <test.nc> [-t <tolerance>] [map ...]" << endl;
+  cerr << "  By default signal, kernel, weight and their filtered versions" << endl;
+  cerr << "  are compared, whichever are present in both files." << endl;
+  exit(1);
+}
+
+///reads map name of a dense or tiled file into map
+bool readMap(NcFile &ncfid, const string &name, MatDoub &map)
+{
+  bool tiled = TiledMap::isTiledFile(ncfid);
+  string vname = (tiled) ? name + "Tiles" : name;
+  if(!ncfid.get_var(vname.c_str())) return 0;
+  vector<string> planes(1, name);
+  TiledMap* tm = TiledMap::readFromNcdf(ncfid, planes, 0);
+  if(!tm) return 0;
+  tm->toDense(0, map);
+  delete tm;
+  return 1;
+}
+
+///compares the maps of two macana output files
+/** Meant for validating a change to the analysis against a reference
+    run: run the same analysis both ways and compare the coadded or
+    per-observation files, e.g. a build with single precision
+    timestreams (WITH_FLOAT32_SAMPLES) against the default double
+    precision one.  Either file may hold tiled maps
+    (mapTileSize), which are expanded first, so tiled output can be
+    checked against dense output.  For every map present in both files
+    the rms of the reference map, the rms and maximum of the difference
+    and their ratio are reported, over the pixels with positive weight
+    in the reference.  With a tolerance the exit status is 2 if any
+    relative rms difference exceeds it.
+**/
+int main(int nArgs, char* args[])
+{
+  if(nArgs < 3) usage();
+  string refFile = args[1];
+  string testFile = args[2];
+  double tolerance = -1.;
+  vector<string> names;
+  for(int i=3;i<nArgs;i++){
+    string a = args[i];
+    if(!a.compare("-t") || !a.compare("--tolerance")){
+      if(++i >= nArgs) usage();
+      tolerance = atof(args[i]);
+    } else names.push_back(a);
+  }
+  if(names.size() == 0){
+    const char* defaults[] = {"signal", "kernel", "weight", "filteredSignal",
+                              "filteredKernel", "filteredWeight"};
+    for(int i=0;i<6;i++) names.push_back(defaults[i]);
+  }
+
+  for(int f=0;f<2;f++){
+    ifstream fs((f) ? testFile.c_str() : refFile.c_str());
+    if(!fs.good()){
+      cerr << ((f) ? testFile : refFile) << " not found." << endl;
+      exit(1);
+    }
+  }
+
+  NcError err(NcError::silent_nonfatal);
+  NcFile ref(refFile.c_str(), NcFile::ReadOnly);
+  NcFile test(testFile.c_str(), NcFile::ReadOnly);
+  NcDim *rd = ref.get_dim("nrows");
+  NcDim *cd = ref.get_dim("ncols");
+  if(!rd || !cd || !test.get_dim("nrows") || !test.get_dim("ncols")){
+    cerr << "mapcompare: nrows and ncols dimensions are needed in both files"
+         << endl;
+    exit(1);
+  }
+  int nrows = rd->size();
+  int ncols = cd->size();
+  if(test.get_dim("nrows")->size() != nrows ||
+     test.get_dim("ncols")->size() != ncols){
+    cerr << "mapcompare: the maps have different sizes" << endl;
+    exit(1);
+  }
+
+  //the covered pixels
+  MatDoub weight;
+  bool haveWeight = readMap(ref, "weight", weight);
+  if(!haveWeight)
+    cerr << "mapcompare: no weight map, comparing all pixels" << endl;
+
+  cout << setw(16) << "map" << setw(14) << "rms(ref)" << setw(14)
+       << "rms(diff)" << setw(14) << "max|diff|" << setw(14)
+       << "rel rms" << endl;
+
+  bool pass = true;
+  int nCompared = 0;
+  MatDoub a, b;
+  for(size_t m=0;m<names.size();m++){
+    if(!readMap(ref, names[m], a) || !readMap(test, names[m], b)) continue;
+
+    double sumRef=0., sumDiff=0., maxDiff=0.;
+    long n=0;
+    for(int i=0;i<nrows;i++)
+      for(int j=0;j<ncols;j++){
+        if(haveWeight && !(weight[i][j] > 0.)) continue;
+        double d = b[i][j]-a[i][j];
+        sumRef += a[i][j]*a[i][j];
+        sumDiff += d*d;
+        if(abs(d) > maxDiff) maxDiff = abs(d);
+        n++;
+      }
+    if(n == 0) continue;
+    double rmsRef = sqrt(sumRef/n);
+    double rmsDiff = sqrt(sumDiff/n);
+    double rel = (rmsRef > 0.) ? rmsDiff/rmsRef : rmsDiff;
+    cout << setw(16) << names[m] << setw(14) << rmsRef << setw(14)
+         << rmsDiff << setw(14) << maxDiff << setw(14) << rel << endl;
+    if(tolerance >= 0. && rel > tolerance) pass = false;
+    nCompared++;
+  }
+
+  if(nCompared == 0){
+    cerr << "mapcompare: no maps in common" << endl;
+    exit(1);
+  }
+  if(!pass){
+    cout << "mapcompare: relative rms difference above " << tolerance << endl;
+    return 2;
+  }
+  return 0;
+}
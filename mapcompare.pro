@@ -0,0 +1,12 @@
+include(macana2.pri)
+TARGET = mapcompare
+TEMPLATE = app
+
+CONFIG -= app_bundle
+CONFIG -= qt
+
+SOURCES += \
+    mapcompare.cpp
+
+LIBS += $$MACANA_LIB_DEPS -L$$OUT_PWD -l$$MACANA_LIB_OUT
+PRE_TARGETDEPS += $$OUT_PWD/lib$${MACANA_LIB_OUT}.a
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <random>
+#include <cmath>
+
+#include "nr3.h"
+#include "astron_utilities.h"
+#include "gnomonic.h"
+
+namespace {
+
+// the scalar projections as they were before gnomonic.h
+void scalarAbsToPhys(double absRa, double absDec, double centerRa,
+                     double centerDec, double *physRa, double *physDec)
+{
+    double tRa = (absRa > PI) ? absRa - TWO_PI : absRa;
+    centerRa = (centerRa > PI) ? centerRa - TWO_PI : centerRa;
+    double sCD = sin(centerDec);
+    double cCD = cos(centerDec);
+    double cosc = sCD * sin(absDec) + cCD * cos(absDec) * cos(tRa - centerRa);
+    if (cosc == 0.) {
+        *physRa = 0.;
+        *physDec = 0.;
+    } else {
+        *physRa = cos(absDec) * sin(tRa - centerRa) / cosc;
+        *physDec = (cCD * sin(absDec) -
+                    sCD * cos(absDec) * cos(tRa - centerRa)) / cosc;
+    }
+}
+
+void scalarPhysToAbs(double pra, double pdec, double cra, double cdec,
+                     double *ara, double *adec)
+{
+    double rho = sqrt(pow(pra, 2) + pow(pdec, 2));
+    double c = atan(rho);
+    if (c == 0.) {
+        *ara = cra;
+        *adec = cdec;
+    } else {
+        double ccwhn0 = cos(c);
+        double scwhn0 = sin(c);
+        double ccdec = cos(cdec);
+        double scdec = sin(cdec);
+        *adec = asin(ccwhn0 * scdec + pdec * scwhn0 * ccdec / rho);
+        *ara = cra + atan(pra * scwhn0 /
+                          (rho * ccdec * ccwhn0 - pdec * scdec * scwhn0));
+    }
+}
+
+class AstronUtilitiesTest : public ::testing::Test
+{
+protected:
+    AstronUtilitiesTest(): e2(12345) {}
+
+    std::mt19937 e2;
+    std::uniform_real_distribution<double> uniform{0., 1.};
+};
+
+TEST_F(AstronUtilitiesTest, SimdKernels) {
+    double maxSin = 0., maxCos = 0., maxAtan = 0., maxAsin = 0.;
+    for (int i = 0; i < 100000; ++i) {
+        double x = 40. * uniform(e2) - 20.;
+        double s, c;
+        simdSincos(x, &s, &c);
+        maxSin = std::max(maxSin, std::abs(s - sin(x)));
+        maxCos = std::max(maxCos, std::abs(c - cos(x)));
+        double t = tan(PI * (uniform(e2) - 0.5));
+        maxAtan = std::max(maxAtan, std::abs(simdAtan(t) - atan(t)));
+        double a = 1.998 * uniform(e2) - 0.999;
+        maxAsin = std::max(maxAsin, std::abs(simdAsin(a) - asin(a)));
+    }
+    EXPECT_LT(maxSin, 1e-15);
+    EXPECT_LT(maxCos, 1e-15);
+    EXPECT_LT(maxAtan, 1e-15);
+    EXPECT_LT(maxAsin, 1e-13);
+    EXPECT_DOUBLE_EQ(simdAtan(0.), 0.);
+    EXPECT_NEAR(simdAsin(1.), PIO2, 1e-15);
+}
+
+TEST_F(AstronUtilitiesTest, AbsToPhysMatchesScalar) {
+    const int n = 20000;
+    std::vector<double> ra(n), dec(n), cra(n), cdec(n);
+    std::vector<double> x(n), y(n), xs(n), ys(n);
+    double centerRa = TWO_PI * uniform(e2);
+    double centerDec = 2.8 * uniform(e2) - 1.4;
+    for (int i = 0; i < n; ++i) {
+        // within about 10 degrees of the tangent point
+        dec[i] = centerDec + 0.35 * (uniform(e2) - 0.5);
+        ra[i] = fmod(centerRa + 0.35 * (uniform(e2) - 0.5) + TWO_PI, TWO_PI);
+        cra[i] = fmod(ra[i] + 0.2 * (uniform(e2) - 0.5) + TWO_PI, TWO_PI);
+        cdec[i] = dec[i] + 0.2 * (uniform(e2) - 0.5);
+    }
+
+    absToPhys(&ra[0], &dec[0], centerRa, centerDec, &x[0], &y[0], n);
+    for (int i = 0; i < n; ++i) {
+        scalarAbsToPhys(ra[i], dec[i], centerRa, centerDec, &xs[i], &ys[i]);
+        EXPECT_NEAR(x[i], xs[i], 1e-14);
+        EXPECT_NEAR(y[i], ys[i], 1e-14);
+    }
+
+    absToPhys(&ra[0], &dec[0], &cra[0], &cdec[0], &x[0], &y[0], n);
+    for (int i = 0; i < n; ++i) {
+        scalarAbsToPhys(ra[i], dec[i], cra[i], cdec[i], &xs[i], &ys[i]);
+        EXPECT_NEAR(x[i], xs[i], 1e-14);
+        EXPECT_NEAR(y[i], ys[i], 1e-14);
+    }
+
+    // in place, as the callers use it
+    std::vector<double> ra2(ra), dec2(dec);
+    absToPhys(&ra2[0], &dec2[0], centerRa, centerDec, &ra2[0], &dec2[0], n);
+    for (int i = 0; i < n; ++i) {
+        scalarAbsToPhys(ra[i], dec[i], centerRa, centerDec, &xs[i], &ys[i]);
+        EXPECT_NEAR(ra2[i], xs[i], 1e-14);
+        EXPECT_NEAR(dec2[i], ys[i], 1e-14);
+    }
+}
+
+TEST_F(AstronUtilitiesTest, PhysToAbsMatchesScalar) {
+    const int n = 20000;
+    std::vector<double> px(n), py(n), cra(n), cdec(n);
+    std::vector<double> ra(n), dec(n);
+    for (int i = 0; i < n; ++i) {
+        px[i] = 0.35 * (uniform(e2) - 0.5);
+        py[i] = 0.35 * (uniform(e2) - 0.5);
+        cra[i] = TWO_PI * uniform(e2);
+        cdec[i] = 2.8 * uniform(e2) - 1.4;
+    }
+    px[0] = 0.;
+    py[0] = 0.;
+
+    physToAbs(&px[0], &py[0], &cra[0], &cdec[0], &ra[0], &dec[0], n);
+    EXPECT_EQ(ra[0], cra[0]);
+    EXPECT_EQ(dec[0], cdec[0]);
+    for (int i = 0; i < n; ++i) {
+        double ras, decs;
+        scalarPhysToAbs(px[i], py[i], cra[i], cdec[i], &ras, &decs);
+        EXPECT_NEAR(ra[i], ras, 1e-13);
+        EXPECT_NEAR(dec[i], decs, 1e-13);
+    }
+}
+
+TEST_F(AstronUtilitiesTest, RoundTrip) {
+    const int n = 1000;
+    std::vector<double> px(n), py(n), cra(n, 2.5), cdec(n, -0.4);
+    std::vector<double> ra(n), dec(n), x(n), y(n);
+    for (int i = 0; i < n; ++i) {
+        px[i] = 0.1 * (uniform(e2) - 0.5);
+        py[i] = 0.1 * (uniform(e2) - 0.5);
+    }
+    physToAbs(&px[0], &py[0], &cra[0], &cdec[0], &ra[0], &dec[0], n);
+    absToPhys(&ra[0], &dec[0], cra[0], cdec[0], &x[0], &y[0], n);
+    for (int i = 0; i < n; ++i) {
+        EXPECT_NEAR(x[i], px[i], 1e-14);
+        EXPECT_NEAR(y[i], py[i], 1e-14);
+    }
+}
+
+}  // namespace
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "nr3.h"
+#include "Distributor.h"
+
+namespace {
+
+// runs body as nRanks local processes, true if all of them exit 0
+template <typename F>
+bool runRanks(int nRanks, const char* runId, F body)
+{
+    std::vector<pid_t> pids;
+    for (int r = 0; r < nRanks; r++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            Distributor dist(".", r, nRanks, runId);
+            bool ok = body(dist);
+            dist.finish();
+            _exit(ok ? 0 : 1);
+        }
+        pids.push_back(pid);
+    }
+    bool ok = true;
+    for (pid_t pid : pids) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    return ok;
+}
+
+// clears the run directory a failed run leaves behind
+void removeRunDir(const std::string &runId)
+{
+    std::string dir = "./.macanaRun." + runId;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return;
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL) {
+        std::string f(e->d_name);
+        if (f != "." && f != "..") unlink((dir + "/" + f).c_str());
+    }
+    closedir(d);
+    rmdir(dir.c_str());
+}
+
+TEST(DistributorTest, SingleRankOwnsEverything) {
+    Distributor dist(".", 0, 1, "");
+    EXPECT_TRUE(dist.isRoot());
+    EXPECT_FALSE(dist.isDistributed());
+    VecDoub work(3, 1.);
+    dist.assignJobs(work);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_TRUE(dist.owns(i));
+        EXPECT_TRUE(dist.ownsTask(i));
+    }
+    double x[2] = {1., 2.};
+    dist.allReduce("x", x, 2);
+    EXPECT_EQ(x[0], 1.);
+    EXPECT_EQ(x[1], 2.);
+}
+
+TEST(DistributorTest, AssignJobsBalancesWork) {
+    double w[7] = {1., 9., 4., 4., 2., 8., 3.};
+    VecDoub work(7, w);
+    VecDoub load(3, 0.);
+    int nOwned = 0;
+    for (int r = 0; r < 3; r++) {
+        Distributor dist(".", r, 3, "assign");
+        dist.assignJobs(work);
+        for (int i = 0; i < 7; i++) {
+            if (dist.owns(i)) {
+                load[r] += work[i];
+                nOwned++;
+            }
+        }
+    }
+    unlink("./.macanaRun.assign/started.0");
+    rmdir("./.macanaRun.assign");
+    EXPECT_EQ(nOwned, 7);
+    EXPECT_EQ(load[0], 10.);
+    EXPECT_EQ(load[1], 11.);
+    EXPECT_EQ(load[2], 10.);
+}
+
+TEST(DistributorTest, AllReduceSumsOverRanks) {
+    for (int nRanks : {2, 3, 5}) {
+        std::string runId = "reduce" + std::to_string(nRanks);
+        bool ok = runRanks(nRanks, runId.c_str(), [&](Distributor &dist) {
+            long n = 1000;
+            std::vector<double> x(n);
+            for (long i = 0; i < n; i++) x[i] = dist.getRank() + i;
+            dist.allReduce("x", &x[0], n);
+            double s = nRanks*(nRanks-1)/2.;
+            for (long i = 0; i < n; i++)
+                if (x[i] != s + nRanks*i) return false;
+            dist.barrier("done");
+            return true;
+        });
+        EXPECT_TRUE(ok) << nRanks << " ranks";
+        struct stat st;
+        EXPECT_NE(stat(("./.macanaRun." + runId).c_str(), &st), 0);
+    }
+}
+
+TEST(DistributorTest, MessagesReachTheRoot) {
+    bool ok = runRanks(4, "messages", [](Distributor &dist) {
+        if (!dist.isRoot()) {
+            for (int k = 0; k < 12; k++) {
+                if (!dist.ownsTask(k)) continue;
+                std::vector<double> m(k+1, k);
+                dist.send("task" + std::to_string(k), &m[0], m.size());
+            }
+            return true;
+        }
+        for (int k = 0; k < 12; k++) {
+            if (dist.ownsTask(k)) continue;
+            VecDoub m;
+            dist.receive("task" + std::to_string(k), dist.taskOwner(k), m);
+            if (m.size() != (size_t) k+1 || m[k] != k) return false;
+        }
+        return true;
+    });
+    EXPECT_TRUE(ok);
+}
+
+TEST(DistributorTest, AbortedRankStopsTheOthers) {
+    time_t start = time(NULL);
+    bool ok = runRanks(3, "aborted", [](Distributor &dist) {
+        dist.setWaitTimeout(60.);
+        if (dist.getRank() == 1) exit(1);
+        dist.barrier("never");
+        return true;
+    });
+    EXPECT_FALSE(ok);
+    EXPECT_LT(difftime(time(NULL), start), 30.);
+    removeRunDir("aborted");
+}
+
+TEST(DistributorTest, WaitGivesUpAfterTimeout) {
+    time_t start = time(NULL);
+    bool ok = runRanks(2, "timeout", [](Distributor &dist) {
+        dist.setWaitTimeout(1.);
+        // dies without a word, as a killed rank would
+        if (dist.getRank() == 1) _exit(0);
+        dist.barrier("never");
+        return true;
+    });
+    EXPECT_FALSE(ok);
+    EXPECT_LT(difftime(time(NULL), start), 30.);
+    removeRunDir("timeout");
+}
+
+} // namespace
@@ -10,7 +10,9 @@ SOURCES += \
     test.cpp \
     AnalParamsTest.cpp \
     MapTest.cpp \
-    GaussFitTest.cpp
+    GaussFitTest.cpp \
+    AstronUtilitiesTest.cpp \
+    DistributorTest.cpp
 
 LIBS += \
     -L /usr/local/lib -lgtest -lgmock \